@@ -22,8 +22,8 @@ use File::Basename;
 my $file = dirname($0)."/../src/schema.tmpl";	# name the file
 
 my ($state, %output, $eol, $fk_bol, $fk_eol, $ltab, $pkey, $table_name);
-my ($szcol1, $szcol2, $szcol3, $szcol4, $sequences, $sql_suffix);
-my ($fkeys, $fkeys_prefix, $fkeys_suffix, $uniq);
+my ($szcol1, $szcol2, $szcol3, $szcol4, $sequences, $triggers, $sql_suffix);
+my ($fkeys, $fkeys_prefix, $fkeys_suffix, $uniq, $table_pkey);
 
 my %c = (
 	"type"		=>	"code",
@@ -205,6 +205,7 @@ sub process_table
 	newstate("table");
 
 	($table_name, $pkey, $flags) = split(/\|/, $line, 3);
+	$table_pkey = $pkey;
 
 	if ($output{"type"} eq "code")
 	{
@@ -394,7 +395,7 @@ sub process_field
 				$sequences = "${sequences}BEFORE INSERT ON ${table_name}${eol}\n";
 				$sequences = "${sequences}FOR EACH ROW${eol}\n";
 				$sequences = "${sequences}BEGIN${eol}\n";
-				$sequences = "${sequences}SELECT ${table_name}_seq.nextval INTO :new.id FROM dual;${eol}\n";
+				$sequences = "${sequences}SELECT ${table_name}_seq.nextval INTO :new.${name} FROM dual;${eol}\n";
 				$sequences = "${sequences}END;${eol}\n/${eol}\n";
 			}
 		}
@@ -519,6 +520,93 @@ sub process_index
 	}
 }
 
+sub process_changelog
+{
+	my $line = $_[0];
+
+	# the journal is not used by the code tables
+	return if ($output{"type"} eq "code");
+
+	# the optional field list limits update records to the changes of configuration fields,
+	# so that runtime data updates by server are not recorded
+	my ($object, $fields) = split(/\|/, $line);
+	$object =~ s/^\s+|\s+$//g;
+	$fields = "" unless defined($fields);
+	$fields =~ s/\s+//g;
+
+	my @operations = (["insert", "INSERT", 1, "new"], ["update", "UPDATE", 2, "new"], ["delete", "DELETE", 3, "old"]);
+
+	foreach (@operations)
+	{
+		my ($suffix, $event, $operation, $row) = @$_;
+		my $trigger = "${table_name}_${suffix}";
+		my $values;
+
+		if ($suffix eq "update" && $fields ne "" && $output{"database"} ne "mysql")
+		{
+			$event = "UPDATE OF ${fields}";
+		}
+
+		if ($output{"database"} eq "mysql")
+		{
+			$values = "(${object},${row}.${table_pkey},${operation},unix_timestamp())";
+
+			$triggers = "${triggers}CREATE TRIGGER `${trigger}` AFTER ${event} ON `${table_name}`${eol}\n";
+			$triggers = "${triggers}FOR EACH ROW${eol}\n";
+			$triggers = "${triggers}INSERT INTO changelog (object,objectid,operation,clock)${eol}\n";
+
+			if ($suffix eq "update" && $fields ne "")
+			{
+				# MySQL triggers cannot be limited to columns, the values are compared instead
+				my $changed = join(" AND ", map { "old.$_<=>new.$_" } split(/,/, $fields));
+
+				$values =~ s/^\((.*)\)$/$1/;
+				$triggers = "${triggers}SELECT ${values} FROM DUAL WHERE NOT (${changed});${eol}\n";
+			}
+			else
+			{
+				$triggers = "${triggers}VALUES ${values};${eol}\n";
+			}
+		}
+		elsif ($output{"database"} eq "postgresql")
+		{
+			$values = "(${object},${row}.${table_pkey},${operation},cast(extract(epoch from now()) as int))";
+
+			$triggers = "${triggers}CREATE FUNCTION changelog_${trigger}() RETURNS TRIGGER LANGUAGE plpgsql AS \$\$${eol}\n";
+			$triggers = "${triggers}BEGIN${eol}\n";
+			$triggers = "${triggers}INSERT INTO changelog (object,objectid,operation,clock)${eol}\n";
+			$triggers = "${triggers}VALUES ${values};${eol}\n";
+			$triggers = "${triggers}RETURN NULL;${eol}\n";
+			$triggers = "${triggers}END \$\$;${eol}\n";
+			$triggers = "${triggers}CREATE TRIGGER ${trigger} AFTER ${event} ON ${table_name}${eol}\n";
+			$triggers = "${triggers}FOR EACH ROW EXECUTE PROCEDURE changelog_${trigger}();${eol}\n";
+		}
+		elsif ($output{"database"} eq "oracle")
+		{
+			$values = "(${object},:${row}.${table_pkey},${operation},".
+					"trunc((cast(sys_extract_utc(systimestamp) as date)-date'1970-01-01')*86400))";
+
+			$triggers = "${triggers}CREATE TRIGGER ${trigger} AFTER ${event} ON ${table_name}${eol}\n";
+			$triggers = "${triggers}FOR EACH ROW${eol}\n";
+			$triggers = "${triggers}BEGIN${eol}\n";
+			$triggers = "${triggers}INSERT INTO changelog (object,objectid,operation,clock)${eol}\n";
+			$triggers = "${triggers}VALUES ${values};${eol}\n";
+			$triggers = "${triggers}END;${eol}\n/${eol}\n";
+		}
+		elsif ($output{"database"} eq "sqlite3")
+		{
+			$values = "(${object},${row}.${table_pkey},${operation},strftime('%s','now'))";
+
+			$triggers = "${triggers}CREATE TRIGGER ${trigger} AFTER ${event} ON ${table_name}${eol}\n";
+			$triggers = "${triggers}FOR EACH ROW${eol}\n";
+			$triggers = "${triggers}BEGIN${eol}\n";
+			$triggers = "${triggers}INSERT INTO changelog (object,objectid,operation,clock)${eol}\n";
+			$triggers = "${triggers}VALUES ${values};${eol}\n";
+			$triggers = "${triggers}END;${eol}\n";
+		}
+	}
+}
+
 sub process_row
 {
 	my $line = $_[0];
@@ -633,6 +721,7 @@ sub process
 	$state = "bof";
 	$fkeys = "";
 	$sequences = "";
+	$triggers = "";
 	$uniq = "";
 	my ($type, $line);
 
@@ -654,12 +743,13 @@ sub process
 			elsif ($type eq 'TABLE')	{ process_table($line); }
 			elsif ($type eq 'UNIQUE')	{ process_index($line, 1); }
 			elsif ($type eq 'ROW' && $output{"type"} ne "code")		{ process_row($line); }
+			elsif ($type eq 'CHANGELOG')	{ process_changelog($line); }
 		}
 	}
 
 	newstate("table");
 
-	print $sequences.$sql_suffix;
+	print $sequences.$triggers.$sql_suffix;
 	print $fkeys_prefix.$fkeys.$fkeys_suffix;
 	print $output{"after"};
 }
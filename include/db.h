@@ -495,6 +495,7 @@ int		DBexecute_once(const char *fmt, ...) __zbx_attr_format_printf(1, 2);
 DB_RESULT	DBselect_once(const char *fmt, ...) __zbx_attr_format_printf(1, 2);
 DB_RESULT	DBselect(const char *fmt, ...) __zbx_attr_format_printf(1, 2);
 DB_RESULT	DBselectN(const char *query, int n);
+DB_RESULT	DBselect_prepared(const char *sql, int params_num, const char **params);
 DB_ROW		DBfetch(DB_RESULT result);
 int		DBis_null(const char *field);
 void		DBbegin(void);
@@ -52,8 +52,11 @@
 extern int	CONFIG_TIMEOUT;
 
 extern zbx_uint64_t	CONFIG_CONF_CACHE_SIZE;
+extern int		CONFIG_ITEM_QUEUE_TIMER_WHEEL;
 extern zbx_uint64_t	CONFIG_HISTORY_CACHE_SIZE;
 extern zbx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE;
+extern zbx_uint64_t	CONFIG_HISTORY_CACHE_OVERFLOW_SIZE;
+extern char		*CONFIG_HISTORY_CACHE_OVERFLOW_DIR;
 extern zbx_uint64_t	CONFIG_TRENDS_CACHE_SIZE;
 
 extern int	CONFIG_POLLER_FORKS;
@@ -614,6 +617,7 @@ int	in_maintenance_without_data_collection(unsigned char maintenance_status, uns
 		unsigned char type);
 void	dc_add_history(zbx_uint64_t itemid, unsigned char item_value_type, unsigned char item_flags,
 		AGENT_RESULT *result, const zbx_timespec_t *ts, unsigned char state, const char *error);
+void	dc_attach_history_cache(unsigned char proc_type, int proc_num);
 void	dc_flush_history(void);
 void	zbx_sync_history_cache(int *values_num, int *triggers_num, int *more);
 void	zbx_log_sync_history_cache_progress(void);
@@ -653,6 +657,11 @@ zbx_uint64_t	DCget_nextid(const char *table_name, int num);
 #define ZBX_DBSYNC_UPDATE	1
 
 void	DCsync_configuration(unsigned char mode);
+void	DCsync_configuration_start_workers(int workers_num);
+int	DCconfig_compact(int time_limit);
+int	DCconfig_compact_interrupt(void);
+int	DCconfig_snapshot_load(const char *path);
+int	DCconfig_snapshot_write(const char *path);
 int	init_configuration_cache(char **error);
 void	free_configuration_cache(void);
 
@@ -720,6 +729,8 @@ int	DCget_host_inventory_value_by_hostid(zbx_uint64_t hostid, char **replace_to,
 #define ZBX_CONFSTATS_BUFFER_FREE	3
 #define ZBX_CONFSTATS_BUFFER_PUSED	4
 #define ZBX_CONFSTATS_BUFFER_PFREE	5
+#define ZBX_CONFSTATS_AVAILABILITY_WRITTEN	6
+#define ZBX_CONFSTATS_AVAILABILITY_COALESCED	7
 void	*DCconfig_get_stats(int request);
 
 int	DCconfig_get_last_sync_time(void);
@@ -797,6 +808,8 @@ int	DCset_hosts_availability(zbx_vector_ptr_t *availabilities);
 
 int	DCreset_hosts_availability(zbx_vector_ptr_t *hosts);
 void	DCupdate_hosts_availability(void);
+int	DCget_queued_hosts_availability(zbx_vector_ptr_t *hosts, int *coalesced_num);
+void	DCflush_hosts_availability(int *updated_num, int *coalesced_num);
 
 void	zbx_dc_get_actions_eval(zbx_vector_ptr_t *actions, zbx_hashset_t *uniq_conditions, unsigned char opflags);
 void	zbx_action_eval_free(zbx_action_eval_t *action);
@@ -951,8 +964,9 @@ zbx_event_suppress_query_t;
 #define ZBX_MAINTENANCE_UPDATE_FALSE	0
 
 void	zbx_event_suppress_query_free(zbx_event_suppress_query_t *query);
-int	zbx_dc_update_maintenances(void);
-void	zbx_dc_get_host_maintenance_updates(const zbx_vector_uint64_t *maintenanceids, zbx_vector_ptr_t *updates);
+int	zbx_dc_update_maintenances(zbx_vector_uint64_t *modified_maintenanceids);
+void	zbx_dc_get_host_maintenance_updates(const zbx_vector_uint64_t *maintenanceids,
+		const zbx_vector_uint64_t *modified_maintenanceids, zbx_vector_ptr_t *updates);
 void	zbx_dc_flush_host_maintenance_updates(const zbx_vector_ptr_t *updates);
 int	zbx_dc_get_event_maintenances(zbx_vector_ptr_t *event_queries, const zbx_vector_uint64_t *maintenanceids);
 int	zbx_dc_get_running_maintenanceids(zbx_vector_uint64_t *maintenanceids);
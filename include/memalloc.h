@@ -23,9 +23,20 @@
 #include "common.h"
 #include "mutexs.h"
 
+/* the slab of small objects of the same size class, see memalloc.c */
+typedef struct
+{
+	void		*pages;		/* the slab pages having free objects */
+	zbx_uint64_t	pages_num;
+	zbx_uint64_t	objects_used;
+	zbx_uint64_t	objects_total;
+}
+zbx_mem_slab_t;
+
 typedef struct
 {
 	void		**buckets;
+	zbx_mem_slab_t	*slabs;		/* NULL if slabs are not enabled, see zbx_mem_enable_slabs() */
 	void		*lo_bound;
 	void		*hi_bound;
 	zbx_uint64_t	free_size;
@@ -64,6 +75,13 @@ void	__zbx_mem_free(const char *file, int line, zbx_mem_info_t *info, void *ptr)
 
 void	zbx_mem_clear(zbx_mem_info_t *info);
 
+void	zbx_mem_enable_slabs(zbx_mem_info_t *info);
+
+void	*zbx_mem_relocate(zbx_mem_info_t *info, void *ptr);
+double	zbx_mem_get_fragmentation(zbx_mem_info_t *info);
+
+int	zbx_mem_validate_numa_policy(const char *policy);
+
 void	zbx_mem_dump_stats(int level, zbx_mem_info_t *info);
 
 size_t	zbx_mem_required_size(int chunks_num, const char *descr, const char *param);
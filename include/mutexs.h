@@ -29,10 +29,19 @@
 typedef wchar_t * zbx_mutex_name_t;
 typedef HANDLE zbx_mutex_t;
 #else	/* not _WINDOWS */
+
+/* the maximum number of independently locked value cache shards */
+#define ZBX_MUTEX_VALUECACHE_NUM	16
+
+/* the maximum number of independently locked history cache shards */
+#define ZBX_MUTEX_HISTORY_CACHE_NUM	16
+
 typedef enum
 {
 	ZBX_MUTEX_LOG = 0,
 	ZBX_MUTEX_CACHE,
+	ZBX_MUTEX_HISTORY_CACHE,
+	ZBX_MUTEX_HISTORY_CACHE_LAST = ZBX_MUTEX_HISTORY_CACHE + ZBX_MUTEX_HISTORY_CACHE_NUM - 1,
 	ZBX_MUTEX_TRENDS,
 	ZBX_MUTEX_CACHE_IDS,
 	ZBX_MUTEX_SELFMON,
@@ -40,6 +49,7 @@ typedef enum
 	ZBX_MUTEX_DISKSTATS,
 	ZBX_MUTEX_ITSERVICES,
 	ZBX_MUTEX_VALUECACHE,
+	ZBX_MUTEX_VALUECACHE_LAST = ZBX_MUTEX_VALUECACHE + ZBX_MUTEX_VALUECACHE_NUM - 1,
 	ZBX_MUTEX_VMWARE,
 	ZBX_MUTEX_SQLITE3,
 	ZBX_MUTEX_PROCSTAT,
@@ -343,6 +343,10 @@
 #	include <sys/shm.h>
 #endif
 
+#ifdef HAVE_SYS_MMAN_H
+#	include <sys/mman.h>
+#endif
+
 #ifdef HAVE_SYS_FILE_H
 #	include <sys/file.h>
 #endif
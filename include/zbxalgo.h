@@ -70,6 +70,7 @@ int	zbx_default_uint64_pair_compare_func(const void *d1, const void *d2);
 typedef void *(*zbx_mem_malloc_func_t)(void *old, size_t size);
 typedef void *(*zbx_mem_realloc_func_t)(void *old, size_t size);
 typedef void (*zbx_mem_free_func_t)(void *ptr);
+typedef void *(*zbx_mem_relocate_func_t)(void *ptr);
 
 void	*zbx_default_mem_malloc_func(void *old, size_t size);
 void	*zbx_default_mem_realloc_func(void *old, size_t size);
@@ -157,6 +158,12 @@ void	zbx_hashset_remove_direct(zbx_hashset_t *hs, const void *data);
 
 void	zbx_hashset_clear(zbx_hashset_t *hs);
 
+typedef void (*zbx_hashset_data_func_t)(void *data);
+
+void	zbx_hashset_relocate_slots(zbx_hashset_t *hs, zbx_mem_relocate_func_t relocate_func);
+int	zbx_hashset_relocate_entries(zbx_hashset_t *hs, int slot, int slots_num, zbx_mem_relocate_func_t relocate_func,
+		zbx_hashset_data_func_t data_func);
+
 typedef struct
 {
 	zbx_hashset_t		*hashset;
@@ -269,6 +276,63 @@ void			zbx_binary_heap_remove_direct(zbx_binary_heap_t *heap, zbx_uint64_t key);
 
 void			zbx_binary_heap_clear(zbx_binary_heap_t *heap);
 
+/* hierarchical timer wheel */
+
+/* Stores zbx_uint64_t keys with arbitrary auxiliary information scheduled with a second       */
+/* resolution. The elements are kept in unordered slot lists of a time range, so insert,       */
+/* reschedule and remove operations take constant time. The upper level slots are cascaded     */
+/* into the lower levels as the wheel time advances and the elements become due with the      */
+/* first level slot of their second. The due elements are returned in no particular order.     */
+
+#define ZBX_TIMER_WHEEL_LEVELS		4
+#define ZBX_TIMER_WHEEL_LEVEL_BITS	6
+#define ZBX_TIMER_WHEEL_LEVEL_SLOTS	(1 << ZBX_TIMER_WHEEL_LEVEL_BITS)
+
+/* the slot of elements scheduled beyond the time range of the last level */
+#define ZBX_TIMER_WHEEL_SLOT_OVERFLOW	(ZBX_TIMER_WHEEL_LEVELS * ZBX_TIMER_WHEEL_LEVEL_SLOTS)
+/* the slot of elements that are due */
+#define ZBX_TIMER_WHEEL_SLOT_DUE	(ZBX_TIMER_WHEEL_SLOT_OVERFLOW + 1)
+#define ZBX_TIMER_WHEEL_SLOTS_NUM	(ZBX_TIMER_WHEEL_SLOT_DUE + 1)
+
+typedef struct zbx_timer_wheel_elem
+{
+	zbx_uint64_t			key;
+	const void			*data;
+	struct zbx_timer_wheel_elem	*prev;
+	struct zbx_timer_wheel_elem	*next;
+	int				time;
+	int				slot;
+}
+zbx_timer_wheel_elem_t;
+
+typedef struct
+{
+	/* the elements by key */
+	zbx_hashset_t		elems;
+
+	/* the slot element lists and the lower bounds of their element times */
+	zbx_timer_wheel_elem_t	*slots[ZBX_TIMER_WHEEL_SLOTS_NUM];
+	int			slots_time[ZBX_TIMER_WHEEL_SLOTS_NUM];
+
+	/* the wheel time - elements scheduled before it are due */
+	int			time;
+}
+zbx_timer_wheel_t;
+
+void		zbx_timer_wheel_create(zbx_timer_wheel_t *wheel, int time);
+void		zbx_timer_wheel_create_ext(zbx_timer_wheel_t *wheel, int time,
+						zbx_mem_malloc_func_t mem_malloc_func,
+						zbx_mem_realloc_func_t mem_realloc_func,
+						zbx_mem_free_func_t mem_free_func);
+void		zbx_timer_wheel_destroy(zbx_timer_wheel_t *wheel);
+
+void		zbx_timer_wheel_insert(zbx_timer_wheel_t *wheel, zbx_uint64_t key, const void *data, int time);
+int		zbx_timer_wheel_remove(zbx_timer_wheel_t *wheel, zbx_uint64_t key);
+const void	*zbx_timer_wheel_pop(zbx_timer_wheel_t *wheel, int now);
+int		zbx_timer_wheel_next_time(const zbx_timer_wheel_t *wheel);
+
+#define zbx_timer_wheel_elems_num(wheel)	((wheel)->elems.num_data)
+
 /* vector */
 
 #define ZBX_VECTOR_DECL(__id, __type)										\
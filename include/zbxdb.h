@@ -121,8 +121,12 @@ void		zbx_db_clean_bind_context(zbx_db_bind_context_t *context);
 int		zbx_db_statement_execute(int iters);
 #endif
 int		zbx_db_vexecute(const char *fmt, va_list args);
+#ifdef HAVE_POSTGRESQL
+int		zbx_db_copy(const char *sql, const char *data, size_t data_len);
+#endif
 DB_RESULT	zbx_db_vselect(const char *fmt, va_list args);
 DB_RESULT	zbx_db_select_n(const char *query, int n);
+DB_RESULT	zbx_db_select_prepared(const char *sql, int params_num, const char **params);
 
 DB_ROW		zbx_db_fetch(DB_RESULT result);
 void		DBfree_result(DB_RESULT result);
@@ -30,6 +30,20 @@ zbx_history_record_t;
 
 ZBX_VECTOR_DECL(history_record, zbx_history_record_t)
 
+/* the item history request, see zbx_history_get_values_multi() */
+typedef struct
+{
+	zbx_uint64_t			itemid;
+
+	/* the requested period ]start,end] */
+	int				start;
+	int				end;
+
+	/* the item history data values */
+	zbx_vector_history_record_t	values;
+}
+zbx_history_request_t;
+
 void	zbx_history_record_vector_clean(zbx_vector_history_record_t *vector, int value_type);
 void	zbx_history_record_vector_destroy(zbx_vector_history_record_t *vector, int value_type);
 void	zbx_history_record_clear(zbx_history_record_t *value, int value_type);
@@ -53,6 +67,7 @@ void	zbx_history_destroy(void);
 int	zbx_history_add_values(const zbx_vector_ptr_t *values);
 int	zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
 		zbx_vector_history_record_t *values);
+int	zbx_history_get_values_multi(int value_type, zbx_vector_ptr_t *requests);
 
 int	zbx_history_requires_trends(int value_type);
 
@@ -377,6 +377,70 @@ void	zbx_hashset_clear(zbx_hashset_t *hs)
 	hs->num_data = 0;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hashset_relocate_slots                                       *
+ *                                                                            *
+ * Purpose: moves hashset slot array to reduce memory fragmentation           *
+ *                                                                            *
+ * Parameters: hs            - [IN] the hashset                               *
+ *             relocate_func - [IN] the memory relocation function, returning *
+ *                                  the new location of the memory            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_hashset_relocate_slots(zbx_hashset_t *hs, zbx_mem_relocate_func_t relocate_func)
+{
+	if (NULL != hs->slots)
+		hs->slots = (ZBX_HASHSET_ENTRY_T **)relocate_func(hs->slots);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_hashset_relocate_entries                                     *
+ *                                                                            *
+ * Purpose: moves hashset entries to reduce memory fragmentation              *
+ *                                                                            *
+ * Parameters: hs            - [IN] the hashset                               *
+ *             slot          - [IN] the first slot to process                 *
+ *             slots_num     - [IN] the number of slots to process            *
+ *             relocate_func - [IN] the memory relocation function, returning *
+ *                                  the new location of the memory (optional) *
+ *             data_func     - [IN] the function called for each entry data   *
+ *                                  after its relocation (optional)           *
+ *                                                                            *
+ * Return value: the next slot to process, hs->num_slots if all slots were    *
+ *               processed                                                    *
+ *                                                                            *
+ * Comments: Entries can be relocated only if they are not referenced by      *
+ *           pointers outside hashset, otherwise relocate_func must be NULL   *
+ *           and only the memory owned by entries can be relocated by         *
+ *           data_func.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_hashset_relocate_entries(zbx_hashset_t *hs, int slot, int slots_num, zbx_mem_relocate_func_t relocate_func,
+		zbx_hashset_data_func_t data_func)
+{
+	int			slot_end;
+	ZBX_HASHSET_ENTRY_T	**link;
+
+	if ((slot_end = slot + slots_num) > hs->num_slots || slot_end < slot)
+		slot_end = hs->num_slots;
+
+	for (; slot < slot_end; slot++)
+	{
+		for (link = &hs->slots[slot]; NULL != *link; link = &(*link)->next)
+		{
+			if (NULL != relocate_func)
+				*link = (ZBX_HASHSET_ENTRY_T *)relocate_func(*link);
+
+			if (NULL != data_func)
+				data_func((*link)->data);
+		}
+	}
+
+	return slot_end;
+}
+
 #define	ITER_START	(-1)
 #define	ITER_FINISH	(-2)
 
@@ -0,0 +1,322 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+
+#include "zbxalgo.h"
+
+#define TIMER_WHEEL_SLOT_MASK		(ZBX_TIMER_WHEEL_LEVEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVEL_SHIFT(level)	(ZBX_TIMER_WHEEL_LEVEL_BITS * (level))
+
+/* the time range covered by all slots of the level */
+#define TIMER_WHEEL_LEVEL_RANGE(level)	(1 << TIMER_WHEEL_LEVEL_SHIFT((level) + 1))
+
+/* private timer wheel functions */
+
+/******************************************************************************
+ *                                                                            *
+ * Function: timer_wheel_get_slot                                             *
+ *                                                                            *
+ * Purpose: get the slot for an element scheduled at the specified time       *
+ *                                                                            *
+ * Comments: The element is placed in the lowest level covering the time      *
+ *           until its schedule. The slot of an upper level is cascaded when  *
+ *           the wheel time reaches the start of its time range, which is     *
+ *           not later than the element schedule.                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	timer_wheel_get_slot(const zbx_timer_wheel_t *wheel, int time)
+{
+	int	level, delta;
+
+	if (time < wheel->time)
+		return ZBX_TIMER_WHEEL_SLOT_DUE;
+
+	delta = time - wheel->time;
+
+	for (level = 0; level < ZBX_TIMER_WHEEL_LEVELS; level++)
+	{
+		if (delta < TIMER_WHEEL_LEVEL_RANGE(level))
+		{
+			return level * ZBX_TIMER_WHEEL_LEVEL_SLOTS +
+					((time >> TIMER_WHEEL_LEVEL_SHIFT(level)) & TIMER_WHEEL_SLOT_MASK);
+		}
+	}
+
+	return ZBX_TIMER_WHEEL_SLOT_OVERFLOW;
+}
+
+static void	timer_wheel_link(zbx_timer_wheel_t *wheel, zbx_timer_wheel_elem_t *elem, int slot)
+{
+	elem->slot = slot;
+	elem->prev = NULL;
+
+	if (NULL != (elem->next = wheel->slots[slot]))
+		elem->next->prev = elem;
+
+	wheel->slots[slot] = elem;
+
+	if (elem->time < wheel->slots_time[slot])
+		wheel->slots_time[slot] = elem->time;
+}
+
+static void	timer_wheel_unlink(zbx_timer_wheel_t *wheel, zbx_timer_wheel_elem_t *elem)
+{
+	if (NULL != elem->prev)
+		elem->prev->next = elem->next;
+	else
+		wheel->slots[elem->slot] = elem->next;
+
+	if (NULL != elem->next)
+		elem->next->prev = elem->prev;
+
+	/* the slot time is kept as the lower bound of the remaining element times */
+	if (NULL == wheel->slots[elem->slot])
+		wheel->slots_time[elem->slot] = INT_MAX;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: timer_wheel_move_slot                                            *
+ *                                                                            *
+ * Purpose: moves slot elements to the slots matching their schedule at the   *
+ *          current wheel time                                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	timer_wheel_move_slot(zbx_timer_wheel_t *wheel, int slot)
+{
+	zbx_timer_wheel_elem_t	*elem, *next;
+
+	elem = wheel->slots[slot];
+	wheel->slots[slot] = NULL;
+	wheel->slots_time[slot] = INT_MAX;
+
+	for (; NULL != elem; elem = next)
+	{
+		next = elem->next;
+		timer_wheel_link(wheel, elem, timer_wheel_get_slot(wheel, elem->time));
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: timer_wheel_tick                                                 *
+ *                                                                            *
+ * Purpose: advances timer wheel by one second, making the elements of the    *
+ *          current second due                                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	timer_wheel_tick(zbx_timer_wheel_t *wheel)
+{
+	int	level, slot;
+
+	/* cascade upper level slots starting at the current time */
+	for (level = 1; level < ZBX_TIMER_WHEEL_LEVELS; level++)
+	{
+		if (0 != (wheel->time & (TIMER_WHEEL_LEVEL_RANGE(level - 1) - 1)))
+			break;
+
+		timer_wheel_move_slot(wheel, level * ZBX_TIMER_WHEEL_LEVEL_SLOTS +
+				((wheel->time >> TIMER_WHEEL_LEVEL_SHIFT(level)) & TIMER_WHEEL_SLOT_MASK));
+	}
+
+	if (ZBX_TIMER_WHEEL_LEVELS == level &&
+			0 == (wheel->time & (TIMER_WHEEL_LEVEL_RANGE(ZBX_TIMER_WHEEL_LEVELS - 1) - 1)))
+	{
+		timer_wheel_move_slot(wheel, ZBX_TIMER_WHEEL_SLOT_OVERFLOW);
+	}
+
+	slot = wheel->time & TIMER_WHEEL_SLOT_MASK;
+	wheel->time++;
+
+	if (NULL != wheel->slots[slot])
+		timer_wheel_move_slot(wheel, slot);
+}
+
+/* public timer wheel interface */
+
+void	zbx_timer_wheel_create(zbx_timer_wheel_t *wheel, int time)
+{
+	zbx_timer_wheel_create_ext(wheel, time,
+					ZBX_DEFAULT_MEM_MALLOC_FUNC,
+					ZBX_DEFAULT_MEM_REALLOC_FUNC,
+					ZBX_DEFAULT_MEM_FREE_FUNC);
+}
+
+void	zbx_timer_wheel_create_ext(zbx_timer_wheel_t *wheel, int time,
+					zbx_mem_malloc_func_t mem_malloc_func,
+					zbx_mem_realloc_func_t mem_realloc_func,
+					zbx_mem_free_func_t mem_free_func)
+{
+	int	i;
+
+	zbx_hashset_create_ext(&wheel->elems, 512, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
+			NULL, mem_malloc_func, mem_realloc_func, mem_free_func);
+
+	for (i = 0; i < ZBX_TIMER_WHEEL_SLOTS_NUM; i++)
+	{
+		wheel->slots[i] = NULL;
+		wheel->slots_time[i] = INT_MAX;
+	}
+
+	wheel->time = time;
+}
+
+void	zbx_timer_wheel_destroy(zbx_timer_wheel_t *wheel)
+{
+	zbx_hashset_destroy(&wheel->elems);
+	memset(wheel->slots, 0, sizeof(wheel->slots));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_timer_wheel_insert                                           *
+ *                                                                            *
+ * Purpose: schedules element at the specified time                           *
+ *                                                                            *
+ * Parameters: wheel - [IN] the timer wheel                                   *
+ *             key   - [IN] the element key                                   *
+ *             data  - [IN] the element data                                  *
+ *             time  - [IN] the element schedule                              *
+ *                                                                            *
+ * Comments: Already scheduled element is rescheduled.                        *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_timer_wheel_insert(zbx_timer_wheel_t *wheel, zbx_uint64_t key, const void *data, int time)
+{
+	zbx_timer_wheel_elem_t	*elem, elem_local;
+
+	elem_local.key = key;
+
+	if (NULL == (elem = (zbx_timer_wheel_elem_t *)zbx_hashset_search(&wheel->elems, &elem_local)))
+		elem = (zbx_timer_wheel_elem_t *)zbx_hashset_insert(&wheel->elems, &elem_local, sizeof(elem_local));
+	else
+		timer_wheel_unlink(wheel, elem);
+
+	elem->data = data;
+	elem->time = time;
+
+	timer_wheel_link(wheel, elem, timer_wheel_get_slot(wheel, time));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_timer_wheel_remove                                           *
+ *                                                                            *
+ * Purpose: removes element from timer wheel                                  *
+ *                                                                            *
+ * Parameters: wheel - [IN] the timer wheel                                   *
+ *             key   - [IN] the element key                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the element was removed                            *
+ *               FAIL    - the element was not scheduled                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_timer_wheel_remove(zbx_timer_wheel_t *wheel, zbx_uint64_t key)
+{
+	zbx_timer_wheel_elem_t	*elem;
+
+	if (NULL == (elem = (zbx_timer_wheel_elem_t *)zbx_hashset_search(&wheel->elems, &key)))
+		return FAIL;
+
+	timer_wheel_unlink(wheel, elem);
+	zbx_hashset_remove_direct(&wheel->elems, elem);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_timer_wheel_pop                                              *
+ *                                                                            *
+ * Purpose: removes a due element from timer wheel                            *
+ *                                                                            *
+ * Parameters: wheel - [IN] the timer wheel                                   *
+ *             now   - [IN] the current time                                  *
+ *                                                                            *
+ * Return value: the data of element scheduled not later than the current     *
+ *               time or NULL if there are no due elements                    *
+ *                                                                            *
+ * Comments: The wheel is advanced up to the current time only when there are *
+ *           no already due elements left, so all due elements can be         *
+ *           retrieved by calling this function until it returns NULL.       *
+ *                                                                            *
+ ******************************************************************************/
+const void	*zbx_timer_wheel_pop(zbx_timer_wheel_t *wheel, int now)
+{
+	zbx_timer_wheel_elem_t	*elem;
+	const void		*data;
+
+	while (NULL == wheel->slots[ZBX_TIMER_WHEEL_SLOT_DUE] && wheel->time <= now)
+	{
+		if (0 == wheel->elems.num_data)
+		{
+			wheel->time = now + 1;
+			break;
+		}
+
+		timer_wheel_tick(wheel);
+	}
+
+	if (NULL == (elem = wheel->slots[ZBX_TIMER_WHEEL_SLOT_DUE]))
+		return NULL;
+
+	data = elem->data;
+
+	timer_wheel_unlink(wheel, elem);
+	zbx_hashset_remove_direct(&wheel->elems, elem);
+
+	return data;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_timer_wheel_next_time                                        *
+ *                                                                            *
+ * Purpose: get the time of the next scheduled element                        *
+ *                                                                            *
+ * Parameters: wheel - [IN] the timer wheel                                   *
+ *                                                                            *
+ * Return value: the time when the next element becomes due or FAIL if the    *
+ *               wheel is empty                                               *
+ *                                                                            *
+ * Comments: The returned time is exact for elements in the first level and   *
+ *           a lower bound for elements in upper levels - it might be         *
+ *           earlier than the actual schedule, but never later.               *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_timer_wheel_next_time(const zbx_timer_wheel_t *wheel)
+{
+	int	i, time = INT_MAX;
+
+	if (0 == wheel->elems.num_data)
+		return FAIL;
+
+	if (NULL != wheel->slots[ZBX_TIMER_WHEEL_SLOT_DUE])
+		return wheel->slots_time[ZBX_TIMER_WHEEL_SLOT_DUE];
+
+	for (i = 0; i < ZBX_TIMER_WHEEL_SLOT_DUE; i++)
+	{
+		if (wheel->slots_time[i] < time)
+			time = wheel->slots_time[i];
+	}
+
+	/* not due elements are scheduled at the wheel time or later */
+	return MAX(time, wheel->time);
+}
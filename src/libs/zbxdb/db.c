@@ -64,16 +64,18 @@ struct zbx_db_result
 #endif
 };
 
-static int	txn_level = 0;	/* transaction level, nested transactions are not supported */
-static int	txn_error = ZBX_DB_OK;	/* failed transaction */
-static int	txn_end_error = ZBX_DB_OK;	/* transaction result */
+/* the connection state is thread local to allow helper threads with their own database connections */
+static ZBX_THREAD_LOCAL int	txn_level = 0;	/* transaction level, nested transactions are not supported */
+static ZBX_THREAD_LOCAL int	txn_error = ZBX_DB_OK;	/* failed transaction */
+static ZBX_THREAD_LOCAL int	txn_end_error = ZBX_DB_OK;	/* transaction result */
 
-static char	*last_db_strerror = NULL;	/* last database error message */
+static ZBX_THREAD_LOCAL char	*last_db_strerror = NULL;	/* last database error message */
 
 extern int	CONFIG_LOG_SLOW_QUERIES;
+extern int	CONFIG_DB_PREPARED_STATEMENTS;
 
 #if defined(HAVE_MYSQL)
-static MYSQL			*conn = NULL;
+static ZBX_THREAD_LOCAL MYSQL	*conn = NULL;
 #elif defined(HAVE_ORACLE)
 #include "zbxalgo.h"
 
@@ -93,10 +95,24 @@ static zbx_oracle_db_handle_t	oracle;
 static ub4	OCI_DBserver_status(void);
 
 #elif defined(HAVE_POSTGRESQL)
-static PGconn			*conn = NULL;
-static unsigned int		ZBX_PG_BYTEAOID = 0;
-static int			ZBX_PG_SVERSION = 0;
+#include "zbxalgo.h"
+
+/* prepared statement, the statement name is formed from its index */
+typedef struct
+{
+	char	*sql;
+	int	index;
+}
+zbx_pg_statement_t;
+
+static ZBX_THREAD_LOCAL PGconn		*conn = NULL;
+static ZBX_THREAD_LOCAL unsigned int	ZBX_PG_BYTEAOID = 0;
+static ZBX_THREAD_LOCAL int		ZBX_PG_SVERSION = 0;
 char				ZBX_PG_ESCAPE_BACKSLASH = 1;
+
+/* prepared statements of the current connection, indexed by statement text */
+static ZBX_THREAD_LOCAL zbx_hashset_t	pg_statements;
+static ZBX_THREAD_LOCAL int		pg_statement_index = 0;
 #elif defined(HAVE_SQLITE3)
 static sqlite3			*conn = NULL;
 static zbx_mutex_t		sqlite_access = ZBX_MUTEX_NULL;
@@ -963,6 +979,12 @@ void	zbx_db_close(void)
 		PQfinish(conn);
 		conn = NULL;
 	}
+
+	/* prepared statements are gone together with the connection */
+	if (NULL != pg_statements.slots)
+		zbx_hashset_destroy(&pg_statements);
+
+	pg_statement_index = 0;
 #elif defined(HAVE_SQLITE3)
 	if (NULL != conn)
 	{
@@ -1546,6 +1568,109 @@ clean:
 	return ret;
 }
 
+#ifdef HAVE_POSTGRESQL
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_copy                                                      *
+ *                                                                            *
+ * Purpose: execute COPY ... FROM STDIN statement and send the data rows      *
+ *                                                                            *
+ * Parameters: sql      - [IN] the copy statement                             *
+ *             data     - [IN] the data rows in COPY text format              *
+ *             data_len - [IN] the data length in bytes                       *
+ *                                                                            *
+ * Return value: ZBX_DB_FAIL (on error) or ZBX_DB_DOWN (on recoverable error) *
+ *               or number of rows copied (on success)                        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_db_copy(const char *sql, const char *data, size_t data_len)
+{
+	PGresult	*result;
+	char		*error = NULL;
+	int		ret = ZBX_DB_OK;
+	double		sec = 0;
+
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+		sec = zbx_time();
+
+	if (0 == txn_level)
+		zabbix_log(LOG_LEVEL_DEBUG, "query without transaction detected");
+
+	if (ZBX_DB_OK != txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level, sql);
+		return ZBX_DB_FAIL;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s] [%.*s]", txn_level, sql, (int)data_len, data);
+
+	result = PQexec(conn, sql);
+
+	if (NULL == result)
+	{
+		zbx_db_errlog(ERR_Z3005, 0, "result is NULL", sql);
+		ret = (CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+		goto out;
+	}
+
+	if (PGRES_COPY_IN != PQresultStatus(result))
+	{
+		zbx_postgresql_error(&error, result);
+		zbx_db_errlog(ERR_Z3005, 0, error, sql);
+		zbx_free(error);
+
+		ret = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? ZBX_DB_DOWN : ZBX_DB_FAIL);
+		PQclear(result);
+		goto out;
+	}
+
+	PQclear(result);
+
+	if (1 != PQputCopyData(conn, data, (int)data_len) || 1 != PQputCopyEnd(conn, NULL))
+	{
+		zbx_db_errlog(ERR_Z3005, 0, PQerrorMessage(conn), sql);
+		ret = (CONNECTION_OK == PQstatus(conn) ? ZBX_DB_FAIL : ZBX_DB_DOWN);
+	}
+
+	/* the copy command status is returned after all data has been sent, */
+	/* results must be read until NULL before the next query can be sent */
+	while (NULL != (result = PQgetResult(conn)))
+	{
+		if (ZBX_DB_OK == ret)
+		{
+			if (PGRES_COMMAND_OK != PQresultStatus(result))
+			{
+				zbx_postgresql_error(&error, result);
+				zbx_db_errlog(ERR_Z3005, 0, error, sql);
+				zbx_free(error);
+
+				ret = (SUCCEED == is_recoverable_postgresql_error(conn, result) ? ZBX_DB_DOWN :
+						ZBX_DB_FAIL);
+			}
+			else
+				ret = atoi(PQcmdTuples(result));
+		}
+
+		PQclear(result);
+	}
+out:
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+	{
+		sec = zbx_time() - sec;
+		if (sec > (double)CONFIG_LOG_SLOW_QUERIES / 1000.0)
+			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\"", sec, sql);
+	}
+
+	if (ZBX_DB_FAIL == ret && 0 < txn_level)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "query [%s] failed, setting transaction as failed", sql);
+		txn_error = ZBX_DB_FAIL;
+	}
+
+	return ret;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_db_vselect                                                   *
@@ -1849,6 +1974,256 @@ DB_RESULT	zbx_db_select_n(const char *query, int n)
 #endif
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_format_prepared                                           *
+ *                                                                            *
+ * Purpose: substitute parameters into prepared statement text                *
+ *                                                                            *
+ * Parameters: sql        - [IN] the statement with $1..$N placeholders       *
+ *             params_num - [IN] the number of parameters                     *
+ *             params     - [IN] the parameter values                         *
+ *                                                                            *
+ * Return value: the statement text with parameter values                     *
+ *                                                                            *
+ * Comments: The parameters are copied without quoting, so only numeric       *
+ *           parameters are supported.                                        *
+ *                                                                            *
+ ******************************************************************************/
+static char	*zbx_db_format_prepared(const char *sql, int params_num, const char **params)
+{
+	char		*str = NULL, *end;
+	size_t		str_alloc = 0, str_offset = 0;
+	const char	*ptr;
+	long		index;
+
+	for (ptr = sql; '\0' != *ptr; ptr++)
+	{
+		if ('$' != *ptr || 0 == isdigit((unsigned char)ptr[1]))
+			continue;
+
+		index = strtol(ptr + 1, &end, 10);
+
+		if (1 > index || params_num < index)
+		{
+			THIS_SHOULD_NEVER_HAPPEN;
+			continue;
+		}
+
+		zbx_strncpy_alloc(&str, &str_alloc, &str_offset, sql, (size_t)(ptr - sql));
+		zbx_strcpy_alloc(&str, &str_alloc, &str_offset, params[index - 1]);
+		sql = end;
+		ptr = end - 1;
+	}
+
+	zbx_strcpy_alloc(&str, &str_alloc, &str_offset, sql);
+
+	return str;
+}
+
+#if defined(HAVE_POSTGRESQL)
+static zbx_hash_t	pg_statement_hash_func(const void *data)
+{
+	const zbx_pg_statement_t	*statement = (const zbx_pg_statement_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(statement->sql, strlen(statement->sql), ZBX_DEFAULT_HASH_SEED);
+}
+
+static int	pg_statement_compare_func(const void *d1, const void *d2)
+{
+	const zbx_pg_statement_t	*s1 = (const zbx_pg_statement_t *)d1;
+	const zbx_pg_statement_t	*s2 = (const zbx_pg_statement_t *)d2;
+
+	return strcmp(s1->sql, s2->sql);
+}
+
+static void	pg_statement_clean_func(void *data)
+{
+	zbx_free(((zbx_pg_statement_t *)data)->sql);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_prepared_text                                             *
+ *                                                                            *
+ * Purpose: get prepared statement text with parameter values for logging,    *
+ *          formatting it on the first call                                   *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*zbx_db_prepared_text(char **text, const char *sql, int params_num, const char **params)
+{
+	if (NULL == *text)
+		*text = zbx_db_format_prepared(sql, params_num, params);
+
+	return *text;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_db_select_prepared                                           *
+ *                                                                            *
+ * Purpose: execute a select statement with parameters                        *
+ *                                                                            *
+ * Parameters: sql        - [IN] the statement with $1..$N placeholders       *
+ *             params_num - [IN] the number of parameters                     *
+ *             params     - [IN] the parameter values                         *
+ *                                                                            *
+ * Return value: data, NULL (on error) or (DB_RESULT)ZBX_DB_DOWN              *
+ *                                                                            *
+ * Comments: On PostgreSQL the statement is prepared on the first execution   *
+ *           and reused for the lifetime of the connection, so the statement  *
+ *           text must not contain variable parts other than placeholders.    *
+ *           On other databases or when DBPreparedStatements is disabled the  *
+ *           parameters are substituted into the statement text, so only      *
+ *           numeric parameters are supported.                                *
+ *                                                                            *
+ ******************************************************************************/
+DB_RESULT	zbx_db_select_prepared(const char *sql, int params_num, const char **params)
+{
+	DB_RESULT		result = NULL;
+	char			*text = NULL;
+#if defined(HAVE_POSTGRESQL)
+	zbx_pg_statement_t	statement_local, *statement;
+	PGresult		*pg_result;
+	char			*error = NULL, name[32];
+	double			sec = 0;
+	int			retried = 0;
+
+	if (0 == CONFIG_DB_PREPARED_STATEMENTS)
+	{
+		text = zbx_db_format_prepared(sql, params_num, params);
+		result = zbx_db_select("%s", text);
+		goto clean;
+	}
+
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+		sec = zbx_time();
+
+	if (ZBX_DB_OK != txn_error)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "ignoring query [txnlev:%d] [%s] within failed transaction", txn_level,
+				zbx_db_prepared_text(&text, sql, params_num, params));
+		goto clean;
+	}
+
+	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_DEBUG))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "query [txnlev:%d] [%s]", txn_level,
+				zbx_db_prepared_text(&text, sql, params_num, params));
+	}
+
+	if (NULL == pg_statements.slots)
+	{
+		zbx_hashset_create_ext(&pg_statements, 10, pg_statement_hash_func, pg_statement_compare_func,
+				pg_statement_clean_func, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+				ZBX_DEFAULT_MEM_FREE_FUNC);
+	}
+
+retry:
+	statement_local.sql = (char *)sql;
+
+	if (NULL == (statement = (zbx_pg_statement_t *)zbx_hashset_search(&pg_statements, &statement_local)))
+	{
+		statement_local.index = ++pg_statement_index;
+		zbx_snprintf(name, sizeof(name), "zbx_stmt_%d", statement_local.index);
+
+		pg_result = PQprepare(conn, name, sql, params_num, NULL);
+
+		if (PGRES_COMMAND_OK != PQresultStatus(pg_result))
+		{
+			zbx_postgresql_error(&error, pg_result);
+			zbx_db_errlog(ERR_Z3005, 0, error, sql);
+			zbx_free(error);
+
+			if (SUCCEED == is_recoverable_postgresql_error(conn, pg_result))
+				result = (DB_RESULT)ZBX_DB_DOWN;
+
+			PQclear(pg_result);
+			goto out;
+		}
+
+		PQclear(pg_result);
+
+		statement_local.sql = zbx_strdup(NULL, sql);
+		statement = (zbx_pg_statement_t *)zbx_hashset_insert(&pg_statements, &statement_local,
+				sizeof(statement_local));
+	}
+	else
+		zbx_snprintf(name, sizeof(name), "zbx_stmt_%d", statement->index);
+
+	result = zbx_malloc(NULL, sizeof(struct zbx_db_result));
+	result->pg_result = PQexecPrepared(conn, name, params_num, params, NULL, NULL, 0);
+	result->values = NULL;
+	result->cursor = 0;
+	result->row_num = 0;
+
+	if (NULL == result->pg_result)
+		zbx_db_errlog(ERR_Z3005, 0, "result is NULL", zbx_db_prepared_text(&text, sql, params_num, params));
+
+	if (PGRES_TUPLES_OK != PQresultStatus(result->pg_result))
+	{
+		/* the statement is not known by the server session, for example when the connection goes */
+		/* through a pooler - forget it and prepare again, unless the transaction is already failed */
+		if (0 == zbx_strcmp_null(PQresultErrorField(result->pg_result, PG_DIAG_SQLSTATE), "26000"))
+		{
+			zbx_hashset_remove_direct(&pg_statements, statement);
+
+			if (0 == retried && 0 == txn_level)
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "prepared statement \"%s\" does not exist, preparing again",
+						name);
+				DBfree_result(result);
+				result = NULL;
+				retried = 1;
+				goto retry;
+			}
+		}
+
+		zbx_postgresql_error(&error, result->pg_result);
+		zbx_db_errlog(ERR_Z3005, 0, error, zbx_db_prepared_text(&text, sql, params_num, params));
+		zbx_free(error);
+
+		if (SUCCEED == is_recoverable_postgresql_error(conn, result->pg_result))
+		{
+			DBfree_result(result);
+			result = (DB_RESULT)ZBX_DB_DOWN;
+		}
+		else
+		{
+			DBfree_result(result);
+			result = NULL;
+		}
+	}
+	else	/* init rownum */
+		result->row_num = PQntuples(result->pg_result);
+out:
+	if (0 != CONFIG_LOG_SLOW_QUERIES)
+	{
+		sec = zbx_time() - sec;
+		if (sec > (double)CONFIG_LOG_SLOW_QUERIES / 1000.0)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "slow query: " ZBX_FS_DBL " sec, \"%s\"", sec,
+					zbx_db_prepared_text(&text, sql, params_num, params));
+		}
+	}
+
+	if (NULL == result && 0 < txn_level)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "query [%s] failed, setting transaction as failed",
+				zbx_db_prepared_text(&text, sql, params_num, params));
+		txn_error = ZBX_DB_FAIL;
+	}
+clean:
+#else
+	text = zbx_db_format_prepared(sql, params_num, params);
+	result = zbx_db_select("%s", text);
+#endif
+	zbx_free(text);
+
+	return result;
+}
+
 #ifdef HAVE_POSTGRESQL
 /******************************************************************************
  *                                                                            *
@@ -40,9 +40,12 @@
 static zbx_mem_info_t	*hc_index_mem = NULL;
 static zbx_mem_info_t	*hc_mem = NULL;
 static zbx_mem_info_t	*trend_mem = NULL;
+static zbx_mem_info_t	*hc_ring_mem = NULL;
 
 #define	LOCK_CACHE	zbx_mutex_lock(cache_lock)
 #define	UNLOCK_CACHE	zbx_mutex_unlock(cache_lock)
+#define	LOCK_SHARD	zbx_mutex_lock(hc_shard->lock)
+#define	UNLOCK_SHARD	zbx_mutex_unlock(hc_shard->lock)
 #define	LOCK_TRENDS	zbx_mutex_lock(trends_lock)
 #define	UNLOCK_TRENDS	zbx_mutex_unlock(trends_lock)
 #define	LOCK_CACHE_IDS		zbx_mutex_lock(cache_ids_lock)
@@ -57,11 +60,19 @@ static size_t		sql_alloc = 64 * ZBX_KIBIBYTE;
 
 extern unsigned char	program_type;
 extern int		CONFIG_DOUBLE_PRECISION;
+extern int		CONFIG_PREPROCMAN_FORKS;
+extern int		CONFIG_TRAPPER_FORKS;
+extern int		CONFIG_PROXYPOLLER_FORKS;
+extern int		CONFIG_CONFSYNCER_FORKS;
+extern int		CONFIG_HISTSYNCER_FORKS;
 
 #define ZBX_IDS_SIZE	9
 
 #define ZBX_HC_ITEMS_INIT_SIZE	1000
 
+/* the minimum history cache and history index cache shard size */
+#define ZBX_HC_SHARD_MIN_SIZE	(256 * ZBX_KIBIBYTE)
+
 #define ZBX_TRENDS_CLEANUP_TIME	((SEC_PER_HOUR * 55) / 60)
 
 /* the maximum time spent synchronizing history */
@@ -100,12 +111,7 @@ static ZBX_DC_IDS	*ids = NULL;
 typedef struct
 {
 	zbx_hashset_t		trends;
-	ZBX_DC_STATS		stats;
-
-	zbx_hashset_t		history_items;
-	zbx_binary_heap_t	history_queue;
 
-	int			history_num;
 	int			trends_num;
 	int			trends_last_cleanup_hour;
 	int			history_num_total;
@@ -115,6 +121,50 @@ ZBX_DC_CACHE;
 
 static ZBX_DC_CACHE	*cache = NULL;
 
+/* The history cache is split into shards by itemid. Each shard has its own lock,     */
+/* history and history index memory segments, so history syncers can take values   */
+/* from their own shards in parallel. The shard being accessed is selected with     */
+/* hc_select_shard() function.                                                      */
+
+/* the history cache shard data, allocated in the shard index memory */
+typedef struct
+{
+	ZBX_DC_STATS		stats;
+
+	zbx_hashset_t		history_items;
+	zbx_binary_heap_t	history_queue;
+
+	int			history_num;
+
+	/* the item values spilled to overflow segment files, see hc_overflow_write() */
+	int			overflow_num;
+	int			overflow_read_segment;
+	int			overflow_write_segment;
+	zbx_uint64_t		overflow_read_offset;
+	zbx_uint64_t		overflow_write_offset;
+	zbx_hc_data_t		*overflow_data;		/* the partially cloned overflow value */
+}
+zbx_hc_cache_t;
+
+typedef struct
+{
+	zbx_mem_info_t	*mem;
+	zbx_mem_info_t	*index_mem;
+	zbx_mutex_t	lock;
+	zbx_hc_cache_t	*cache;
+}
+zbx_hc_shard_t;
+
+static zbx_hc_shard_t	hc_shards[ZBX_MUTEX_HISTORY_CACHE_NUM];
+static int		hc_shards_num = 0;
+
+/* the selected history cache shard and its data */
+static zbx_hc_shard_t	*hc_shard = NULL;
+static zbx_hc_cache_t	*hc_cache = NULL;
+
+/* the shard synced first by the current process, -1 for other than history syncer processes */
+static int		hc_syncer_shard = -1;
+
 /* local history cache */
 #define ZBX_MAX_VALUES_LOCAL	256
 #define ZBX_STRUCT_REALLOC_STEP	8
@@ -158,16 +208,216 @@ static size_t		string_values_alloc = 0, string_values_offset = 0;
 static dc_item_value_t	*item_values = NULL;
 static size_t		item_values_alloc = 0, item_values_num = 0;
 
-static void	hc_add_item_values(dc_item_value_t *values, int values_num);
-static void	hc_pop_items(zbx_vector_ptr_t *history_items);
+/* history staging rings */
+
+/* the staging ring buffer size of history collecting processes */
+#define ZBX_HC_RING_SIZE		(256 * ZBX_KIBIBYTE)
+/* the staging ring buffer size of preprocessing manager, the main history collecting process */
+#define ZBX_HC_RING_SIZE_PREPROCMAN	(16 * ZBX_HC_RING_SIZE)
+/* the minimum staging ring buffer size, smaller rings are not created */
+#define ZBX_HC_RING_SIZE_MIN		(16 * ZBX_KIBIBYTE)
+/* the maximum part of history cache taken by staging rings */
+#define ZBX_HC_RINGS_SIZE_MAX		(CONFIG_HISTORY_CACHE_SIZE / 4)
+
+#define ZBX_HC_RING_ALIGN(size)		(((size) + 7) & ~(zbx_uint64_t)7)
+
+#if defined(__GNUC__)
+#	define ZBX_HC_RING_BARRIER()	__sync_synchronize()
+#else
+#	define ZBX_HC_RING_BARRIER()	/* staging rings are not used without memory barrier support */
+#endif
+
+/* The staging ring record - a batch of item values flushed by dc_flush_history().    */
+/* The record header is followed by item value array and the value string buffer.    */
+/* Records with zero values are used to mark the unused space before ring wraparound. */
+typedef struct
+{
+	zbx_uint64_t	size;
+	int		values_num;
+	int		values_done;	/* the number of values already moved to history cache */
+	zbx_hc_data_t	*data;		/* the partially cloned value when history cache shard is full */
+	int		data_shard;	/* the shard of partially cloned value */
+}
+zbx_hc_ring_record_t;
+
+/* The single producer/single consumer ring buffer of a history collecting process. */
+/* The owner process writes records and advances head without locking while the     */
+/* records are moved to history cache and tail is advanced under history cache lock. */
+typedef struct
+{
+	volatile zbx_uint64_t	head;
+	volatile zbx_uint64_t	tail;
+	zbx_uint64_t		size;
+	char			*buffer;
+	int			process_num;
+	unsigned char		process_type;
+}
+zbx_hc_ring_t;
+
+static zbx_hc_ring_t	*hc_rings = NULL;
+static int		hc_rings_num = 0;
+/* the history cache memory taken by staging rings */
+static zbx_uint64_t	hc_rings_size = 0;
+
+/* the staging ring of the current process, see dc_attach_history_cache() */
+static zbx_hc_ring_t	*hc_ring = NULL;
+
+/* history cache overflow */
+
+/* the overflow segment file size */
+#define ZBX_HC_OVERFLOW_SEGMENT_SIZE	(16 * ZBX_MEBIBYTE)
+/* the overflow segment file name prefix, followed by shard index and segment number */
+#define ZBX_HC_OVERFLOW_FILE_PREFIX	"zabbix_history_overflow_"
+
+/* The overflow record - an item value spilled to overflow segment file when history */
+/* cache shard is full. The record header is followed by the value string buffer.    */
+/* The unused space at the end of segment is zero filled, so records with zero size  */
+/* mark the end of segment.                                                          */
+typedef struct
+{
+	zbx_uint64_t	size;
+	dc_item_value_t	value;
+}
+zbx_hc_overflow_record_t;
+
+/* the memory-mapped overflow segment of the current process */
+typedef struct
+{
+	char	*data;
+	int	segment;
+}
+zbx_hc_overflow_map_t;
+
+static zbx_hc_overflow_map_t	hc_overflow_write_maps[ZBX_MUTEX_HISTORY_CACHE_NUM];
+static zbx_hc_overflow_map_t	hc_overflow_read_maps[ZBX_MUTEX_HISTORY_CACHE_NUM];
+
+/* the maximum number of overflow segments per shard */
+static int	hc_overflow_segments_max = 0;
+
+static void	hc_add_item_values(dc_item_value_t *values, int values_num, const char *strings);
+static int	hc_ring_write(zbx_hc_ring_t *ring, const dc_item_value_t *values, int values_num, const char *strings,
+		size_t strings_len);
+static int	hc_ring_read(zbx_hc_ring_t *ring);
+static void	hc_rings_read(void);
+static int	hc_rings_empty(void);
+static int	hc_pop_items(zbx_vector_ptr_t *history_items);
 static void	hc_get_item_values(ZBX_DC_HISTORY *history, zbx_vector_ptr_t *history_items);
 static void	hc_push_items(zbx_vector_ptr_t *history_items);
 static void	hc_free_item_values(ZBX_DC_HISTORY *history, int history_num);
 static void	hc_queue_item(zbx_hc_item_t *item);
 static int	hc_queue_elem_compare_func(const void *d1, const void *d2);
 static int	hc_queue_get_size(void);
+static int	hc_queues_empty(void);
 static int	hc_get_history_compression_age(void);
 
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_select_shard                                                  *
+ *                                                                            *
+ * Purpose: selects history cache shard                                       *
+ *                                                                            *
+ * Parameters: index - [IN] the shard index                                   *
+ *                                                                            *
+ * Comments: The shard must be selected before locking it with LOCK_SHARD.    *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_select_shard(int index)
+{
+	hc_shard = &hc_shards[index];
+	hc_cache = hc_shard->cache;
+	hc_mem = hc_shard->mem;
+	hc_index_mem = hc_shard->index_mem;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_item_shard                                                *
+ *                                                                            *
+ * Purpose: returns index of the history cache shard storing item values      *
+ *                                                                            *
+ * Parameters: itemid - [IN] the item identifier                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_item_shard(zbx_uint64_t itemid)
+{
+	return ZBX_DEFAULT_UINT64_HASH_FUNC(&itemid) % hc_shards_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_history_num                                               *
+ *                                                                            *
+ * Purpose: returns the number of values in all history cache shards,         *
+ *          including the values spilled to overflow files                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_get_history_num(void)
+{
+	int	i, history_num = 0;
+
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		hc_select_shard(i);
+
+		LOCK_SHARD;
+		history_num += hc_cache->history_num + hc_cache->overflow_num;
+		UNLOCK_SHARD;
+	}
+
+	return history_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_get_stats                                                     *
+ *                                                                            *
+ * Purpose: retrieves statistics summed over all history cache shards         *
+ *                                                                            *
+ * Parameters: stats         - [OUT] the history cache statistics             *
+ *             history_free  - [OUT] the free history cache size              *
+ *             history_total - [OUT] the total history cache size             *
+ *             index_free    - [OUT] the free history index cache size        *
+ *             index_total   - [OUT] the total history index cache size       *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_get_stats(ZBX_DC_STATS *stats, zbx_uint64_t *history_free, zbx_uint64_t *history_total,
+		zbx_uint64_t *index_free, zbx_uint64_t *index_total)
+{
+	int	i;
+
+	memset(stats, 0, sizeof(ZBX_DC_STATS));
+	*history_free = *history_total = *index_free = *index_total = 0;
+
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		hc_select_shard(i);
+
+		LOCK_SHARD;
+
+		stats->history_counter += hc_cache->stats.history_counter;
+		stats->history_float_counter += hc_cache->stats.history_float_counter;
+		stats->history_uint_counter += hc_cache->stats.history_uint_counter;
+		stats->history_str_counter += hc_cache->stats.history_str_counter;
+		stats->history_log_counter += hc_cache->stats.history_log_counter;
+		stats->history_text_counter += hc_cache->stats.history_text_counter;
+		stats->notsupported_counter += hc_cache->stats.notsupported_counter;
+
+		*history_free += hc_mem->free_size;
+		*history_total += hc_mem->total_size;
+		*index_free += hc_index_mem->free_size;
+		*index_total += hc_index_mem->total_size;
+
+		UNLOCK_SHARD;
+	}
+
+	/* staging rings are part of history cache, their free space is read without locking */
+	for (i = 0; i < hc_rings_num; i++)
+	{
+		*history_free += hc_rings[i].size - (hc_rings[i].head - hc_rings[i].tail);
+		*history_total += hc_rings[i].size;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: DCget_stats_all                                                  *
@@ -179,21 +429,18 @@ static int	hc_get_history_compression_age(void);
  ******************************************************************************/
 void	DCget_stats_all(zbx_wcache_info_t *wcache_info)
 {
-	LOCK_CACHE;
-
-	wcache_info->stats = cache->stats;
-	wcache_info->history_free = hc_mem->free_size;
-	wcache_info->history_total = hc_mem->total_size;
-	wcache_info->index_free = hc_index_mem->free_size;
-	wcache_info->index_total = hc_index_mem->total_size;
+	hc_get_stats(&wcache_info->stats, &wcache_info->history_free, &wcache_info->history_total,
+			&wcache_info->index_free, &wcache_info->index_total);
 
 	if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
 	{
+		LOCK_TRENDS;
+
 		wcache_info->trend_free = trend_mem->free_size;
 		wcache_info->trend_total = trend_mem->orig_size;
-	}
 
-	UNLOCK_CACHE;
+		UNLOCK_TRENDS;
+	}
 }
 
 /******************************************************************************
@@ -210,57 +457,61 @@ void	*DCget_stats(int request)
 	static zbx_uint64_t	value_uint;
 	static double		value_double;
 	void			*ret;
+	ZBX_DC_STATS		stats;
+	zbx_uint64_t		history_free, history_total, index_free, index_total;
 
-	LOCK_CACHE;
+	hc_get_stats(&stats, &history_free, &history_total, &index_free, &index_total);
+
+	LOCK_TRENDS;
 
 	switch (request)
 	{
 		case ZBX_STATS_HISTORY_COUNTER:
-			value_uint = cache->stats.history_counter;
+			value_uint = stats.history_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FLOAT_COUNTER:
-			value_uint = cache->stats.history_float_counter;
+			value_uint = stats.history_float_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_UINT_COUNTER:
-			value_uint = cache->stats.history_uint_counter;
+			value_uint = stats.history_uint_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_STR_COUNTER:
-			value_uint = cache->stats.history_str_counter;
+			value_uint = stats.history_str_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_LOG_COUNTER:
-			value_uint = cache->stats.history_log_counter;
+			value_uint = stats.history_log_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TEXT_COUNTER:
-			value_uint = cache->stats.history_text_counter;
+			value_uint = stats.history_text_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_NOTSUPPORTED_COUNTER:
-			value_uint = cache->stats.notsupported_counter;
+			value_uint = stats.notsupported_counter;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_TOTAL:
-			value_uint = hc_mem->total_size;
+			value_uint = history_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_USED:
-			value_uint = hc_mem->total_size - hc_mem->free_size;
+			value_uint = history_total - history_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_FREE:
-			value_uint = hc_mem->free_size;
+			value_uint = history_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_PUSED:
-			value_double = 100 * (double)(hc_mem->total_size - hc_mem->free_size) / hc_mem->total_size;
+			value_double = 100 * (double)(history_total - history_free) / history_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_PFREE:
-			value_double = 100 * (double)hc_mem->free_size / hc_mem->total_size;
+			value_double = 100 * (double)history_free / history_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_TREND_TOTAL:
@@ -285,31 +536,30 @@ void	*DCget_stats(int request)
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_TOTAL:
-			value_uint = hc_index_mem->total_size;
+			value_uint = index_total;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_USED:
-			value_uint = hc_index_mem->total_size - hc_index_mem->free_size;
+			value_uint = index_total - index_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_FREE:
-			value_uint = hc_index_mem->free_size;
+			value_uint = index_free;
 			ret = (void *)&value_uint;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PUSED:
-			value_double = 100 * (double)(hc_index_mem->total_size - hc_index_mem->free_size) /
-					hc_index_mem->total_size;
+			value_double = 100 * (double)(index_total - index_free) / index_total;
 			ret = (void *)&value_double;
 			break;
 		case ZBX_STATS_HISTORY_INDEX_PFREE:
-			value_double = 100 * (double)hc_index_mem->free_size / hc_index_mem->total_size;
+			value_double = 100 * (double)index_free / index_total;
 			ret = (void *)&value_double;
 			break;
 		default:
 			ret = NULL;
 	}
 
-	UNLOCK_CACHE;
+	UNLOCK_TRENDS;
 
 	return ret;
 }
@@ -2728,7 +2978,7 @@ static void	DCmodule_sync_history(int history_float_num, int history_integer_num
 
 static void	sync_proxy_history(int *total_num, int *more)
 {
-	int			history_num;
+	int			history_num, shard;
 	time_t			sync_start;
 	zbx_vector_ptr_t	history_items;
 	ZBX_DC_HISTORY		history[ZBX_HC_SYNC_MAX];
@@ -2742,13 +2992,11 @@ static void	sync_proxy_history(int *total_num, int *more)
 	{
 		*more = ZBX_SYNC_DONE;
 
-		LOCK_CACHE;
+		hc_rings_read();			/* move staged values to history cache */
 
-		hc_pop_items(&history_items);		/* select and take items out of history cache */
+		shard = hc_pop_items(&history_items);	/* select and take items out of history cache */
 		history_num = history_items.values_num;
 
-		UNLOCK_CACHE;
-
 		if (0 == history_num)
 			break;
 
@@ -2763,15 +3011,17 @@ static void	sync_proxy_history(int *total_num, int *more)
 		}
 		while (ZBX_DB_DOWN == DBcommit());
 
-		LOCK_CACHE;
+		hc_select_shard(shard);
+
+		LOCK_SHARD;
 
 		hc_push_items(&history_items);	/* return items to history cache */
-		cache->history_num -= history_num;
+		hc_cache->history_num -= history_num;
 
-		if (0 != hc_queue_get_size())
+		if (0 != hc_queue_get_size() || 0 != hc_cache->overflow_num || SUCCEED != hc_rings_empty())
 			*more = ZBX_SYNC_MORE;
 
-		UNLOCK_CACHE;
+		UNLOCK_SHARD;
 
 		*total_num += history_num;
 
@@ -2819,7 +3069,7 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 	static ZBX_HISTORY_TEXT		*history_text;
 	static ZBX_HISTORY_LOG		*history_log;
 	int				i, history_num, history_float_num, history_integer_num, history_string_num,
-					history_text_num, history_log_num, txn_error, compression_age;
+					history_text_num, history_log_num, txn_error, compression_age, shard;
 	time_t				sync_start;
 	zbx_vector_uint64_t		triggerids, timer_triggerids;
 	zbx_vector_ptr_t		history_items, trigger_diff, item_diff, inventory_values;
@@ -2884,17 +3134,18 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 		*more = ZBX_SYNC_DONE;
 
-		LOCK_CACHE;
-		hc_pop_items(&history_items);		/* select and take items out of history cache */
-		UNLOCK_CACHE;
+		hc_rings_read();			/* move staged values to history cache */
+		shard = hc_pop_items(&history_items);	/* select and take items out of history cache */
 
 		if (0 != history_items.values_num)
 		{
 			if (0 == (history_num = DCconfig_lock_triggers_by_history_items(&history_items, &triggerids)))
 			{
-				LOCK_CACHE;
+				hc_select_shard(shard);
+
+				LOCK_SHARD;
 				hc_push_items(&history_items);
-				UNLOCK_CACHE;
+				UNLOCK_SHARD;
 				zbx_vector_ptr_clear(&history_items);
 			}
 		}
@@ -3009,11 +3260,13 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 		if (0 != history_num)
 		{
-			LOCK_CACHE;
+			hc_select_shard(shard);
+
+			LOCK_SHARD;
 			hc_push_items(&history_items);	/* return items to history cache */
-			cache->history_num -= history_num;
+			hc_cache->history_num -= history_num;
 
-			if (0 != hc_queue_get_size())
+			if (0 != hc_queue_get_size() || 0 != hc_cache->overflow_num || SUCCEED != hc_rings_empty())
 			{
 				/* Continue sync if enough of sync candidates were processed       */
 				/* (meaning most of sync candidates are not locked by triggers).   */
@@ -3024,7 +3277,7 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 					*more = ZBX_SYNC_MORE;
 			}
 
-			UNLOCK_CACHE;
+			UNLOCK_SHARD;
 
 			*values_num += history_num;
 		}
@@ -3100,16 +3353,16 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
  ******************************************************************************/
 static void	sync_history_cache_full(void)
 {
-	int			values_num = 0, triggers_num = 0, more;
+	int			values_num = 0, triggers_num = 0, more, i;
 	zbx_hashset_iter_t	iter;
 	zbx_hc_item_t		*item;
-	zbx_binary_heap_t	tmp_history_queue;
+	zbx_binary_heap_t	tmp_history_queues[ZBX_MUTEX_HISTORY_CACHE_NUM];
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, hc_get_history_num());
 
 	/* History index cache might be full without any space left for queueing items from history index to  */
-	/* history queue. The solution: replace the shared-memory history queue with heap-allocated one. Add  */
-	/* all items from history index to the new history queue.                                             */
+	/* history queue. The solution: replace the shared-memory history queues with heap-allocated ones.    */
+	/* Add all items from history index to the new history queues.                                       */
 	/*                                                                                                    */
 	/* Assertions that must be true.                                                                      */
 	/*   * This is the main server or proxy process,                                                      */
@@ -3127,22 +3380,28 @@ static void	sync_history_cache_full(void)
 		zbx_dc_clear_timer_queue();
 	}
 
-	tmp_history_queue = cache->history_queue;
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		hc_select_shard(i);
 
-	zbx_binary_heap_create(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY);
-	zbx_hashset_iter_reset(&cache->history_items, &iter);
+		tmp_history_queues[i] = hc_cache->history_queue;
 
-	/* add all items from history index to the new history queue */
-	while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
-	{
-		if (NULL != item->tail)
+		zbx_binary_heap_create(&hc_cache->history_queue, hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY);
+		zbx_hashset_iter_reset(&hc_cache->history_items, &iter);
+
+		/* add all items from history index to the new history queue */
+		while (NULL != (item = (zbx_hc_item_t *)zbx_hashset_iter_next(&iter)))
 		{
-			item->status = ZBX_HC_ITEM_STATUS_NORMAL;
-			hc_queue_item(item);
+			if (NULL != item->tail)
+			{
+				item->status = ZBX_HC_ITEM_STATUS_NORMAL;
+				hc_queue_item(item);
+			}
 		}
 	}
 
-	if (0 != hc_queue_get_size())
+	if (SUCCEED != hc_queues_empty() || SUCCEED != hc_rings_empty())
 	{
 		zabbix_log(LOG_LEVEL_WARNING, "syncing history data...");
 
@@ -3154,15 +3413,20 @@ static void	sync_history_cache_full(void)
 				sync_proxy_history(&values_num, &more);
 
 			zabbix_log(LOG_LEVEL_WARNING, "syncing history data... " ZBX_FS_DBL "%%",
-					(double)values_num / (cache->history_num + values_num) * 100);
+					(double)values_num / (hc_get_history_num() + values_num) * 100);
 		}
-		while (0 != hc_queue_get_size());
+		while (SUCCEED != hc_queues_empty() || SUCCEED != hc_rings_empty());
 
 		zabbix_log(LOG_LEVEL_WARNING, "syncing history data done");
 	}
 
-	zbx_binary_heap_destroy(&cache->history_queue);
-	cache->history_queue = tmp_history_queue;
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		hc_select_shard(i);
+
+		zbx_binary_heap_destroy(&hc_cache->history_queue);
+		hc_cache->history_queue = tmp_history_queues[i];
+	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
@@ -3177,7 +3441,7 @@ static void	sync_history_cache_full(void)
 void	zbx_log_sync_history_cache_progress(void)
 {
 	double		pcnt = -1.0;
-	int		ts_last, ts_next, sec;
+	int		ts_last, ts_next, sec, history_num;
 
 	LOCK_CACHE;
 
@@ -3189,19 +3453,20 @@ void	zbx_log_sync_history_cache_progress(void)
 
 	ts_last = cache->history_progress_ts;
 	sec = time(NULL);
+	history_num = hc_get_history_num();
 
 	if (0 == cache->history_progress_ts)
 	{
-		cache->history_num_total = cache->history_num;
+		cache->history_num_total = history_num;
 		cache->history_progress_ts = sec;
 	}
 
-	if (ZBX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == cache->history_num)
+	if (ZBX_HC_SYNC_TIME_MAX <= sec - cache->history_progress_ts || 0 == history_num)
 	{
 		if (0 != cache->history_num_total)
-			pcnt = 100 * (double)(cache->history_num_total - cache->history_num) / cache->history_num_total;
+			pcnt = 100 * (double)(cache->history_num_total - history_num) / cache->history_num_total;
 
-		cache->history_progress_ts = (0 == cache->history_num ? INT_MAX : sec);
+		cache->history_progress_ts = (0 == history_num ? INT_MAX : sec);
 	}
 
 	ts_next = cache->history_progress_ts;
@@ -3232,7 +3497,7 @@ void	zbx_log_sync_history_cache_progress(void)
  ******************************************************************************/
 void	zbx_sync_history_cache(int *values_num, int *triggers_num, int *more)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() history_num:%d", __func__, cache->history_num);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	*values_num = 0;
 	*triggers_num = 0;
@@ -3590,18 +3855,79 @@ void	dc_add_history(zbx_uint64_t itemid, unsigned char item_value_type, unsigned
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_attach_history_cache                                          *
+ *                                                                            *
+ * Purpose: attaches the current process to its history staging ring and     *
+ *          history cache shard                                               *
+ *                                                                            *
+ * Parameters: proc_type - [IN] the process type; ZBX_PROCESS_TYPE_*          *
+ *             proc_num  - [IN] the process number                            *
+ *                                                                            *
+ * Comments: The processes without staging ring add the flushed values        *
+ *           directly to history cache.                                       *
+ *           History syncers take values from their own shards first and      *
+ *           from the other shards only when their own shards are empty.      *
+ *                                                                            *
+ ******************************************************************************/
+void	dc_attach_history_cache(unsigned char proc_type, int proc_num)
+{
+	int	i;
+
+	for (i = 0; i < hc_rings_num; i++)
+	{
+		if (hc_rings[i].process_type == proc_type && hc_rings[i].process_num == proc_num)
+		{
+			hc_ring = &hc_rings[i];
+			break;
+		}
+	}
+
+	if (ZBX_PROCESS_TYPE_HISTSYNCER == proc_type && 0 != hc_shards_num)
+		hc_syncer_shard = (proc_num - 1) % hc_shards_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_flush_history                                                 *
+ *                                                                            *
+ * Purpose: moves the locally collected item values to history cache          *
+ *                                                                            *
+ * Comments: The values are written to the staging ring of the current        *
+ *           process without locking history cache. If the process has no     *
+ *           staging ring or there is not enough space in it, the staged      *
+ *           values are moved to history cache before the local values to     *
+ *           keep the item value order.                                       *
+ *                                                                            *
+ ******************************************************************************/
 void	dc_flush_history(void)
 {
 	if (0 == item_values_num)
 		return;
 
-	LOCK_CACHE;
+	if (NULL == hc_ring || SUCCEED != hc_ring_write(hc_ring, item_values, item_values_num, string_values,
+			string_values_offset))
+	{
+		if (NULL != hc_ring)
+		{
+			LOCK_CACHE;
+
+			while (SUCCEED != hc_ring_read(hc_ring))
+			{
+				UNLOCK_CACHE;
 
-	hc_add_item_values(item_values, item_values_num);
+				zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
+				sleep(1);
+
+				LOCK_CACHE;
+			}
 
-	cache->history_num += item_values_num;
+			UNLOCK_CACHE;
+		}
 
-	UNLOCK_CACHE;
+		hc_add_item_values(item_values, item_values_num, string_values);
+	}
 
 	item_values_num = 0;
 	string_values_offset = 0;
@@ -3687,7 +4013,7 @@ static void	hc_queue_item(zbx_hc_item_t *item)
 {
 	zbx_binary_heap_elem_t	elem = {item->itemid, (const void *)item};
 
-	zbx_binary_heap_insert(&cache->history_queue, &elem);
+	zbx_binary_heap_insert(&hc_cache->history_queue, &elem);
 }
 
 /******************************************************************************
@@ -3704,7 +4030,7 @@ static void	hc_queue_item(zbx_hc_item_t *item)
  ******************************************************************************/
 static zbx_hc_item_t	*hc_get_item(zbx_uint64_t itemid)
 {
-	return (zbx_hc_item_t *)zbx_hashset_search(&cache->history_items, &itemid);
+	return (zbx_hc_item_t *)zbx_hashset_search(&hc_cache->history_items, &itemid);
 }
 
 /******************************************************************************
@@ -3723,7 +4049,7 @@ static zbx_hc_item_t	*hc_add_item(zbx_uint64_t itemid, zbx_hc_data_t *data)
 {
 	zbx_hc_item_t	item_local = {itemid, ZBX_HC_ITEM_STATUS_NORMAL, data, data};
 
-	return (zbx_hc_item_t *)zbx_hashset_insert(&cache->history_items, &item_local, sizeof(item_local));
+	return (zbx_hc_item_t *)zbx_hashset_insert(&hc_cache->history_items, &item_local, sizeof(item_local));
 }
 
 /******************************************************************************
@@ -3732,19 +4058,20 @@ static zbx_hc_item_t	*hc_add_item(zbx_uint64_t itemid, zbx_hc_data_t *data)
  *                                                                            *
  * Purpose: copies string value to history cache                              *
  *                                                                            *
- * Parameters: str - [IN] the string value                                    *
+ * Parameters: str     - [IN] the string value                                *
+ *             strings - [IN] the string buffer of the value                  *
  *                                                                            *
  * Return value: the copied string or NULL if there was not enough memory     *
  *                                                                            *
  ******************************************************************************/
-static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
+static char	*hc_mem_value_str_dup(const dc_value_str_t *str, const char *strings)
 {
 	char	*ptr;
 
 	if (NULL == (ptr = (char *)__hc_mem_malloc_func(NULL, str->len)))
 		return NULL;
 
-	memcpy(ptr, &string_values[str->pvalue], str->len - 1);
+	memcpy(ptr, &strings[str->pvalue], str->len - 1);
 	ptr[str->len - 1] = '\0';
 
 	return ptr;
@@ -3756,8 +4083,9 @@ static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
  *                                                                            *
  * Purpose: clones string value into history data memory                      *
  *                                                                            *
- * Parameters: dst - [IN/OUT] a reference to the cloned value                 *
- *             str - [IN] the string value to clone                           *
+ * Parameters: dst     - [IN/OUT] a reference to the cloned value             *
+ *             str     - [IN] the string value to clone                       *
+ *             strings - [IN] the string buffer of the value                  *
  *                                                                            *
  * Return value: SUCCESS - either there was no need to clone the string       *
  *                         (it was empty or already cloned) or the string was *
@@ -3768,7 +4096,7 @@ static char	*hc_mem_value_str_dup(const dc_value_str_t *str)
  *           until it finishes cloning string value.                          *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
+static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str, const char *strings)
 {
 	if (0 == str->len)
 		return SUCCEED;
@@ -3776,7 +4104,7 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
 	if (NULL != *dst)
 		return SUCCEED;
 
-	if (NULL != (*dst = hc_mem_value_str_dup(str)))
+	if (NULL != (*dst = hc_mem_value_str_dup(str, strings)))
 		return SUCCEED;
 
 	return FAIL;
@@ -3790,6 +4118,7 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
  *                                                                            *
  * Parameters: dst        - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the log value to clone                       *
+ *             strings    - [IN] the string buffer of the value               *
  *                                                                            *
  * Return value: SUCCESS - the log value was cloned successfully              *
  *               FAIL    - not enough memory                                  *
@@ -3798,7 +4127,8 @@ static int	hc_clone_history_str_data(char **dst, const dc_value_str_t *str)
  *           until it finishes cloning log value.                             *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_t *item_value)
+static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_t *item_value,
+		const char *strings)
 {
 	if (NULL == *dst)
 	{
@@ -3809,10 +4139,10 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
 		memset(*dst, 0, sizeof(zbx_log_value_t));
 	}
 
-	if (SUCCEED != hc_clone_history_str_data(&(*dst)->value, &item_value->value.value_str))
+	if (SUCCEED != hc_clone_history_str_data(&(*dst)->value, &item_value->value.value_str, strings))
 		return FAIL;
 
-	if (SUCCEED != hc_clone_history_str_data(&(*dst)->source, &item_value->source))
+	if (SUCCEED != hc_clone_history_str_data(&(*dst)->source, &item_value->source, strings))
 		return FAIL;
 
 	(*dst)->logeventid = item_value->logeventid;
@@ -3830,6 +4160,7 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *                                                                            *
  * Parameters: data       - [IN/OUT] a reference to the cloned value          *
  *             item_value - [IN] the item value                               *
+ *             strings    - [IN] the string buffer of the value               *
  *                                                                            *
  * Return value: SUCCESS - the item value was cloned successfully             *
  *               FAIL    - not enough memory                                  *
@@ -3838,7 +4169,7 @@ static int	hc_clone_history_log_data(zbx_log_value_t **dst, const dc_item_value_
  *           until it finishes cloning item value.                            *
  *                                                                            *
  ******************************************************************************/
-static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *item_value)
+static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *item_value, const char *strings)
 {
 	if (NULL == *data)
 	{
@@ -3860,24 +4191,24 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 	if (ITEM_STATE_NOTSUPPORTED == item_value->state)
 	{
-		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str)))
+		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str, strings)))
 			return FAIL;
 
 		(*data)->value_type = item_value->value_type;
-		cache->stats.notsupported_counter++;
+		hc_cache->stats.notsupported_counter++;
 
 		return SUCCEED;
 	}
 
 	if (0 != (ZBX_DC_FLAG_LLD & item_value->flags))
 	{
-		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str)))
+		if (NULL == ((*data)->value.str = hc_mem_value_str_dup(&item_value->value.value_str, strings)))
 			return FAIL;
 
 		(*data)->value_type = ITEM_VALUE_TYPE_TEXT;
 
-		cache->stats.history_text_counter++;
-		cache->stats.history_counter++;
+		hc_cache->stats.history_text_counter++;
+		hc_cache->stats.history_counter++;
 
 		return SUCCEED;
 	}
@@ -3894,20 +4225,20 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 				break;
 			case ITEM_VALUE_TYPE_STR:
 				if (SUCCEED != hc_clone_history_str_data(&(*data)->value.str,
-						&item_value->value.value_str))
+						&item_value->value.value_str, strings))
 				{
 					return FAIL;
 				}
 				break;
 			case ITEM_VALUE_TYPE_TEXT:
 				if (SUCCEED != hc_clone_history_str_data(&(*data)->value.str,
-						&item_value->value.value_str))
+						&item_value->value.value_str, strings))
 				{
 					return FAIL;
 				}
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				if (SUCCEED != hc_clone_history_log_data(&(*data)->value.log, item_value))
+				if (SUCCEED != hc_clone_history_log_data(&(*data)->value.log, item_value, strings))
 					return FAIL;
 				break;
 		}
@@ -3915,23 +4246,23 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 		switch (item_value->item_value_type)
 		{
 			case ITEM_VALUE_TYPE_FLOAT:
-				cache->stats.history_float_counter++;
+				hc_cache->stats.history_float_counter++;
 				break;
 			case ITEM_VALUE_TYPE_UINT64:
-				cache->stats.history_uint_counter++;
+				hc_cache->stats.history_uint_counter++;
 				break;
 			case ITEM_VALUE_TYPE_STR:
-				cache->stats.history_str_counter++;
+				hc_cache->stats.history_str_counter++;
 				break;
 			case ITEM_VALUE_TYPE_TEXT:
-				cache->stats.history_text_counter++;
+				hc_cache->stats.history_text_counter++;
 				break;
 			case ITEM_VALUE_TYPE_LOG:
-				cache->stats.history_log_counter++;
+				hc_cache->stats.history_log_counter++;
 				break;
 		}
 
-		cache->stats.history_counter++;
+		hc_cache->stats.history_counter++;
 	}
 
 	(*data)->value_type = item_value->value_type;
@@ -3941,92 +4272,790 @@ static int	hc_clone_history_data(zbx_hc_data_t **data, const dc_item_value_t *it
 
 /******************************************************************************
  *                                                                            *
- * Function: hc_add_item_values                                               *
+ * Function: hc_add_item_value                                                *
  *                                                                            *
- * Purpose: adds item values to the history cache                             *
+ * Purpose: adds item value to the history cache                              *
  *                                                                            *
- * Parameters: values     - [IN] the item values to add                       *
- *             values_num - [IN] the number of item values to add             *
+ * Parameters: item_value - [IN] the item value to add                        *
+ *             strings    - [IN] the string buffer of the value               *
+ *             data       - [IN/OUT] a reference to the cloned value          *
  *                                                                            *
- * Comments: If the history cache is full this function will wait until       *
- *           history syncers processes values freeing enough space to store   *
- *           the new value.                                                   *
+ * Return value: SUCCEED - the item value was added                           *
+ *               FAIL    - not enough memory                                  *
+ *                                                                            *
+ * Comments: This function can be called in loop with the same data value     *
+ *           until it finishes adding item value.                             *
  *                                                                            *
  ******************************************************************************/
-static void	hc_add_item_values(dc_item_value_t *values, int values_num)
+static int	hc_add_item_value(const dc_item_value_t *item_value, const char *strings, zbx_hc_data_t **data)
 {
-	dc_item_value_t	*item_value;
-	int		i;
 	zbx_hc_item_t	*item;
 
-	for (i = 0; i < values_num; i++)
+	if (SUCCEED != hc_clone_history_data(data, item_value, strings))
+		return FAIL;
+
+	if (NULL == (item = hc_get_item(item_value->itemid)))
+	{
+		item = hc_add_item(item_value->itemid, *data);
+		hc_queue_item(item);
+	}
+	else
 	{
-		zbx_hc_data_t	*data = NULL;
+		item->head->next = *data;
+		item->head = *data;
+	}
 
-		item_value = &values[i];
+	*data = NULL;
 
-		while (SUCCEED != hc_clone_history_data(&data, item_value))
-		{
-			UNLOCK_CACHE;
+	return SUCCEED;
+}
 
-			zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
-			sleep(1);
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_free_partial_data                                             *
+ *                                                                            *
+ * Purpose: frees partially cloned history item data                          *
+ *                                                                            *
+ * Parameters: data       - [IN] the partially cloned history data            *
+ *             item_value - [IN] the item value being cloned                  *
+ *                                                                            *
+ * Comments: Cloning fails only when allocating value strings, so the only    *
+ *           allocated value data can be log value structure and its strings. *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_free_partial_data(zbx_hc_data_t *data, const dc_item_value_t *item_value)
+{
+	if (ITEM_STATE_NOTSUPPORTED != item_value->state && ITEM_VALUE_TYPE_LOG == item_value->value_type &&
+			0 == (item_value->flags & (ZBX_DC_FLAG_LLD | ZBX_DC_FLAG_NOVALUE)) && NULL != data->value.log)
+	{
+		if (NULL != data->value.log->value)
+			__hc_mem_free_func(data->value.log->value);
 
-			LOCK_CACHE;
-		}
+		if (NULL != data->value.log->source)
+			__hc_mem_free_func(data->value.log->source);
 
-		if (NULL == (item = hc_get_item(item_value->itemid)))
-		{
-			item = hc_add_item(item_value->itemid, data);
-			hc_queue_item(item);
-		}
-		else
-		{
-			item->head->next = data;
-			item->head = data;
-		}
+		__hc_mem_free_func(data->value.log);
 	}
+
+	__hc_mem_free_func(data);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: hc_copy_history_data                                             *
- *                                                                            *
- * Purpose: copies item value from history cache into the specified history   *
- *          value                                                             *
+ * Function: hc_overflow_get_path                                             *
  *                                                                            *
- * Parameters: history - [OUT] the history value                              *
- *             itemid  - [IN] the item identifier                             *
- *             data    - [IN] the history data to copy                        *
+ * Purpose: gets overflow segment file path                                   *
  *                                                                            *
- * Comments: handling of uninitialized fields in dc_add_proxy_history_log()   *
+ * Parameters: shard   - [IN] the history cache shard index                   *
+ *             segment - [IN] the overflow segment number                     *
+ *             path    - [OUT] the segment file path                          *
+ *             size    - [IN] the path buffer size                            *
  *                                                                            *
  ******************************************************************************/
-static void	hc_copy_history_data(ZBX_DC_HISTORY *history, zbx_uint64_t itemid, zbx_hc_data_t *data)
+static void	hc_overflow_get_path(int shard, int segment, char *path, size_t size)
 {
-	history->itemid = itemid;
-	history->ts = data->ts;
-	history->state = data->state;
-	history->flags = data->flags;
-	history->lastlogsize = data->lastlogsize;
-	history->mtime = data->mtime;
+	zbx_snprintf(path, size, "%s/" ZBX_HC_OVERFLOW_FILE_PREFIX "%d_%d", CONFIG_HISTORY_CACHE_OVERFLOW_DIR, shard,
+			segment);
+}
 
-	if (ITEM_STATE_NOTSUPPORTED == data->state)
-	{
-		history->value.err = zbx_strdup(NULL, data->value.str);
-		history->flags |= ZBX_DC_FLAG_UNDEF;
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_overflow_unmap                                                *
+ *                                                                            *
+ * Purpose: unmaps overflow segment from the current process memory           *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_overflow_unmap(zbx_hc_overflow_map_t *map)
+{
+	if (NULL == map->data)
 		return;
-	}
-
-	history->value_type = data->value_type;
+#if defined(HAVE_SYS_MMAN_H)
+	munmap(map->data, ZBX_HC_OVERFLOW_SEGMENT_SIZE);
+#endif
+	map->data = NULL;
+}
 
-	if (0 == (ZBX_DC_FLAG_NOVALUE & data->flags))
-	{
-		switch (data->value_type)
-		{
-			case ITEM_VALUE_TYPE_FLOAT:
-				history->value.dbl = data->value.dbl;
-				break;
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_overflow_map                                                  *
+ *                                                                            *
+ * Purpose: maps overflow segment file into the current process memory        *
+ *                                                                            *
+ * Parameters: map     - [IN/OUT] the overflow segment mapping                *
+ *             shard   - [IN] the history cache shard index                   *
+ *             segment - [IN] the overflow segment number                     *
+ *             create  - [IN] 1 - create a new segment file                   *
+ *                            0 - map an existing segment file                *
+ *                                                                            *
+ * Return value: SUCCEED - the segment was mapped                             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The mapping is kept until another segment of the same shard is   *
+ *           mapped or the segment is removed, see hc_overflow_release(), so  *
+ *           sequential writes and reads do not remap segments.               *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_overflow_map(zbx_hc_overflow_map_t *map, int shard, int segment, int create)
+{
+#if defined(HAVE_SYS_MMAN_H)
+	char	path[MAX_STRING_LEN];
+	int	fd, flags = O_RDWR;
+	void	*data;
+
+	if (NULL != map->data && segment == map->segment)
+		return SUCCEED;
+
+	hc_overflow_unmap(map);
+	hc_overflow_get_path(shard, segment, path, sizeof(path));
+
+	if (0 != create)
+		flags |= O_CREAT | O_TRUNC;
+
+	if (-1 == (fd = open(path, flags, 0600)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot open history cache overflow file \"%s\": %s", path,
+				zbx_strerror(errno));
+		return FAIL;
+	}
+
+	/* the unused space of new segment is zero filled, marking the end of segment */
+	if (0 != create && 0 != ftruncate(fd, ZBX_HC_OVERFLOW_SEGMENT_SIZE))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot resize history cache overflow file \"%s\": %s", path,
+				zbx_strerror(errno));
+		close(fd);
+		return FAIL;
+	}
+
+	data = mmap(NULL, ZBX_HC_OVERFLOW_SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (MAP_FAILED == data)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot map history cache overflow file \"%s\": %s", path,
+				zbx_strerror(errno));
+		return FAIL;
+	}
+
+	map->data = (char *)data;
+	map->segment = segment;
+
+	return SUCCEED;
+#else
+	ZBX_UNUSED(map);
+	ZBX_UNUSED(shard);
+	ZBX_UNUSED(segment);
+	ZBX_UNUSED(create);
+
+	return FAIL;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_overflow_remove                                               *
+ *                                                                            *
+ * Purpose: removes overflow segment file                                     *
+ *                                                                            *
+ * Parameters: shard   - [IN] the history cache shard index                   *
+ *             segment - [IN] the overflow segment number                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_overflow_remove(int shard, int segment)
+{
+	char	path[MAX_STRING_LEN];
+
+	if (segment == hc_overflow_read_maps[shard].segment)
+		hc_overflow_unmap(&hc_overflow_read_maps[shard]);
+
+	if (segment == hc_overflow_write_maps[shard].segment)
+		hc_overflow_unmap(&hc_overflow_write_maps[shard]);
+
+	hc_overflow_get_path(shard, segment, path, sizeof(path));
+
+	if (0 != unlink(path) && ENOENT != errno)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot remove history cache overflow file \"%s\": %s", path,
+				zbx_strerror(errno));
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_overflow_release                                              *
+ *                                                                            *
+ * Purpose: unmaps overflow segments of the selected shard that were removed  *
+ *          by other processes                                                *
+ *                                                                            *
+ * Parameters: shard - [IN] the selected shard index                          *
+ *                                                                            *
+ * Comments: Segments are removed in order, so all segments below the shard   *
+ *           read segment are unlinked. Their mappings must be dropped by     *
+ *           every process, otherwise the disk space is not freed and the     *
+ *           overflow size limit does not hold.                               *
+ *           This function must be called with locked shard.                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_overflow_release(int shard)
+{
+	if (hc_overflow_read_maps[shard].segment < hc_cache->overflow_read_segment)
+		hc_overflow_unmap(&hc_overflow_read_maps[shard]);
+
+	if (hc_overflow_write_maps[shard].segment < hc_cache->overflow_read_segment)
+		hc_overflow_unmap(&hc_overflow_write_maps[shard]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_overflow_write                                                *
+ *                                                                            *
+ * Purpose: spills item value to overflow segment file of the selected shard  *
+ *                                                                            *
+ * Parameters: shard   - [IN] the selected shard index                        *
+ *             value   - [IN] the item value                                  *
+ *             strings - [IN] the string buffer of the value                  *
+ *                                                                            *
+ * Return value: SUCCEED - the value was written                              *
+ *               FAIL    - overflow directory is not configured, the overflow *
+ *                         size limit was reached or writing failed           *
+ *                                                                            *
+ * Comments: The values are appended to the last segment and a new segment is *
+ *           started when the last one is full, so the files are written      *
+ *           sequentially.                                                    *
+ *           This function must be called with locked shard.                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_overflow_write(int shard, const dc_item_value_t *value, const char *strings)
+{
+	const dc_value_str_t		*str = NULL, *source = NULL;
+	zbx_hc_overflow_record_t	*record;
+	zbx_uint64_t			size;
+	char				*ptr;
+
+	if (NULL == CONFIG_HISTORY_CACHE_OVERFLOW_DIR)
+		return FAIL;
+
+	if (ITEM_STATE_NOTSUPPORTED == value->state || 0 != (ZBX_DC_FLAG_LLD & value->flags))
+	{
+		str = &value->value.value_str;
+	}
+	else if (0 == (ZBX_DC_FLAG_NOVALUE & value->flags))
+	{
+		switch (value->value_type)
+		{
+			case ITEM_VALUE_TYPE_LOG:
+				source = &value->source;
+				ZBX_FALLTHROUGH;
+			case ITEM_VALUE_TYPE_STR:
+			case ITEM_VALUE_TYPE_TEXT:
+				str = &value->value.value_str;
+				break;
+		}
+	}
+
+	size = ZBX_HC_RING_ALIGN(sizeof(zbx_hc_overflow_record_t) + (NULL != str ? str->len : 0) +
+			(NULL != source ? source->len : 0));
+
+	if (ZBX_HC_OVERFLOW_SEGMENT_SIZE < size)
+		return FAIL;
+
+	if (ZBX_HC_OVERFLOW_SEGMENT_SIZE - hc_cache->overflow_write_offset < size)
+	{
+		if (hc_overflow_segments_max <= hc_cache->overflow_write_segment - hc_cache->overflow_read_segment + 1)
+			return FAIL;
+
+		hc_cache->overflow_write_segment++;
+		hc_cache->overflow_write_offset = 0;
+	}
+
+	if (SUCCEED != hc_overflow_map(&hc_overflow_write_maps[shard], shard, hc_cache->overflow_write_segment,
+			0 == hc_cache->overflow_write_offset))
+	{
+		return FAIL;
+	}
+
+	record = (zbx_hc_overflow_record_t *)(hc_overflow_write_maps[shard].data + hc_cache->overflow_write_offset);
+	record->value = *value;
+	ptr = (char *)(record + 1);
+
+	/* the value strings are rebased to the record string buffer */
+	if (NULL != str && 0 != str->len)
+	{
+		memcpy(ptr, strings + str->pvalue, str->len);
+		record->value.value.value_str.pvalue = (size_t)(ptr - (char *)(record + 1));
+		ptr += str->len;
+	}
+
+	if (NULL != source && 0 != source->len)
+	{
+		memcpy(ptr, strings + source->pvalue, source->len);
+		record->value.source.pvalue = (size_t)(ptr - (char *)(record + 1));
+	}
+
+	record->size = size;
+	hc_cache->overflow_write_offset += size;
+
+	if (0 == hc_cache->overflow_num++)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "history cache shard %d is full, writing item values to overflow files",
+				shard);
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_overflow_read                                                 *
+ *                                                                            *
+ * Purpose: moves item values from overflow segment files of the selected     *
+ *          shard back to history cache                                       *
+ *                                                                            *
+ * Parameters: shard - [IN] the selected shard index                          *
+ *                                                                            *
+ * Comments: The values are moved in the order they were written until the    *
+ *           shard is full. Segments are removed after all their values are   *
+ *           moved.                                                           *
+ *           This function must be called with locked shard.                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_overflow_read(int shard)
+{
+	zbx_hc_overflow_map_t		*map = &hc_overflow_read_maps[shard];
+	zbx_hc_overflow_record_t	*record;
+
+	while (0 != hc_cache->overflow_num)
+	{
+		if (SUCCEED != hc_overflow_map(map, shard, hc_cache->overflow_read_segment, 0))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot read history cache overflow, %d item values are lost",
+					hc_cache->overflow_num);
+
+			while (hc_cache->overflow_read_segment < hc_cache->overflow_write_segment)
+				hc_overflow_remove(shard, hc_cache->overflow_read_segment++);
+
+			hc_cache->overflow_num = 0;
+			break;
+		}
+
+		record = (zbx_hc_overflow_record_t *)(map->data + hc_cache->overflow_read_offset);
+
+		if (ZBX_HC_OVERFLOW_SEGMENT_SIZE - hc_cache->overflow_read_offset < sizeof(zbx_hc_overflow_record_t) ||
+				0 == record->size)
+		{
+			hc_overflow_remove(shard, hc_cache->overflow_read_segment++);
+			hc_cache->overflow_read_offset = 0;
+			continue;
+		}
+
+		if (SUCCEED != hc_add_item_value(&record->value, (const char *)(record + 1), &hc_cache->overflow_data))
+			return;
+
+		hc_cache->overflow_read_offset += record->size;
+		hc_cache->overflow_num--;
+		hc_cache->history_num++;
+	}
+
+	/* start the next overflow with a new segment */
+	hc_overflow_remove(shard, hc_cache->overflow_write_segment);
+
+	hc_cache->overflow_read_segment = ++hc_cache->overflow_write_segment;
+	hc_cache->overflow_read_offset = 0;
+	hc_cache->overflow_write_offset = 0;
+
+	zabbix_log(LOG_LEVEL_WARNING, "history cache shard %d overflow has been processed", shard);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: init_history_overflow                                            *
+ *                                                                            *
+ * Purpose: prepares overflow directory for history cache overflow files      *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the overflow directory was prepared or overflow    *
+ *                         is not configured                                  *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The overflow files left by previous run are removed as their     *
+ *           index was kept in the history cache shared memory.               *
+ *                                                                            *
+ ******************************************************************************/
+static int	init_history_overflow(char **error)
+{
+	DIR		*dir;
+	struct dirent	*entry;
+	char		path[MAX_STRING_LEN];
+	int		i;
+
+	if (NULL == CONFIG_HISTORY_CACHE_OVERFLOW_DIR)
+		return SUCCEED;
+
+#if !defined(HAVE_SYS_MMAN_H)
+	*error = zbx_strdup(*error, "history cache overflow files are not supported on this platform");
+	return FAIL;
+#endif
+	if (NULL == (dir = opendir(CONFIG_HISTORY_CACHE_OVERFLOW_DIR)))
+	{
+		*error = zbx_dsprintf(*error, "cannot open history cache overflow directory \"%s\": %s",
+				CONFIG_HISTORY_CACHE_OVERFLOW_DIR, zbx_strerror(errno));
+		return FAIL;
+	}
+
+	while (NULL != (entry = readdir(dir)))
+	{
+		if (0 != strncmp(entry->d_name, ZBX_HC_OVERFLOW_FILE_PREFIX, ZBX_CONST_STRLEN(ZBX_HC_OVERFLOW_FILE_PREFIX)))
+			continue;
+
+		zbx_snprintf(path, sizeof(path), "%s/%s", CONFIG_HISTORY_CACHE_OVERFLOW_DIR, entry->d_name);
+
+		if (0 != unlink(path))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot remove history cache overflow file \"%s\": %s", path,
+					zbx_strerror(errno));
+		}
+	}
+
+	closedir(dir);
+
+	hc_overflow_segments_max = (int)(CONFIG_HISTORY_CACHE_OVERFLOW_SIZE / ZBX_HC_OVERFLOW_SEGMENT_SIZE /
+			(zbx_uint64_t)hc_shards_num);
+
+	if (1 > hc_overflow_segments_max)
+		hc_overflow_segments_max = 1;
+
+	for (i = 0; i < hc_shards_num; i++)
+	{
+		hc_overflow_write_maps[i].segment = -1;
+		hc_overflow_read_maps[i].segment = -1;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_add_shard_item_values                                         *
+ *                                                                            *
+ * Purpose: adds item values stored in the selected shard to history cache    *
+ *                                                                            *
+ * Parameters: shard       - [IN] the selected shard index                    *
+ *             values      - [IN/OUT] the item values to add                  *
+ *             values_num  - [IN] the number of item values                   *
+ *             strings     - [IN] the string buffer of the values             *
+ *             data        - [IN/OUT] a reference to the cloned value         *
+ *             values_done - [IN/OUT] the number of added values              *
+ *                                                                            *
+ * Return value: SUCCEED - the item values were added                         *
+ *               FAIL    - not enough memory in the shard                     *
+ *                                                                            *
+ * Comments: The added values are marked by resetting their itemid, so this   *
+ *           function can be called in loop with the same data value until    *
+ *           it finishes adding item values.                                  *
+ *           If overflow directory is configured, the values not fitting into *
+ *           the shard are spilled to overflow files instead of failing.      *
+ *           This function must be called with locked shard.                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_add_shard_item_values(int shard, dc_item_value_t *values, int values_num, const char *strings,
+		zbx_hc_data_t **data, int *values_done)
+{
+	int	i;
+
+	hc_overflow_release(shard);
+
+	for (i = 0; i < values_num; i++)
+	{
+		if (0 == values[i].itemid || shard != hc_get_item_shard(values[i].itemid))
+			continue;
+
+		/* to keep the item value order all values are spilled while the shard has overflow values */
+		if (0 != hc_cache->overflow_num || SUCCEED != hc_add_item_value(&values[i], strings, data))
+		{
+			if (SUCCEED != hc_overflow_write(shard, &values[i], strings))
+				return FAIL;
+
+			if (NULL != *data)
+			{
+				hc_free_partial_data(*data, &values[i]);
+				*data = NULL;
+			}
+		}
+		else
+			hc_cache->history_num++;
+
+		values[i].itemid = 0;
+		(*values_done)++;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_add_item_values                                               *
+ *                                                                            *
+ * Purpose: adds item values to the history cache                             *
+ *                                                                            *
+ * Parameters: values     - [IN/OUT] the item values to add                   *
+ *             values_num - [IN] the number of item values to add             *
+ *             strings    - [IN] the string buffer of the values              *
+ *                                                                            *
+ * Comments: If the history cache is full this function will wait until       *
+ *           history syncers processes values freeing enough space to store   *
+ *           the new value.                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_add_item_values(dc_item_value_t *values, int values_num, const char *strings)
+{
+	int		shard, values_done = 0;
+	zbx_hc_data_t	*data = NULL;
+
+	for (shard = 0; shard < hc_shards_num && values_done < values_num; shard++)
+	{
+		hc_select_shard(shard);
+
+		LOCK_SHARD;
+
+		while (SUCCEED != hc_add_shard_item_values(shard, values, values_num, strings, &data, &values_done))
+		{
+			UNLOCK_SHARD;
+
+			zabbix_log(LOG_LEVEL_DEBUG, "History cache is full. Sleeping for 1 second.");
+			sleep(1);
+
+			LOCK_SHARD;
+		}
+
+		UNLOCK_SHARD;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_ring_write                                                    *
+ *                                                                            *
+ * Purpose: writes item values to the staging ring                            *
+ *                                                                            *
+ * Parameters: ring        - [IN] the staging ring of the current process     *
+ *             values      - [IN] the item values to write                    *
+ *             values_num  - [IN] the number of item values to write          *
+ *             strings     - [IN] the string buffer of the values             *
+ *             strings_len - [IN] the used size of string buffer              *
+ *                                                                            *
+ * Return value: SUCCEED - the values were written                            *
+ *               FAIL    - not enough space in the ring                       *
+ *                                                                            *
+ * Comments: This function must be called only by the ring owner process.     *
+ *           The ring is written without locking - the record is published    *
+ *           by advancing ring head after the record data is written.         *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_ring_write(zbx_hc_ring_t *ring, const dc_item_value_t *values, int values_num, const char *strings,
+		size_t strings_len)
+{
+	zbx_uint64_t		head, tail, size, offset, skip = 0;
+	zbx_hc_ring_record_t	*record;
+	char			*ptr;
+
+	size = ZBX_HC_RING_ALIGN(sizeof(zbx_hc_ring_record_t) + sizeof(dc_item_value_t) * (size_t)values_num +
+			strings_len);
+
+	head = ring->head;
+	tail = ring->tail;
+	ZBX_HC_RING_BARRIER();
+
+	/* records are not split at the end of buffer - the remaining space is skipped instead */
+	offset = head % ring->size;
+	if (ring->size - offset < size)
+		skip = ring->size - offset;
+
+	if (ring->size - (head - tail) < skip + size)
+		return FAIL;
+
+	if (sizeof(zbx_hc_ring_record_t) <= skip)
+	{
+		record = (zbx_hc_ring_record_t *)(ring->buffer + offset);
+		record->size = skip;
+		record->values_num = 0;
+		record->values_done = 0;
+	}
+
+	head += skip;
+
+	record = (zbx_hc_ring_record_t *)(ring->buffer + head % ring->size);
+	record->size = size;
+	record->values_num = values_num;
+	record->values_done = 0;
+	record->data = NULL;
+	record->data_shard = 0;
+
+	ptr = (char *)(record + 1);
+	memcpy(ptr, values, sizeof(dc_item_value_t) * (size_t)values_num);
+
+	if (0 != strings_len)
+		memcpy(ptr + sizeof(dc_item_value_t) * (size_t)values_num, strings, strings_len);
+
+	ZBX_HC_RING_BARRIER();
+	ring->head = head + size;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_ring_read                                                     *
+ *                                                                            *
+ * Purpose: moves item values from staging ring to history cache              *
+ *                                                                            *
+ * Parameters: ring - [IN] the staging ring                                   *
+ *                                                                            *
+ * Return value: SUCCEED - all published values were moved to history cache   *
+ *               FAIL    - history cache shard is full                        *
+ *                                                                            *
+ * Comments: This function must be called with locked cache, so there is      *
+ *           only one ring reader at a time.                                  *
+ *           Record values are moved shard by shard, starting with the shard  *
+ *           of partially cloned value. When a shard is full the rest of      *
+ *           values are kept in ring and are moved to history cache by the    *
+ *           following calls.                                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_ring_read(zbx_hc_ring_t *ring)
+{
+	zbx_uint64_t		head, tail, offset;
+	zbx_hc_ring_record_t	*record;
+	dc_item_value_t		*values;
+	int			i, shard, ret;
+
+	head = ring->head;
+	ZBX_HC_RING_BARRIER();
+
+	for (tail = ring->tail; tail != head; tail = ring->tail)
+	{
+		offset = tail % ring->size;
+
+		if (ring->size - offset < sizeof(zbx_hc_ring_record_t))
+		{
+			ring->tail = tail + ring->size - offset;
+			continue;
+		}
+
+		record = (zbx_hc_ring_record_t *)(ring->buffer + offset);
+		values = (dc_item_value_t *)(record + 1);
+
+		for (i = 0; i < hc_shards_num && record->values_done < record->values_num; i++)
+		{
+			shard = (record->data_shard + i) % hc_shards_num;
+			hc_select_shard(shard);
+
+			LOCK_SHARD;
+			ret = hc_add_shard_item_values(shard, values, record->values_num,
+					(const char *)(values + record->values_num), &record->data, &record->values_done);
+			UNLOCK_SHARD;
+
+			if (SUCCEED != ret)
+			{
+				record->data_shard = shard;
+				return FAIL;
+			}
+		}
+
+		ZBX_HC_RING_BARRIER();
+		ring->tail = tail + record->size;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_rings_read                                                    *
+ *                                                                            *
+ * Purpose: moves item values from all staging rings to history cache         *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_rings_read(void)
+{
+	int	i;
+
+	if (SUCCEED == hc_rings_empty())
+		return;
+
+	LOCK_CACHE;
+
+	for (i = 0; i < hc_rings_num; i++)
+	{
+		if (SUCCEED != hc_ring_read(&hc_rings[i]))
+			break;
+	}
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_rings_empty                                                   *
+ *                                                                            *
+ * Purpose: checks if there are item values in staging rings                  *
+ *                                                                            *
+ * Return value: SUCCEED - all staging rings are empty                        *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_rings_empty(void)
+{
+	int	i;
+
+	for (i = 0; i < hc_rings_num; i++)
+	{
+		if (hc_rings[i].head != hc_rings[i].tail)
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_copy_history_data                                             *
+ *                                                                            *
+ * Purpose: copies item value from history cache into the specified history   *
+ *          value                                                             *
+ *                                                                            *
+ * Parameters: history - [OUT] the history value                              *
+ *             itemid  - [IN] the item identifier                             *
+ *             data    - [IN] the history data to copy                        *
+ *                                                                            *
+ * Comments: handling of uninitialized fields in dc_add_proxy_history_log()   *
+ *                                                                            *
+ ******************************************************************************/
+static void	hc_copy_history_data(ZBX_DC_HISTORY *history, zbx_uint64_t itemid, zbx_hc_data_t *data)
+{
+	history->itemid = itemid;
+	history->ts = data->ts;
+	history->state = data->state;
+	history->flags = data->flags;
+	history->lastlogsize = data->lastlogsize;
+	history->mtime = data->mtime;
+
+	if (ITEM_STATE_NOTSUPPORTED == data->state)
+	{
+		history->value.err = zbx_strdup(NULL, data->value.str);
+		history->flags |= ZBX_DC_FLAG_UNDEF;
+		return;
+	}
+
+	history->value_type = data->value_type;
+
+	if (0 == (ZBX_DC_FLAG_NOVALUE & data->flags))
+	{
+		switch (data->value_type)
+		{
+			case ITEM_VALUE_TYPE_FLOAT:
+				history->value.dbl = data->value.dbl;
+				break;
 			case ITEM_VALUE_TYPE_UINT64:
 				history->value.ui64 = data->value.ui64;
 				break;
@@ -4060,23 +5089,53 @@ static void	hc_copy_history_data(ZBX_DC_HISTORY *history, zbx_uint64_t itemid, z
  *                                                                            *
  * Parameters: history_items - [OUT] the locked history items                 *
  *                                                                            *
+ * Return value: the index of shard the items were taken from                 *
+ *                                                                            *
  * Comments: The history_items must be returned back to history cache with    *
  *           hc_push_items() function after they have been processed.         *
+ *           The items are taken from the shard of current history syncer.    *
+ *           If it is empty the items are taken from the next non-empty shard.*
+ *           The values spilled to overflow files are moved back to history   *
+ *           cache before taking items.                                       *
  *                                                                            *
  ******************************************************************************/
-static void	hc_pop_items(zbx_vector_ptr_t *history_items)
+static int	hc_pop_items(zbx_vector_ptr_t *history_items)
 {
 	zbx_binary_heap_elem_t	*elem;
 	zbx_hc_item_t		*item;
+	int			i, shard = 0, start;
 
-	while (ZBX_HC_SYNC_MAX > history_items->values_num && FAIL == zbx_binary_heap_empty(&cache->history_queue))
+	start = (-1 == hc_syncer_shard ? 0 : hc_syncer_shard);
+
+	for (i = 0; i < hc_shards_num; i++)
 	{
-		elem = zbx_binary_heap_find_min(&cache->history_queue);
-		item = (zbx_hc_item_t *)elem->data;
-		zbx_vector_ptr_append(history_items, item);
+		shard = (start + i) % hc_shards_num;
+		hc_select_shard(shard);
+
+		LOCK_SHARD;
+
+		hc_overflow_release(shard);
+
+		if (0 != hc_cache->overflow_num)
+			hc_overflow_read(shard);
+
+		while (ZBX_HC_SYNC_MAX > history_items->values_num &&
+				FAIL == zbx_binary_heap_empty(&hc_cache->history_queue))
+		{
+			elem = zbx_binary_heap_find_min(&hc_cache->history_queue);
+			item = (zbx_hc_item_t *)elem->data;
+			zbx_vector_ptr_append(history_items, item);
+
+			zbx_binary_heap_remove_min(&hc_cache->history_queue);
+		}
 
-		zbx_binary_heap_remove_min(&cache->history_queue);
+		UNLOCK_SHARD;
+
+		if (0 != history_items->values_num)
+			break;
 	}
+
+	return shard;
 }
 
 /******************************************************************************
@@ -4143,7 +5202,7 @@ void	hc_push_items(zbx_vector_ptr_t *history_items)
 				item->tail = item->tail->next;
 				hc_free_data(data_free);
 				if (NULL == item->tail)
-					zbx_hashset_remove(&cache->history_items, item);
+					zbx_hashset_remove(&hc_cache->history_items, item);
 				else
 					hc_queue_item(item);
 				break;
@@ -4155,12 +5214,42 @@ void	hc_push_items(zbx_vector_ptr_t *history_items)
  *                                                                            *
  * Function: hc_queue_get_size                                                *
  *                                                                            *
- * Purpose: retrieve the size of history queue                                *
+ * Purpose: retrieve the size of history queue of the selected shard          *
  *                                                                            *
  ******************************************************************************/
 int	hc_queue_get_size(void)
 {
-	return cache->history_queue.elems_num;
+	return hc_cache->history_queue.elems_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_queues_empty                                                  *
+ *                                                                            *
+ * Purpose: checks if history queues and overflow files of all shards are     *
+ *          empty                                                             *
+ *                                                                            *
+ * Return value: SUCCEED - all history queues are empty                       *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	hc_queues_empty(void)
+{
+	int	i, ret = SUCCEED;
+
+	for (i = 0; i < hc_shards_num && SUCCEED == ret; i++)
+	{
+		hc_select_shard(i);
+
+		LOCK_SHARD;
+
+		if (0 != hc_queue_get_size() || 0 != hc_cache->overflow_num)
+			ret = FAIL;
+
+		UNLOCK_SHARD;
+	}
+
+	return ret;
 }
 
 int	hc_get_history_compression_age(void)
@@ -4233,6 +5322,162 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_ring_get_size                                                 *
+ *                                                                            *
+ * Purpose: returns staging ring buffer size for the specified process type   *
+ *                                                                            *
+ * Parameters: proc_type - [IN] the process type; ZBX_PROCESS_TYPE_*          *
+ *             forks     - [OUT] the number of processes of specified type    *
+ *                                                                            *
+ * Return value: the ring buffer size or 0 if processes of the specified type *
+ *               add values directly to history cache                         *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	hc_ring_get_size(unsigned char proc_type, int *forks)
+{
+#if defined(__GNUC__)
+	switch (proc_type)
+	{
+		case ZBX_PROCESS_TYPE_PREPROCMAN:
+			*forks = CONFIG_PREPROCMAN_FORKS;
+			return ZBX_HC_RING_SIZE_PREPROCMAN;
+		case ZBX_PROCESS_TYPE_TRAPPER:
+			*forks = CONFIG_TRAPPER_FORKS;
+			return ZBX_HC_RING_SIZE;
+		case ZBX_PROCESS_TYPE_PROXYPOLLER:
+			*forks = CONFIG_PROXYPOLLER_FORKS;
+			return ZBX_HC_RING_SIZE;
+		case ZBX_PROCESS_TYPE_CONFSYNCER:
+			*forks = CONFIG_CONFSYNCER_FORKS;
+			return ZBX_HC_RING_SIZE;
+	}
+#else
+	ZBX_UNUSED(proc_type);
+#endif
+	*forks = 0;
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: hc_ring_get_fitted_size                                          *
+ *                                                                            *
+ * Purpose: returns staging ring buffer size for the specified process type   *
+ *          reduced to fit the staging rings into their part of history cache *
+ *                                                                            *
+ * Parameters: proc_type  - [IN] the process type; ZBX_PROCESS_TYPE_*         *
+ *             rings_size - [IN] the total size of rings with default sizes   *
+ *             forks      - [OUT] the number of processes of specified type   *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	hc_ring_get_fitted_size(unsigned char proc_type, zbx_uint64_t rings_size, int *forks)
+{
+	zbx_uint64_t	ring_size;
+
+	ring_size = hc_ring_get_size(proc_type, forks);
+
+	if (rings_size > ZBX_HC_RINGS_SIZE_MAX)
+		ring_size = (ring_size * ZBX_HC_RINGS_SIZE_MAX / rings_size) & ~(zbx_uint64_t)7;
+
+	return ring_size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: init_history_rings                                               *
+ *                                                                            *
+ * Purpose: allocate shared memory for staging rings of history collecting    *
+ *          processes                                                         *
+ *                                                                            *
+ * Comments: Is called from init_database_cache() before history cache shards *
+ *           are created. The rings are taken out of HistoryCacheSize and may *
+ *           use up to a quarter of it - when the default ring sizes do not   *
+ *           fit, the rings are shrunk proportionally. Rings smaller than     *
+ *           ZBX_HC_RING_SIZE_MIN are not created and the processes add       *
+ *           values directly to history cache instead.                        *
+ *                                                                            *
+ ******************************************************************************/
+
+ZBX_MEM_FUNC1_IMPL_MALLOC(__hc_ring, hc_ring_mem)
+
+static int	init_history_rings(char **error)
+{
+	int		ret = SUCCEED, forks, i, rings_num = 0;
+	unsigned char	proc_type;
+	zbx_uint64_t	sz = 0, ring_size, rings_size = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	for (proc_type = 0; ZBX_PROCESS_TYPE_COUNT > proc_type; proc_type++)
+	{
+		ring_size = hc_ring_get_size(proc_type, &forks);
+		rings_size += ring_size * (zbx_uint64_t)forks;
+	}
+
+	if (0 == rings_size)
+		goto out;
+
+	for (proc_type = 0; ZBX_PROCESS_TYPE_COUNT > proc_type; proc_type++)
+	{
+		if (ZBX_HC_RING_SIZE_MIN > (ring_size = hc_ring_get_fitted_size(proc_type, rings_size, &forks)))
+			continue;
+
+		rings_num += forks;
+		sz += ring_size * (zbx_uint64_t)forks;
+	}
+
+	if (0 == rings_num)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "history cache is too small for staging buffers, item values will be"
+				" added directly to history cache");
+		goto out;
+	}
+
+	if (rings_size > ZBX_HC_RINGS_SIZE_MAX)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "history staging buffers were reduced to " ZBX_FS_UI64 " bytes to fit"
+				" into a quarter of HistoryCacheSize", sz);
+	}
+
+	sz += sizeof(zbx_hc_ring_t) * (size_t)rings_num;
+	sz += zbx_mem_required_size(rings_num + 1, "history staging buffers", "HistoryCacheSize");
+
+	if (SUCCEED != (ret = zbx_mem_create(&hc_ring_mem, sz, "history staging buffers", "HistoryCacheSize", 0,
+			error)))
+	{
+		goto out;
+	}
+
+	hc_rings_size = sz;
+	hc_rings = (zbx_hc_ring_t *)__hc_ring_mem_malloc_func(NULL, sizeof(zbx_hc_ring_t) * (size_t)rings_num);
+
+	for (proc_type = 0; ZBX_PROCESS_TYPE_COUNT > proc_type; proc_type++)
+	{
+		if (ZBX_HC_RING_SIZE_MIN > (ring_size = hc_ring_get_fitted_size(proc_type, rings_size, &forks)))
+			continue;
+
+		for (i = 0; i < forks; i++)
+		{
+			zbx_hc_ring_t	*ring = &hc_rings[hc_rings_num++];
+
+			ring->head = 0;
+			ring->tail = 0;
+			ring->size = ring_size;
+			ring->buffer = (char *)__hc_ring_mem_malloc_func(NULL, ring_size);
+			ring->process_type = proc_type;
+			ring->process_num = i + 1;
+		}
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() rings:%d size:" ZBX_FS_UI64, __func__, hc_rings_num,
+			hc_rings_size);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: init_database_cache                                              *
@@ -4244,7 +5489,8 @@ out:
  ******************************************************************************/
 int	init_database_cache(char **error)
 {
-	int	ret;
+	int		ret, i, shards_num;
+	zbx_uint64_t	history_size, shard_size, shard_index_size;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -4254,44 +5500,94 @@ int	init_database_cache(char **error)
 	if (SUCCEED != (ret = zbx_mutex_create(&cache_ids_lock, ZBX_MUTEX_CACHE_IDS, error)))
 		goto out;
 
-	if (SUCCEED != (ret = zbx_mem_create(&hc_mem, CONFIG_HISTORY_CACHE_SIZE, "history cache",
-			"HistoryCacheSize", 1, error)))
-	{
+	/* staging rings are taken out of history cache size */
+	if (SUCCEED != (ret = init_history_rings(error)))
 		goto out;
-	}
 
-	if (SUCCEED != (ret = zbx_mem_create(&hc_index_mem, CONFIG_HISTORY_INDEX_CACHE_SIZE, "history index cache",
-			"HistoryIndexCacheSize", 0, error)))
+	history_size = CONFIG_HISTORY_CACHE_SIZE - hc_rings_size;
+
+	/* history cache is split into shards owned by history syncers, limited by the number of */
+	/* available mutexes and the minimum shard size                                           */
+	shards_num = MIN(CONFIG_HISTSYNCER_FORKS, ZBX_MUTEX_HISTORY_CACHE_NUM);
+
+	if ((zbx_uint64_t)shards_num > history_size / ZBX_HC_SHARD_MIN_SIZE)
+		shards_num = (int)(history_size / ZBX_HC_SHARD_MIN_SIZE);
+
+	if ((zbx_uint64_t)shards_num > CONFIG_HISTORY_INDEX_CACHE_SIZE / ZBX_HC_SHARD_MIN_SIZE)
+		shards_num = (int)(CONFIG_HISTORY_INDEX_CACHE_SIZE / ZBX_HC_SHARD_MIN_SIZE);
+
+	if (1 > shards_num)
+		shards_num = 1;
+
+	shard_size = history_size / (zbx_uint64_t)shards_num;
+	shard_index_size = CONFIG_HISTORY_INDEX_CACHE_SIZE / (zbx_uint64_t)shards_num;
+
+	for (i = 0; i < shards_num; i++)
 	{
-		goto out;
+		zbx_hc_shard_t	*shard = &hc_shards[i];
+
+		if (SUCCEED != (ret = zbx_mutex_create(&shard->lock, (zbx_mutex_name_t)(ZBX_MUTEX_HISTORY_CACHE + i),
+				error)))
+			goto out;
+
+		if (SUCCEED != (ret = zbx_mem_create(&shard->mem, shard_size, "history cache", "HistoryCacheSize", 1,
+				error)))
+		{
+			goto out;
+		}
+
+		if (SUCCEED != (ret = zbx_mem_create(&shard->index_mem, shard_index_size, "history index cache",
+				"HistoryIndexCacheSize", 0, error)))
+		{
+			goto out;
+		}
+
+		zbx_mem_enable_slabs(shard->mem);
+		zbx_mem_enable_slabs(shard->index_mem);
+
+		hc_shard = shard;
+		hc_mem = shard->mem;
+		hc_index_mem = shard->index_mem;
+
+		shard->cache = (zbx_hc_cache_t *)__hc_index_mem_malloc_func(NULL, sizeof(zbx_hc_cache_t));
+		memset(shard->cache, 0, sizeof(zbx_hc_cache_t));
+
+		zbx_hashset_create_ext(&shard->cache->history_items, ZBX_HC_ITEMS_INIT_SIZE,
+				ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+				__hc_index_mem_malloc_func, __hc_index_mem_realloc_func, __hc_index_mem_free_func);
+
+		zbx_binary_heap_create_ext(&shard->cache->history_queue, hc_queue_elem_compare_func,
+				ZBX_BINARY_HEAP_OPTION_EMPTY, __hc_index_mem_malloc_func, __hc_index_mem_realloc_func,
+				__hc_index_mem_free_func);
+
+		hc_shards_num++;
 	}
 
+	/* the data shared by all shards is kept in the index memory of the first shard */
+	hc_select_shard(0);
+
 	cache = (ZBX_DC_CACHE *)__hc_index_mem_malloc_func(NULL, sizeof(ZBX_DC_CACHE));
 	memset(cache, 0, sizeof(ZBX_DC_CACHE));
 
 	ids = (ZBX_DC_IDS *)__hc_index_mem_malloc_func(NULL, sizeof(ZBX_DC_IDS));
 	memset(ids, 0, sizeof(ZBX_DC_IDS));
 
-	zbx_hashset_create_ext(&cache->history_items, ZBX_HC_ITEMS_INIT_SIZE,
-			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__hc_index_mem_malloc_func, __hc_index_mem_realloc_func, __hc_index_mem_free_func);
-
-	zbx_binary_heap_create_ext(&cache->history_queue, hc_queue_elem_compare_func, ZBX_BINARY_HEAP_OPTION_EMPTY,
-			__hc_index_mem_malloc_func, __hc_index_mem_realloc_func, __hc_index_mem_free_func);
-
 	if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
 	{
 		if (SUCCEED != (ret = init_trend_cache(error)))
 			goto out;
 	}
 
+	if (SUCCEED != (ret = init_history_overflow(error)))
+		goto out;
+
 	cache->history_num_total = 0;
 	cache->history_progress_ts = 0;
 
 	if (NULL == sql)
 		sql = (char *)zbx_malloc(sql, sql_alloc);
 out:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() shards:%d", __func__, hc_shards_num);
 
 	return ret;
 }
@@ -4327,6 +5623,8 @@ static void	DCsync_all(void)
  ******************************************************************************/
 void	free_database_cache(void)
 {
+	int	i;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
 	DCsync_all();
@@ -4336,6 +5634,9 @@ void	free_database_cache(void)
 	zbx_mutex_destroy(&cache_lock);
 	zbx_mutex_destroy(&cache_ids_lock);
 
+	for (i = 0; i < hc_shards_num; i++)
+		zbx_mutex_destroy(&hc_shards[i].lock);
+
 	if (0 != (program_type & ZBX_PROGRAM_TYPE_SERVER))
 		zbx_mutex_destroy(&trends_lock);
 
@@ -4424,39 +5725,35 @@ zbx_uint64_t	DCget_nextid(const char *table_name, int num)
 
 /******************************************************************************
  *                                                                            *
- * Function: DCupdate_hosts_availability                                      *
+ * Function: db_update_hosts_availability                                     *
  *                                                                            *
- * Purpose: performs host availability reset for hosts with availability set  *
- *          on interfaces without enabled items                               *
+ * Purpose: writes host availability changes into database                    *
+ *                                                                            *
+ * Parameters: hosts - [IN] the host availability data                        *
+ *                                                                            *
+ * Return value: the number of updated hosts                                  *
  *                                                                            *
  ******************************************************************************/
-void	DCupdate_hosts_availability(void)
+static int	db_update_hosts_availability(const zbx_vector_ptr_t *hosts)
 {
-	zbx_vector_ptr_t	hosts;
-	char			*sql_buf = NULL;
-	size_t			sql_buf_alloc = 0, sql_buf_offset = 0;
-	int			i;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	zbx_vector_ptr_create(&hosts);
-
-	if (SUCCEED != DCreset_hosts_availability(&hosts))
-		goto out;
+	char	*sql_buf = NULL;
+	size_t	sql_buf_alloc = 0, sql_buf_offset = 0;
+	int	i, updated_num = 0;
 
 	DBbegin();
 	DBbegin_multiple_update(&sql_buf, &sql_buf_alloc, &sql_buf_offset);
 
-	for (i = 0; i < hosts.values_num; i++)
+	for (i = 0; i < hosts->values_num; i++)
 	{
 		if (SUCCEED != zbx_sql_add_host_availability(&sql_buf, &sql_buf_alloc, &sql_buf_offset,
-				(zbx_host_availability_t *)hosts.values[i]))
+				(zbx_host_availability_t *)hosts->values[i]))
 		{
 			continue;
 		}
 
 		zbx_strcpy_alloc(&sql_buf, &sql_buf_alloc, &sql_buf_offset, ";\n");
 		DBexecute_overflowed_sql(&sql_buf, &sql_buf_alloc, &sql_buf_offset);
+		updated_num++;
 	}
 
 	DBend_multiple_update(&sql_buf, &sql_buf_alloc, &sql_buf_offset);
@@ -4467,9 +5764,67 @@ void	DCupdate_hosts_availability(void)
 	DBcommit();
 
 	zbx_free(sql_buf);
-out:
+
+	return updated_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCupdate_hosts_availability                                      *
+ *                                                                            *
+ * Purpose: performs host availability reset for hosts with availability set  *
+ *          on interfaces without enabled items                               *
+ *                                                                            *
+ ******************************************************************************/
+void	DCupdate_hosts_availability(void)
+{
+	zbx_vector_ptr_t	hosts;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	zbx_vector_ptr_create(&hosts);
+
+	if (SUCCEED == DCreset_hosts_availability(&hosts))
+		db_update_hosts_availability(&hosts);
+
 	zbx_vector_ptr_clear_ext(&hosts, (zbx_mem_free_func_t)zbx_host_availability_free);
 	zbx_vector_ptr_destroy(&hosts);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCflush_hosts_availability                                       *
+ *                                                                            *
+ * Purpose: writes queued host availability changes into database            *
+ *                                                                            *
+ * Parameters: updated_num   - [OUT] the number of updated hosts              *
+ *             coalesced_num - [OUT] the number of availability changes       *
+ *                                   merged into other updates of the same    *
+ *                                   host                                     *
+ *                                                                            *
+ * Comments: Pollers change host availability in configuration cache and      *
+ *           queue the changes instead of updating database for each host.    *
+ *           This function must be called by a single process to keep the     *
+ *           database updates in order.                                       *
+ *                                                                            *
+ ******************************************************************************/
+void	DCflush_hosts_availability(int *updated_num, int *coalesced_num)
+{
+	zbx_vector_ptr_t	hosts;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	*updated_num = 0;
+
+	zbx_vector_ptr_create(&hosts);
+
+	if (SUCCEED == DCget_queued_hosts_availability(&hosts, coalesced_num))
+		*updated_num = db_update_hosts_availability(&hosts);
+
+	zbx_vector_ptr_clear_ext(&hosts, (zbx_mem_free_func_t)zbx_host_availability_free);
+	zbx_vector_ptr_destroy(&hosts);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() updated:%d coalesced:%d", __func__, *updated_num, *coalesced_num);
+}
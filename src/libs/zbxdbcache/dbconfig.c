@@ -34,14 +34,34 @@
 #include "../zbxcrypto/tls_tcp_active.h"
 
 #define ZBX_DBCONFIG_IMPL
+#include "daemon.h"
 #include "dbconfig.h"
+#include "dbsnapshot.h"
 #include "dbsync.h"
 #include "proxy.h"
 
 int	sync_in_progress = 0;
+static double	sync_lock_ts;		/* time when configuration syncer acquired write lock */
+static double	sync_lock_max;		/* the longest write lock hold time during configuration sync */
 
-#define START_SYNC	WRLOCK_CACHE; sync_in_progress = 1
-#define FINISH_SYNC	sync_in_progress = 0; UNLOCK_CACHE
+#define START_SYNC	WRLOCK_CACHE; sync_in_progress = 1; sync_lock_ts = zbx_time()
+#define FINISH_SYNC	dc_sync_update_lock_max(); sync_in_progress = 0; UNLOCK_CACHE
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_sync_update_lock_max                                          *
+ *                                                                            *
+ * Purpose: updates the longest configuration cache write lock hold time by   *
+ *          configuration syncer, reported in sync diagnostics                *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_sync_update_lock_max(void)
+{
+	double	lock_sec;
+
+	if (sync_lock_max < (lock_sec = zbx_time() - sync_lock_ts))
+		sync_lock_max = lock_sec;
+}
 
 #define ZBX_LOC_NOWHERE	0
 #define ZBX_LOC_QUEUE	1
@@ -99,6 +119,25 @@ static void	dc_maintenance_precache_nested_groups(void);
 /* by default the macro environment is non-secure and all secret macros are masked with ****** */
 static unsigned char	macro_env = ZBX_MACRO_ENV_NONSECURE;
 
+/* trigger related changes collected by configuration syncer, used to update only the */
+/* affected trigger cache data (see dc_trigger_update_cache, dc_trigger_update_topology) */
+typedef struct
+{
+	/* triggers with changed expression, status, functions or items */
+	zbx_vector_uint64_t	triggerids;
+
+	/* triggers with changed dependencies */
+	zbx_vector_uint64_t	dep_triggerids;
+
+	/* host status was changed, all triggers must be updated */
+	int			update_all;
+}
+zbx_dc_trigger_changes_t;
+
+/* The changes are kept between syncs, so that they are applied by the next sync */
+/* if the current one fails after the changed tables were already synced.         */
+static zbx_dc_trigger_changes_t	trigger_changes;
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_strdup                                                        *
@@ -637,17 +676,106 @@ int	DCstrpool_replace(int found, const char **curr, const char *new_str)
 	return SUCCEED;	/* indicate that the string has been replaced */
 }
 
-static void	DCupdate_item_queue(ZBX_DC_ITEM *item, unsigned char old_poller_type, int old_nextcheck)
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_item_queue_insert                                             *
+ *                                                                            *
+ * Purpose: adds item to poller item queue                                    *
+ *                                                                            *
+ * Comments: With timer wheel only the items that are already due are kept   *
+ *           in the binary heap, the rest are scheduled in the timer wheel    *
+ *           and moved to the heap when they become due.                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_item_queue_insert(zbx_dc_item_queue_t *queue, const ZBX_DC_ITEM *item)
+{
+	zbx_binary_heap_elem_t	elem;
+
+	if (NULL != queue->wheel && item->nextcheck >= queue->wheel->time)
+	{
+		zbx_timer_wheel_insert(queue->wheel, item->itemid, item, item->nextcheck);
+		return;
+	}
+
+	elem.key = item->itemid;
+	elem.data = (const void *)item;
+
+	zbx_binary_heap_insert(&queue->heap, &elem);
+}
+
+static void	dc_item_queue_remove(zbx_dc_item_queue_t *queue, zbx_uint64_t itemid)
+{
+	if (NULL != queue->wheel && SUCCEED == zbx_timer_wheel_remove(queue->wheel, itemid))
+		return;
+
+	zbx_binary_heap_remove_direct(&queue->heap, itemid);
+}
+
+static void	dc_item_queue_update(zbx_dc_item_queue_t *queue, const ZBX_DC_ITEM *item)
 {
 	zbx_binary_heap_elem_t	elem;
 
+	if (NULL != queue->wheel)
+	{
+		/* the item might have to be moved between timer wheel and binary heap */
+		dc_item_queue_remove(queue, item->itemid);
+		dc_item_queue_insert(queue, item);
+		return;
+	}
+
+	elem.key = item->itemid;
+	elem.data = (const void *)item;
+
+	zbx_binary_heap_update_direct(&queue->heap, &elem);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_item_queue_find_min                                           *
+ *                                                                            *
+ * Purpose: get the first item in poller item queue                           *
+ *                                                                            *
+ * Parameters: queue - [IN] the queue                                         *
+ *             now   - [IN] the current time                                  *
+ *                                                                            *
+ * Return value: the item with the earliest nextcheck or NULL if the queue    *
+ *               has no due items                                             *
+ *                                                                            *
+ * Comments: The returned item is removed from the queue with                 *
+ *           zbx_binary_heap_remove_min(&queue->heap).                        *
+ *                                                                            *
+ ******************************************************************************/
+static ZBX_DC_ITEM	*dc_item_queue_find_min(zbx_dc_item_queue_t *queue, int now)
+{
+	if (NULL != queue->wheel)
+	{
+		const ZBX_DC_ITEM	*item;
+		zbx_binary_heap_elem_t	elem;
+
+		while (NULL != (item = (const ZBX_DC_ITEM *)zbx_timer_wheel_pop(queue->wheel, now)))
+		{
+			elem.key = item->itemid;
+			elem.data = (const void *)item;
+
+			zbx_binary_heap_insert(&queue->heap, &elem);
+		}
+	}
+
+	if (SUCCEED == zbx_binary_heap_empty(&queue->heap))
+		return NULL;
+
+	return (ZBX_DC_ITEM *)zbx_binary_heap_find_min(&queue->heap)->data;
+}
+
+static void	DCupdate_item_queue(ZBX_DC_ITEM *item, unsigned char old_poller_type, int old_nextcheck)
+{
 	if (ZBX_LOC_POLLER == item->location)
 		return;
 
 	if (ZBX_LOC_QUEUE == item->location && old_poller_type != item->poller_type)
 	{
 		item->location = ZBX_LOC_NOWHERE;
-		zbx_binary_heap_remove_direct(&config->queues[old_poller_type], item->itemid);
+		dc_item_queue_remove(&config->queues[old_poller_type], item->itemid);
 	}
 
 	if (item->poller_type == ZBX_NO_POLLER)
@@ -656,16 +784,13 @@ static void	DCupdate_item_queue(ZBX_DC_ITEM *item, unsigned char old_poller_type
 	if (ZBX_LOC_QUEUE == item->location && old_nextcheck == item->nextcheck)
 		return;
 
-	elem.key = item->itemid;
-	elem.data = (const void *)item;
-
 	if (ZBX_LOC_QUEUE != item->location)
 	{
 		item->location = ZBX_LOC_QUEUE;
-		zbx_binary_heap_insert(&config->queues[item->poller_type], &elem);
+		dc_item_queue_insert(&config->queues[item->poller_type], item);
 	}
 	else
-		zbx_binary_heap_update_direct(&config->queues[item->poller_type], &elem);
+		dc_item_queue_update(&config->queues[item->poller_type], item);
 }
 
 static void	DCupdate_proxy_queue(ZBX_DC_PROXY *proxy)
@@ -1404,8 +1529,13 @@ done:
 
 			/* reset host status if host status has been changed (e.g., if host has been disabled) */
 			if (status != host->status)
+			{
 				host->reset_availability = 1;
 
+				/* triggers using host items can become (not) functional */
+				trigger_changes.update_all = 1;
+			}
+
 			/* reset host status if host proxy assignment has been changed */
 			if (proxy_hostid != host->proxy_hostid)
 				host->reset_availability = 1;
@@ -1748,6 +1878,9 @@ static void	DCsync_htmpls(zbx_dbsync_t *sync)
 
 	zbx_vector_ptr_destroy(&sort);
 
+	if (0 != sync->add_num + sync->update_num + sync->remove_num)
+		config->um_revision++;
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
@@ -1835,6 +1968,9 @@ static void	DCsync_gmacros(zbx_dbsync_t *sync)
 		zbx_hashset_remove_direct(&config->gmacros, gmacro);
 	}
 
+	if (0 != sync->add_num + sync->update_num + sync->remove_num)
+		config->um_revision++;
+
 	zbx_free(context);
 	zbx_free(macro);
 
@@ -1928,6 +2064,9 @@ static void	DCsync_hmacros(zbx_dbsync_t *sync)
 		zbx_hashset_remove_direct(&config->hmacros, hmacro);
 	}
 
+	if (0 != sync->add_num + sync->update_num + sync->remove_num)
+		config->um_revision++;
+
 	zbx_free(context);
 	zbx_free(macro);
 
@@ -2417,6 +2556,68 @@ static void	dc_host_update_agent_stats(ZBX_DC_HOST *host, unsigned char type, in
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_item_queue_trigger_changes                                    *
+ *                                                                            *
+ * Purpose: queues triggers linked to the item for trigger cache update       *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_item_queue_trigger_changes(const ZBX_DC_ITEM *item)
+{
+	ZBX_DC_TRIGGER	**trigger;
+
+	if (NULL == item->cold->triggers)
+		return;
+
+	for (trigger = item->cold->triggers; NULL != *trigger; trigger++)
+		zbx_vector_uint64_append(&trigger_changes.triggerids, (*trigger)->triggerid);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_item_unlink_trigger                                           *
+ *                                                                            *
+ * Purpose: removes trigger from the list of triggers using the item          *
+ *                                                                            *
+ * Parameters: itemid    - [IN] the item identifier                           *
+ *             triggerid - [IN] the trigger identifier                        *
+ *                                                                            *
+ * Comments: The trigger is queued for update and will be linked back if it   *
+ *           still uses the item through another function.                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_item_unlink_trigger(zbx_uint64_t itemid, zbx_uint64_t triggerid)
+{
+	ZBX_DC_ITEM	*item;
+	ZBX_DC_TRIGGER	*trigger, **ptr;
+
+	zbx_vector_uint64_append(&trigger_changes.triggerids, triggerid);
+
+	if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemid)) ||
+			NULL == item->cold->triggers)
+	{
+		return;
+	}
+
+	if (NULL == (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_search(&config->triggers, &triggerid)))
+		return;
+
+	for (ptr = item->cold->triggers; NULL != *ptr; ptr++)
+	{
+		if (*ptr != trigger)
+			continue;
+
+		do
+		{
+			ptr[0] = ptr[1];
+		}
+		while (NULL != *ptr++);
+
+		break;
+	}
+}
+
 static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 {
 	char			**row;
@@ -2474,11 +2675,14 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 
 		item = (ZBX_DC_ITEM *)DCfind_id(&config->items, itemid, sizeof(ZBX_DC_ITEM), &found);
 
+		if (0 == found)
+			item->cold = (ZBX_DC_ITEM_COLD *)__config_mem_malloc_func(NULL, sizeof(ZBX_DC_ITEM_COLD));
+
 		/* template item */
-		ZBX_DBROW2UINT64(item->templateid, row[48]);
+		ZBX_DBROW2UINT64(item->cold->templateid, row[48]);
 
 		/* LLD item prototype */
-		ZBX_DBROW2UINT64(item->parent_itemid, row[49]);
+		ZBX_DBROW2UINT64(item->cold->parent_itemid, row[49]);
 
 		if (0 != found && ITEM_TYPE_SNMPTRAP == item->type)
 			dc_interface_snmpitems_remove(item);
@@ -2518,16 +2722,16 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 		item->flags = (unsigned char)atoi(row[18]);
 		ZBX_DBROW2UINT64(item->interfaceid, row[19]);
 
-		if (SUCCEED != is_time_suffix(row[22], &item->history_sec, ZBX_LENGTH_UNLIMITED))
-			item->history_sec = ZBX_HK_PERIOD_MAX;
+		if (SUCCEED != is_time_suffix(row[22], &item->cold->history_sec, ZBX_LENGTH_UNLIMITED))
+			item->cold->history_sec = ZBX_HK_PERIOD_MAX;
 
-		if (0 != item->history_sec && ZBX_HK_OPTION_ENABLED == config->config->hk.history_global)
-			item->history_sec = config->config->hk.history;
+		if (0 != item->cold->history_sec && ZBX_HK_OPTION_ENABLED == config->config->hk.history_global)
+			item->cold->history_sec = config->config->hk.history;
 
-		item->history = (0 != item->history_sec);
+		item->cold->history = (0 != item->cold->history_sec);
 
-		ZBX_STR2UCHAR(item->inventory_link, row[24]);
-		ZBX_DBROW2UINT64(item->valuemapid, row[25]);
+		ZBX_STR2UCHAR(item->cold->inventory_link, row[24]);
+		ZBX_DBROW2UINT64(item->cold->valuemapid, row[25]);
 
 		if (0 != (ZBX_FLAG_DISCOVERY_RULE & item->flags))
 			value_type = ITEM_VALUE_TYPE_TEXT;
@@ -2539,15 +2743,14 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 
 		if (0 == found)
 		{
-			item->triggers = NULL;
-			item->update_triggers = 0;
+			item->cold->triggers = NULL;
 			item->nextcheck = 0;
-			item->lastclock = 0;
+			item->cold->lastclock = 0;
 			item->state = (unsigned char)atoi(row[12]);
-			ZBX_STR2UINT64(item->lastlogsize, row[20]);
-			item->mtime = atoi(row[21]);
-			DCstrpool_replace(found, &item->error, row[27]);
-			item->data_expected_from = now;
+			ZBX_STR2UINT64(item->cold->lastlogsize, row[20]);
+			item->cold->mtime = atoi(row[21]);
+			DCstrpool_replace(found, &item->cold->error, row[27]);
+			item->cold->data_expected_from = now;
 			item->location = ZBX_LOC_NOWHERE;
 			item->poller_type = ZBX_NO_POLLER;
 			item->queue_priority = ZBX_QUEUE_PRIORITY_NORMAL;
@@ -2559,10 +2762,14 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 				flags |= ZBX_ITEM_TYPE_CHANGED;
 
 			if (ITEM_STATUS_ACTIVE == status && ITEM_STATUS_ACTIVE != item->status)
-				item->data_expected_from = now;
+				item->cold->data_expected_from = now;
 
 			if (ITEM_STATUS_ACTIVE == item->status)
 				dc_host_update_agent_stats(host, item->type, -1);
+
+			/* triggers using the item can become (not) functional */
+			if (status != item->status)
+				dc_item_queue_trigger_changes(item);
 		}
 
 		if (ITEM_STATUS_ACTIVE == status)
@@ -3150,14 +3357,20 @@ static void	DCsync_items(zbx_dbsync_t *sync, int flags)
 		}
 
 		if (ZBX_LOC_QUEUE == item->location)
-			zbx_binary_heap_remove_direct(&config->queues[item->poller_type], item->itemid);
+			dc_item_queue_remove(&config->queues[item->poller_type], item->itemid);
 
 		zbx_strpool_release(item->key);
-		zbx_strpool_release(item->error);
+		zbx_strpool_release(item->cold->error);
 		zbx_strpool_release(item->delay);
 
-		if (NULL != item->triggers)
-			config->items.mem_free_func(item->triggers);
+		if (NULL != item->cold->triggers)
+		{
+			/* triggers using removed item can become functional */
+			dc_item_queue_trigger_changes(item);
+			config->items.mem_free_func(item->cold->triggers);
+		}
+
+		config->items.mem_free_func(item->cold);
 
 		if (NULL != (preprocitem = (ZBX_DC_PREPROCITEM *)zbx_hashset_search(&config->preprocitems, &item->itemid)))
 		{
@@ -3290,7 +3503,12 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 			zbx_vector_ptr_create_ext(&trigger->tags, __config_mem_malloc_func, __config_mem_realloc_func,
 					__config_mem_free_func);
 			trigger->topoindex = 1;
+			trigger->functional = TRIGGER_FUNCTIONAL_TRUE;
+			trigger->timer = ZBX_TRIGGER_TIMER_UNKNOWN;
+			trigger->location = ZBX_LOC_NOWHERE;
 		}
+
+		zbx_vector_uint64_append(&trigger_changes.triggerids, triggerid);
 	}
 
 	/* remove deleted triggers from buffer */
@@ -3298,7 +3516,6 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 	{
 		zbx_vector_uint64_t	functionids;
 		int			i;
-		ZBX_DC_ITEM		*item;
 		ZBX_DC_FUNCTION		*function;
 
 		zbx_vector_uint64_create(&functionids);
@@ -3308,7 +3525,10 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 			if (NULL == (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_search(&config->triggers, &rowid)))
 				continue;
 
-			/* force trigger list update for items used in removed trigger */
+			if (ZBX_LOC_QUEUE == trigger->location)
+				zbx_binary_heap_remove_direct(&config->timer_queue, trigger->triggerid);
+
+			/* remove trigger from trigger lists of the items used in removed trigger */
 
 			get_functionids(&functionids, trigger->expression);
 
@@ -3320,15 +3540,8 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 				if (NULL == (function = (ZBX_DC_FUNCTION *)zbx_hashset_search(&config->functions, &functionids.values[i])))
 					continue;
 
-				if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &function->itemid)))
-					continue;
-
-				item->update_triggers = 1;
-				if (NULL != item->triggers)
-				{
-					config->items.mem_free_func(item->triggers);
-					item->triggers = NULL;
-				}
+				if (function->triggerid == trigger->triggerid)
+					dc_item_unlink_trigger(function->itemid, trigger->triggerid);
 			}
 			zbx_vector_uint64_clear(&functionids);
 
@@ -3349,7 +3562,7 @@ static void	DCsync_triggers(zbx_dbsync_t *sync)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
-static void	DCconfig_sort_triggers_topologically(void);
+static void	DCconfig_sort_triggers_topologically(const zbx_vector_ptr_t *trigdeps);
 
 /******************************************************************************
  *                                                                            *
@@ -3363,6 +3576,7 @@ static int	dc_trigger_deplist_release(ZBX_DC_TRIGGER_DEPLIST *trigdep)
 	if (0 == --trigdep->refcount)
 	{
 		zbx_vector_ptr_destroy(&trigdep->dependencies);
+		zbx_vector_ptr_destroy(&trigdep->dependents);
 		zbx_hashset_remove_direct(&config->trigdeps, trigdep);
 		return SUCCEED;
 	}
@@ -3383,6 +3597,8 @@ static void	dc_trigger_deplist_init(ZBX_DC_TRIGGER_DEPLIST *trigdep, ZBX_DC_TRIG
 	trigdep->trigger = trigger;
 	zbx_vector_ptr_create_ext(&trigdep->dependencies, __config_mem_malloc_func, __config_mem_realloc_func,
 			__config_mem_free_func);
+	zbx_vector_ptr_create_ext(&trigdep->dependents, __config_mem_malloc_func, __config_mem_realloc_func,
+			__config_mem_free_func);
 }
 
 /******************************************************************************
@@ -3443,6 +3659,9 @@ static void	DCsync_trigdeps(zbx_dbsync_t *sync)
 			trigdep_up->refcount++;
 
 		zbx_vector_ptr_append(&trigdep_down->dependencies, trigdep_up);
+		zbx_vector_ptr_append(&trigdep_up->dependents, trigdep_down);
+
+		zbx_vector_uint64_append(&trigger_changes.dep_triggerids, triggerid_down);
 	}
 
 	/* remove deleted trigger dependencies from buffer */
@@ -3455,11 +3674,17 @@ static void	DCsync_trigdeps(zbx_dbsync_t *sync)
 			continue;
 		}
 
+		zbx_vector_uint64_append(&trigger_changes.dep_triggerids, triggerid_down);
+
 		ZBX_STR2UINT64(triggerid_up, row[1]);
 		if (NULL != (trigdep_up = (ZBX_DC_TRIGGER_DEPLIST *)zbx_hashset_search(&config->trigdeps,
-				&triggerid_up)))
+				&triggerid_up)) && SUCCEED != dc_trigger_deplist_release(trigdep_up))
 		{
-			dc_trigger_deplist_release(trigdep_up);
+			if (FAIL != (index = zbx_vector_ptr_search(&trigdep_up->dependents, trigdep_down,
+					ZBX_DEFAULT_PTR_COMPARE_FUNC)))
+			{
+				zbx_vector_ptr_remove_noorder(&trigdep_up->dependents, index);
+			}
 		}
 
 		if (SUCCEED != dc_trigger_deplist_release(trigdep_down))
@@ -3519,20 +3744,8 @@ static void	DCsync_functions(zbx_dbsync_t *sync)
 
 		function = (ZBX_DC_FUNCTION *)DCfind_id(&config->functions, functionid, sizeof(ZBX_DC_FUNCTION), &found);
 
-		if (1 == found && function->itemid != itemid)
-		{
-			ZBX_DC_ITEM	*item_last;
-
-			if (NULL != (item_last = zbx_hashset_search(&config->items, &function->itemid)))
-			{
-				item_last->update_triggers = 1;
-				if (NULL != item_last->triggers)
-				{
-					config->items.mem_free_func(item_last->triggers);
-					item_last->triggers = NULL;
-				}
-			}
-		}
+		if (1 == found && (function->itemid != itemid || function->triggerid != triggerid))
+			dc_item_unlink_trigger(function->itemid, function->triggerid);
 
 		function->triggerid = triggerid;
 		function->itemid = itemid;
@@ -3541,9 +3754,7 @@ static void	DCsync_functions(zbx_dbsync_t *sync)
 
 		function->timer = (SUCCEED == is_time_function(function->function) ? 1 : 0);
 
-		item->update_triggers = 1;
-		if (NULL != item->triggers)
-			item->triggers[0] = NULL;
+		zbx_vector_uint64_append(&trigger_changes.triggerids, triggerid);
 	}
 
 	for (; SUCCEED == ret; ret = zbx_dbsync_next(sync, &rowid, &row, &tag))
@@ -3551,15 +3762,7 @@ static void	DCsync_functions(zbx_dbsync_t *sync)
 		if (NULL == (function = (ZBX_DC_FUNCTION *)zbx_hashset_search(&config->functions, &rowid)))
 			continue;
 
-		if (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &function->itemid)))
-		{
-			item->update_triggers = 1;
-			if (NULL != item->triggers)
-			{
-				config->items.mem_free_func(item->triggers);
-				item->triggers = NULL;
-			}
-		}
+		dc_item_unlink_trigger(function->itemid, function->triggerid);
 
 		zbx_strpool_release(function->function);
 		zbx_strpool_release(function->parameter);
@@ -4778,17 +4981,75 @@ static void	DCsync_hostgroup_hosts(zbx_dbsync_t *sync)
  *                                                                            *
  * Purpose: updates trigger topology after trigger dependency changes         *
  *                                                                            *
+ * Parameters: triggerids - [IN] the triggers with changed dependencies       *
+ *                                                                            *
+ * Comments: Only the topology indexes of the changed triggers and triggers   *
+ *           (transitively) depending on them are recalculated.               *
+ *                                                                            *
  ******************************************************************************/
-static void	dc_trigger_update_topology(void)
+static void	dc_trigger_update_topology(const zbx_vector_uint64_t *triggerids)
 {
-	zbx_hashset_iter_t	iter;
-	ZBX_DC_TRIGGER		*trigger;
+	int				i, j;
+	ZBX_DC_TRIGGER			*trigger;
+	ZBX_DC_TRIGGER_DEPLIST		*trigdep, *dependent;
+	zbx_vector_ptr_t		trigdeps;
+	zbx_hashset_t			visited;
 
-	zbx_hashset_iter_reset(&config->triggers, &iter);
-	while (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_iter_next(&iter)))
-		trigger->topoindex = 1;
+	zbx_vector_ptr_create(&trigdeps);
+	zbx_hashset_create(&visited, (size_t)triggerids->values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (i = 0; i < triggerids->values_num; i++)
+	{
+		/* triggers without dependencies have the lowest index */
+		if (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_search(&config->triggers, &triggerids->values[i])))
+			trigger->topoindex = 1;
+
+		if (NULL == (trigdep = (ZBX_DC_TRIGGER_DEPLIST *)zbx_hashset_search(&config->trigdeps,
+				&triggerids->values[i])))
+		{
+			continue;
+		}
+
+		if (NULL != zbx_hashset_search(&visited, &trigdep->triggerid))
+			continue;
+
+		zbx_hashset_insert(&visited, &trigdep->triggerid, sizeof(trigdep->triggerid));
+		zbx_vector_ptr_append(&trigdeps, trigdep);
+	}
+
+	/* the vector is extended while iterating to collect all dependent triggers */
+	for (i = 0; i < trigdeps.values_num; i++)
+	{
+		trigdep = (ZBX_DC_TRIGGER_DEPLIST *)trigdeps.values[i];
+
+		for (j = 0; j < trigdep->dependents.values_num; j++)
+		{
+			dependent = (ZBX_DC_TRIGGER_DEPLIST *)trigdep->dependents.values[j];
+
+			if (NULL != zbx_hashset_search(&visited, &dependent->triggerid))
+				continue;
+
+			zbx_hashset_insert(&visited, &dependent->triggerid, sizeof(dependent->triggerid));
+			zbx_vector_ptr_append(&trigdeps, dependent);
+		}
+	}
+
+	for (i = 0; i < trigdeps.values_num; i++)
+	{
+		trigdep = (ZBX_DC_TRIGGER_DEPLIST *)trigdeps.values[i];
+
+		if (NULL != trigdep->trigger)
+			trigdep->trigger->topoindex = 1;
+	}
+
+	DCconfig_sort_triggers_topologically(&trigdeps);
 
-	DCconfig_sort_triggers_topologically();
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() changed:%d updated:%d", __func__, triggerids->values_num,
+			trigdeps.values_num);
+
+	zbx_hashset_destroy(&visited);
+	zbx_vector_ptr_destroy(&trigdeps);
 }
 
 static int	zbx_default_ptr_pair_ptr_compare_func(const void *d1, const void *d2)
@@ -4824,16 +5085,94 @@ static int	dc_timer_calculate_nextcheck(time_t now, zbx_uint64_t seed)
 	return nextcheck;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_trigger_update_timer                                          *
+ *                                                                            *
+ * Purpose: adds/removes trigger to/from timer queue depending on trigger     *
+ *          status, functionality and time functions                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_trigger_update_timer(ZBX_DC_TRIGGER *trigger, int now)
+{
+	zbx_binary_heap_elem_t	elem;
+
+	if (TRIGGER_STATUS_DISABLED == trigger->status || TRIGGER_FUNCTIONAL_FALSE == trigger->functional ||
+			ZBX_TRIGGER_TIMER_QUEUE != trigger->timer)
+	{
+		if (ZBX_LOC_QUEUE == trigger->location)
+		{
+			zbx_binary_heap_remove_direct(&config->timer_queue, trigger->triggerid);
+			trigger->location = ZBX_LOC_NOWHERE;
+		}
+
+		return;
+	}
+
+	/* keep already scheduled triggers in their place */
+	if (ZBX_LOC_QUEUE == trigger->location)
+		return;
+
+	trigger->nextcheck = dc_timer_calculate_nextcheck(now, trigger->triggerid);
+	elem.key = trigger->triggerid;
+	elem.data = (void *)trigger;
+	zbx_binary_heap_insert(&config->timer_queue, &elem);
+	trigger->location = ZBX_LOC_QUEUE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_item_link_triggers                                            *
+ *                                                                            *
+ * Purpose: adds triggers to the list of triggers using the item              *
+ *                                                                            *
+ * Parameters: item          - [IN] the item                                  *
+ *             itemtrigs     - [IN] the item-trigger pairs                    *
+ *             itemtrigs_num - [IN] the number of item-trigger pairs          *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_item_link_triggers(ZBX_DC_ITEM *item, const zbx_ptr_pair_t *itemtrigs, int itemtrigs_num)
+{
+	int	i, j, triggers_num = 0;
+
+	if (NULL != item->cold->triggers)
+	{
+		while (NULL != item->cold->triggers[triggers_num])
+			triggers_num++;
+	}
+
+	item->cold->triggers = (ZBX_DC_TRIGGER **)config->items.mem_realloc_func(item->cold->triggers,
+			(triggers_num + itemtrigs_num + 1) * sizeof(ZBX_DC_TRIGGER *));
+
+	for (i = 0; i < itemtrigs_num; i++)
+	{
+		for (j = 0; j < triggers_num; j++)
+		{
+			if (item->cold->triggers[j] == itemtrigs[i].second)
+				break;
+		}
+
+		if (j == triggers_num)
+			item->cold->triggers[triggers_num++] = (ZBX_DC_TRIGGER *)itemtrigs[i].second;
+	}
+
+	item->cold->triggers[triggers_num] = NULL;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_trigger_update_cache                                          *
  *                                                                            *
- * Purpose: updates trigger related cache data;                               *
+ * Purpose: updates trigger related cache data of the changed triggers;       *
  *              1) time triggers assigned to timer processes                  *
  *              2) trigger functionality (if it uses contain disabled         *
  *                 items/hosts)                                               *
  *              3) list of triggers each item is used by                      *
  *                                                                            *
+ * Comments: Links to the triggers no longer using an item are removed from   *
+ *           the item trigger list during sync (see dc_item_unlink_trigger),  *
+ *           so here the links of changed triggers are only added.            *
+ *                                                                            *
  ******************************************************************************/
 static void	dc_trigger_update_cache(void)
 {
@@ -4841,59 +5180,94 @@ static void	dc_trigger_update_cache(void)
 	ZBX_DC_TRIGGER		*trigger;
 	ZBX_DC_FUNCTION		*function;
 	ZBX_DC_ITEM		*item;
-	int			i, j, k, now;
+	int			i, j, now;
 	zbx_ptr_pair_t		itemtrig;
 	zbx_vector_ptr_pair_t	itemtrigs;
+	zbx_vector_uint64_t	functionids;
 	ZBX_DC_HOST		*host;
 
-	zbx_hashset_iter_reset(&config->triggers, &iter);
-	while (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_iter_next(&iter)))
+	if (0 != trigger_changes.update_all)
 	{
-		trigger->functional = TRIGGER_FUNCTIONAL_TRUE;
-		trigger->timer = ZBX_TRIGGER_TIMER_UNKNOWN;
+		zbx_hashset_iter_reset(&config->items, &iter);
+		while (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL != item->cold->triggers)
+				item->cold->triggers[0] = NULL;
+		}
+
+		zbx_vector_uint64_clear(&trigger_changes.triggerids);
+
+		zbx_hashset_iter_reset(&config->triggers, &iter);
+		while (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_iter_next(&iter)))
+			zbx_vector_uint64_append(&trigger_changes.triggerids, trigger->triggerid);
+	}
+	else
+	{
+		zbx_vector_uint64_sort(&trigger_changes.triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(&trigger_changes.triggerids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 	}
 
 	zbx_vector_ptr_pair_create(&itemtrigs);
-	zbx_hashset_iter_reset(&config->functions, &iter);
-	while (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_iter_next(&iter)))
-	{
+	zbx_vector_uint64_create(&functionids);
+	now = time(NULL);
 
-		if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &function->itemid)) ||
-				NULL == (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_search(&config->triggers, &function->triggerid)))
+	for (i = 0; i < trigger_changes.triggerids.values_num; i++)
+	{
+		if (NULL == (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_search(&config->triggers,
+				&trigger_changes.triggerids.values[i])))
 		{
 			continue;
 		}
 
-		/* cache item - trigger link */
-		if (0 != item->update_triggers)
+		trigger->functional = TRIGGER_FUNCTIONAL_TRUE;
+		trigger->timer = ZBX_TRIGGER_TIMER_UNKNOWN;
+
+		get_functionids(&functionids, trigger->expression);
+		get_functionids(&functionids, trigger->recovery_expression);
+
+		for (j = 0; j < functionids.values_num; j++)
 		{
+			if (NULL == (function = (ZBX_DC_FUNCTION *)zbx_hashset_search(&config->functions,
+					&functionids.values[j])) || function->triggerid != trigger->triggerid)
+			{
+				continue;
+			}
+
+			if (NULL == (item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &function->itemid)))
+				continue;
+
+			/* cache item - trigger link */
 			itemtrig.first = item;
 			itemtrig.second = trigger;
 			zbx_vector_ptr_pair_append(&itemtrigs, itemtrig);
-		}
 
-		/* disable functionality for triggers with expression containing */
-		/* disabled or not monitored items                               */
+			/* disable functionality for triggers with expression containing */
+			/* disabled or not monitored items                               */
 
-		if (TRIGGER_FUNCTIONAL_FALSE == trigger->functional)
-			continue;
+			if (TRIGGER_FUNCTIONAL_FALSE == trigger->functional)
+				continue;
 
-		if (ITEM_STATUS_DISABLED == item->status ||
-				(NULL == (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &item->hostid)) ||
-						HOST_STATUS_NOT_MONITORED == host->status))
-		{
-			trigger->functional = TRIGGER_FUNCTIONAL_FALSE;
+			if (ITEM_STATUS_DISABLED == item->status ||
+					(NULL == (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &item->hostid)) ||
+							HOST_STATUS_NOT_MONITORED == host->status))
+			{
+				trigger->functional = TRIGGER_FUNCTIONAL_FALSE;
+			}
+
+			if (1 == function->timer)
+				trigger->timer = ZBX_TRIGGER_TIMER_QUEUE;
 		}
 
-		if (1 == function->timer)
-			trigger->timer = ZBX_TRIGGER_TIMER_QUEUE;
+		zbx_vector_uint64_clear(&functionids);
+
+		dc_trigger_update_timer(trigger, now);
 	}
 
 	zbx_vector_ptr_pair_sort(&itemtrigs, zbx_default_ptr_pair_ptr_compare_func);
 	zbx_vector_ptr_pair_uniq(&itemtrigs, zbx_default_ptr_pair_ptr_compare_func);
 
 	/* update links from items to triggers */
-	for (i = 0; i < itemtrigs.values_num; i++)
+	for (i = 0; i < itemtrigs.values_num; i = j)
 	{
 		for (j = i + 1; j < itemtrigs.values_num; j++)
 		{
@@ -4901,42 +5275,14 @@ static void	dc_trigger_update_cache(void)
 				break;
 		}
 
-		item = (ZBX_DC_ITEM *)itemtrigs.values[i].first;
-		item->update_triggers = 0;
-		item->triggers = (ZBX_DC_TRIGGER **)config->items.mem_realloc_func(item->triggers, (j - i + 1) * sizeof(ZBX_DC_TRIGGER *));
-
-		for (k = i; k < j; k++)
-			item->triggers[k - i] = (ZBX_DC_TRIGGER *)itemtrigs.values[k].second;
+		dc_item_link_triggers((ZBX_DC_ITEM *)itemtrigs.values[i].first, &itemtrigs.values[i], j - i);
+	}
 
-		item->triggers[j - i] = NULL;
-
-		i = j - 1;
-	}
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() triggers:%d links:%d", __func__, trigger_changes.triggerids.values_num,
+			itemtrigs.values_num);
 
+	zbx_vector_uint64_destroy(&functionids);
 	zbx_vector_ptr_pair_destroy(&itemtrigs);
-
-	/* add triggers to timer queue */
-	now = time(NULL);
-	zbx_binary_heap_clear(&config->timer_queue);
-	zbx_hashset_iter_reset(&config->triggers, &iter);
-	while (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_iter_next(&iter)))
-	{
-		zbx_binary_heap_elem_t	elem;
-
-		if (TRIGGER_STATUS_DISABLED == trigger->status)
-			continue;
-
-		if (TRIGGER_FUNCTIONAL_FALSE == trigger->functional)
-			continue;
-
-		if (ZBX_TRIGGER_TIMER_QUEUE != trigger->timer)
-			continue;
-
-		trigger->nextcheck = dc_timer_calculate_nextcheck(now, trigger->triggerid);
-		elem.key = trigger->triggerid;
-		elem.data = (void *)trigger;
-		zbx_binary_heap_insert(&config->timer_queue, &elem);
-	}
 }
 
 /******************************************************************************
@@ -4966,16 +5312,41 @@ static void	dc_hostgroups_update_cache(void)
 
 /******************************************************************************
  *                                                                            *
- * Function: DCsync_configuration                                             *
+ * Function: DCsync_configuration_start_workers                               *
+ *                                                                            *
+ * Purpose: starts threads comparing independent configuration tables in     *
+ *          parallel during configuration synchronization                     *
+ *                                                                            *
+ * Parameters: workers_num - [IN] the number of threads to start              *
+ *                                                                            *
+ * Comments: Must be called only by the configuration syncer process. Each    *
+ *           thread keeps its own database connection.                        *
+ *                                                                            *
+ ******************************************************************************/
+void	DCsync_configuration_start_workers(int workers_num)
+{
+	zbx_dbsync_workers_init(workers_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_sync_configuration                                            *
  *                                                                            *
  * Purpose: Synchronize configuration data from database                      *
  *                                                                            *
+ * Parameters: mode     - [IN] the synchronization mode                       *
+ *             snapshot - [IN] the snapshot to read the largest tables from   *
+ *                             instead of database, can be NULL               *
+ *                                                                            *
+ * Return value: SUCCEED - the configuration was synchronized                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
  * Author: Alexander Vladishev, Aleksandrs Saveljevs                          *
  *                                                                            *
  ******************************************************************************/
-void	DCsync_configuration(unsigned char mode)
+static int	dc_sync_configuration(unsigned char mode, zbx_dbsnapshot_t *snapshot)
 {
-	int		i, flags;
+	int		i, flags, ret = FAIL;
 	double		sec, csec, hsec, hisec, htsec, gmsec, hmsec, ifsec, isec, tsec, dsec, fsec, expr_sec, csec2,
 			hsec2, hisec2, htsec2, gmsec2, hmsec2, ifsec2, isec2, tsec2, dsec2, fsec2, expr_sec2,
 			action_sec, action_sec2, action_op_sec, action_op_sec2, action_condition_sec,
@@ -4993,12 +5364,19 @@ void	DCsync_configuration(unsigned char mode)
 
 	double		autoreg_csec, autoreg_csec2;
 	zbx_dbsync_t	autoreg_config_sync;
+	zbx_dbsync_batch_t	batch;
 	zbx_uint64_t	update_flags = 0;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
+	sync_lock_max = 0;
+
 	zbx_dbsync_init_env(config);
 
+	/* the changelog records reflected in snapshot are restored after the snapshot is loaded */
+	if (NULL == snapshot)
+		zbx_dbsync_env_prepare(mode);
+
 	/* global configuration must be synchronized directly with database */
 	zbx_dbsync_init(&config_sync, ZBX_DBSYNC_INIT);
 	zbx_dbsync_init(&autoreg_config_sync, mode);
@@ -5038,15 +5416,22 @@ void	DCsync_configuration(unsigned char mode)
 	zbx_dbsync_init(&maintenance_group_sync, mode);
 	zbx_dbsync_init(&maintenance_host_sync, mode);
 
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_config(&config_sync))
-		goto out;
-	csec = zbx_time() - sec;
+	if (NULL != snapshot)
+	{
+		items_sync.snapshot = zbx_dbsnapshot_get_table(snapshot, ZBX_DBSNAPSHOT_ITEMS);
+		template_items_sync.snapshot = zbx_dbsnapshot_get_table(snapshot, ZBX_DBSNAPSHOT_TEMPLATE_ITEMS);
+		prototype_items_sync.snapshot = zbx_dbsnapshot_get_table(snapshot, ZBX_DBSNAPSHOT_PROTOTYPE_ITEMS);
+		itempp_sync.snapshot = zbx_dbsnapshot_get_table(snapshot, ZBX_DBSNAPSHOT_ITEM_PREPROCS);
+		func_sync.snapshot = zbx_dbsnapshot_get_table(snapshot, ZBX_DBSNAPSHOT_FUNCTIONS);
+		triggers_sync.snapshot = zbx_dbsnapshot_get_table(snapshot, ZBX_DBSNAPSHOT_TRIGGERS);
+	}
 
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_autoreg_psk(&autoreg_config_sync))
+	zbx_dbsync_batch_init(&batch);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_config, &config_sync, &csec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_autoreg_psk, &autoreg_config_sync, &autoreg_csec);
+
+	if (FAIL == zbx_dbsync_batch_run(&batch))
 		goto out;
-	autoreg_csec = zbx_time() - sec;
 
 	/* sync global configuration settings */
 	START_SYNC;
@@ -5061,25 +5446,14 @@ void	DCsync_configuration(unsigned char mode)
 
 	/* sync macro related data, to support macro resolving during configuration sync */
 
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_host_templates(&htmpl_sync))
-		goto out;
-	htsec = zbx_time() - sec;
+	zbx_dbsync_batch_init(&batch);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_host_templates, &htmpl_sync, &htsec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_global_macros, &gmacro_sync, &gmsec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_host_macros, &hmacro_sync, &hmsec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_host_tags, &host_tag_sync, &host_tag_sec);
 
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_global_macros(&gmacro_sync))
-		goto out;
-	gmsec = zbx_time() - sec;
-
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_host_macros(&hmacro_sync))
+	if (FAIL == zbx_dbsync_batch_run(&batch))
 		goto out;
-	hmsec = zbx_time() - sec;
-
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_host_tags(&host_tag_sync))
-		goto out;
-	host_tag_sec = zbx_time() - sec;
 
 	START_SYNC;
 	sec = zbx_time();
@@ -5099,37 +5473,32 @@ void	DCsync_configuration(unsigned char mode)
 	host_tag_sec2 = zbx_time() - sec;
 	FINISH_SYNC;
 
-	/* sync host data to support host lookups when resolving macros during configuration sync */
-
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_hosts(&hosts_sync))
-		goto out;
-	hsec = zbx_time() - sec;
-
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_host_inventory(&hi_sync))
-		goto out;
-	hisec = zbx_time() - sec;
+	/* changed user macros affect items, triggers and preprocessing steps without changelog records */
+	if (0 != htmpl_sync.add_num + htmpl_sync.update_num + htmpl_sync.remove_num +
+			gmacro_sync.add_num + gmacro_sync.update_num + gmacro_sync.remove_num +
+			hmacro_sync.add_num + hmacro_sync.update_num + hmacro_sync.remove_num)
+	{
+		zbx_dbsync_env_ignore_changelog();
+	}
 
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_host_groups(&hgroups_sync))
-		goto out;
-	if (FAIL == zbx_dbsync_compare_host_group_hosts(&hgroup_host_sync))
-		goto out;
-	hgroups_sec = zbx_time() - sec;
+	/* sync host data to support host lookups when resolving macros during configuration sync */
 
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_maintenances(&maintenance_sync))
-		goto out;
-	if (FAIL == zbx_dbsync_compare_maintenance_tags(&maintenance_tag_sync))
+	zbx_dbsync_batch_init(&batch);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_hosts, &hosts_sync, &hsec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_host_inventory, &hi_sync, &hisec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_host_groups, &hgroups_sync, &hgroups_sec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_host_group_hosts, &hgroup_host_sync, &hgroups_sec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_maintenances, &maintenance_sync, &maintenance_sec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_maintenance_tags, &maintenance_tag_sync, &maintenance_sec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_maintenance_periods, &maintenance_period_sync,
+			&maintenance_sec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_maintenance_groups, &maintenance_group_sync,
+			&maintenance_sec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_maintenance_hosts, &maintenance_host_sync,
+			&maintenance_sec);
+
+	if (FAIL == zbx_dbsync_batch_run(&batch))
 		goto out;
-	if (FAIL == zbx_dbsync_compare_maintenance_periods(&maintenance_period_sync))
-		goto out;
-	if (FAIL == zbx_dbsync_compare_maintenance_groups(&maintenance_group_sync))
-		goto out;
-	if (FAIL == zbx_dbsync_compare_maintenance_hosts(&maintenance_host_sync))
-		goto out;
-	maintenance_sec = zbx_time() - sec;
 
 	START_SYNC;
 	sec = zbx_time();
@@ -5171,27 +5540,16 @@ void	DCsync_configuration(unsigned char mode)
 
 	/* sync item data to support item lookups when resolving macros during configuration sync */
 
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_interfaces(&if_sync))
-		goto out;
-	ifsec = zbx_time() - sec;
+	zbx_dbsync_batch_init(&batch);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_interfaces, &if_sync, &ifsec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_items, &items_sync, &isec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_template_items, &template_items_sync, &isec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_prototype_items, &prototype_items_sync, &isec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_item_preprocs, &itempp_sync, &itempp_sec);
 
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_items(&items_sync))
-		goto out;
-
-	if (FAIL == zbx_dbsync_compare_template_items(&template_items_sync))
+	if (FAIL == zbx_dbsync_batch_run(&batch))
 		goto out;
 
-	if (FAIL == zbx_dbsync_compare_prototype_items(&prototype_items_sync))
-		goto out;
-	isec = zbx_time() - sec;
-
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_item_preprocs(&itempp_sync))
-		goto out;
-	itempp_sec = zbx_time() - sec;
-
 	START_SYNC;
 
 	/* resolves macros for interface_snmpaddrs, must be after DCsync_hmacros() */
@@ -5231,55 +5589,23 @@ void	DCsync_configuration(unsigned char mode)
 
 	/* sync rest of the data */
 
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_triggers(&triggers_sync))
-		goto out;
-	tsec = zbx_time() - sec;
-
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_trigger_dependency(&tdep_sync))
-		goto out;
-	dsec = zbx_time() - sec;
-
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_expressions(&expr_sync))
-		goto out;
-	expr_sec = zbx_time() - sec;
-
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_actions(&action_sync))
-		goto out;
-	action_sec = zbx_time() - sec;
-
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_action_ops(&action_op_sync))
-		goto out;
-	action_op_sec = zbx_time() - sec;
-
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_action_conditions(&action_condition_sync))
-		goto out;
-	action_condition_sec = zbx_time() - sec;
-
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_trigger_tags(&trigger_tag_sync))
-		goto out;
-	trigger_tag_sec = zbx_time() - sec;
-
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_correlations(&correlation_sync))
-		goto out;
-	correlation_sec = zbx_time() - sec;
-
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_corr_conditions(&corr_condition_sync))
+	zbx_dbsync_batch_init(&batch);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_triggers, &triggers_sync, &tsec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_trigger_dependency, &tdep_sync, &dsec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_expressions, &expr_sync, &expr_sec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_actions, &action_sync, &action_sec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_action_ops, &action_op_sync, &action_op_sec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_action_conditions, &action_condition_sync,
+			&action_condition_sec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_trigger_tags, &trigger_tag_sync, &trigger_tag_sec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_correlations, &correlation_sync, &correlation_sec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_corr_conditions, &corr_condition_sync,
+			&corr_condition_sec);
+	zbx_dbsync_batch_add(&batch, zbx_dbsync_compare_corr_operations, &corr_operation_sync,
+			&corr_operation_sec);
+
+	if (FAIL == zbx_dbsync_batch_run(&batch))
 		goto out;
-	corr_condition_sec = zbx_time() - sec;
-
-	sec = zbx_time();
-	if (FAIL == zbx_dbsync_compare_corr_operations(&corr_operation_sync))
-		goto out;
-	corr_operation_sec = zbx_time() - sec;
 
 	START_SYNC;
 
@@ -5328,30 +5654,19 @@ void	DCsync_configuration(unsigned char mode)
 
 	sec = zbx_time();
 
-	if (0 != hosts_sync.add_num + hosts_sync.update_num + hosts_sync.remove_num)
-		update_flags |= ZBX_DBSYNC_UPDATE_HOSTS;
-
-	if (0 != items_sync.add_num + items_sync.update_num + items_sync.remove_num)
-		update_flags |= ZBX_DBSYNC_UPDATE_ITEMS;
-
-	if (0 != func_sync.add_num + func_sync.update_num + func_sync.remove_num)
-		update_flags |= ZBX_DBSYNC_UPDATE_FUNCTIONS;
-
-	if (0 != triggers_sync.add_num + triggers_sync.update_num + triggers_sync.remove_num)
-		update_flags |= ZBX_DBSYNC_UPDATE_TRIGGERS;
-
-	if (0 != tdep_sync.add_num + tdep_sync.update_num + tdep_sync.remove_num)
-		update_flags |= ZBX_DBSYNC_UPDATE_TRIGGER_DEPENDENCY;
-
 	/* update trigger topology if trigger dependency was changed */
-	if (0 != (update_flags & ZBX_DBSYNC_UPDATE_TRIGGER_DEPENDENCY))
-		dc_trigger_update_topology();
+	if (0 != trigger_changes.dep_triggerids.values_num)
+	{
+		dc_trigger_update_topology(&trigger_changes.dep_triggerids);
+		zbx_vector_uint64_clear(&trigger_changes.dep_triggerids);
+	}
 
 	/* update various trigger related links in cache */
-	if (0 != (update_flags & (ZBX_DBSYNC_UPDATE_HOSTS | ZBX_DBSYNC_UPDATE_ITEMS | ZBX_DBSYNC_UPDATE_FUNCTIONS |
-			ZBX_DBSYNC_UPDATE_TRIGGERS)))
+	if (0 != trigger_changes.update_all || 0 != trigger_changes.triggerids.values_num)
 	{
 		dc_trigger_update_cache();
+		zbx_vector_uint64_clear(&trigger_changes.triggerids);
+		trigger_changes.update_all = 0;
 	}
 
 	update_sec = zbx_time() - sec;
@@ -5480,6 +5795,7 @@ void	DCsync_configuration(unsigned char mode)
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() total sql  : " ZBX_FS_DBL " sec.", __func__, total);
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() total sync : " ZBX_FS_DBL " sec.", __func__, total2);
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() lock       : " ZBX_FS_DBL " sec longest.", __func__, sync_lock_max);
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() proxies    : %d (%d slots)", __func__,
 				config->proxies.num_data, config->proxies.num_slots);
@@ -5588,7 +5904,13 @@ void	DCsync_configuration(unsigned char mode)
 		for (i = 0; ZBX_POLLER_TYPE_COUNT > i; i++)
 		{
 			zabbix_log(LOG_LEVEL_DEBUG, "%s() queue[%d]   : %d (%d allocated)", __func__,
-					i, config->queues[i].elems_num, config->queues[i].elems_alloc);
+					i, config->queues[i].heap.elems_num, config->queues[i].heap.elems_alloc);
+
+			if (NULL != config->queues[i].wheel)
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "%s() wheel[%d]   : %d", __func__,
+						i, zbx_timer_wheel_elems_num(config->queues[i].wheel));
+			}
 		}
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() pqueue     : %d (%d allocated)", __func__,
@@ -5605,6 +5927,8 @@ void	DCsync_configuration(unsigned char mode)
 
 		zbx_mem_dump_stats(LOG_LEVEL_DEBUG, config_mem);
 	}
+
+	ret = SUCCEED;
 out:
 	if (0 == sync_in_progress)
 	{
@@ -5618,6 +5942,9 @@ out:
 
 	FINISH_SYNC;
 
+	if (SUCCEED == ret)
+		zbx_dbsync_env_flush_changelog();
+
 	zbx_dbsync_clear(&config_sync);
 	zbx_dbsync_clear(&autoreg_config_sync);
 	zbx_dbsync_clear(&hosts_sync);
@@ -5655,7 +5982,125 @@ out:
 	if (SUCCEED == ZBX_CHECK_LOG_LEVEL(LOG_LEVEL_TRACE))
 		DCdump_configuration();
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCsync_configuration                                             *
+ *                                                                            *
+ * Purpose: Synchronize configuration data from database                      *
+ *                                                                            *
+ ******************************************************************************/
+void	DCsync_configuration(unsigned char mode)
+{
+	dc_sync_configuration(mode, NULL);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_snapshot_load                                           *
+ *                                                                            *
+ * Purpose: initializes configuration cache from snapshot                     *
+ *                                                                            *
+ * Parameters: path - [IN] the snapshot file path                             *
+ *                                                                            *
+ * Return value: SUCCEED - configuration cache was initialized                *
+ *               FAIL    - the snapshot cannot be used, configuration cache   *
+ *                         must be initialized from database                  *
+ *                                                                            *
+ * Comments: The largest tables are read from snapshot, the rest from         *
+ *           database. The changes made after the snapshot was written are    *
+ *           applied by the following incremental synchronization.            *
+ *                                                                            *
+ ******************************************************************************/
+int	DCconfig_snapshot_load(const char *path)
+{
+	zbx_dbsnapshot_t	*snapshot;
+	char			*error = NULL;
+	double			sec;
+	int			ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	sec = zbx_time();
+
+	if (SUCCEED != zbx_dbsnapshot_open(path, &snapshot, &error))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot load configuration cache snapshot \"%s\": %s", path, error);
+		zbx_free(error);
+		ret = FAIL;
+		goto out;
+	}
+
+	if (SUCCEED == dc_sync_configuration(ZBX_DBSYNC_INIT, snapshot) && FAIL == zbx_dbsnapshot_failed(snapshot))
+	{
+		zbx_dbsync_env_restore_changelog(zbx_dbsnapshot_get_changelog(snapshot),
+				zbx_dbsnapshot_get_clock(snapshot));
+	}
+	else
+	{
+		/* without restored changelog the following synchronization compares whole tables */
+		zabbix_log(LOG_LEVEL_WARNING, "configuration cache was partially loaded from snapshot \"%s\","
+				" synchronizing with database", path);
+	}
+
+	zbx_dbsnapshot_close(snapshot);
+
+	DCsync_configuration(ZBX_DBSYNC_UPDATE);
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "configuration cache loaded from snapshot \"%s\" in " ZBX_FS_DBL " sec",
+			path, zbx_time() - sec);
+
+	ret = SUCCEED;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_snapshot_write                                          *
+ *                                                                            *
+ * Purpose: writes configuration cache snapshot                               *
+ *                                                                            *
+ * Parameters: path - [IN] the snapshot file path                             *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was written                           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The snapshot rows are selected from database, so configuration   *
+ *           cache is not locked while writing.                               *
+ *           This function must be called by configuration syncer, which      *
+ *           keeps the changelog records needed to update configuration cache *
+ *           loaded from the written snapshot.                                *
+ *                                                                            *
+ ******************************************************************************/
+int	DCconfig_snapshot_write(const char *path)
+{
+	char	*error = NULL;
+	double	sec;
+	int	ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	sec = zbx_time();
+
+	if (SUCCEED != (ret = zbx_dbsnapshot_write(path, &error)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write configuration cache snapshot \"%s\": %s", path, error);
+		zbx_free(error);
+	}
+	else
+		zbx_dbsync_env_set_snapshot_clock((int)sec);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s " ZBX_FS_DBL " sec", __func__, zbx_result_string(ret),
+			zbx_time() - sec);
+
+	return ret;
 }
 
 /******************************************************************************
@@ -5904,62 +6349,461 @@ static zbx_hash_t	__config_regexp_hash(const void *data)
 	return ZBX_DEFAULT_STRING_HASH_FUNC(regexp->name);
 }
 
-static int	__config_regexp_compare(const void *d1, const void *d2)
-{
-	const ZBX_DC_REGEXP	*r1 = (const ZBX_DC_REGEXP *)d1;
-	const ZBX_DC_REGEXP	*r2 = (const ZBX_DC_REGEXP *)d2;
+static int	__config_regexp_compare(const void *d1, const void *d2)
+{
+	const ZBX_DC_REGEXP	*r1 = (const ZBX_DC_REGEXP *)d1;
+	const ZBX_DC_REGEXP	*r2 = (const ZBX_DC_REGEXP *)d2;
+
+	return r1->name == r2->name ? 0 : strcmp(r1->name, r2->name);
+}
+
+#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+static zbx_hash_t	__config_psk_hash(const void *data)
+{
+	const ZBX_DC_PSK	*psk_i = (const ZBX_DC_PSK *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_ALGO(psk_i->tls_psk_identity, strlen(psk_i->tls_psk_identity),
+			ZBX_DEFAULT_HASH_SEED);
+}
+
+static int	__config_psk_compare(const void *d1, const void *d2)
+{
+	const ZBX_DC_PSK	*psk_1 = (const ZBX_DC_PSK *)d1;
+	const ZBX_DC_PSK	*psk_2 = (const ZBX_DC_PSK *)d2;
+
+	return psk_1->tls_psk_identity == psk_2->tls_psk_identity ? 0 : strcmp(psk_1->tls_psk_identity,
+			psk_2->tls_psk_identity);
+}
+#endif
+
+static int	__config_timer_compare(const void *d1, const void *d2)
+{
+	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
+	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
+
+	const ZBX_DC_TRIGGER		*t1 = (const ZBX_DC_TRIGGER *)e1->data;
+	const ZBX_DC_TRIGGER		*t2 = (const ZBX_DC_TRIGGER *)e2->data;
+
+	ZBX_RETURN_IF_NOT_EQUAL(t1->nextcheck, t2->nextcheck);
+
+	return 0;
+}
+
+static zbx_hash_t	__config_data_session_hash(const void *data)
+{
+	const zbx_data_session_t	*session = (const zbx_data_session_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_UINT64_HASH_FUNC(&session->hostid);
+	return ZBX_DEFAULT_STRING_HASH_ALGO(session->token, strlen(session->token), hash);
+}
+
+static int	__config_data_session_compare(const void *d1, const void *d2)
+{
+	const zbx_data_session_t	*s1 = (const zbx_data_session_t *)d1;
+	const zbx_data_session_t	*s2 = (const zbx_data_session_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(s1->hostid, s2->hostid);
+	return strcmp(s1->token, s2->token);
+}
+
+/* configuration cache compaction */
+
+/* the free memory fragmentation (%) to start compaction at */
+#define ZBX_DC_COMPACT_FRAGMENTATION	25
+/* the number of hashset slots processed between time limit checks */
+#define ZBX_DC_COMPACT_SLOTS		1000
+/* the maximum time configuration cache is locked by a compaction pass, in milliseconds */
+#define ZBX_DC_COMPACT_LOCK_MSEC	10
+
+typedef struct
+{
+	size_t			offset;			/* the hashset offset in configuration cache */
+	int			relocate_entries;	/* 1 - the entries are not referenced by pointers */
+	zbx_hashset_data_func_t	data_func;		/* relocates memory owned by entries */
+}
+zbx_dc_compact_table_t;
+
+/* the configuration cache compaction cursor - the table and its hashset slot to continue with */
+static int	dc_compact_table = 0, dc_compact_slot = 0;
+/* the fragmentation at the start of compaction and the fragmentation to start the next compaction at */
+static double	dc_compact_fragmentation, dc_compact_threshold = ZBX_DC_COMPACT_FRAGMENTATION;
+
+#define ZBX_DC_COMPACT_IDLE		0
+#define ZBX_DC_COMPACT_RUNNING		1
+#define ZBX_DC_COMPACT_INTERRUPTED	2
+
+/* the compaction state, changed from signal handler by DCconfig_compact_interrupt() */
+static volatile sig_atomic_t	dc_compact_state = ZBX_DC_COMPACT_IDLE;
+
+static void	*dc_mem_relocate(void *ptr)
+{
+	return zbx_mem_relocate(config_mem, ptr);
+}
+
+#define DC_RELOCATE_VECTOR(vector)							\
+											\
+do											\
+{											\
+	if (NULL != (vector)->values)							\
+		(vector)->values = dc_mem_relocate((vector)->values);			\
+}											\
+while (0)
+
+static void	dc_compact_item(void *data)
+{
+	ZBX_DC_ITEM	*item = (ZBX_DC_ITEM *)data;
+
+	item->cold = (ZBX_DC_ITEM_COLD *)dc_mem_relocate(item->cold);
+
+	if (NULL != item->cold->triggers)
+		item->cold->triggers = (ZBX_DC_TRIGGER **)dc_mem_relocate(item->cold->triggers);
+}
+
+static void	dc_compact_masteritem(void *data)
+{
+	DC_RELOCATE_VECTOR(&((ZBX_DC_MASTERITEM *)data)->dep_itemids);
+}
+
+static void	dc_compact_preprocitem(void *data)
+{
+	DC_RELOCATE_VECTOR(&((ZBX_DC_PREPROCITEM *)data)->preproc_ops);
+}
+
+static void	dc_compact_trigger(void *data)
+{
+	DC_RELOCATE_VECTOR(&((ZBX_DC_TRIGGER *)data)->tags);
+}
+
+static void	dc_compact_trigdep(void *data)
+{
+	DC_RELOCATE_VECTOR(&((ZBX_DC_TRIGGER_DEPLIST *)data)->dependencies);
+	DC_RELOCATE_VECTOR(&((ZBX_DC_TRIGGER_DEPLIST *)data)->dependents);
+}
+
+static void	dc_compact_host(void *data)
+{
+	DC_RELOCATE_VECTOR(&((ZBX_DC_HOST *)data)->interfaces_v);
+}
+
+static void	dc_compact_htmpl(void *data)
+{
+	DC_RELOCATE_VECTOR(&((ZBX_DC_HTMPL *)data)->templateids);
+}
+
+static void	dc_compact_gmacro_m(void *data)
+{
+	DC_RELOCATE_VECTOR(&((ZBX_DC_GMACRO_M *)data)->gmacros);
+}
+
+static void	dc_compact_hmacro_hm(void *data)
+{
+	DC_RELOCATE_VECTOR(&((ZBX_DC_HMACRO_HM *)data)->hmacros);
+}
+
+static void	dc_compact_interface_addr(void *data)
+{
+	DC_RELOCATE_VECTOR(&((ZBX_DC_INTERFACE_ADDR *)data)->interfaceids);
+}
+
+static void	dc_compact_interface_item(void *data)
+{
+	DC_RELOCATE_VECTOR(&((ZBX_DC_INTERFACE_ITEM *)data)->itemids);
+}
+
+static void	dc_compact_regexp(void *data)
+{
+	DC_RELOCATE_VECTOR(&((ZBX_DC_REGEXP *)data)->expressionids);
+}
+
+static void	dc_compact_action(void *data)
+{
+	DC_RELOCATE_VECTOR(&((zbx_dc_action_t *)data)->conditions);
+}
+
+static void	dc_compact_host_tag_index(void *data)
+{
+	DC_RELOCATE_VECTOR(&((zbx_dc_host_tag_index_t *)data)->tags);
+}
+
+static void	dc_compact_correlation(void *data)
+{
+	zbx_dc_correlation_t	*correlation = (zbx_dc_correlation_t *)data;
+
+	DC_RELOCATE_VECTOR(&correlation->conditions);
+	DC_RELOCATE_VECTOR(&correlation->operations);
+}
+
+static void	dc_compact_hostgroup(void *data)
+{
+	zbx_dc_hostgroup_t	*group = (zbx_dc_hostgroup_t *)data;
+
+	if (0 != (group->flags & ZBX_DC_HOSTGROUP_FLAGS_NESTED_GROUPIDS))
+		DC_RELOCATE_VECTOR(&group->nested_groupids);
+
+	zbx_hashset_relocate_slots(&group->hostids, dc_mem_relocate);
+	zbx_hashset_relocate_entries(&group->hostids, 0, group->hostids.num_slots, dc_mem_relocate, NULL);
+}
+
+static void	dc_compact_maintenance(void *data)
+{
+	zbx_dc_maintenance_t	*maintenance = (zbx_dc_maintenance_t *)data;
+
+	DC_RELOCATE_VECTOR(&maintenance->groupids);
+	DC_RELOCATE_VECTOR(&maintenance->hostids);
+	DC_RELOCATE_VECTOR(&maintenance->tags);
+	DC_RELOCATE_VECTOR(&maintenance->periods);
+}
+
+#define DC_COMPACT_TABLE(hashset, relocate_entries, data_func)	\
+		{offsetof(ZBX_DC_CONFIG, hashset), relocate_entries, data_func}
+
+/* The entries of hashsets referenced by pointers from other configuration cache objects (or */
+/* from process local data, like strpool strings) cannot be relocated, only their slots and  */
+/* the memory owned by the entries is relocated.                                             */
+static const zbx_dc_compact_table_t	dc_compact_tables[] = {
+	DC_COMPACT_TABLE(items, 0, dc_compact_item),
+	DC_COMPACT_TABLE(items_hk, 1, NULL),
+	DC_COMPACT_TABLE(template_items, 1, NULL),
+	DC_COMPACT_TABLE(prototype_items, 1, NULL),
+	DC_COMPACT_TABLE(numitems, 1, NULL),
+	DC_COMPACT_TABLE(snmpitems, 1, NULL),
+	DC_COMPACT_TABLE(ipmiitems, 1, NULL),
+	DC_COMPACT_TABLE(trapitems, 1, NULL),
+	DC_COMPACT_TABLE(dependentitems, 1, NULL),
+	DC_COMPACT_TABLE(logitems, 1, NULL),
+	DC_COMPACT_TABLE(dbitems, 1, NULL),
+	DC_COMPACT_TABLE(sshitems, 1, NULL),
+	DC_COMPACT_TABLE(telnetitems, 1, NULL),
+	DC_COMPACT_TABLE(simpleitems, 1, NULL),
+	DC_COMPACT_TABLE(jmxitems, 1, NULL),
+	DC_COMPACT_TABLE(calcitems, 1, NULL),
+	DC_COMPACT_TABLE(masteritems, 1, dc_compact_masteritem),
+	DC_COMPACT_TABLE(preprocitems, 1, dc_compact_preprocitem),
+	DC_COMPACT_TABLE(httpitems, 1, NULL),
+	DC_COMPACT_TABLE(functions, 0, NULL),
+	DC_COMPACT_TABLE(triggers, 0, dc_compact_trigger),
+	DC_COMPACT_TABLE(trigdeps, 0, dc_compact_trigdep),
+	DC_COMPACT_TABLE(hosts, 0, dc_compact_host),
+	DC_COMPACT_TABLE(hosts_h, 1, NULL),
+	DC_COMPACT_TABLE(hosts_p, 1, NULL),
+	DC_COMPACT_TABLE(proxies, 0, NULL),
+	DC_COMPACT_TABLE(host_inventories, 1, NULL),
+	DC_COMPACT_TABLE(host_inventories_auto, 1, NULL),
+	DC_COMPACT_TABLE(ipmihosts, 1, NULL),
+	DC_COMPACT_TABLE(htmpls, 1, dc_compact_htmpl),
+	DC_COMPACT_TABLE(gmacros, 0, NULL),
+	DC_COMPACT_TABLE(gmacros_m, 1, dc_compact_gmacro_m),
+	DC_COMPACT_TABLE(hmacros, 0, NULL),
+	DC_COMPACT_TABLE(hmacros_hm, 1, dc_compact_hmacro_hm),
+	DC_COMPACT_TABLE(interfaces, 0, NULL),
+	DC_COMPACT_TABLE(interfaces_snmp, 0, NULL),
+	DC_COMPACT_TABLE(interfaces_ht, 1, NULL),
+	DC_COMPACT_TABLE(interface_snmpaddrs, 1, dc_compact_interface_addr),
+	DC_COMPACT_TABLE(interface_snmpitems, 1, dc_compact_interface_item),
+	DC_COMPACT_TABLE(regexps, 0, dc_compact_regexp),
+	DC_COMPACT_TABLE(expressions, 0, NULL),
+	DC_COMPACT_TABLE(actions, 0, dc_compact_action),
+	DC_COMPACT_TABLE(action_conditions, 0, NULL),
+	DC_COMPACT_TABLE(trigger_tags, 0, NULL),
+	DC_COMPACT_TABLE(host_tags, 0, NULL),
+	DC_COMPACT_TABLE(host_tags_index, 0, dc_compact_host_tag_index),
+	DC_COMPACT_TABLE(correlations, 0, dc_compact_correlation),
+	DC_COMPACT_TABLE(corr_conditions, 0, NULL),
+	DC_COMPACT_TABLE(corr_operations, 0, NULL),
+	DC_COMPACT_TABLE(hostgroups, 0, dc_compact_hostgroup),
+	DC_COMPACT_TABLE(preprocops, 0, NULL),
+	DC_COMPACT_TABLE(maintenances, 0, dc_compact_maintenance),
+	DC_COMPACT_TABLE(maintenance_periods, 0, NULL),
+	DC_COMPACT_TABLE(maintenance_tags, 0, NULL),
+	DC_COMPACT_TABLE(strpool, 0, NULL),
+	DC_COMPACT_TABLE(data_sessions, 0, NULL)
+};
+
+#undef DC_COMPACT_TABLE
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_compact_arrays                                                *
+ *                                                                            *
+ * Purpose: relocates configuration cache arrays not owned by hashsets        *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_compact_arrays(void)
+{
+	int	i;
+
+	DC_RELOCATE_VECTOR(&config->hostgroups_name);
+
+	for (i = 0; i < ZBX_POLLER_TYPE_COUNT; i++)
+	{
+		config->queues[i].heap.elems = (zbx_binary_heap_elem_t *)dc_mem_relocate(config->queues[i].heap.elems);
+
+		/* timer wheel elements are referenced by slot lists and cannot be relocated */
+		if (NULL != config->queues[i].wheel)
+			zbx_hashset_relocate_slots(&config->queues[i].wheel->elems, dc_mem_relocate);
+	}
+
+	config->pqueue.elems = (zbx_binary_heap_elem_t *)dc_mem_relocate(config->pqueue.elems);
+	config->timer_queue.elems = (zbx_binary_heap_elem_t *)dc_mem_relocate(config->timer_queue.elems);
+}
+
+#undef DC_RELOCATE_VECTOR
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_compact                                                       *
+ *                                                                            *
+ * Purpose: performs configuration cache compaction pass                      *
+ *                                                                            *
+ * Parameters: time_limit - [IN] the maximum time to keep configuration cache *
+ *                               locked, in seconds                           *
+ *                                                                            *
+ * Return value: SUCCEED - the compaction is finished or is not required      *
+ *               FAIL    - the compaction was interrupted because of time     *
+ *                         limit and must be continued with the next pass     *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_compact(double time_limit)
+{
+	double	time_start, fragmentation;
+	int	ret = FAIL;
+
+	WRLOCK_CACHE;
+
+	time_start = zbx_time();
+
+	if (0 == dc_compact_table && 0 == dc_compact_slot)
+	{
+		if (dc_compact_threshold > (dc_compact_fragmentation = zbx_mem_get_fragmentation(config_mem)))
+		{
+			ret = SUCCEED;
+			goto out;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() starting compaction, fragmentation:%.2f%%", __func__,
+				dc_compact_fragmentation);
+	}
+
+	while (dc_compact_table < (int)ARRSIZE(dc_compact_tables))
+	{
+		const zbx_dc_compact_table_t	*table = &dc_compact_tables[dc_compact_table];
+		zbx_hashset_t			*hashset;
+
+		hashset = (zbx_hashset_t *)((char *)config + table->offset);
+
+		if (0 == dc_compact_slot)
+			zbx_hashset_relocate_slots(hashset, dc_mem_relocate);
+
+		if (0 != table->relocate_entries || NULL != table->data_func)
+		{
+			dc_compact_slot = zbx_hashset_relocate_entries(hashset, dc_compact_slot, ZBX_DC_COMPACT_SLOTS,
+					0 != table->relocate_entries ? dc_mem_relocate : NULL, table->data_func);
+		}
+		else
+			dc_compact_slot = hashset->num_slots;
+
+		if (dc_compact_slot >= hashset->num_slots)
+		{
+			dc_compact_table++;
+			dc_compact_slot = 0;
+		}
+
+		if (zbx_time() - time_start > time_limit)
+			goto out;
+	}
+
+	dc_compact_arrays();
 
-	return r1->name == r2->name ? 0 : strcmp(r1->name, r2->name);
-}
+	fragmentation = zbx_mem_get_fragmentation(config_mem);
 
-#if defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-static zbx_hash_t	__config_psk_hash(const void *data)
-{
-	const ZBX_DC_PSK	*psk_i = (const ZBX_DC_PSK *)data;
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() finished compaction, fragmentation:%.2f%% -> %.2f%%", __func__,
+			dc_compact_fragmentation, fragmentation);
 
-	return ZBX_DEFAULT_STRING_HASH_ALGO(psk_i->tls_psk_identity, strlen(psk_i->tls_psk_identity),
-			ZBX_DEFAULT_HASH_SEED);
-}
+	/* if compaction did not help, wait until fragmentation grows before trying again */
+	if (1 > dc_compact_fragmentation - fragmentation)
+		dc_compact_threshold = MAX(ZBX_DC_COMPACT_FRAGMENTATION, fragmentation + 5);
+	else
+		dc_compact_threshold = ZBX_DC_COMPACT_FRAGMENTATION;
 
-static int	__config_psk_compare(const void *d1, const void *d2)
-{
-	const ZBX_DC_PSK	*psk_1 = (const ZBX_DC_PSK *)d1;
-	const ZBX_DC_PSK	*psk_2 = (const ZBX_DC_PSK *)d2;
+	dc_compact_table = 0;
+	ret = SUCCEED;
+out:
+	UNLOCK_CACHE;
 
-	return psk_1->tls_psk_identity == psk_2->tls_psk_identity ? 0 : strcmp(psk_1->tls_psk_identity,
-			psk_2->tls_psk_identity);
+	return ret;
 }
-#endif
 
-static int	__config_timer_compare(const void *d1, const void *d2)
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_compact                                                 *
+ *                                                                            *
+ * Purpose: reduces configuration cache memory fragmentation by relocating    *
+ *          hashset entries and arrays                                        *
+ *                                                                            *
+ * Parameters: time_limit - [IN] the maximum compaction time, in seconds      *
+ *                                                                            *
+ * Return value: SUCCEED - the compaction is finished, is not required or     *
+ *                         was stopped by time limit and will be continued    *
+ *                         with the next call                                 *
+ *               FAIL    - the compaction was interrupted by shutdown or      *
+ *                         DCconfig_compact_interrupt(), the caller must not  *
+ *                         sleep for the rest of its idle time                *
+ *                                                                            *
+ * Comments: The compaction is performed in short passes, leaving the cache   *
+ *           unlocked between passes for at least the same time.             *
+ *                                                                            *
+ *           The compaction state is kept in process memory, so it must be    *
+ *           performed by a single process (configuration syncer).            *
+ *                                                                            *
+ *           Chunks are moved to the free space before them and objects in    *
+ *           sparse slab pages are moved to other pages of the slab, so free  *
+ *           memory gradually accumulates in larger chunks.                   *
+ *                                                                            *
+ ******************************************************************************/
+int	DCconfig_compact(int time_limit)
 {
-	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
-	const zbx_binary_heap_elem_t	*e2 = (const zbx_binary_heap_elem_t *)d2;
-
-	const ZBX_DC_TRIGGER		*t1 = (const ZBX_DC_TRIGGER *)e1->data;
-	const ZBX_DC_TRIGGER		*t2 = (const ZBX_DC_TRIGGER *)e2->data;
+	double		time_end;
+	int		ret;
+	struct timespec	ts = {0, ZBX_DC_COMPACT_LOCK_MSEC * 1000000};
 
-	ZBX_RETURN_IF_NOT_EQUAL(t1->nextcheck, t2->nextcheck);
+	time_end = zbx_time() + time_limit;
+	dc_compact_state = ZBX_DC_COMPACT_RUNNING;
 
-	return 0;
-}
+	while (ZBX_IS_RUNNING() && ZBX_DC_COMPACT_RUNNING == dc_compact_state &&
+			FAIL == dc_compact(ZBX_DC_COMPACT_LOCK_MSEC / 1000.0) && zbx_time() < time_end)
+	{
+		nanosleep(&ts, NULL);
+	}
 
-static zbx_hash_t	__config_data_session_hash(const void *data)
-{
-	const zbx_data_session_t	*session = (const zbx_data_session_t *)data;
-	zbx_hash_t			hash;
+	ret = (ZBX_IS_RUNNING() && ZBX_DC_COMPACT_RUNNING == dc_compact_state ? SUCCEED : FAIL);
+	dc_compact_state = ZBX_DC_COMPACT_IDLE;
 
-	hash = ZBX_DEFAULT_UINT64_HASH_FUNC(&session->hostid);
-	return ZBX_DEFAULT_STRING_HASH_ALGO(session->token, strlen(session->token), hash);
+	return ret;
 }
 
-static int	__config_data_session_compare(const void *d1, const void *d2)
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_compact_interrupt                                       *
+ *                                                                            *
+ * Purpose: interrupts configuration cache compaction                         *
+ *                                                                            *
+ * Return value: SUCCEED - the compaction was interrupted                     *
+ *               FAIL    - the compaction is not in progress                  *
+ *                                                                            *
+ * Comments: This function is called from signal handler to force reloading   *
+ *           of configuration cache while the idle time is used for           *
+ *           compaction, see DCconfig_compact().                              *
+ *                                                                            *
+ ******************************************************************************/
+int	DCconfig_compact_interrupt(void)
 {
-	const zbx_data_session_t	*s1 = (const zbx_data_session_t *)d1;
-	const zbx_data_session_t	*s2 = (const zbx_data_session_t *)d2;
+	if (ZBX_DC_COMPACT_RUNNING != dc_compact_state)
+		return FAIL;
 
-	ZBX_RETURN_IF_NOT_EQUAL(s1->hostid, s2->hostid);
-	return strcmp(s1->token, s2->token);
+	dc_compact_state = ZBX_DC_COMPACT_INTERRUPTED;
+
+	return SUCCEED;
 }
 
 /******************************************************************************
@@ -5986,6 +6830,8 @@ int	init_configuration_cache(char **error)
 		goto out;
 	}
 
+	zbx_mem_enable_slabs(config_mem);
+
 	config = (ZBX_DC_CONFIG *)__config_mem_malloc_func(NULL, sizeof(ZBX_DC_CONFIG) +
 			CONFIG_TIMER_FORKS * sizeof(zbx_vector_ptr_t));
 
@@ -6049,6 +6895,11 @@ int	init_configuration_cache(char **error)
 	CREATE_HASHSET(config->maintenance_periods, 0);
 	CREATE_HASHSET(config->maintenance_tags, 0);
 
+	CREATE_HASHSET(config->availability_updates, 0);
+	config->availability_coalesced = 0;
+	config->availability_coalesced_total = 0;
+	config->availability_written_total = 0;
+
 	CREATE_HASHSET_EXT(config->items_hk, 100, __config_item_hk_hash, __config_item_hk_compare);
 	CREATE_HASHSET_EXT(config->hosts_h, 10, __config_host_h_hash, __config_host_h_compare);
 	CREATE_HASHSET_EXT(config->hosts_p, 0, __config_host_h_hash, __config_host_h_compare);
@@ -6069,7 +6920,7 @@ int	init_configuration_cache(char **error)
 		switch (i)
 		{
 			case ZBX_POLLER_TYPE_JAVA:
-				zbx_binary_heap_create_ext(&config->queues[i],
+				zbx_binary_heap_create_ext(&config->queues[i].heap,
 						__config_java_elem_compare,
 						ZBX_BINARY_HEAP_OPTION_DIRECT,
 						__config_mem_malloc_func,
@@ -6077,7 +6928,7 @@ int	init_configuration_cache(char **error)
 						__config_mem_free_func);
 				break;
 			case ZBX_POLLER_TYPE_PINGER:
-				zbx_binary_heap_create_ext(&config->queues[i],
+				zbx_binary_heap_create_ext(&config->queues[i].heap,
 						__config_pinger_elem_compare,
 						ZBX_BINARY_HEAP_OPTION_DIRECT,
 						__config_mem_malloc_func,
@@ -6085,7 +6936,7 @@ int	init_configuration_cache(char **error)
 						__config_mem_free_func);
 				break;
 			default:
-				zbx_binary_heap_create_ext(&config->queues[i],
+				zbx_binary_heap_create_ext(&config->queues[i].heap,
 						__config_heap_elem_compare,
 						ZBX_BINARY_HEAP_OPTION_DIRECT,
 						__config_mem_malloc_func,
@@ -6093,6 +6944,16 @@ int	init_configuration_cache(char **error)
 						__config_mem_free_func);
 				break;
 		}
+
+		if (0 != CONFIG_ITEM_QUEUE_TIMER_WHEEL)
+		{
+			config->queues[i].wheel = (zbx_timer_wheel_t *)__config_mem_malloc_func(NULL,
+					sizeof(zbx_timer_wheel_t));
+			zbx_timer_wheel_create_ext(config->queues[i].wheel, (int)time(NULL), __config_mem_malloc_func,
+					__config_mem_realloc_func, __config_mem_free_func);
+		}
+		else
+			config->queues[i].wheel = NULL;
 	}
 
 	zbx_binary_heap_create_ext(&config->pqueue,
@@ -6119,6 +6980,7 @@ int	init_configuration_cache(char **error)
 	config->availability_diff_ts = 0;
 	config->sync_ts = 0;
 	config->item_sync_ts = 0;
+	config->um_revision = 0;
 
 	config->internal_actions = 0;
 
@@ -6126,6 +6988,7 @@ int	init_configuration_cache(char **error)
 	if (0 != CONFIG_TIMER_FORKS)
 	{
 		config->maintenance_update = ZBX_MAINTENANCE_UPDATE_FALSE;
+		config->maintenance_lastcheck = 0;
 		config->maintenance_update_flags = (zbx_uint64_t *)__config_mem_malloc_func(NULL, sizeof(zbx_uint64_t) *
 				ZBX_MAINTENANCE_UPDATE_FLAGS_NUM());
 		memset(config->maintenance_update_flags, 0, sizeof(zbx_uint64_t) * ZBX_MAINTENANCE_UPDATE_FLAGS_NUM());
@@ -6145,6 +7008,10 @@ int	init_configuration_cache(char **error)
 	else
 		config->session_token = NULL;
 
+	zbx_vector_uint64_create(&trigger_changes.triggerids);
+	zbx_vector_uint64_create(&trigger_changes.dep_triggerids);
+	trigger_changes.update_all = 0;
+
 #undef CREATE_HASHSET
 #undef CREATE_HASHSET_EXT
 out:
@@ -6172,6 +7039,9 @@ void	free_configuration_cache(void)
 
 	UNLOCK_CACHE;
 
+	zbx_vector_uint64_destroy(&trigger_changes.dep_triggerids);
+	zbx_vector_uint64_destroy(&trigger_changes.triggerids);
+
 	zbx_rwlock_destroy(&config_lock);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -6594,17 +7464,17 @@ static void	DCget_item(DC_ITEM *dst_item, const ZBX_DC_ITEM *src_item)
 	dst_item->delay = zbx_strdup(NULL, src_item->delay);
 	dst_item->nextcheck = src_item->nextcheck;
 	dst_item->state = src_item->state;
-	dst_item->lastclock = src_item->lastclock;
+	dst_item->lastclock = src_item->cold->lastclock;
 	dst_item->flags = src_item->flags;
-	dst_item->lastlogsize = src_item->lastlogsize;
-	dst_item->mtime = src_item->mtime;
-	dst_item->history = src_item->history;
-	dst_item->inventory_link = src_item->inventory_link;
-	dst_item->valuemapid = src_item->valuemapid;
+	dst_item->lastlogsize = src_item->cold->lastlogsize;
+	dst_item->mtime = src_item->cold->mtime;
+	dst_item->history = src_item->cold->history;
+	dst_item->inventory_link = src_item->cold->inventory_link;
+	dst_item->valuemapid = src_item->cold->valuemapid;
 	dst_item->status = src_item->status;
-	dst_item->history_sec = src_item->history_sec;
+	dst_item->history_sec = src_item->cold->history_sec;
 
-	dst_item->error = zbx_strdup(NULL, src_item->error);
+	dst_item->error = zbx_strdup(NULL, src_item->cold->error);
 
 	switch (src_item->value_type)
 	{
@@ -7382,10 +8252,10 @@ int	DCconfig_lock_triggers_by_history_items(zbx_vector_ptr_t *history_items, zbx
 		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &history_item->itemid)))
 			continue;
 
-		if (NULL == dc_item->triggers)
+		if (NULL == dc_item->cold->triggers)
 			continue;
 
-		for (j = 0; NULL != (dc_trigger = dc_item->triggers[j]); j++)
+		for (j = 0; NULL != (dc_trigger = dc_item->cold->triggers[j]); j++)
 		{
 			if (TRIGGER_STATUS_ENABLED != dc_trigger->status)
 				continue;
@@ -7398,7 +8268,7 @@ int	DCconfig_lock_triggers_by_history_items(zbx_vector_ptr_t *history_items, zbx
 			}
 		}
 
-		for (j = 0; NULL != (dc_trigger = dc_item->triggers[j]); j++)
+		for (j = 0; NULL != (dc_trigger = dc_item->cold->triggers[j]); j++)
 		{
 			if (TRIGGER_STATUS_ENABLED != dc_trigger->status)
 				continue;
@@ -7521,12 +8391,13 @@ void	DCconfig_get_triggers_by_itemids(zbx_hashset_t *trigger_info, zbx_vector_pt
 	{
 		/* skip items which are not in configuration cache and items without triggers */
 
-		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])) || NULL == dc_item->triggers)
+		if (NULL == (dc_item = (ZBX_DC_ITEM *)zbx_hashset_search(&config->items, &itemids[i])) ||
+				NULL == dc_item->cold->triggers)
 			continue;
 
 		/* process all triggers for the specified item */
 
-		for (j = 0; NULL != (dc_trigger = dc_item->triggers[j]); j++)
+		for (j = 0; NULL != (dc_trigger = dc_item->cold->triggers[j]); j++)
 		{
 			if (TRIGGER_STATUS_ENABLED != dc_trigger->status)
 				continue;
@@ -7707,7 +8578,13 @@ void	zbx_dc_get_timer_triggerids(zbx_vector_uint64_t *triggerids, int now, int l
  ******************************************************************************/
 void	zbx_dc_clear_timer_queue(void)
 {
+	int	i;
+
 	WRLOCK_CACHE;
+
+	for (i = 0; i < config->timer_queue.elems_num; i++)
+		((ZBX_DC_TRIGGER *)config->timer_queue.elems[i].data)->location = ZBX_LOC_NOWHERE;
+
 	zbx_binary_heap_clear(&config->timer_queue);
 	UNLOCK_CACHE;
 }
@@ -7902,19 +8779,21 @@ unlock:
  * Return value: nextcheck or FAIL if no items for the specified queue        *
  *                                                                            *
  ******************************************************************************/
-static int	dc_config_get_queue_nextcheck(zbx_binary_heap_t *queue)
+static int	dc_config_get_queue_nextcheck(zbx_dc_item_queue_t *queue)
 {
 	int				nextcheck;
 	const zbx_binary_heap_elem_t	*min;
 	const ZBX_DC_ITEM		*dc_item;
 
-	if (FAIL == zbx_binary_heap_empty(queue))
+	if (FAIL == zbx_binary_heap_empty(&queue->heap))
 	{
-		min = zbx_binary_heap_find_min(queue);
+		min = zbx_binary_heap_find_min(&queue->heap);
 		dc_item = (const ZBX_DC_ITEM *)min->data;
 
 		nextcheck = dc_item->nextcheck;
 	}
+	else if (NULL != queue->wheel)
+		nextcheck = zbx_timer_wheel_next_time(queue->wheel);
 	else
 		nextcheck = FAIL;
 
@@ -7937,7 +8816,7 @@ static int	dc_config_get_queue_nextcheck(zbx_binary_heap_t *queue)
 int	DCconfig_get_poller_nextcheck(unsigned char poller_type)
 {
 	int			nextcheck;
-	zbx_binary_heap_t	*queue;
+	zbx_dc_item_queue_t	*queue;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() poller_type:%d", __func__, (int)poller_type);
 
@@ -8024,7 +8903,8 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
 int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 {
 	int			now, num = 0, max_items;
-	zbx_binary_heap_t	*queue;
+	zbx_dc_item_queue_t	*queue;
+	ZBX_DC_ITEM		*dc_item;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() poller_type:%d", __func__, (int)poller_type);
 
@@ -8046,17 +8926,12 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 
 	WRLOCK_CACHE;
 
-	while (num < max_items && FAIL == zbx_binary_heap_empty(queue))
+	while (num < max_items && NULL != (dc_item = dc_item_queue_find_min(queue, now)))
 	{
 		int				disable_until;
-		const zbx_binary_heap_elem_t	*min;
 		ZBX_DC_HOST			*dc_host;
-		ZBX_DC_ITEM			*dc_item;
 		static const ZBX_DC_ITEM	*dc_item_prev = NULL;
 
-		min = zbx_binary_heap_find_min(queue);
-		dc_item = (ZBX_DC_ITEM *)min->data;
-
 		if (dc_item->nextcheck > now)
 			break;
 
@@ -8074,7 +8949,7 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 			}
 		}
 
-		zbx_binary_heap_remove_min(queue);
+		zbx_binary_heap_remove_min(&queue->heap);
 		dc_item->location = ZBX_LOC_NOWHERE;
 
 		if (NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
@@ -8168,7 +9043,8 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 int	DCconfig_get_ipmi_poller_items(int now, DC_ITEM *items, int items_num, int *nextcheck)
 {
 	int			num = 0;
-	zbx_binary_heap_t	*queue;
+	zbx_dc_item_queue_t	*queue;
+	ZBX_DC_ITEM		*dc_item;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
@@ -8176,20 +9052,15 @@ int	DCconfig_get_ipmi_poller_items(int now, DC_ITEM *items, int items_num, int *
 
 	WRLOCK_CACHE;
 
-	while (num < items_num && FAIL == zbx_binary_heap_empty(queue))
+	while (num < items_num && NULL != (dc_item = dc_item_queue_find_min(queue, now)))
 	{
-		int				disable_until;
-		const zbx_binary_heap_elem_t	*min;
-		ZBX_DC_HOST			*dc_host;
-		ZBX_DC_ITEM			*dc_item;
-
-		min = zbx_binary_heap_find_min(queue);
-		dc_item = (ZBX_DC_ITEM *)min->data;
+		int		disable_until;
+		ZBX_DC_HOST	*dc_host;
 
 		if (dc_item->nextcheck > now)
 			break;
 
-		zbx_binary_heap_remove_min(queue);
+		zbx_binary_heap_remove_min(&queue->heap);
 		dc_item->location = ZBX_LOC_NOWHERE;
 
 		if (NULL == (dc_host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &dc_item->hostid)))
@@ -8738,6 +9609,43 @@ int	zbx_host_availability_is_set(const zbx_host_availability_t *ha)
 	return FAIL;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_queue_host_availability                                       *
+ *                                                                            *
+ * Purpose: queues host availability changes to be flushed into database      *
+ *                                                                            *
+ * Parameters: hostid     - [IN] the host identifier                          *
+ *             agent_type - [IN] the agent type (see ZBX_AGENT_* defines)     *
+ *             flags      - [IN] the changed agent availability fields        *
+ *                                                                            *
+ * Comments: The configuration cache must be locked already.                  *
+ *                                                                            *
+ *           Only the changed fields are queued, the values are taken from    *
+ *           configuration cache when flushing. So repeated changes of the    *
+ *           same host are coalesced into single database update.             *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_queue_host_availability(zbx_uint64_t hostid, unsigned char agent_type, unsigned char flags)
+{
+	zbx_dc_availability_update_t	*update;
+
+	if (NULL == (update = (zbx_dc_availability_update_t *)zbx_hashset_search(&config->availability_updates,
+			&hostid)))
+	{
+		zbx_dc_availability_update_t	update_local;
+
+		memset(&update_local, 0, sizeof(update_local));
+		update_local.hostid = hostid;
+		update = (zbx_dc_availability_update_t *)zbx_hashset_insert(&config->availability_updates,
+				&update_local, sizeof(update_local));
+	}
+	else
+		config->availability_coalesced++;
+
+	update->flags[agent_type] |= flags;
+}
+
 /**************************************************************************************
  *                                                                                    *
  * Host availability update example                                                   *
@@ -8796,7 +9704,8 @@ int	zbx_host_availability_is_set(const zbx_host_availability_t *ha)
  *                         failed                                             *
  *                                                                            *
  * Comments: The host availability fields are updated according to the above  *
- *           schema.                                                          *
+ *           schema. The changes are queued to be flushed into database by    *
+ *           DCflush_hosts_availability() function.                           *
  *                                                                            *
  ******************************************************************************/
 int	DChost_activate(zbx_uint64_t hostid, unsigned char agent_type, const zbx_timespec_t *ts,
@@ -8828,7 +9737,10 @@ int	DChost_activate(zbx_uint64_t hostid, unsigned char agent_type, const zbx_tim
 	DChost_set_agent_availability(dc_host, ts->sec, agent_type, out);
 
 	if (ZBX_FLAGS_AGENT_STATUS_NONE != out->flags)
+	{
+		dc_queue_host_availability(hostid, agent_type, out->flags);
 		ret = SUCCEED;
+	}
 unlock:
 	UNLOCK_CACHE;
 out:
@@ -8855,7 +9767,8 @@ out:
  *                         failed                                             *
  *                                                                            *
  * Comments: The host availability fields are updated according to the above  *
- *           schema.                                                          *
+ *           schema. The changes are queued to be flushed into database by    *
+ *           DCflush_hosts_availability() function.                           *
  *                                                                            *
  ******************************************************************************/
 int	DChost_deactivate(zbx_uint64_t hostid, unsigned char agent_type, const zbx_timespec_t *ts,
@@ -8926,7 +9839,10 @@ int	DChost_deactivate(zbx_uint64_t hostid, unsigned char agent_type, const zbx_t
 	DChost_set_agent_availability(dc_host, ts->sec, agent_type, out);
 
 	if (ZBX_FLAGS_AGENT_STATUS_NONE != out->flags)
+	{
+		dc_queue_host_availability(hostid, agent_type, out->flags);
 		ret = SUCCEED;
+	}
 unlock:
 	UNLOCK_CACHE;
 out:
@@ -9133,19 +10049,21 @@ exit:
  *                                                                            *
  * Purpose: assign each trigger an index based on trigger dependency topology *
  *                                                                            *
+ * Parameters: trigdeps - [IN] the trigger dependency lists with reset        *
+ *                             topology index                                 *
+ *                                                                            *
  * Author: Aleksandrs Saveljevs                                               *
  *                                                                            *
  ******************************************************************************/
-static void	DCconfig_sort_triggers_topologically(void)
+static void	DCconfig_sort_triggers_topologically(const zbx_vector_ptr_t *trigdeps)
 {
-	zbx_hashset_iter_t		iter;
+	int				i;
 	ZBX_DC_TRIGGER			*trigger;
 	const ZBX_DC_TRIGGER_DEPLIST	*trigdep;
 
-	zbx_hashset_iter_reset(&config->trigdeps, &iter);
-
-	while (NULL != (trigdep = (ZBX_DC_TRIGGER_DEPLIST *)zbx_hashset_iter_next(&iter)))
+	for (i = 0; i < trigdeps->values_num; i++)
 	{
+		trigdep = (const ZBX_DC_TRIGGER_DEPLIST *)trigdeps->values[i];
 		trigger = trigdep->trigger;
 
 		if (NULL == trigger || 1 < trigger->topoindex || 0 == trigdep->dependencies.values_num)
@@ -9229,6 +10147,12 @@ void	*DCconfig_get_stats(int request)
 		case ZBX_CONFSTATS_BUFFER_PFREE:
 			value_double = 100 * (double)config_mem->free_size / config_mem->orig_size;
 			return &value_double;
+		case ZBX_CONFSTATS_AVAILABILITY_WRITTEN:
+			value_uint = config->availability_written_total;
+			return &value_uint;
+		case ZBX_CONFSTATS_AVAILABILITY_COALESCED:
+			value_uint = config->availability_coalesced_total;
+			return &value_uint;
 		default:
 			return NULL;
 	}
@@ -9468,16 +10392,16 @@ void	DCrequeue_proxy(zbx_uint64_t hostid, unsigned char update_nextcheck, int pr
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
-static void	dc_get_host_macro_value(const ZBX_DC_HMACRO *macro, char **value)
+/* the resolved user macro value, the value points to configuration cache string pool */
+typedef struct
 {
-	if (ZBX_MACRO_ENV_NONSECURE == macro_env && ZBX_MACRO_VALUE_SECRET == macro->type)
-		*value = zbx_strdup(*value, ZBX_MACRO_SECRET_MASK);
-	else
-		*value = zbx_strdup(*value, macro->value);
+	const char	*value;
+	unsigned char	type;
 }
+zbx_dc_um_value_t;
 
 static void	dc_get_host_macro(const zbx_uint64_t *hostids, int host_num, const char *macro, const char *context,
-		char **value, char **value_default)
+		zbx_dc_um_value_t *value, zbx_dc_um_value_t *value_default)
 {
 	int			i, j;
 	const ZBX_DC_HMACRO_HM	*hmacro_hm;
@@ -9504,13 +10428,17 @@ static void	dc_get_host_macro(const zbx_uint64_t *hostids, int host_num, const c
 				{
 					if (0 == zbx_strcmp_null(hmacro->context, context))
 					{
-						dc_get_host_macro_value(hmacro, value);
+						value->value = hmacro->value;
+						value->type = hmacro->type;
 						return;
 					}
 
 					/* check for the default (without parameters) macro value */
-					if (NULL == *value_default && NULL != context && NULL == hmacro->context)
-						dc_get_host_macro_value(hmacro, value_default);
+					if (NULL == value_default->value && NULL != context && NULL == hmacro->context)
+					{
+						value_default->value = hmacro->value;
+						value_default->type = hmacro->type;
+					}
 				}
 			}
 		}
@@ -9537,15 +10465,8 @@ static void	dc_get_host_macro(const zbx_uint64_t *hostids, int host_num, const c
 	zbx_vector_uint64_destroy(&templateids);
 }
 
-static void	dc_get_global_macro_value(const ZBX_DC_GMACRO *macro, char **value)
-{
-	if (ZBX_MACRO_ENV_NONSECURE == macro_env && ZBX_MACRO_VALUE_SECRET == macro->type)
-		*value = zbx_strdup(*value, ZBX_MACRO_SECRET_MASK);
-	else
-		*value = zbx_strdup(*value, macro->value);
-}
-
-static void	dc_get_global_macro(const char *macro, const char *context, char **value, char **value_default)
+static void	dc_get_global_macro(const char *macro, const char *context, zbx_dc_um_value_t *value,
+		zbx_dc_um_value_t *value_default)
 {
 	int			i;
 	const ZBX_DC_GMACRO_M	*gmacro_m;
@@ -9563,22 +10484,40 @@ static void	dc_get_global_macro(const char *macro, const char *context, char **v
 			{
 				if (0 == zbx_strcmp_null(gmacro->context, context))
 				{
-					dc_get_global_macro_value(gmacro, value);
+					value->value = gmacro->value;
+					value->type = gmacro->type;
 					break;
 				}
 
 				/* check for the default (without parameters) macro value */
-				if (NULL == *value_default && NULL != context && NULL == gmacro->context)
-					dc_get_global_macro_value(gmacro, value_default);
+				if (NULL == value_default->value && NULL != context && NULL == gmacro->context)
+				{
+					value_default->value = gmacro->value;
+					value_default->type = gmacro->type;
+				}
 			}
 		}
 	}
 }
 
-static void	dc_get_user_macro(const zbx_uint64_t *hostids, int hostids_num, const char *macro, const char *context,
-		char **replace_to)
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_resolve_user_macro                                            *
+ *                                                                            *
+ * Purpose: finds user macro value in host, template and global macros        *
+ *                                                                            *
+ * Parameters: hostids     - [IN] the host identifiers                        *
+ *             hostids_num - [IN] the number of host identifiers              *
+ *             macro       - [IN] the macro name                              *
+ *             context     - [IN] the macro context, can be NULL              *
+ *             value       - [OUT] the resolved value, NULL value if the      *
+ *                                 macro was not found                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_resolve_user_macro(const zbx_uint64_t *hostids, int hostids_num, const char *macro,
+		const char *context, zbx_dc_um_value_t *value)
 {
-	char	*value = NULL, *value_default = NULL;
+	zbx_dc_um_value_t	value_default = {NULL, 0};
 
 	/* User macros should be expanded according to the following priority: */
 	/*                                                                     */
@@ -9591,23 +10530,166 @@ static void	dc_get_user_macro(const zbx_uint64_t *hostids, int hostids_num, cons
 	/* the host level, we try to expand global macros, passing the default */
 	/* macro value found on the host level, if any.                        */
 
-	dc_get_host_macro(hostids, hostids_num, macro, context, &value, &value_default);
+	value->value = NULL;
+
+	dc_get_host_macro(hostids, hostids_num, macro, context, value, &value_default);
+
+	if (NULL == value->value)
+		dc_get_global_macro(macro, context, value, &value_default);
+
+	if (NULL == value->value)
+		*value = value_default;
+}
+
+/*
+ * Resolved user macro cache.
+ *
+ * Resolving user macro walks host templates level by level, which is repeated for every item
+ * and every check. The resolved values are cached by processes (and configuration syncer
+ * threads) for single host lookups. The cache is dropped when host or global macros or
+ * host templates are changed in configuration cache (see um_revision).
+ */
+
+/* the maximum number of cached user macros before the cache is dropped */
+#define ZBX_DC_UM_CACHE_MAX	100000
+
+typedef struct
+{
+	zbx_uint64_t	hostid;
+	char		*macro;
+	char		*context;
+
+	/* the resolved value, NULL if the macro was not found */
+	char		*value;
+	unsigned char	type;
+}
+zbx_dc_um_cache_entry_t;
+
+static ZBX_THREAD_LOCAL zbx_hashset_t	dc_um_cache;
+static ZBX_THREAD_LOCAL zbx_uint64_t	dc_um_cache_revision;
+
+static zbx_hash_t	dc_um_cache_hash_func(const void *data)
+{
+	const zbx_dc_um_cache_entry_t	*entry = (const zbx_dc_um_cache_entry_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_UINT64_HASH_FUNC(&entry->hostid);
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(entry->macro, strlen(entry->macro), hash);
+
+	if (NULL != entry->context)
+		hash = ZBX_DEFAULT_STRING_HASH_ALGO(entry->context, strlen(entry->context), hash);
+
+	return hash;
+}
+
+static int	dc_um_cache_compare_func(const void *d1, const void *d2)
+{
+	const zbx_dc_um_cache_entry_t	*e1 = (const zbx_dc_um_cache_entry_t *)d1;
+	const zbx_dc_um_cache_entry_t	*e2 = (const zbx_dc_um_cache_entry_t *)d2;
+	int				ret;
+
+	ZBX_RETURN_IF_NOT_EQUAL(e1->hostid, e2->hostid);
+
+	if (0 != (ret = strcmp(e1->macro, e2->macro)))
+		return ret;
+
+	return zbx_strcmp_null(e1->context, e2->context);
+}
+
+static void	dc_um_cache_entry_clear(zbx_dc_um_cache_entry_t *entry)
+{
+	zbx_free(entry->macro);
+	zbx_free(entry->context);
+	zbx_free(entry->value);
+}
+
+static void	dc_um_cache_clear(void)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_dc_um_cache_entry_t	*entry;
+
+	zbx_hashset_iter_reset(&dc_um_cache, &iter);
+	while (NULL != (entry = (zbx_dc_um_cache_entry_t *)zbx_hashset_iter_next(&iter)))
+		dc_um_cache_entry_clear(entry);
 
-	if (NULL == value)
-		dc_get_global_macro(macro, context, &value, &value_default);
+	zbx_hashset_clear(&dc_um_cache);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_um_cache_get                                                  *
+ *                                                                            *
+ * Purpose: gets resolved user macro from cache, resolving it if necessary    *
+ *                                                                            *
+ * Parameters: hostid  - [IN] the host identifier, 0 for global macros        *
+ *             macro   - [IN] the macro name                                  *
+ *             context - [IN] the macro context, can be NULL                  *
+ *                                                                            *
+ * Return value: the cached user macro                                        *
+ *                                                                            *
+ * Comments: Configuration cache must be locked, except in configuration      *
+ *           syncer which is the only process changing it.                    *
+ *                                                                            *
+ ******************************************************************************/
+static const zbx_dc_um_cache_entry_t	*dc_um_cache_get(zbx_uint64_t hostid, const char *macro, const char *context)
+{
+	zbx_dc_um_cache_entry_t	entry_local, *entry;
+	zbx_dc_um_value_t	value;
 
-	if (NULL != value)
+	if (NULL == dc_um_cache.slots)
+	{
+		zbx_hashset_create(&dc_um_cache, 100, dc_um_cache_hash_func, dc_um_cache_compare_func);
+		dc_um_cache_revision = config->um_revision;
+	}
+	else if (dc_um_cache_revision != config->um_revision || ZBX_DC_UM_CACHE_MAX <= dc_um_cache.num_data)
 	{
-		zbx_free(*replace_to);
-		*replace_to = value;
+		dc_um_cache_clear();
+		dc_um_cache_revision = config->um_revision;
+	}
+
+	entry_local.hostid = hostid;
+	entry_local.macro = (char *)macro;
+	entry_local.context = (char *)context;
+
+	if (NULL != (entry = (zbx_dc_um_cache_entry_t *)zbx_hashset_search(&dc_um_cache, &entry_local)))
+		return entry;
+
+	dc_resolve_user_macro(&hostid, 0 == hostid ? 0 : 1, macro, context, &value);
+
+	entry_local.macro = zbx_strdup(NULL, macro);
+	entry_local.context = (NULL != context ? zbx_strdup(NULL, context) : NULL);
+	entry_local.value = (NULL != value.value ? zbx_strdup(NULL, value.value) : NULL);
+	entry_local.type = value.type;
+
+	return (zbx_dc_um_cache_entry_t *)zbx_hashset_insert(&dc_um_cache, &entry_local, sizeof(entry_local));
+}
+
+static void	dc_get_user_macro(const zbx_uint64_t *hostids, int hostids_num, const char *macro, const char *context,
+		char **replace_to)
+{
+	zbx_dc_um_value_t	value;
 
-		zbx_free(value_default);
+	/* the macros resolved for multiple hosts depend on the host combination and are not cached */
+	if (1 < hostids_num)
+	{
+		dc_resolve_user_macro(hostids, hostids_num, macro, context, &value);
 	}
-	else if (NULL != value_default)
+	else
 	{
-		zbx_free(*replace_to);
-		*replace_to = value_default;
+		const zbx_dc_um_cache_entry_t	*entry;
+
+		entry = dc_um_cache_get(0 == hostids_num ? 0 : hostids[0], macro, context);
+		value.value = entry->value;
+		value.type = entry->type;
 	}
+
+	if (NULL == value.value)
+		return;
+
+	if (ZBX_MACRO_ENV_NONSECURE == macro_env && ZBX_MACRO_VALUE_SECRET == value.type)
+		*replace_to = zbx_strdup(*replace_to, ZBX_MACRO_SECRET_MASK);
+	else
+		*replace_to = zbx_strdup(*replace_to, value.value);
 }
 
 void	DCget_user_macro(const zbx_uint64_t *hostids, int hostids_num, const char *macro, char **replace_to)
@@ -9947,7 +11029,7 @@ int	DCget_item_queue(zbx_vector_ptr_t *queue, int from, int to)
 					continue;
 				break;
 			case ITEM_TYPE_ZABBIX_ACTIVE:
-				if (dc_host->data_expected_from > (data_expected_from = dc_item->data_expected_from))
+				if (dc_host->data_expected_from > (data_expected_from = dc_item->cold->data_expected_from))
 					data_expected_from = dc_host->data_expected_from;
 				if (SUCCEED != zbx_interval_preproc(dc_item->delay, &delay, NULL, NULL))
 					continue;
@@ -10577,7 +11659,7 @@ int	DCget_data_expected_from(zbx_uint64_t itemid, int *seconds)
 	if (HOST_STATUS_MONITORED != dc_host->status)
 		goto unlock;
 
-	*seconds = MAX(dc_item->data_expected_from, dc_host->data_expected_from);
+	*seconds = MAX(dc_item->cold->data_expected_from, dc_host->data_expected_from);
 
 	ret = SUCCEED;
 unlock:
@@ -10914,6 +11996,85 @@ int	DCreset_hosts_availability(zbx_vector_ptr_t *hosts)
 	return 0 == hosts->values_num ? FAIL : SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DCget_queued_hosts_availability                                  *
+ *                                                                            *
+ * Purpose: gets queued host availability changes and clears the queue       *
+ *                                                                            *
+ * Parameters: hosts         - [OUT] changed host availability data           *
+ *             coalesced_num - [OUT] the number of changes coalesced with     *
+ *                                   already queued updates                   *
+ *                                                                            *
+ * Return value: SUCCEED - availability was changed for at least one host     *
+ *               FAIL    - no queued availability changes                     *
+ *                                                                            *
+ * Comments: The current availability values are taken from configuration    *
+ *           cache, so the caller must write them into database before the    *
+ *           next call of this function to keep the database updates in       *
+ *           order.                                                           *
+ *           The queue is checked without locking, so configuration cache is  *
+ *           not write locked when there are no queued changes. The changes   *
+ *           queued meanwhile are picked up by the next call.                 *
+ *                                                                            *
+ ******************************************************************************/
+int	DCget_queued_hosts_availability(zbx_vector_ptr_t *hosts, int *coalesced_num)
+{
+	const ZBX_DC_HOST			*host;
+	const zbx_dc_availability_update_t	*update;
+	zbx_host_availability_t			*ha;
+	zbx_hashset_iter_t			iter;
+	int					i;
+
+	*coalesced_num = 0;
+
+	if (0 == config->availability_updates.num_data)
+		return FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	WRLOCK_CACHE;
+
+	zbx_vector_ptr_reserve(hosts, config->availability_updates.num_data);
+
+	zbx_hashset_iter_reset(&config->availability_updates, &iter);
+	while (NULL != (update = (const zbx_dc_availability_update_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (NULL == (host = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &update->hostid)))
+			continue;
+
+		ha = (zbx_host_availability_t *)zbx_malloc(NULL, sizeof(zbx_host_availability_t));
+		zbx_host_availability_init(ha, host->hostid);
+
+		for (i = 0; i < ZBX_AGENT_MAX; i++)
+		{
+			if (ZBX_FLAGS_AGENT_STATUS_NONE == update->flags[i])
+				continue;
+
+			DChost_get_agent_availability(host, i, &ha->agents[i]);
+			ha->agents[i].flags = update->flags[i];
+		}
+
+		zbx_vector_ptr_append(hosts, ha);
+	}
+
+	zbx_hashset_clear(&config->availability_updates);
+
+	*coalesced_num = config->availability_coalesced;
+	config->availability_coalesced_total += (zbx_uint64_t)config->availability_coalesced;
+	config->availability_coalesced = 0;
+	config->availability_written_total += (zbx_uint64_t)hosts->values_num;
+
+	UNLOCK_CACHE;
+
+	zbx_vector_ptr_sort(hosts, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() hosts:%d coalesced:%d", __func__, hosts->values_num,
+			*coalesced_num);
+
+	return 0 == hosts->values_num ? FAIL : SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: DCget_hosts_availability                                         *
@@ -11940,19 +13101,19 @@ void	DCconfig_items_apply_changes(const zbx_vector_ptr_t *item_diff)
 			continue;
 
 		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_LASTLOGSIZE & diff->flags))
-			dc_item->lastlogsize = diff->lastlogsize;
+			dc_item->cold->lastlogsize = diff->lastlogsize;
 
 		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_MTIME & diff->flags))
-			dc_item->mtime = diff->mtime;
+			dc_item->cold->mtime = diff->mtime;
 
 		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_ERROR & diff->flags))
-			DCstrpool_replace(1, &dc_item->error, diff->error);
+			DCstrpool_replace(1, &dc_item->cold->error, diff->error);
 
 		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_STATE & diff->flags))
 			dc_item->state = diff->state;
 
 		if (0 != (ZBX_FLAGS_ITEM_DIFF_UPDATE_LASTCLOCK & diff->flags))
-			dc_item->lastclock = diff->lastclock;
+			dc_item->cold->lastclock = diff->lastclock;
 	}
 
 	UNLOCK_CACHE;
@@ -12517,14 +13678,14 @@ static void	zbx_get_item_tags(zbx_uint64_t itemid, zbx_vector_ptr_t *item_tags)
 
 	zbx_gather_tags_from_host(item->hostid, item_tags);
 
-	if (0 != item->templateid)
-		zbx_gather_tags_from_template_chain(item->templateid, item_tags);
+	if (0 != item->cold->templateid)
+		zbx_gather_tags_from_template_chain(item->cold->templateid, item_tags);
 
 	/* check for discovered item */
-	if (0 != item->parent_itemid && 4 == item->flags)
+	if (0 != item->cold->parent_itemid && 4 == item->flags)
 	{
 		if (NULL != (lld_item = (ZBX_DC_PROTOTYPE_ITEM *)zbx_hashset_search(&config->prototype_items,
-				&item->parent_itemid)))
+				&item->cold->parent_itemid)))
 		{
 			if (0 != lld_item->templateid)
 				zbx_gather_tags_from_template_chain(lld_item->templateid, item_tags);
@@ -47,6 +47,7 @@ typedef struct
 	unsigned char		recovery_mode;		/* see TRIGGER_RECOVERY_MODE_* defines   */
 	unsigned char		correlation_mode;	/* see ZBX_TRIGGER_CORRELATION_* defines */
 	unsigned char		timer;			/* see ZBX_TRIGGER_TIMER_* defines       */
+	unsigned char		location;		/* timer queue location, see ZBX_LOC_*   */
 
 	zbx_vector_ptr_t	tags;
 }
@@ -58,6 +59,7 @@ typedef struct zbx_dc_trigger_deplist
 	int			refcount;
 	ZBX_DC_TRIGGER		*trigger;
 	zbx_vector_ptr_t	dependencies;
+	zbx_vector_ptr_t	dependents;	/* the trigger lists depending on this trigger */
 }
 ZBX_DC_TRIGGER_DEPLIST;
 
@@ -72,38 +74,45 @@ typedef struct
 }
 ZBX_DC_FUNCTION;
 
+/* the item fields not used by poller queue scheduling */
 typedef struct
 {
-	zbx_uint64_t		itemid;
-	zbx_uint64_t		hostid;
-	zbx_uint64_t		interfaceid;
 	zbx_uint64_t		lastlogsize;
 	zbx_uint64_t		valuemapid;
-	const char		*key;
-	const char		*port;
+	zbx_uint64_t		templateid;
+	zbx_uint64_t		parent_itemid; /* from joined item_discovery table */
 	const char		*error;
-	const char		*delay;
 	ZBX_DC_TRIGGER		**triggers;
-	int			nextcheck;
 	int			lastclock;
 	int			mtime;
 	int			data_expected_from;
 	int			history_sec;
 	unsigned char		history;
+	unsigned char		inventory_link;
+}
+ZBX_DC_ITEM_COLD;
+
+/* The item fields used by poller queue scheduling are kept together and fit in a single cache line, */
+/* so scanning and requeuing items touches as little memory as possible. The rest of item fields   */
+/* are kept in separately allocated cold record.                                                    */
+typedef struct
+{
+	zbx_uint64_t		itemid;
+	zbx_uint64_t		hostid;
+	zbx_uint64_t		interfaceid;
+	const char		*key;
+	const char		*delay;
+	ZBX_DC_ITEM_COLD	*cold;
+	int			nextcheck;
 	unsigned char		type;
 	unsigned char		value_type;
 	unsigned char		poller_type;
 	unsigned char		state;
-	unsigned char		db_state;
-	unsigned char		inventory_link;
 	unsigned char		location;
 	unsigned char		flags;
 	unsigned char		status;
 	unsigned char		queue_priority;
 	unsigned char		schedulable;
-	unsigned char		update_triggers;
-	zbx_uint64_t		templateid;
-	zbx_uint64_t		parent_itemid; /* from joined item_discovery table */
 }
 ZBX_DC_ITEM;
 
@@ -699,6 +708,7 @@ typedef struct
 	int			active_until;
 	int			running_since;
 	int			running_until;
+	int			nextcheck;	/* the next time maintenance state must be recalculated */
 	zbx_vector_uint64_t	groupids;
 	zbx_vector_uint64_t	hostids;
 	zbx_vector_ptr_t	tags;
@@ -706,6 +716,14 @@ typedef struct
 }
 zbx_dc_maintenance_t;
 
+/* host availability changes waiting to be flushed into database */
+typedef struct
+{
+	zbx_uint64_t	hostid;
+	unsigned char	flags[ZBX_AGENT_MAX];	/* the changed agent fields, see ZBX_FLAGS_AGENT_STATUS_* defines */
+}
+zbx_dc_availability_update_t;
+
 typedef struct
 {
 	zbx_uint64_t	maintenancetagid;
@@ -738,6 +756,17 @@ typedef struct
 }
 zbx_dc_timer_trigger_t;
 
+/* the poller item queue */
+typedef struct
+{
+	/* the items ordered by nextcheck, only due items when timer wheel is used */
+	zbx_binary_heap_t	heap;
+
+	/* the items scheduled in the future, NULL if timer wheel is not used (see ItemQueueTimerWheel) */
+	zbx_timer_wheel_t	*wheel;
+}
+zbx_dc_item_queue_t;
+
 typedef struct
 {
 	/* timestamp of the last host availability diff sent to sever, used only by proxies */
@@ -746,10 +775,15 @@ typedef struct
 	int			sync_ts;
 	int			item_sync_ts;
 
+	/* incremented when host or global macros or host templates are changed, */
+	/* used to drop the resolved user macros cached by processes             */
+	zbx_uint64_t		um_revision;
+
 	unsigned int		internal_actions;		/* number of enabled internal actions */
 
 	/* maintenance processing management */
 	unsigned char		maintenance_update;		/* flag to trigger maintenance update by timers  */
+	int			maintenance_lastcheck;		/* the last maintenance state calculation time   */
 	zbx_uint64_t		*maintenance_update_flags;	/* Array of flags to manage timer maintenance updates.*/
 								/* Each array member contains 0/1 flag for 64 timers  */
 								/* indicating if the timer must process maintenance.  */
@@ -819,7 +853,11 @@ typedef struct
 							/* by PSK identity */
 #endif
 	zbx_hashset_t		data_sessions;
-	zbx_binary_heap_t	queues[ZBX_POLLER_TYPE_COUNT];
+	zbx_hashset_t		availability_updates;	/* queued host availability changes, coalesced per host */
+	int			availability_coalesced;	/* number of changes merged into already queued updates */
+	zbx_uint64_t		availability_coalesced_total;	/* statistics, see DCconfig_get_stats() */
+	zbx_uint64_t		availability_written_total;
+	zbx_dc_item_queue_t	queues[ZBX_POLLER_TYPE_COUNT];
 	zbx_binary_heap_t	pqueue;
 	zbx_binary_heap_t	timer_queue;
 	ZBX_DC_CONFIG_TABLE	*config;
@@ -595,16 +595,17 @@ static void	DCdump_items(void)
 				item->itemid, item->hostid, item->key);
 		zabbix_log(LOG_LEVEL_TRACE, "  type:%u value_type:%u", item->type, item->value_type);
 		zabbix_log(LOG_LEVEL_TRACE, "  interfaceid:" ZBX_FS_UI64, item->interfaceid);
-		zabbix_log(LOG_LEVEL_TRACE, "  state:%u error:'%s'", item->state, item->error);
+		zabbix_log(LOG_LEVEL_TRACE, "  state:%u error:'%s'", item->state, item->cold->error);
 		zabbix_log(LOG_LEVEL_TRACE, "  flags:%u status:%u", item->flags, item->status);
-		zabbix_log(LOG_LEVEL_TRACE, "  valuemapid:" ZBX_FS_UI64, item->valuemapid);
-		zabbix_log(LOG_LEVEL_TRACE, "  lastlogsize:" ZBX_FS_UI64 " mtime:%d", item->lastlogsize, item->mtime);
+		zabbix_log(LOG_LEVEL_TRACE, "  valuemapid:" ZBX_FS_UI64, item->cold->valuemapid);
+		zabbix_log(LOG_LEVEL_TRACE, "  lastlogsize:" ZBX_FS_UI64 " mtime:%d", item->cold->lastlogsize,
+				item->cold->mtime);
 		zabbix_log(LOG_LEVEL_TRACE, "  delay:'%s' nextcheck:%d lastclock:%d", item->delay, item->nextcheck,
-				item->lastclock);
-		zabbix_log(LOG_LEVEL_TRACE, "  data_expected_from:%d", item->data_expected_from);
-		zabbix_log(LOG_LEVEL_TRACE, "  history:%d history_sec:%d", item->history, item->history_sec);
+				item->cold->lastclock);
+		zabbix_log(LOG_LEVEL_TRACE, "  data_expected_from:%d", item->cold->data_expected_from);
+		zabbix_log(LOG_LEVEL_TRACE, "  history:%d history_sec:%d", item->cold->history, item->cold->history_sec);
 		zabbix_log(LOG_LEVEL_TRACE, "  poller_type:%u location:%u", item->poller_type, item->location);
-		zabbix_log(LOG_LEVEL_TRACE, "  inventory_link:%u", item->inventory_link);
+		zabbix_log(LOG_LEVEL_TRACE, "  inventory_link:%u", item->cold->inventory_link);
 		zabbix_log(LOG_LEVEL_TRACE, "  priority:%u schedulable:%u", item->queue_priority, item->schedulable);
 
 		for (j = 0; j < (int)ARRSIZE(trace_items); j++)
@@ -613,13 +614,13 @@ static void	DCdump_items(void)
 				trace_items[j].dump_func(ptr);
 		}
 
-		if (NULL != item->triggers)
+		if (NULL != item->cold->triggers)
 		{
 			ZBX_DC_TRIGGER	*trigger;
 
 			zabbix_log(LOG_LEVEL_TRACE, "  triggers:");
 
-			for (j = 0; NULL != (trigger = item->triggers[j]); j++)
+			for (j = 0; NULL != (trigger = item->cold->triggers[j]); j++)
 				zabbix_log(LOG_LEVEL_TRACE, "    triggerid:" ZBX_FS_UI64, trigger->triggerid);
 		}
 	}
@@ -104,6 +104,9 @@ void	DCsync_maintenances(zbx_dbsync_t *sync)
 		ZBX_STR2UCHAR(maintenance->tags_evaltype, row[4]);
 		maintenance->active_since = atoi(row[2]);
 		maintenance->active_until = atoi(row[3]);
+
+		/* force maintenance state recalculation */
+		maintenance->nextcheck = 0;
 	}
 
 	/* remove deleted maintenances */
@@ -308,6 +311,8 @@ void	DCsync_maintenance_periods(zbx_dbsync_t *sync)
 
 		if (0 == found)
 			zbx_vector_ptr_append(&maintenance->periods, period);
+
+		maintenance->nextcheck = 0;
 	}
 
 	/* remove deleted maintenance tags */
@@ -328,6 +333,8 @@ void	DCsync_maintenance_periods(zbx_dbsync_t *sync)
 
 			if (FAIL != index)
 				zbx_vector_ptr_remove_noorder(&maintenance->periods, index);
+
+			maintenance->nextcheck = 0;
 		}
 
 		zbx_hashset_remove_direct(&config->maintenance_periods, period);
@@ -701,6 +708,78 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_calculate_maintenance_nextcheck                               *
+ *                                                                            *
+ * Purpose: calculates the next time when maintenance state can change        *
+ *                                                                            *
+ * Parameter: maintenance - [IN] the maintenance with up to date state        *
+ *            now         - [IN] current time                                 *
+ *                                                                            *
+ * Return value: the time when maintenance state must be recalculated         *
+ *                                                                            *
+ * Comments: Maintenance periods can start only at their start time of day    *
+ *           (or start date for one time periods), so idle maintenance must   *
+ *           be checked at the nearest period start time. Running maintenance *
+ *           must be checked also when its longest running period ends.       *
+ *                                                                            *
+ ******************************************************************************/
+static int	dc_calculate_maintenance_nextcheck(const zbx_dc_maintenance_t *maintenance, time_t now)
+{
+	const zbx_dc_maintenance_period_t	*period;
+	struct tm				tm;
+	time_t					nextcheck, day_start, period_start;
+	int					i;
+
+	if (now >= maintenance->active_until)
+		return ZBX_JAN_2038;
+
+	if (now < maintenance->active_since)
+		return maintenance->active_since;
+
+	nextcheck = maintenance->active_until;
+
+	if (ZBX_MAINTENANCE_RUNNING == maintenance->state && maintenance->running_until < nextcheck)
+		nextcheck = maintenance->running_until;
+
+	tm = *localtime(&now);
+	day_start = dc_substract_time(now, tm.tm_hour * SEC_PER_HOUR + tm.tm_min * SEC_PER_MIN + tm.tm_sec, &tm);
+
+	for (i = 0; i < maintenance->periods.values_num; i++)
+	{
+		period = (const zbx_dc_maintenance_period_t *)maintenance->periods.values[i];
+
+		if (TIMEPERIOD_TYPE_ONETIME == period->type)
+		{
+			period_start = period->start_date;
+		}
+		else
+		{
+			period_start = dc_substract_time(day_start, -period->start_time, &tm);
+
+			if (period_start <= now)
+				period_start = dc_substract_time(period_start, -SEC_PER_DAY, &tm);
+
+			/* Running period end time is calculated from its start day which is found by going back */
+			/* from the current day. With DST changes in between the result can differ by the DST    */
+			/* offset depending on the current day, so running maintenance is also rechecked daily.   */
+			if (ZBX_MAINTENANCE_RUNNING == maintenance->state)
+			{
+				time_t	day_end;
+
+				if ((day_end = dc_substract_time(day_start, -SEC_PER_DAY, &tm)) < nextcheck)
+					nextcheck = day_end;
+			}
+		}
+
+		if (period_start > now && period_start < nextcheck)
+			nextcheck = period_start;
+	}
+
+	return (int)nextcheck;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_dc_maintenance_set_update_flags                              *
@@ -813,12 +892,37 @@ out:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_maintenance_cache_nested_groupids                             *
+ *                                                                            *
+ * Purpose: precache nested host groups of the specified maintenance          *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_maintenance_cache_nested_groupids(const zbx_dc_maintenance_t *maintenance)
+{
+	int			i;
+	zbx_dc_hostgroup_t	*group;
+
+	for (i = 0; i < maintenance->groupids.values_num; i++)
+	{
+		if (NULL != (group = (zbx_dc_hostgroup_t *)zbx_hashset_search(&config->hostgroups,
+				&maintenance->groupids.values[i])))
+		{
+			dc_hostgroup_cache_nested_groupids(group);
+		}
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_dc_update_maintenances                                       *
  *                                                                            *
  * Purpose: update maintenance state depending on maintenance periods         *
  *                                                                            *
+ * Parameters: modified_maintenanceids - [OUT] the maintenances with changed  *
+ *                                       state (optional)                     *
+ *                                                                            *
  * Return value: SUCCEED - maintenance status was changed, host/event update  *
  *                         must be performed                                  *
  *               FAIL    - otherwise                                          *
@@ -826,14 +930,21 @@ out:
  * Comments: This function calculates if any maintenance period is running    *
  *           and based on that sets current maintenance state - running/idle  *
  *           and period start/end time.                                       *
+ *           Maintenance state is recalculated only when its next check time  *
+ *           has come or when its configuration was changed.                  *
+ *           The modified maintenance identifiers are returned only if the    *
+ *           update was caused by maintenance periods alone. If maintenance   *
+ *           configuration was changed the vector is left empty and all hosts *
+ *           must be checked.                                                 *
  *                                                                            *
  ******************************************************************************/
-int	zbx_dc_update_maintenances(void)
+int	zbx_dc_update_maintenances(zbx_vector_uint64_t *modified_maintenanceids)
 {
 	zbx_dc_maintenance_t		*maintenance;
 	zbx_dc_maintenance_period_t	*period;
 	zbx_hashset_iter_t		iter;
-	int				i, running_num = 0, started_num = 0, stopped_num = 0, ret = FAIL;
+	int				i, running_num = 0, started_num = 0, stopped_num = 0, checked_num = 0,
+					modified, config_update = FAIL, ret = FAIL;
 	unsigned char			state;
 	time_t				now, period_start, period_end, running_since, running_until;
 
@@ -845,13 +956,23 @@ int	zbx_dc_update_maintenances(void)
 
 	if (ZBX_MAINTENANCE_UPDATE_TRUE == config->maintenance_update)
 	{
-		ret = SUCCEED;
+		ret = config_update = SUCCEED;
 		config->maintenance_update = ZBX_MAINTENANCE_UPDATE_FALSE;
 	}
 
 	zbx_hashset_iter_reset(&config->maintenances, &iter);
 	while (NULL != (maintenance = (zbx_dc_maintenance_t *)zbx_hashset_iter_next(&iter)))
 	{
+		/* the next check times are not valid anymore if system time was moved backwards */
+		if (now < maintenance->nextcheck && now >= config->maintenance_lastcheck)
+		{
+			if (ZBX_MAINTENANCE_RUNNING == maintenance->state)
+				running_num++;
+			continue;
+		}
+
+		checked_num++;
+		modified = FAIL;
 		state = ZBX_MAINTENANCE_IDLE;
 		running_since = 0;
 		running_until = 0;
@@ -887,23 +1008,14 @@ int	zbx_dc_update_maintenances(void)
 				/* Precache nested host groups for started maintenances.   */
 				/* Nested host groups for running maintenances are already */
 				/* precached during configuration cache synchronization.   */
-				for (i = 0; i < maintenance->groupids.values_num; i++)
-				{
-					zbx_dc_hostgroup_t	*group;
-
-					if (NULL != (group = (zbx_dc_hostgroup_t *)zbx_hashset_search(
-							&config->hostgroups, &maintenance->groupids.values[i])))
-					{
-						dc_hostgroup_cache_nested_groupids(group);
-					}
-				}
-				ret = SUCCEED;
+				dc_maintenance_cache_nested_groupids(maintenance);
+				modified = SUCCEED;
 			}
 
 			if (maintenance->running_until != running_until)
 			{
 				maintenance->running_until = running_until;
-				ret = SUCCEED;
+				modified = SUCCEED;
 			}
 			running_num++;
 		}
@@ -915,15 +1027,32 @@ int	zbx_dc_update_maintenances(void)
 				maintenance->running_until = 0;
 				maintenance->state = ZBX_MAINTENANCE_IDLE;
 				stopped_num++;
-				ret = SUCCEED;
+
+				/* hosts of stopped maintenance are checked with read lock */
+				dc_maintenance_cache_nested_groupids(maintenance);
+				modified = SUCCEED;
 			}
 		}
+
+		maintenance->nextcheck = dc_calculate_maintenance_nextcheck(maintenance, now);
+
+		if (SUCCEED == modified)
+		{
+			if (NULL != modified_maintenanceids)
+				zbx_vector_uint64_append(modified_maintenanceids, maintenance->maintenanceid);
+			ret = SUCCEED;
+		}
 	}
 
+	config->maintenance_lastcheck = now;
+
 	UNLOCK_CACHE;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() started:%d stopped:%d running:%d", __func__,
-			started_num, stopped_num, running_num);
+	if (SUCCEED == config_update && NULL != modified_maintenanceids)
+		zbx_vector_uint64_clear(modified_maintenanceids);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() started:%d stopped:%d running:%d checked:%d", __func__,
+			started_num, stopped_num, running_num, checked_num);
 
 	return ret;
 }
@@ -1060,18 +1189,18 @@ static void	dc_get_host_maintenances_by_ids(const zbx_vector_uint64_t *maintenan
 
 /******************************************************************************
  *                                                                            *
- * Function: dc_get_host_maintenance_updates                                  *
+ * Function: dc_get_host_maintenance_update                                   *
  *                                                                            *
- * Purpose: gets maintenance updates for all hosts                            *
+ * Purpose: gets maintenance update for the specified host                    *
  *                                                                            *
- * Parameters: host_maintenances - [IN] the maintenances running on hosts     *
+ * Parameters: host              - [IN] the host                              *
+ *             host_maintenances - [IN] the maintenances running on hosts     *
  *             updates           - [OUT] updates to be applied                *
  *                                                                            *
  ******************************************************************************/
-static void	dc_get_host_maintenance_updates(zbx_hashset_t *host_maintenances, zbx_vector_ptr_t *updates)
+static void	dc_get_host_maintenance_update(const ZBX_DC_HOST *host, zbx_hashset_t *host_maintenances,
+		zbx_vector_ptr_t *updates)
 {
-	zbx_hashset_iter_t		iter;
-	ZBX_DC_HOST			*host;
 	int				maintenance_from;
 	unsigned char			maintenance_status, maintenance_type;
 	zbx_uint64_t			maintenanceid;
@@ -1079,55 +1208,85 @@ static void	dc_get_host_maintenance_updates(zbx_hashset_t *host_maintenances, zb
 	unsigned int			flags;
 	const zbx_host_maintenance_t	*host_maintenance;
 
-	zbx_hashset_iter_reset(&config->hosts, &iter);
-	while (NULL != (host = (ZBX_DC_HOST *)zbx_hashset_iter_next(&iter)))
-	{
-		if (HOST_STATUS_PROXY_ACTIVE == host->status || HOST_STATUS_PROXY_PASSIVE == host->status)
-			continue;
+	if (HOST_STATUS_PROXY_ACTIVE == host->status || HOST_STATUS_PROXY_PASSIVE == host->status)
+		return;
 
-		if (NULL != (host_maintenance = zbx_hashset_search(host_maintenances, &host->hostid)))
-		{
-			maintenance_status = HOST_MAINTENANCE_STATUS_ON;
-			maintenance_type = host_maintenance->maintenance->type;
-			maintenanceid = host_maintenance->maintenance->maintenanceid;
-			maintenance_from = host_maintenance->maintenance->running_since;
-		}
-		else
-		{
-			maintenance_status = HOST_MAINTENANCE_STATUS_OFF;
-			maintenance_type = MAINTENANCE_TYPE_NORMAL;
-			maintenanceid = 0;
-			maintenance_from = 0;
-		}
+	if (NULL != (host_maintenance = zbx_hashset_search(host_maintenances, &host->hostid)))
+	{
+		maintenance_status = HOST_MAINTENANCE_STATUS_ON;
+		maintenance_type = host_maintenance->maintenance->type;
+		maintenanceid = host_maintenance->maintenance->maintenanceid;
+		maintenance_from = host_maintenance->maintenance->running_since;
+	}
+	else
+	{
+		maintenance_status = HOST_MAINTENANCE_STATUS_OFF;
+		maintenance_type = MAINTENANCE_TYPE_NORMAL;
+		maintenanceid = 0;
+		maintenance_from = 0;
+	}
 
-		flags = 0;
+	flags = 0;
 
-		if (maintenanceid != host->maintenanceid)
-			flags |= ZBX_FLAG_HOST_MAINTENANCE_UPDATE_MAINTENANCEID;
+	if (maintenanceid != host->maintenanceid)
+		flags |= ZBX_FLAG_HOST_MAINTENANCE_UPDATE_MAINTENANCEID;
 
-		if (maintenance_status != host->maintenance_status)
-			flags |= ZBX_FLAG_HOST_MAINTENANCE_UPDATE_MAINTENANCE_STATUS;
+	if (maintenance_status != host->maintenance_status)
+		flags |= ZBX_FLAG_HOST_MAINTENANCE_UPDATE_MAINTENANCE_STATUS;
 
-		if (maintenance_from != host->maintenance_from)
-			flags |= ZBX_FLAG_HOST_MAINTENANCE_UPDATE_MAINTENANCE_FROM;
+	if (maintenance_from != host->maintenance_from)
+		flags |= ZBX_FLAG_HOST_MAINTENANCE_UPDATE_MAINTENANCE_FROM;
 
-		if (maintenance_type != host->maintenance_type)
-			flags |= ZBX_FLAG_HOST_MAINTENANCE_UPDATE_MAINTENANCE_TYPE;
+	if (maintenance_type != host->maintenance_type)
+		flags |= ZBX_FLAG_HOST_MAINTENANCE_UPDATE_MAINTENANCE_TYPE;
 
-		if (0 != flags)
-		{
-			diff = (zbx_host_maintenance_diff_t *)zbx_malloc(0, sizeof(zbx_host_maintenance_diff_t));
-			diff->flags = flags;
-			diff->hostid = host->hostid;
-			diff->maintenanceid = maintenanceid;
-			diff->maintenance_status = maintenance_status;
-			diff->maintenance_from = maintenance_from;
-			diff->maintenance_type = maintenance_type;
-			zbx_vector_ptr_append(updates, diff);
-		}
+	if (0 != flags)
+	{
+		diff = (zbx_host_maintenance_diff_t *)zbx_malloc(0, sizeof(zbx_host_maintenance_diff_t));
+		diff->flags = flags;
+		diff->hostid = host->hostid;
+		diff->maintenanceid = maintenanceid;
+		diff->maintenance_status = maintenance_status;
+		diff->maintenance_from = maintenance_from;
+		diff->maintenance_type = maintenance_type;
+		zbx_vector_ptr_append(updates, diff);
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_get_host_maintenance_updates                                  *
+ *                                                                            *
+ * Purpose: gets maintenance updates for all hosts                            *
+ *                                                                            *
+ * Parameters: host_maintenances - [IN] the maintenances running on hosts     *
+ *             updates           - [OUT] updates to be applied                *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_get_host_maintenance_updates(zbx_hashset_t *host_maintenances, zbx_vector_ptr_t *updates)
+{
+	zbx_hashset_iter_t	iter;
+	ZBX_DC_HOST		*host;
+
+	zbx_hashset_iter_reset(&config->hosts, &iter);
+	while (NULL != (host = (ZBX_DC_HOST *)zbx_hashset_iter_next(&iter)))
+		dc_get_host_maintenance_update(host, host_maintenances, updates);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_add_maintenance_host                                          *
+ *                                                                            *
+ * Purpose: adds host to the set of hosts affected by maintenance changes     *
+ *                                                                            *
+ ******************************************************************************/
+static void	dc_add_maintenance_host(zbx_hashset_t *hostids, zbx_dc_maintenance_t *maintenance, zbx_uint64_t hostid)
+{
+	ZBX_UNUSED(maintenance);
+
+	zbx_hashset_insert(hostids, &hostid, sizeof(hostid));
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_dc_flush_host_maintenance_updates                            *
@@ -1195,9 +1354,13 @@ void	zbx_dc_flush_host_maintenance_updates(const zbx_vector_ptr_t *updates)
  * Purpose: calculates required host maintenance updates based on specified   *
  *          maintenances                                                      *
  *                                                                            *
- * Parameters: maintenanceids   - [IN] identifiers of the maintenances to     *
- *                                process                                     *
- *             updates          - [OUT] pending updates                       *
+ * Parameters: maintenanceids          - [IN] identifiers of the maintenances *
+ *                                       to process                           *
+ *             modified_maintenanceids - [IN] identifiers of the maintenances *
+ *                                       with changed state, only hosts of    *
+ *                                       these maintenances are checked. If   *
+ *                                       empty all hosts are checked.         *
+ *             updates                 - [OUT] pending updates                *
  *                                                                            *
  * Comments: This function must be called after zbx_dc_update_maintenances()  *
  *           function has updated maintenance state in configuration cache.   *
@@ -1206,11 +1369,12 @@ void	zbx_dc_flush_host_maintenance_updates(const zbx_vector_ptr_t *updates)
  *           before calling this function.                                    *
  *                                                                            *
  ******************************************************************************/
-void	zbx_dc_get_host_maintenance_updates(const zbx_vector_uint64_t *maintenanceids, zbx_vector_ptr_t *updates)
+void	zbx_dc_get_host_maintenance_updates(const zbx_vector_uint64_t *maintenanceids,
+		const zbx_vector_uint64_t *modified_maintenanceids, zbx_vector_ptr_t *updates)
 {
-	zbx_hashset_t	host_maintenances;
+	zbx_hashset_t	host_maintenances, hostids;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() modified:%d", __func__, modified_maintenanceids->values_num);
 
 	zbx_hashset_create(&host_maintenances, maintenanceids->values_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
 			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
@@ -1219,9 +1383,33 @@ void	zbx_dc_get_host_maintenance_updates(const zbx_vector_uint64_t *maintenancei
 
 	dc_get_host_maintenances_by_ids(maintenanceids, &host_maintenances, dc_assign_maintenance_to_host);
 
-	/* host maintenance update must be performed even without running maintenances */
-	/* to reset host maintenances status for stopped maintenances                  */
-	dc_get_host_maintenance_updates(&host_maintenances, updates);
+	if (0 != modified_maintenanceids->values_num)
+	{
+		zbx_hashset_iter_t	iter;
+		zbx_uint64_t		*phostid;
+		const ZBX_DC_HOST	*host;
+
+		/* only hosts of the modified maintenances can have their maintenance status changed */
+
+		zbx_hashset_create(&hostids, 100, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		dc_get_host_maintenances_by_ids(modified_maintenanceids, &hostids, dc_add_maintenance_host);
+
+		zbx_hashset_iter_reset(&hostids, &iter);
+		while (NULL != (phostid = (zbx_uint64_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL != (host = (const ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, phostid)))
+				dc_get_host_maintenance_update(host, &host_maintenances, updates);
+		}
+
+		zbx_hashset_destroy(&hostids);
+	}
+	else
+	{
+		/* host maintenance update must be performed even without running maintenances */
+		/* to reset host maintenances status for stopped maintenances                  */
+		dc_get_host_maintenance_updates(&host_maintenances, updates);
+	}
 
 	UNLOCK_CACHE;
 
@@ -0,0 +1,897 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "log.h"
+#include "db.h"
+#include "dbcache.h"
+#include "mutexs.h"
+#include "version.h"
+
+#define ZBX_DBCONFIG_IMPL
+#include "dbconfig.h"
+#include "dbsync.h"
+#include "dbsnapshot.h"
+
+extern unsigned char	program_type;
+
+/*
+ * Configuration cache snapshot contains the rows of the largest configuration tables as they were
+ * selected by configuration cache synchronization. When configuration cache is initialized from
+ * snapshot these rows are applied instead of the database result sets, while the other tables are
+ * selected from database as usual. The changes made after the snapshot was written are found by
+ * the following incremental synchronization using changelog records unknown at the time the
+ * snapshot was written.
+ *
+ * The file uses native byte order and is not portable between systems:
+ *
+ *   header    - signature, format, version, database, program type and creation time
+ *   changelog - the number of records followed by the records
+ *   index     - the number of columns, the number of rows and the file offset of each table
+ *   tables    - the table rows, each row consisting of the row size followed by the column
+ *               values - value length, value and terminating zero (or NULL value marker)
+ */
+
+#define ZBX_DBSNAPSHOT_SIGNATURE	"ZBXCSNAP"
+#define ZBX_DBSNAPSHOT_SIGNATURE_LEN	8
+#define ZBX_DBSNAPSHOT_FORMAT		1
+
+#define ZBX_DBSNAPSHOT_VALUE_NULL	0xffffffff
+#define ZBX_DBSNAPSHOT_STRING_LEN_MAX	4096
+#define ZBX_DBSNAPSHOT_ROW_SIZE_MAX	(256 * ZBX_MEBIBYTE)
+
+#define ZBX_DBSNAPSHOT_RTDATA_COLUMNS_MAX	4
+
+typedef struct
+{
+	const char			*name;
+	zbx_dbsync_compare_func_t	compare;
+
+	/* The runtime data is updated in database without changelog records, so it is selected */
+	/* from database when snapshot is loaded. The query must select the object identifier   */
+	/* (the first column of snapshot rows) followed by the columns replacing the snapshot    */
+	/* row columns at the specified indexes.                                                 */
+	const char			*rtdata_sql;
+	int				rtdata_columns[ZBX_DBSNAPSHOT_RTDATA_COLUMNS_MAX];
+	int				rtdata_columns_num;
+}
+zbx_dbsnapshot_desc_t;
+
+/* the table order must match ZBX_DBSNAPSHOT_* defines */
+static const zbx_dbsnapshot_desc_t	dbsnapshot_tables[ZBX_DBSNAPSHOT_TABLES_NUM] = {
+	/* item_rtdata columns selected by zbx_dbsync_compare_items() */
+	{"items", zbx_dbsync_compare_items,
+			"select itemid,state,lastlogsize,mtime,error from item_rtdata", {12, 20, 21, 27}, 4},
+	{"template items", zbx_dbsync_compare_template_items, NULL, {0}, 0},
+	{"prototype items", zbx_dbsync_compare_prototype_items, NULL, {0}, 0},
+	{"item preprocessing", zbx_dbsync_compare_item_preprocs, NULL, {0}, 0},
+	{"functions", zbx_dbsync_compare_functions, NULL, {0}, 0},
+	/* trigger runtime columns selected by zbx_dbsync_compare_triggers() */
+	{"triggers", zbx_dbsync_compare_triggers,
+			"select triggerid,error,value,state,lastchange from triggers", {3, 6, 7, 8}, 4}
+};
+
+typedef struct
+{
+	zbx_uint64_t	id;
+
+	/* the runtime data column values, each followed by terminating zero */
+	char		*data;
+}
+zbx_dbsnapshot_rtdata_t;
+
+typedef struct
+{
+	zbx_uint32_t	columns_num;
+	zbx_uint64_t	rows_num;
+	zbx_uint64_t	offset;
+}
+zbx_dbsnapshot_index_t;
+
+struct zbx_dbsnapshot_table
+{
+	const zbx_dbsnapshot_desc_t	*desc;
+	const char			*path;
+	zbx_dbsnapshot_index_t		index;
+
+	FILE				*file;
+	zbx_uint64_t			rows_left;
+
+	/* the last read row */
+	char				*buf;
+	size_t				buf_alloc;
+	char				**row;
+
+	zbx_hashset_t			rtdata;
+
+	int				failed;
+};
+
+struct zbx_dbsnapshot
+{
+	char			*path;
+	zbx_dbsnapshot_table_t	tables[ZBX_DBSNAPSHOT_TABLES_NUM];
+
+	/* the changelog records read before the tables were written */
+	zbx_vector_ptr_t	changelog;
+
+	/* the time the snapshot was written */
+	int			clock;
+};
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsnapshot_get_version                                           *
+ *                                                                            *
+ * Purpose: get the version identifying snapshot row layout                   *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*dbsnapshot_get_version(void)
+{
+	return ZABBIX_VERSION " (revision " ZABBIX_REVISION ")";
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsnapshot_get_database                                          *
+ *                                                                            *
+ * Purpose: get the identifier of the database snapshot is written from       *
+ *                                                                            *
+ ******************************************************************************/
+static char	*dbsnapshot_get_database(void)
+{
+	return zbx_dsprintf(NULL, "%s:%d/%s/%s", ZBX_NULL2EMPTY_STR(CONFIG_DBHOST), CONFIG_DBPORT,
+			ZBX_NULL2EMPTY_STR(CONFIG_DBNAME), ZBX_NULL2EMPTY_STR(CONFIG_DBSCHEMA));
+}
+
+/* snapshot writing support */
+
+/* the write errors are checked with ferror() after writing the whole file */
+
+static void	dbsnapshot_write_uint32(FILE *file, zbx_uint32_t value)
+{
+	fwrite(&value, sizeof(value), 1, file);
+}
+
+static void	dbsnapshot_write_uint64(FILE *file, zbx_uint64_t value)
+{
+	fwrite(&value, sizeof(value), 1, file);
+}
+
+static void	dbsnapshot_write_string(FILE *file, const char *value)
+{
+	zbx_uint32_t	len;
+
+	len = (zbx_uint32_t)strlen(value);
+	dbsnapshot_write_uint32(file, len);
+	fwrite(value, 1, len, file);
+}
+
+static void	dbsnapshot_write_row(FILE *file, DB_ROW row, int columns_num)
+{
+	zbx_uint32_t	size = 0;
+	int		i;
+
+	for (i = 0; i < columns_num; i++)
+	{
+		size += sizeof(zbx_uint32_t);
+
+		if (NULL != row[i])
+			size += strlen(row[i]) + 1;
+	}
+
+	dbsnapshot_write_uint32(file, size);
+
+	for (i = 0; i < columns_num; i++)
+	{
+		if (NULL == row[i])
+		{
+			dbsnapshot_write_uint32(file, ZBX_DBSNAPSHOT_VALUE_NULL);
+			continue;
+		}
+
+		dbsnapshot_write_string(file, row[i]);
+		fputc('\0', file);
+	}
+}
+
+static void	dbsnapshot_write_index(FILE *file, const zbx_dbsnapshot_index_t *index)
+{
+	int	i;
+
+	for (i = 0; i < ZBX_DBSNAPSHOT_TABLES_NUM; i++)
+	{
+		dbsnapshot_write_uint32(file, index[i].columns_num);
+		dbsnapshot_write_uint64(file, index[i].rows_num);
+		dbsnapshot_write_uint64(file, index[i].offset);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsnapshot_write_changelog                                       *
+ *                                                                            *
+ * Purpose: reads changelog records from database and writes them to         *
+ *          snapshot                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsnapshot_write_changelog(FILE *file)
+{
+	DB_RESULT		result;
+	DB_ROW			row;
+	zbx_vector_uint64_t	records;
+	int			i;
+
+	if (NULL == (result = DBselect("select changelogid,object,objectid,operation,clock from changelog")))
+		return FAIL;
+
+	zbx_vector_uint64_create(&records);
+
+	/* the records are written after the number of records is known */
+	while (NULL != (row = DBfetch(result)))
+	{
+		zbx_uint64_t	value;
+
+		ZBX_STR2UINT64(value, row[0]);
+		zbx_vector_uint64_append(&records, value);
+		zbx_vector_uint64_append(&records, (zbx_uint64_t)atoi(row[1]));
+		ZBX_STR2UINT64(value, row[2]);
+		zbx_vector_uint64_append(&records, value);
+		zbx_vector_uint64_append(&records, (zbx_uint64_t)atoi(row[3]));
+		zbx_vector_uint64_append(&records, (zbx_uint64_t)atoi(row[4]));
+	}
+	DBfree_result(result);
+
+	dbsnapshot_write_uint32(file, (zbx_uint32_t)(records.values_num / 5));
+
+	for (i = 0; i < records.values_num; i += 5)
+	{
+		dbsnapshot_write_uint64(file, records.values[i]);
+		dbsnapshot_write_uint32(file, (zbx_uint32_t)records.values[i + 1]);
+		dbsnapshot_write_uint64(file, records.values[i + 2]);
+		dbsnapshot_write_uint32(file, (zbx_uint32_t)records.values[i + 3]);
+		dbsnapshot_write_uint32(file, (zbx_uint32_t)records.values[i + 4]);
+	}
+
+	zbx_vector_uint64_destroy(&records);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsnapshot_write_table                                           *
+ *                                                                            *
+ * Purpose: selects all table rows used by configuration cache and writes     *
+ *          them to snapshot                                                  *
+ *                                                                            *
+ * Parameters: file  - [IN] the snapshot file                                 *
+ *             desc  - [IN] the table description                             *
+ *             index - [OUT] the table index                                  *
+ *                                                                            *
+ * Return value: SUCCEED - the table was written                              *
+ *               FAIL    - database error                                     *
+ *                                                                            *
+ * Comments: The rows are selected by the same table comparison function as   *
+ *           during configuration cache initialization, so they are applied   *
+ *           the same way as database rows.                                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsnapshot_write_table(FILE *file, const zbx_dbsnapshot_desc_t *desc, zbx_dbsnapshot_index_t *index)
+{
+	zbx_dbsync_t	sync;
+	DB_ROW		row;
+	int		ret;
+
+	index->offset = (zbx_uint64_t)ftell(file);
+	index->rows_num = 0;
+
+	zbx_dbsync_init(&sync, ZBX_DBSYNC_INIT);
+
+	if (SUCCEED == (ret = desc->compare(&sync)))
+	{
+		index->columns_num = (zbx_uint32_t)sync.columns_num;
+
+		while (NULL != (row = DBfetch(sync.dbresult)))
+		{
+			dbsnapshot_write_row(file, row, sync.columns_num);
+			index->rows_num++;
+		}
+	}
+
+	zbx_dbsync_clear(&sync);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsnapshot_write                                             *
+ *                                                                            *
+ * Purpose: writes configuration cache snapshot                               *
+ *                                                                            *
+ * Parameters: path  - [IN] the snapshot file path                            *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was written                           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The snapshot is written to a temporary file which replaces the   *
+ *           previous snapshot only when completed.                           *
+ *           The changelog records are read before the tables, so all changes *
+ *           having known records are reflected in the written rows. The      *
+ *           changes committed later are compared again after the snapshot is *
+ *           loaded.                                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsnapshot_write(const char *path, char **error)
+{
+	FILE			*file = NULL;
+	int			fd, i, ret = FAIL;
+	char			*path_tmp, *database;
+	long			index_offset;
+	zbx_dbsnapshot_index_t	index[ZBX_DBSNAPSHOT_TABLES_NUM];
+
+	path_tmp = zbx_dsprintf(NULL, "%s.tmp", path);
+
+	/* the snapshot contains item credentials, so it must be readable only by the owner */
+	if (-1 == (fd = open(path_tmp, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR)))
+	{
+		*error = zbx_dsprintf(*error, "cannot open file \"%s\": %s", path_tmp, zbx_strerror(errno));
+		goto out;
+	}
+
+	if (NULL == (file = fdopen(fd, "wb")))
+	{
+		*error = zbx_dsprintf(*error, "cannot open file \"%s\": %s", path_tmp, zbx_strerror(errno));
+		close(fd);
+		goto out;
+	}
+
+	fwrite(ZBX_DBSNAPSHOT_SIGNATURE, 1, ZBX_DBSNAPSHOT_SIGNATURE_LEN, file);
+	dbsnapshot_write_uint32(file, ZBX_DBSNAPSHOT_FORMAT);
+	dbsnapshot_write_string(file, dbsnapshot_get_version());
+	database = dbsnapshot_get_database();
+	dbsnapshot_write_string(file, database);
+	zbx_free(database);
+	dbsnapshot_write_uint32(file, program_type);
+	dbsnapshot_write_uint32(file, (zbx_uint32_t)time(NULL));
+
+	if (SUCCEED != dbsnapshot_write_changelog(file))
+	{
+		*error = zbx_strdup(*error, "cannot read changelog records");
+		goto out;
+	}
+
+	/* the index is rewritten after the tables are written */
+	memset(index, 0, sizeof(index));
+	index_offset = ftell(file);
+	dbsnapshot_write_index(file, index);
+
+	for (i = 0; i < ZBX_DBSNAPSHOT_TABLES_NUM; i++)
+	{
+		if (SUCCEED != dbsnapshot_write_table(file, &dbsnapshot_tables[i], &index[i]))
+		{
+			*error = zbx_dsprintf(*error, "cannot select %s", dbsnapshot_tables[i].name);
+			goto out;
+		}
+	}
+
+	if (0 == fseek(file, index_offset, SEEK_SET))
+		dbsnapshot_write_index(file, index);
+
+	if (0 != ferror(file) || 0 != fflush(file) || 0 != fsync(fileno(file)))
+	{
+		*error = zbx_dsprintf(*error, "cannot write file \"%s\": %s", path_tmp, zbx_strerror(errno));
+		goto out;
+	}
+
+	i = fclose(file);
+	file = NULL;
+
+	if (0 != i)
+	{
+		*error = zbx_dsprintf(*error, "cannot write file \"%s\": %s", path_tmp, zbx_strerror(errno));
+		goto out;
+	}
+
+	if (0 != rename(path_tmp, path))
+	{
+		*error = zbx_dsprintf(*error, "cannot rename file \"%s\" to \"%s\": %s", path_tmp, path,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	ret = SUCCEED;
+out:
+	if (NULL != file)
+		fclose(file);
+
+	if (SUCCEED != ret)
+		unlink(path_tmp);
+
+	zbx_free(path_tmp);
+
+	return ret;
+}
+
+/* snapshot reading support */
+
+static int	dbsnapshot_read(FILE *file, void *data, size_t size)
+{
+	return 1 == fread(data, size, 1, file) ? SUCCEED : FAIL;
+}
+
+static int	dbsnapshot_read_uint32(FILE *file, zbx_uint32_t *value)
+{
+	return dbsnapshot_read(file, value, sizeof(*value));
+}
+
+static int	dbsnapshot_read_uint64(FILE *file, zbx_uint64_t *value)
+{
+	return dbsnapshot_read(file, value, sizeof(*value));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsnapshot_check_string                                          *
+ *                                                                            *
+ * Purpose: reads string from snapshot and compares it with expected value    *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsnapshot_check_string(FILE *file, const char *expected)
+{
+	zbx_uint32_t	len;
+	char		*value;
+	int		ret = FAIL;
+
+	if (SUCCEED != dbsnapshot_read_uint32(file, &len) || ZBX_DBSNAPSHOT_STRING_LEN_MAX < len)
+		return FAIL;
+
+	value = (char *)zbx_malloc(NULL, len + 1);
+
+	if (0 == len || SUCCEED == dbsnapshot_read(file, value, len))
+	{
+		value[len] = '\0';
+
+		if (0 == strcmp(value, expected))
+			ret = SUCCEED;
+	}
+
+	zbx_free(value);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsnapshot_read_header                                           *
+ *                                                                            *
+ * Purpose: reads and validates snapshot header, changelog records and table  *
+ *          index                                                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsnapshot_read_header(FILE *file, zbx_dbsnapshot_t *snapshot, zbx_uint64_t size, char **error)
+{
+	char		signature[ZBX_DBSNAPSHOT_SIGNATURE_LEN], *database;
+	zbx_uint32_t	value, clock, records_num, i;
+	int		ret;
+
+	if (SUCCEED != dbsnapshot_read(file, signature, sizeof(signature)) ||
+			0 != memcmp(signature, ZBX_DBSNAPSHOT_SIGNATURE, sizeof(signature)) ||
+			SUCCEED != dbsnapshot_read_uint32(file, &value) || ZBX_DBSNAPSHOT_FORMAT != value)
+	{
+		*error = zbx_strdup(*error, "not a configuration cache snapshot or unsupported format");
+		return FAIL;
+	}
+
+	if (SUCCEED != dbsnapshot_check_string(file, dbsnapshot_get_version()))
+	{
+		*error = zbx_strdup(*error, "the snapshot was written by another version");
+		return FAIL;
+	}
+
+	database = dbsnapshot_get_database();
+	ret = dbsnapshot_check_string(file, database);
+	zbx_free(database);
+
+	if (SUCCEED != ret || SUCCEED != dbsnapshot_read_uint32(file, &value) || program_type != value)
+	{
+		*error = zbx_strdup(*error, "the snapshot was written from another database");
+		return FAIL;
+	}
+
+	if (SUCCEED != dbsnapshot_read_uint32(file, &clock) || SUCCEED != dbsnapshot_read_uint32(file, &records_num))
+		goto out;
+
+	for (i = 0; i < records_num; i++)
+	{
+		zbx_dbsync_changelog_t	*record;
+		zbx_uint32_t		object, operation, record_clock;
+
+		record = (zbx_dbsync_changelog_t *)zbx_malloc(NULL, sizeof(zbx_dbsync_changelog_t));
+		zbx_vector_ptr_append(&snapshot->changelog, record);
+
+		if (SUCCEED != dbsnapshot_read_uint64(file, &record->changelogid) ||
+				SUCCEED != dbsnapshot_read_uint32(file, &object) ||
+				SUCCEED != dbsnapshot_read_uint64(file, &record->objectid) ||
+				SUCCEED != dbsnapshot_read_uint32(file, &operation) ||
+				SUCCEED != dbsnapshot_read_uint32(file, &record_clock))
+		{
+			goto out;
+		}
+
+		record->object = (int)object;
+		record->operation = (int)operation;
+		record->clock = (int)record_clock;
+		record->revision = 0;
+	}
+
+	snapshot->clock = (int)clock;
+
+	for (i = 0; i < ZBX_DBSNAPSHOT_TABLES_NUM; i++)
+	{
+		zbx_dbsnapshot_index_t	*index = &snapshot->tables[i].index;
+
+		if (SUCCEED != dbsnapshot_read_uint32(file, &index->columns_num) ||
+				SUCCEED != dbsnapshot_read_uint64(file, &index->rows_num) ||
+				SUCCEED != dbsnapshot_read_uint64(file, &index->offset) ||
+				size < index->offset || LONG_MAX < index->offset)
+		{
+			goto out;
+		}
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "configuration cache snapshot was written at %s %s",
+			zbx_date2str((time_t)clock), zbx_time2str((time_t)clock));
+
+	return SUCCEED;
+out:
+	*error = zbx_strdup(*error, "the snapshot is corrupted");
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsnapshot_open                                              *
+ *                                                                            *
+ * Purpose: opens configuration cache snapshot                                *
+ *                                                                            *
+ * Parameters: path     - [IN] the snapshot file path                         *
+ *             snapshot - [OUT] the snapshot                                  *
+ *             error    - [OUT] the error message                             *
+ *                                                                            *
+ * Return value: SUCCEED - the snapshot was opened                            *
+ *               FAIL    - the snapshot does not exist or cannot be used      *
+ *                                                                            *
+ * Comments: Only the snapshot header is validated, the table rows are        *
+ *           validated while being read.                                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsnapshot_open(const char *path, zbx_dbsnapshot_t **snapshot, char **error)
+{
+	FILE		*file;
+	zbx_stat_t	st;
+	int		i, ret;
+
+	if (NULL == (file = fopen(path, "rb")))
+	{
+		*error = zbx_dsprintf(*error, "cannot open file: %s", zbx_strerror(errno));
+		return FAIL;
+	}
+
+	if (0 != zbx_fstat(fileno(file), &st))
+	{
+		*error = zbx_dsprintf(*error, "cannot obtain file information: %s", zbx_strerror(errno));
+		fclose(file);
+		return FAIL;
+	}
+
+	*snapshot = (zbx_dbsnapshot_t *)zbx_malloc(NULL, sizeof(zbx_dbsnapshot_t));
+	memset(*snapshot, 0, sizeof(zbx_dbsnapshot_t));
+	(*snapshot)->path = zbx_strdup(NULL, path);
+	zbx_vector_ptr_create(&(*snapshot)->changelog);
+
+	for (i = 0; i < ZBX_DBSNAPSHOT_TABLES_NUM; i++)
+	{
+		(*snapshot)->tables[i].desc = &dbsnapshot_tables[i];
+		(*snapshot)->tables[i].path = (*snapshot)->path;
+	}
+
+	ret = dbsnapshot_read_header(file, *snapshot, (zbx_uint64_t)st.st_size, error);
+	fclose(file);
+
+	if (SUCCEED != ret)
+		zbx_dbsnapshot_close(*snapshot);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsnapshot_close                                             *
+ *                                                                            *
+ * Purpose: closes configuration cache snapshot and frees its resources       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsnapshot_close(zbx_dbsnapshot_t *snapshot)
+{
+	int	i;
+
+	for (i = 0; i < ZBX_DBSNAPSHOT_TABLES_NUM; i++)
+	{
+		zbx_dbsnapshot_table_t	*table = &snapshot->tables[i];
+
+		if (NULL != table->file)
+			fclose(table->file);
+
+		if (NULL != table->rtdata.slots)
+		{
+			zbx_hashset_iter_t	iter;
+			zbx_dbsnapshot_rtdata_t	*rtdata;
+
+			zbx_hashset_iter_reset(&table->rtdata, &iter);
+			while (NULL != (rtdata = (zbx_dbsnapshot_rtdata_t *)zbx_hashset_iter_next(&iter)))
+				zbx_free(rtdata->data);
+
+			zbx_hashset_destroy(&table->rtdata);
+		}
+
+		zbx_free(table->buf);
+		zbx_free(table->row);
+	}
+
+	zbx_vector_ptr_clear_ext(&snapshot->changelog, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&snapshot->changelog);
+	zbx_free(snapshot->path);
+	zbx_free(snapshot);
+}
+
+zbx_dbsnapshot_table_t	*zbx_dbsnapshot_get_table(zbx_dbsnapshot_t *snapshot, int table)
+{
+	return &snapshot->tables[table];
+}
+
+const zbx_vector_ptr_t	*zbx_dbsnapshot_get_changelog(const zbx_dbsnapshot_t *snapshot)
+{
+	return &snapshot->changelog;
+}
+
+int	zbx_dbsnapshot_get_clock(const zbx_dbsnapshot_t *snapshot)
+{
+	return snapshot->clock;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsnapshot_failed                                            *
+ *                                                                            *
+ * Purpose: checks if reading of any snapshot table has failed                *
+ *                                                                            *
+ * Return value: SUCCEED - reading of a table has failed, not all rows were   *
+ *                         applied to configuration cache                     *
+ *               FAIL    - all opened tables were read successfully           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsnapshot_failed(const zbx_dbsnapshot_t *snapshot)
+{
+	int	i;
+
+	for (i = 0; i < ZBX_DBSNAPSHOT_TABLES_NUM; i++)
+	{
+		if (0 != snapshot->tables[i].failed)
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsnapshot_read_rtdata                                           *
+ *                                                                            *
+ * Purpose: selects the current table runtime data from database              *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsnapshot_read_rtdata(zbx_dbsnapshot_table_t *table)
+{
+	DB_RESULT		result;
+	DB_ROW			row;
+	zbx_dbsnapshot_rtdata_t	rtdata;
+	int			i, columns_num = table->desc->rtdata_columns_num;
+
+	if (NULL == (result = DBselect("%s", table->desc->rtdata_sql)))
+		return FAIL;
+
+	zbx_hashset_create(&table->rtdata, (size_t)table->index.rows_num, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		size_t	size = 0, len;
+		char	*ptr;
+
+		ZBX_STR2UINT64(rtdata.id, row[0]);
+
+		for (i = 1; i <= columns_num; i++)
+			size += strlen(ZBX_NULL2EMPTY_STR(row[i])) + 1;
+
+		ptr = rtdata.data = (char *)zbx_malloc(NULL, size);
+
+		for (i = 1; i <= columns_num; i++)
+		{
+			len = strlen(ZBX_NULL2EMPTY_STR(row[i])) + 1;
+			memcpy(ptr, ZBX_NULL2EMPTY_STR(row[i]), len);
+			ptr += len;
+		}
+
+		zbx_hashset_insert(&table->rtdata, &rtdata, sizeof(rtdata));
+	}
+	DBfree_result(result);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsnapshot_table_open                                        *
+ *                                                                            *
+ * Purpose: prepares snapshot table for reading rows                          *
+ *                                                                            *
+ * Parameters: table       - [IN] the snapshot table                          *
+ *             columns_num - [IN] the expected number of columns              *
+ *                                                                            *
+ * Return value: SUCCEED - the table is ready for reading                     *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: This function is called instead of table selection by the table *
+ *           comparison function, possibly by a configuration syncer thread.  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsnapshot_table_open(zbx_dbsnapshot_table_t *table, int columns_num)
+{
+	if ((zbx_uint32_t)columns_num != table->index.columns_num)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot read %s from configuration cache snapshot \"%s\": unexpected"
+				" number of columns", table->desc->name, table->path);
+		goto out;
+	}
+
+	if (NULL == (table->file = fopen(table->path, "rb")) ||
+			0 != fseek(table->file, (long)table->index.offset, SEEK_SET))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot read %s from configuration cache snapshot \"%s\": %s",
+				table->desc->name, table->path, zbx_strerror(errno));
+		goto out;
+	}
+
+	if (NULL != table->desc->rtdata_sql && SUCCEED != dbsnapshot_read_rtdata(table))
+		goto out;
+
+	table->row = (char **)zbx_malloc(NULL, sizeof(char *) * columns_num);
+	table->rows_left = table->index.rows_num;
+
+	return SUCCEED;
+out:
+	table->failed = 1;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsnapshot_apply_rtdata                                          *
+ *                                                                            *
+ * Purpose: replaces runtime data columns of the read row with the current    *
+ *          values selected from database                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsnapshot_apply_rtdata(zbx_dbsnapshot_table_t *table)
+{
+	zbx_uint64_t		id;
+	zbx_dbsnapshot_rtdata_t	*rtdata;
+	char			*ptr;
+	int			i;
+
+	if (NULL == table->row[0])
+		return;
+
+	ZBX_STR2UINT64(id, table->row[0]);
+
+	/* the objects removed since the snapshot was written are removed by the following synchronization */
+	if (NULL == (rtdata = (zbx_dbsnapshot_rtdata_t *)zbx_hashset_search(&table->rtdata, &id)))
+		return;
+
+	for (ptr = rtdata->data, i = 0; i < table->desc->rtdata_columns_num; i++)
+	{
+		table->row[table->desc->rtdata_columns[i]] = ptr;
+		ptr += strlen(ptr) + 1;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsnapshot_table_fetch                                       *
+ *                                                                            *
+ * Purpose: reads the next row from snapshot table                            *
+ *                                                                            *
+ * Parameters: table - [IN] the snapshot table                                *
+ *                                                                            *
+ * Return value: the row (valid until the next call) or NULL if there are no  *
+ *               more rows or the table is corrupted                          *
+ *                                                                            *
+ ******************************************************************************/
+char	**zbx_dbsnapshot_table_fetch(zbx_dbsnapshot_table_t *table)
+{
+	zbx_uint32_t	size, len, i;
+	size_t		offset = 0;
+
+	if (0 == table->rows_left || 0 != table->failed)
+		return NULL;
+
+	if (SUCCEED != dbsnapshot_read_uint32(table->file, &size) || ZBX_DBSNAPSHOT_ROW_SIZE_MAX < size)
+		goto out;
+
+	if (table->buf_alloc < size)
+	{
+		table->buf_alloc = size;
+		table->buf = (char *)zbx_realloc(table->buf, table->buf_alloc);
+	}
+
+	if (0 != size && SUCCEED != dbsnapshot_read(table->file, table->buf, size))
+		goto out;
+
+	for (i = 0; i < table->index.columns_num; i++)
+	{
+		if (size - offset < sizeof(len))
+			goto out;
+
+		memcpy(&len, table->buf + offset, sizeof(len));
+		offset += sizeof(len);
+
+		if (ZBX_DBSNAPSHOT_VALUE_NULL == len)
+		{
+			table->row[i] = NULL;
+			continue;
+		}
+
+		if (size - offset <= len || '\0' != table->buf[offset + len])
+			goto out;
+
+		table->row[i] = table->buf + offset;
+		offset += len + 1;
+	}
+
+	if (offset != size)
+		goto out;
+
+	table->rows_left--;
+
+	if (NULL != table->rtdata.slots)
+		dbsnapshot_apply_rtdata(table);
+
+	return table->row;
+out:
+	zabbix_log(LOG_LEVEL_WARNING, "cannot read %s from configuration cache snapshot \"%s\": the snapshot is"
+			" corrupted", table->desc->name, table->path);
+	table->failed = 1;
+
+	return NULL;
+}
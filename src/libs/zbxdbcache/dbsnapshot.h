@@ -0,0 +1,50 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#ifndef ZABBIX_DBSNAPSHOT_H
+#define ZABBIX_DBSNAPSHOT_H
+
+#include "common.h"
+#include "zbxalgo.h"
+
+/* the tables stored in configuration cache snapshot - the largest tables having changelog */
+#define ZBX_DBSNAPSHOT_ITEMS		0
+#define ZBX_DBSNAPSHOT_TEMPLATE_ITEMS	1
+#define ZBX_DBSNAPSHOT_PROTOTYPE_ITEMS	2
+#define ZBX_DBSNAPSHOT_ITEM_PREPROCS	3
+#define ZBX_DBSNAPSHOT_FUNCTIONS	4
+#define ZBX_DBSNAPSHOT_TRIGGERS		5
+#define ZBX_DBSNAPSHOT_TABLES_NUM	6
+
+typedef struct zbx_dbsnapshot_table zbx_dbsnapshot_table_t;
+typedef struct zbx_dbsnapshot zbx_dbsnapshot_t;
+
+int	zbx_dbsnapshot_write(const char *path, char **error);
+
+int	zbx_dbsnapshot_open(const char *path, zbx_dbsnapshot_t **snapshot, char **error);
+void	zbx_dbsnapshot_close(zbx_dbsnapshot_t *snapshot);
+zbx_dbsnapshot_table_t	*zbx_dbsnapshot_get_table(zbx_dbsnapshot_t *snapshot, int table);
+const zbx_vector_ptr_t	*zbx_dbsnapshot_get_changelog(const zbx_dbsnapshot_t *snapshot);
+int	zbx_dbsnapshot_get_clock(const zbx_dbsnapshot_t *snapshot);
+int	zbx_dbsnapshot_failed(const zbx_dbsnapshot_t *snapshot);
+
+int	zbx_dbsnapshot_table_open(zbx_dbsnapshot_table_t *table, int columns_num);
+char	**zbx_dbsnapshot_table_fetch(zbx_dbsnapshot_table_t *table);
+
+#endif
@@ -36,6 +36,118 @@ zbx_dbsync_env_t;
 
 static zbx_dbsync_env_t	dbsync_env;
 
+/* parallel table comparison support */
+
+#if defined(HAVE_PTHREAD_PROCESS_SHARED) && defined(HAVE_THREAD_LOCAL) && \
+		(defined(HAVE_MYSQL) || defined(HAVE_POSTGRESQL))
+#	define ZBX_DBSYNC_WORKERS
+#endif
+
+#ifdef ZBX_DBSYNC_WORKERS
+typedef struct
+{
+	pthread_t		*threads;
+	int			threads_num;
+
+	/* protects the batch being compared */
+	pthread_mutex_t		lock;
+
+	/* protects the string pool during comparison */
+	pthread_mutex_t		strpool_lock;
+
+	pthread_cond_t		batch_started;
+	pthread_cond_t		batch_finished;
+
+	/* the batch being compared, NULL if there is none */
+	zbx_dbsync_batch_t	*batch;
+}
+zbx_dbsync_workers_t;
+
+static zbx_dbsync_workers_t	dbsync_workers = {NULL, 0, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+		PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL};
+
+#	define LOCK_STRPOOL	pthread_mutex_lock(&dbsync_workers.strpool_lock)
+#	define UNLOCK_STRPOOL	pthread_mutex_unlock(&dbsync_workers.strpool_lock)
+#else
+#	define LOCK_STRPOOL
+#	define UNLOCK_STRPOOL
+#endif
+
+/* configuration changelog support */
+
+/* the time the processed changelog records are kept in database before purging, */
+/* allowing to detect records committed later than the records with higher ids   */
+#define ZBX_DBSYNC_CHANGELOG_TTL	(10 * SEC_PER_MIN)
+
+/* the changed objects are selected by identifiers only if their number does not  */
+/* exceed 1/ZBX_DBSYNC_CHANGELOG_RATIO of cached objects, otherwise the whole      */
+/* table is compared                                                               */
+#define ZBX_DBSYNC_CHANGELOG_RATIO	4
+
+typedef struct
+{
+	/* the changelog records already read from database with identifiers above lastid */
+	zbx_hashset_t		records;
+
+	/* the records with lower or equal identifiers were processed and are not read again */
+	zbx_uint64_t		lastid;
+
+	/* the lastid and snapshot_clock values of the last purge of processed records */
+	zbx_uint64_t		purge_lastid;
+	int			purge_snapshot_clock;
+
+	/* the identifiers of changelog records first read during current synchronization */
+	zbx_vector_uint64_t	changelogids;
+
+	int			revision;
+
+	/* SUCCEED - the changes can be selected by changelog records, */
+	/* FAIL    - the whole tables must be compared                 */
+	int			status;
+
+	/* SUCCEED - the current synchronization was completed */
+	int			flushed;
+
+	/* the time the last configuration cache snapshot was written, 0 if there is none - the */
+	/* records needed to update configuration cache loaded from it are not purged          */
+	int			snapshot_clock;
+
+	/* the objects changed in database by changelog records */
+	zbx_vector_uint64_t	hostids;
+	zbx_vector_uint64_t	itemids;
+	zbx_vector_uint64_t	functionids;
+	zbx_vector_uint64_t	triggerids;
+	zbx_vector_uint64_t	item_preprocids;
+
+	/* the objects removed from database by changelog records */
+	zbx_vector_uint64_t	del_hostids;
+	zbx_vector_uint64_t	del_itemids;
+	zbx_vector_uint64_t	del_triggerids;
+
+	/* the objects to compare - the changed objects and the cached */
+	/* objects affected by changes of the objects they depend on  */
+	zbx_vector_uint64_t	sync_itemids;
+	zbx_vector_uint64_t	sync_template_itemids;
+	zbx_vector_uint64_t	sync_prototype_itemids;
+	zbx_vector_uint64_t	sync_functionids;
+	zbx_vector_uint64_t	sync_triggerids;
+	zbx_vector_uint64_t	sync_item_preprocids;
+}
+zbx_dbsync_changelog_env_t;
+
+static zbx_dbsync_changelog_env_t	dbsync_changelog;
+
+static zbx_vector_uint64_t	*dbsync_changelog_vectors[] = {
+	&dbsync_changelog.changelogids,
+	&dbsync_changelog.hostids, &dbsync_changelog.itemids, &dbsync_changelog.functionids,
+	&dbsync_changelog.triggerids, &dbsync_changelog.item_preprocids,
+	&dbsync_changelog.del_hostids, &dbsync_changelog.del_itemids, &dbsync_changelog.del_triggerids,
+	&dbsync_changelog.sync_itemids, &dbsync_changelog.sync_template_itemids,
+	&dbsync_changelog.sync_prototype_itemids, &dbsync_changelog.sync_functionids,
+	&dbsync_changelog.sync_triggerids, &dbsync_changelog.sync_item_preprocids,
+	NULL
+};
+
 /* string pool support */
 
 #define REFCOUNT_FIELD_SIZE	sizeof(zbx_uint32_t)
@@ -166,8 +278,12 @@ static void	dbsync_add_row(zbx_dbsync_t *sync, zbx_uint64_t rowid, unsigned char
 	{
 		row->row = (char **)zbx_malloc(NULL, sizeof(char *) * sync->columns_num);
 
+		LOCK_STRPOOL;
+
 		for (i = 0; i < sync->columns_num; i++)
 			row->row[i] = (NULL == dbrow[i] ? NULL : dbsync_strdup(dbrow[i]));
+
+		UNLOCK_STRPOOL;
 	}
 	else
 		row->row = NULL;
@@ -279,14 +395,605 @@ void	zbx_dbsync_init_env(ZBX_DC_CONFIG *cache)
 	zbx_hashset_create(&dbsync_env.strpool, 100, dbsync_strpool_hash_func, dbsync_strpool_compare_func);
 }
 
-/******************************************************************************
- *                                                                            *
- * Function: dbsync_env_release                                               *
- *                                                                            *
- ******************************************************************************/
-void	zbx_dbsync_free_env(void)
-{
-	zbx_hashset_destroy(&dbsync_env.strpool);
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_env_release                                               *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_free_env(void)
+{
+	int	i;
+
+	zbx_hashset_destroy(&dbsync_env.strpool);
+
+	if (NULL == dbsync_changelog.records.slots)
+		return;
+
+	/* forget the records read during failed synchronization, so they are processed again */
+	if (SUCCEED != dbsync_changelog.flushed)
+	{
+		for (i = 0; i < dbsync_changelog.changelogids.values_num; i++)
+			zbx_hashset_remove(&dbsync_changelog.records, &dbsync_changelog.changelogids.values[i]);
+	}
+
+	for (i = 0; NULL != dbsync_changelog_vectors[i]; i++)
+		zbx_vector_uint64_clear(dbsync_changelog_vectors[i]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_changelog_add_record                                      *
+ *                                                                            *
+ * Purpose: adds changelog record to the changed objects                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_changelog_add_record(const zbx_dbsync_changelog_t *record)
+{
+	zbx_vector_uint64_t	*objectids, *del_objectids = NULL;
+
+	switch (record->object)
+	{
+		case ZBX_DBSYNC_OBJ_HOST:
+			objectids = &dbsync_changelog.hostids;
+			del_objectids = &dbsync_changelog.del_hostids;
+			break;
+		case ZBX_DBSYNC_OBJ_ITEM:
+			objectids = &dbsync_changelog.itemids;
+			del_objectids = &dbsync_changelog.del_itemids;
+			break;
+		case ZBX_DBSYNC_OBJ_TRIGGER:
+			objectids = &dbsync_changelog.triggerids;
+			del_objectids = &dbsync_changelog.del_triggerids;
+			break;
+		case ZBX_DBSYNC_OBJ_FUNCTION:
+			objectids = &dbsync_changelog.functionids;
+			break;
+		case ZBX_DBSYNC_OBJ_ITEM_PREPROC:
+			objectids = &dbsync_changelog.item_preprocids;
+			break;
+		default:
+			return;
+	}
+
+	zbx_vector_uint64_append(objectids, record->objectid);
+
+	if (ZBX_DBSYNC_ROW_REMOVE == record->operation && NULL != del_objectids)
+		zbx_vector_uint64_append(del_objectids, record->objectid);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_changelog_read                                            *
+ *                                                                            *
+ * Purpose: reads new changelog records from database                         *
+ *                                                                            *
+ * Parameters: mode - [IN] the synchronization mode (see ZBX_DBSYNC_* defines)*
+ *                                                                            *
+ * Return value: SUCCEED - the changes since the last synchronization can be  *
+ *                         derived from the read records                      *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Identifiers are allocated before commit and the records can      *
+ *           become visible out of order, so the records are read starting    *
+ *           from the low-water mark (see zbx_dbsync_env_flush_changelog())   *
+ *           rather than from the last processed record. A known record that  *
+ *           disappeared or changed its contents means the journal was        *
+ *           modified outside server (purged, restored from backup) and the   *
+ *           changes must be found by comparing whole tables.                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_changelog_read(unsigned char mode)
+{
+	DB_RESULT		result;
+	DB_ROW			row;
+	zbx_dbsync_changelog_t	record, *prec;
+	zbx_hashset_iter_t	iter;
+	int			ret = SUCCEED;
+
+	if (NULL == (result = DBselect("select changelogid,object,objectid,operation,clock from changelog"
+			" where changelogid>" ZBX_FS_UI64, dbsync_changelog.lastid)))
+	{
+		return FAIL;
+	}
+
+	dbsync_changelog.revision++;
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		ZBX_STR2UINT64(record.changelogid, row[0]);
+		record.object = atoi(row[1]);
+		ZBX_STR2UINT64(record.objectid, row[2]);
+		record.operation = atoi(row[3]);
+		record.clock = atoi(row[4]);
+		record.revision = dbsync_changelog.revision;
+
+		if (NULL != (prec = (zbx_dbsync_changelog_t *)zbx_hashset_search(&dbsync_changelog.records, &record)))
+		{
+			if (prec->object != record.object || prec->objectid != record.objectid ||
+					prec->operation != record.operation)
+			{
+				ret = FAIL;
+				*prec = record;
+			}
+			else
+				prec->revision = record.revision;
+
+			continue;
+		}
+
+		zbx_hashset_insert(&dbsync_changelog.records, &record, sizeof(record));
+		zbx_vector_uint64_append(&dbsync_changelog.changelogids, record.changelogid);
+
+		if (ZBX_DBSYNC_UPDATE == mode)
+			dbsync_changelog_add_record(&record);
+	}
+	DBfree_result(result);
+
+	zbx_hashset_iter_reset(&dbsync_changelog.records, &iter);
+	while (NULL != (prec = (zbx_dbsync_changelog_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (prec->revision != dbsync_changelog.revision)
+		{
+			zbx_hashset_iter_remove(&iter);
+			ret = FAIL;
+		}
+	}
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_changelog_item_hostid_match                               *
+ *                                                                            *
+ * Purpose: checks if the cached item belongs to one of the specified hosts   *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_changelog_item_hostid_match(zbx_uint64_t itemid, const zbx_vector_uint64_t *hostids)
+{
+	const ZBX_DC_ITEM	*item;
+
+	if (0 == hostids->values_num)
+		return FAIL;
+
+	if (NULL == (item = (const ZBX_DC_ITEM *)zbx_hashset_search(&dbsync_env.cache->items, &itemid)))
+		return FAIL;
+
+	if (FAIL == zbx_vector_uint64_bsearch(hostids, item->hostid, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+#define DBSYNC_VECTOR_CONTAINS(v, id)	\
+		(0 != (v)->values_num && FAIL != zbx_vector_uint64_bsearch(v, id, ZBX_DEFAULT_UINT64_COMPARE_FUNC))
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_changelog_select_objects                                  *
+ *                                                                            *
+ * Purpose: selects the objects to compare from the changed objects and the   *
+ *          cached objects depending on them                                  *
+ *                                                                            *
+ * Comments: This function must be called before synchronization changes     *
+ *           configuration cache, so the removed objects can be still found   *
+ *           with their dependencies. Removals are tracked through dependent  *
+ *           objects because cascaded deletes do not fire database triggers   *
+ *           on all databases.                                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_changelog_select_objects(void)
+{
+	zbx_hashset_iter_t	iter;
+	int			i;
+
+	for (i = 1; NULL != dbsync_changelog_vectors[i]; i++)
+	{
+		zbx_vector_uint64_sort(dbsync_changelog_vectors[i], ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(dbsync_changelog_vectors[i], ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+
+	zbx_vector_uint64_append_array(&dbsync_changelog.sync_itemids, dbsync_changelog.itemids.values,
+			dbsync_changelog.itemids.values_num);
+	zbx_vector_uint64_append_array(&dbsync_changelog.sync_template_itemids, dbsync_changelog.itemids.values,
+			dbsync_changelog.itemids.values_num);
+	zbx_vector_uint64_append_array(&dbsync_changelog.sync_prototype_itemids, dbsync_changelog.itemids.values,
+			dbsync_changelog.itemids.values_num);
+	zbx_vector_uint64_append_array(&dbsync_changelog.sync_functionids, dbsync_changelog.functionids.values,
+			dbsync_changelog.functionids.values_num);
+	zbx_vector_uint64_append_array(&dbsync_changelog.sync_triggerids, dbsync_changelog.triggerids.values,
+			dbsync_changelog.triggerids.values_num);
+	zbx_vector_uint64_append_array(&dbsync_changelog.sync_item_preprocids,
+			dbsync_changelog.item_preprocids.values, dbsync_changelog.item_preprocids.values_num);
+
+	if (0 != dbsync_changelog.del_hostids.values_num)
+	{
+		const ZBX_DC_ITEM		*item;
+		const ZBX_DC_TEMPLATE_ITEM	*template_item;
+		const ZBX_DC_PROTOTYPE_ITEM	*prototype_item;
+
+		zbx_hashset_iter_reset(&dbsync_env.cache->items, &iter);
+		while (NULL != (item = (const ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+		{
+			if (DBSYNC_VECTOR_CONTAINS(&dbsync_changelog.del_hostids, item->hostid))
+				zbx_vector_uint64_append(&dbsync_changelog.sync_itemids, item->itemid);
+		}
+
+		zbx_hashset_iter_reset(&dbsync_env.cache->template_items, &iter);
+		while (NULL != (template_item = (const ZBX_DC_TEMPLATE_ITEM *)zbx_hashset_iter_next(&iter)))
+		{
+			if (DBSYNC_VECTOR_CONTAINS(&dbsync_changelog.del_hostids, template_item->hostid))
+				zbx_vector_uint64_append(&dbsync_changelog.sync_template_itemids, template_item->itemid);
+		}
+
+		zbx_hashset_iter_reset(&dbsync_env.cache->prototype_items, &iter);
+		while (NULL != (prototype_item = (const ZBX_DC_PROTOTYPE_ITEM *)zbx_hashset_iter_next(&iter)))
+		{
+			if (DBSYNC_VECTOR_CONTAINS(&dbsync_changelog.del_hostids, prototype_item->hostid))
+			{
+				zbx_vector_uint64_append(&dbsync_changelog.sync_prototype_itemids,
+						prototype_item->itemid);
+			}
+		}
+	}
+
+	if (0 != dbsync_changelog.del_hostids.values_num || 0 != dbsync_changelog.del_itemids.values_num ||
+			0 != dbsync_changelog.del_triggerids.values_num ||
+			0 != dbsync_changelog.functionids.values_num)
+	{
+		const ZBX_DC_FUNCTION	*function;
+
+		zbx_hashset_iter_reset(&dbsync_env.cache->functions, &iter);
+		while (NULL != (function = (const ZBX_DC_FUNCTION *)zbx_hashset_iter_next(&iter)))
+		{
+			if (DBSYNC_VECTOR_CONTAINS(&dbsync_changelog.del_itemids, function->itemid) ||
+					DBSYNC_VECTOR_CONTAINS(&dbsync_changelog.del_triggerids, function->triggerid) ||
+					SUCCEED == dbsync_changelog_item_hostid_match(function->itemid,
+							&dbsync_changelog.del_hostids))
+			{
+				zbx_vector_uint64_append(&dbsync_changelog.sync_functionids, function->functionid);
+				zbx_vector_uint64_append(&dbsync_changelog.sync_triggerids, function->triggerid);
+			}
+			else if (DBSYNC_VECTOR_CONTAINS(&dbsync_changelog.functionids, function->functionid))
+				zbx_vector_uint64_append(&dbsync_changelog.sync_triggerids, function->triggerid);
+		}
+	}
+
+	if (0 != dbsync_changelog.hostids.values_num || 0 != dbsync_changelog.itemids.values_num)
+	{
+		const zbx_dc_preproc_op_t	*preproc;
+
+		zbx_hashset_iter_reset(&dbsync_env.cache->preprocops, &iter);
+		while (NULL != (preproc = (const zbx_dc_preproc_op_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (DBSYNC_VECTOR_CONTAINS(&dbsync_changelog.itemids, preproc->itemid) ||
+					SUCCEED == dbsync_changelog_item_hostid_match(preproc->itemid,
+							&dbsync_changelog.hostids))
+			{
+				zbx_vector_uint64_append(&dbsync_changelog.sync_item_preprocids,
+						preproc->item_preprocid);
+			}
+		}
+	}
+
+	for (i = 1; NULL != dbsync_changelog_vectors[i]; i++)
+	{
+		zbx_vector_uint64_sort(dbsync_changelog_vectors[i], ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+		zbx_vector_uint64_uniq(dbsync_changelog_vectors[i], ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	}
+}
+
+#undef DBSYNC_VECTOR_CONTAINS
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_changelog_check                                           *
+ *                                                                            *
+ * Purpose: checks if the changes of a table can be compared by changelog     *
+ *                                                                            *
+ * Parameters: sync         - [IN] the changeset                              *
+ *             objectids    - [IN] the objects to compare                     *
+ *             objects_num  - [IN] the number of cached objects               *
+ *                                                                            *
+ * Return value: SUCCEED - only the objects selected by changelog must be     *
+ *                         compared                                           *
+ *               FAIL    - the whole table must be compared                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	dbsync_changelog_check(const zbx_dbsync_t *sync, const zbx_vector_uint64_t *objectids,
+		int objects_num)
+{
+	if (ZBX_DBSYNC_UPDATE != sync->mode || SUCCEED != dbsync_changelog.status)
+		return FAIL;
+
+	if (objectids->values_num * ZBX_DBSYNC_CHANGELOG_RATIO > objects_num)
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_changelog_add_condition                                   *
+ *                                                                            *
+ * Purpose: adds alternative object identifier condition to the changelog     *
+ *          based object selection query                                      *
+ *                                                                            *
+ * Parameters: sql            - [IN/OUT] the sql query                        *
+ *             sql_alloc      - [IN/OUT] the sql query buffer size            *
+ *             sql_offset     - [IN/OUT] the sql query length                 *
+ *             fieldname      - [IN] the object identifier field name         *
+ *             ids            - [IN] the object identifiers                   *
+ *             conditions_num - [IN/OUT] the number of added conditions       *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_changelog_add_condition(char **sql, size_t *sql_alloc, size_t *sql_offset, const char *fieldname,
+		const zbx_vector_uint64_t *ids, int *conditions_num)
+{
+	if (0 == ids->values_num)
+		return;
+
+	if (0 != (*conditions_num)++)
+		zbx_strcpy_alloc(sql, sql_alloc, sql_offset, " or");
+
+	DBadd_condition_alloc(sql, sql_alloc, sql_offset, fieldname, ids->values, ids->values_num);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_remove_missing_rows                                       *
+ *                                                                            *
+ * Purpose: adds removal rows for the compared cached objects missing in      *
+ *          database                                                          *
+ *                                                                            *
+ * Parameters: sync      - [IN] the changeset                                 *
+ *             objects   - [IN] the cached objects                            *
+ *             objectids - [IN] the compared object identifiers               *
+ *             ids       - [IN] the object identifiers found in database      *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_remove_missing_rows(zbx_dbsync_t *sync, zbx_hashset_t *objects,
+		const zbx_vector_uint64_t *objectids, zbx_hashset_t *ids)
+{
+	int	i;
+
+	for (i = 0; i < objectids->values_num; i++)
+	{
+		if (NULL != zbx_hashset_search(ids, &objectids->values[i]))
+			continue;
+
+		if (NULL != zbx_hashset_search(objects, &objectids->values[i]))
+			dbsync_add_row(sync, objectids->values[i], ZBX_DBSYNC_ROW_REMOVE, NULL);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_changelog_init                                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_changelog_init(void)
+{
+	int	i;
+
+	zbx_hashset_create(&dbsync_changelog.records, 100, ZBX_DEFAULT_UINT64_HASH_FUNC,
+			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	for (i = 0; NULL != dbsync_changelog_vectors[i]; i++)
+		zbx_vector_uint64_create(dbsync_changelog_vectors[i]);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_env_prepare                                           *
+ *                                                                            *
+ * Purpose: reads configuration changelog and selects the objects to compare  *
+ *          during configuration synchronization                              *
+ *                                                                            *
+ * Parameters: mode - [IN] the synchronization mode (see ZBX_DBSYNC_* defines)*
+ *                                                                            *
+ * Comments: The changelog records are read in both modes to know which       *
+ *           records are already reflected in configuration cache. If the     *
+ *           changes cannot be reliably derived from changelog the whole      *
+ *           tables are compared as before.                                   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_prepare(unsigned char mode)
+{
+	int	initialized, ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	if (0 == (initialized = (NULL != dbsync_changelog.records.slots)))
+		dbsync_changelog_init();
+
+	dbsync_changelog.flushed = FAIL;
+
+	ret = dbsync_changelog_read(mode);
+
+	/* the changes made before the first synchronization in this process are unknown */
+	if (ZBX_DBSYNC_UPDATE == mode && 0 == initialized)
+		ret = FAIL;
+
+	if (SUCCEED == (dbsync_changelog.status = ret) && ZBX_DBSYNC_UPDATE == mode)
+		dbsync_changelog_select_objects();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() records:%d new:%d items:%d functions:%d triggers:%d"
+			" preprocessing:%d status:%s", __func__, dbsync_changelog.records.num_data,
+			dbsync_changelog.changelogids.values_num, dbsync_changelog.sync_itemids.values_num,
+			dbsync_changelog.sync_functionids.values_num, dbsync_changelog.sync_triggerids.values_num,
+			dbsync_changelog.sync_item_preprocids.values_num, zbx_result_string(dbsync_changelog.status));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_env_ignore_changelog                                  *
+ *                                                                            *
+ * Purpose: forces the whole table comparison for the rest of configuration   *
+ *          synchronization                                                   *
+ *                                                                            *
+ * Comments: This function is used when the compared rows can change without  *
+ *           changelog records, for example when user macros used in the rows *
+ *           are changed.                                                     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_ignore_changelog(void)
+{
+	dbsync_changelog.status = FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_env_restore_changelog                                 *
+ *                                                                            *
+ * Purpose: sets the changelog records reflected in configuration cache       *
+ *          loaded from snapshot                                              *
+ *                                                                            *
+ * Parameters: records - [IN] the changelog records read before the snapshot  *
+ *                            was written                                     *
+ *             clock   - [IN] the time the snapshot was written               *
+ *                                                                            *
+ * Comments: The next synchronization compares only the objects changed by    *
+ *           the records not known at the time the snapshot was written.      *
+ *           The records are not purged while they can be needed by the last  *
+ *           written snapshot (see zbx_dbsync_env_flush_changelog()), so the  *
+ *           restored records must still be in database. If any of them is    *
+ *           missing, the records written after the snapshot could have been  *
+ *           purged too and the whole tables are compared instead.            *
+ *           The records old enough to be purged before the snapshot was      *
+ *           written are not restored. If such records are still in database, *
+ *           the changed objects are compared again, which is harmless.       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_restore_changelog(const zbx_vector_ptr_t *records, int clock)
+{
+	int				i;
+	const zbx_dbsync_changelog_t	*record;
+
+	if (NULL == dbsync_changelog.records.slots)
+		dbsync_changelog_init();
+
+	/* the low-water mark as it would be set by synchronization at the time the snapshot was written */
+	for (i = 0; i < records->values_num; i++)
+	{
+		record = (const zbx_dbsync_changelog_t *)records->values[i];
+
+		if (record->clock + ZBX_DBSYNC_CHANGELOG_TTL < clock && dbsync_changelog.lastid < record->changelogid)
+			dbsync_changelog.lastid = record->changelogid;
+	}
+
+	for (i = 0; i < records->values_num; i++)
+	{
+		zbx_dbsync_changelog_t	record_local = *(const zbx_dbsync_changelog_t *)records->values[i];
+
+		if (record_local.changelogid <= dbsync_changelog.lastid)
+			continue;
+
+		record_local.revision = dbsync_changelog.revision;
+		zbx_hashset_insert(&dbsync_changelog.records, &record_local, sizeof(record_local));
+	}
+
+	dbsync_changelog.flushed = SUCCEED;
+	dbsync_changelog.snapshot_clock = clock;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() records:%d", __func__, dbsync_changelog.records.num_data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_env_set_snapshot_clock                                *
+ *                                                                            *
+ * Purpose: sets the time the last configuration cache snapshot was written   *
+ *                                                                            *
+ * Parameters: clock - [IN] the time the snapshot writing was started         *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_set_snapshot_clock(int clock)
+{
+	dbsync_changelog.snapshot_clock = clock;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_env_flush_changelog                                   *
+ *                                                                            *
+ * Purpose: marks the changelog records read during current synchronization   *
+ *          as processed and purges old processed records from database       *
+ *                                                                            *
+ * Comments: This function must be called after configuration cache has been *
+ *           successfully synchronized.                                       *
+ *           A record older than ZBX_DBSYNC_CHANGELOG_TTL cannot be followed  *
+ *           by records with lower identifiers committed out of order, so the *
+ *           highest identifier of such records becomes the low-water mark.   *
+ *           The records up to it are not read again and are forgotten, only  *
+ *           the records above it are checked for being lost.                 *
+ *           Only the records up to the low-water mark are purged, so the     *
+ *           records committed out of order are not lost. The records that    *
+ *           could be committed after the last snapshot was written are kept  *
+ *           until the next snapshot, otherwise the cache loaded from that    *
+ *           snapshot could not be updated by changelog.                      *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_env_flush_changelog(void)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_dbsync_changelog_t	*record;
+	zbx_uint64_t		lastid;
+	int			now, purge_clock, ret = FAIL;
+
+	if (NULL == dbsync_changelog.records.slots)
+		return;
+
+	dbsync_changelog.flushed = SUCCEED;
+	zbx_vector_uint64_clear(&dbsync_changelog.changelogids);
+
+	now = time(NULL);
+	lastid = dbsync_changelog.lastid;
+
+	zbx_hashset_iter_reset(&dbsync_changelog.records, &iter);
+	while (NULL != (record = (zbx_dbsync_changelog_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (record->clock + ZBX_DBSYNC_CHANGELOG_TTL < now && lastid < record->changelogid)
+			lastid = record->changelogid;
+	}
+
+	if (lastid != dbsync_changelog.lastid)
+	{
+		zbx_hashset_iter_reset(&dbsync_changelog.records, &iter);
+		while (NULL != (record = (zbx_dbsync_changelog_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (record->changelogid <= lastid)
+				zbx_hashset_iter_remove(&iter);
+		}
+
+		dbsync_changelog.lastid = lastid;
+	}
+
+	/* the records left by the previous purge are purged together with the next processed records */
+	if (0 == lastid || (lastid == dbsync_changelog.purge_lastid &&
+			dbsync_changelog.snapshot_clock == dbsync_changelog.purge_snapshot_clock))
+	{
+		return;
+	}
+
+	purge_clock = now;
+
+	if (0 != dbsync_changelog.snapshot_clock && dbsync_changelog.snapshot_clock < purge_clock)
+		purge_clock = dbsync_changelog.snapshot_clock;
+
+	DBbegin();
+
+	if (ZBX_DB_OK <= DBexecute("delete from changelog where changelogid<=" ZBX_FS_UI64 " and clock<%d", lastid,
+			purge_clock - ZBX_DBSYNC_CHANGELOG_TTL))
+	{
+		ret = SUCCEED;
+	}
+
+	if (SUCCEED == DBend(ret))
+	{
+		dbsync_changelog.purge_lastid = lastid;
+		dbsync_changelog.purge_snapshot_clock = dbsync_changelog.snapshot_clock;
+	}
 }
 
 /******************************************************************************
@@ -307,6 +1014,7 @@ void	zbx_dbsync_init(zbx_dbsync_t *sync, unsigned char mode)
 
 	sync->row = NULL;
 	sync->preproc_row_func = NULL;
+	sync->snapshot = NULL;
 	zbx_vector_ptr_create(&sync->columns);
 
 	if (ZBX_DBSYNC_UPDATE == sync->mode)
@@ -399,7 +1107,12 @@ int	zbx_dbsync_next(zbx_dbsync_t *sync, zbx_uint64_t *rowid, char ***row, unsign
 	{
 		char	**dbrow;
 
-		if (NULL == (dbrow = DBfetch(sync->dbresult)))
+		if (NULL != sync->snapshot)
+			dbrow = zbx_dbsnapshot_table_fetch(sync->snapshot);
+		else
+			dbrow = DBfetch(sync->dbresult);
+
+		if (NULL == dbrow)
 		{
 			*row = NULL;
 			return FAIL;
@@ -416,6 +1129,253 @@ int	zbx_dbsync_next(zbx_dbsync_t *sync, zbx_uint64_t *rowid, char ***row, unsign
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_task_run                                                  *
+ *                                                                            *
+ * Purpose: performs table comparison task                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_task_run(zbx_dbsync_task_t *task)
+{
+	double	sec;
+
+	sec = zbx_time();
+	task->ret = task->compare(task->sync);
+	task->time = zbx_time() - sec;
+}
+
+#ifdef ZBX_DBSYNC_WORKERS
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_workers_process_batch                                     *
+ *                                                                            *
+ * Purpose: performs batch tasks until there are no tasks left to start       *
+ *                                                                            *
+ * Parameters: batch - [IN/OUT] the batch being compared                      *
+ *                                                                            *
+ * Comments: Must be called with workers lock held, the lock is released      *
+ *           while the tasks are being performed.                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	dbsync_workers_process_batch(zbx_dbsync_batch_t *batch)
+{
+	zbx_dbsync_task_t	*task;
+
+	while (batch->next < batch->tasks_num)
+	{
+		task = &batch->tasks[batch->next++];
+
+		if (SUCCEED == batch->ret)
+		{
+			pthread_mutex_unlock(&dbsync_workers.lock);
+			dbsync_task_run(task);
+			pthread_mutex_lock(&dbsync_workers.lock);
+
+			if (SUCCEED != task->ret)
+				batch->ret = FAIL;
+		}
+
+		if (++batch->done == batch->tasks_num)
+			pthread_cond_signal(&dbsync_workers.batch_finished);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: dbsync_worker_thread                                             *
+ *                                                                            *
+ * Purpose: compares configuration tables with its own database connection    *
+ *                                                                            *
+ ******************************************************************************/
+static void	*dbsync_worker_thread(void *args)
+{
+	ZBX_UNUSED(args);
+
+	DBconnect(ZBX_DB_CONNECT_NORMAL);
+
+	pthread_mutex_lock(&dbsync_workers.lock);
+
+	for (;;)
+	{
+		if (NULL != dbsync_workers.batch)
+			dbsync_workers_process_batch(dbsync_workers.batch);
+
+		pthread_cond_wait(&dbsync_workers.batch_started, &dbsync_workers.lock);
+	}
+
+	return NULL;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_workers_init                                          *
+ *                                                                            *
+ * Purpose: starts threads performing table comparison batches together with  *
+ *          the calling process                                               *
+ *                                                                            *
+ * Parameters: workers_num - [IN] the number of threads to start              *
+ *                                                                            *
+ * Comments: Each thread opens its own database connection. The threads are   *
+ *           supported only with MySQL and PostgreSQL databases.              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_workers_init(int workers_num)
+{
+#ifdef ZBX_DBSYNC_WORKERS
+	sigset_t	mask, orig_mask;
+	int		err;
+
+	if (0 >= workers_num || 0 != dbsync_workers.threads_num)
+		return;
+
+	/* leave the signal handling to the process main thread */
+	sigfillset(&mask);
+	sigdelset(&mask, SIGSEGV);
+	sigdelset(&mask, SIGBUS);
+	sigdelset(&mask, SIGFPE);
+	sigdelset(&mask, SIGILL);
+	sigdelset(&mask, SIGABRT);
+
+	if (0 != (err = pthread_sigmask(SIG_BLOCK, &mask, &orig_mask)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot set signal mask for configuration synchronization threads: %s",
+				zbx_strerror(err));
+		return;
+	}
+
+	dbsync_workers.threads = (pthread_t *)zbx_malloc(NULL, sizeof(pthread_t) * workers_num);
+
+	for (; dbsync_workers.threads_num < workers_num; dbsync_workers.threads_num++)
+	{
+		if (0 != (err = pthread_create(&dbsync_workers.threads[dbsync_workers.threads_num], NULL,
+				dbsync_worker_thread, NULL)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot start configuration synchronization thread: %s",
+					zbx_strerror(err));
+			break;
+		}
+	}
+
+	pthread_sigmask(SIG_SETMASK, &orig_mask, NULL);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "started %d configuration synchronization threads", dbsync_workers.threads_num);
+#else
+	if (0 < workers_num)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "configuration synchronization threads are not supported with the"
+				" database in use, tables will be compared sequentially");
+	}
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_batch_init                                            *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_batch_init(zbx_dbsync_batch_t *batch)
+{
+	batch->tasks_num = 0;
+	batch->next = 0;
+	batch->done = 0;
+	batch->ret = SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_batch_add                                             *
+ *                                                                            *
+ * Purpose: adds table comparison to the batch                                *
+ *                                                                            *
+ * Parameters: batch   - [IN/OUT] the batch                                   *
+ *             compare - [IN] the table comparison function                   *
+ *             sync    - [OUT] the changeset                                  *
+ *             sec     - [OUT] the comparison time, reset when the task is    *
+ *                             added and summed when batch is finished, so    *
+ *                             it can be shared by several tasks              *
+ *                                                                            *
+ * Comments: The batch tasks must not depend on each other - the tables can   *
+ *           be compared in any order and at the same time.                   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_dbsync_batch_add(zbx_dbsync_batch_t *batch, zbx_dbsync_compare_func_t compare, zbx_dbsync_t *sync,
+		double *sec)
+{
+	zbx_dbsync_task_t	*task;
+
+	if (ZBX_DBSYNC_BATCH_MAX == batch->tasks_num)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		exit(EXIT_FAILURE);
+	}
+
+	task = &batch->tasks[batch->tasks_num++];
+	task->compare = compare;
+	task->sync = sync;
+	task->sec = sec;
+	task->time = 0;
+	task->ret = SUCCEED;
+
+	*sec = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_dbsync_batch_run                                             *
+ *                                                                            *
+ * Purpose: compares the batch tables, in parallel if synchronization threads *
+ *          were started                                                      *
+ *                                                                            *
+ * Parameters: batch - [IN/OUT] the batch                                     *
+ *                                                                            *
+ * Return value: SUCCEED - all changesets were successfully calculated        *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The calling process takes part in comparison and returns only    *
+ *           when all started tasks are finished.                             *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_dbsync_batch_run(zbx_dbsync_batch_t *batch)
+{
+	int	i;
+
+#ifdef ZBX_DBSYNC_WORKERS
+	if (0 != dbsync_workers.threads_num && 1 < batch->tasks_num)
+	{
+		pthread_mutex_lock(&dbsync_workers.lock);
+
+		dbsync_workers.batch = batch;
+		pthread_cond_broadcast(&dbsync_workers.batch_started);
+
+		dbsync_workers_process_batch(batch);
+
+		while (batch->done != batch->tasks_num)
+			pthread_cond_wait(&dbsync_workers.batch_finished, &dbsync_workers.lock);
+
+		dbsync_workers.batch = NULL;
+
+		pthread_mutex_unlock(&dbsync_workers.lock);
+	}
+	else
+#endif
+	{
+		for (; batch->next < batch->tasks_num && SUCCEED == batch->ret; batch->next++)
+		{
+			dbsync_task_run(&batch->tasks[batch->next]);
+
+			if (SUCCEED != batch->tasks[batch->next].ret)
+				batch->ret = FAIL;
+		}
+	}
+
+	for (i = 0; i < batch->tasks_num; i++)
+		*batch->tasks[i].sec += batch->tasks[i].time;
+
+	return batch->ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_dbsync_compare_config                                        *
@@ -1392,10 +2352,10 @@ static int	dbsync_compare_item(const ZBX_DC_ITEM *item, const DB_ROW dbrow)
 	if (FAIL == dbsync_compare_uint64(dbrow[1], item->hostid))
 		return FAIL;
 
-	if (FAIL == dbsync_compare_uint64(dbrow[48], item->templateid))
+	if (FAIL == dbsync_compare_uint64(dbrow[48], item->cold->templateid))
 		return FAIL;
 
-	if (FAIL == dbsync_compare_uint64(dbrow[49], item->parent_itemid))
+	if (FAIL == dbsync_compare_uint64(dbrow[49], item->cold->parent_itemid))
 		return FAIL;
 
 	if (NULL == (host = (ZBX_DC_HOST *)zbx_hashset_search(&dbsync_env.cache->hosts, &item->hostid)))
@@ -1423,16 +2383,16 @@ static int	dbsync_compare_item(const ZBX_DC_ITEM *item, const DB_ROW dbrow)
 	if (0 != history_sec && ZBX_HK_OPTION_ENABLED == dbsync_env.cache->config->hk.history_global)
 		history_sec = dbsync_env.cache->config->hk.history;
 
-	if (item->history != (0 != history_sec))
+	if (item->cold->history != (0 != history_sec))
 		return FAIL;
 
-	if (history_sec != item->history_sec)
+	if (history_sec != item->cold->history_sec)
 		return FAIL;
 
-	if (FAIL == dbsync_compare_uchar(dbrow[24], item->inventory_link))
+	if (FAIL == dbsync_compare_uchar(dbrow[24], item->cold->inventory_link))
 		return FAIL;
 
-	if (FAIL == dbsync_compare_uint64(dbrow[25], item->valuemapid))
+	if (FAIL == dbsync_compare_uint64(dbrow[25], item->cold->valuemapid))
 		return FAIL;
 
 	ZBX_STR2UCHAR(value_type, dbrow[4]);
@@ -1792,9 +2752,24 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	ZBX_DC_ITEM		*item;
-	char			**row;
+	char			**row, *sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			changelog;
+	zbx_vector_uint64_t	*itemids = &dbsync_changelog.sync_itemids;
 
-	if (NULL == (result = DBselect(
+	dbsync_prepare(sync, 50, dbsync_item_preproc_row);
+
+	if (NULL != sync->snapshot)
+		return zbx_dbsnapshot_table_open(sync->snapshot, sync->columns_num);
+
+	if (SUCCEED == (changelog = dbsync_changelog_check(sync, itemids, dbsync_env.cache->items.num_data)) &&
+			0 == itemids->values_num)
+	{
+		return SUCCEED;
+	}
+
+	/* the item_rtdata column indexes are also used by configuration cache snapshot */
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select i.itemid,i.hostid,i.status,i.type,i.value_type,i.key_,i.snmp_oid,i.ipmi_sensor,i.delay,"
 				"i.trapper_hosts,i.logtimefmt,i.params,ir.state,i.authtype,i.username,i.password,"
 				"i.publickey,i.privatekey,i.flags,i.interfaceid,ir.lastlogsize,ir.mtime,"
@@ -1808,13 +2783,20 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 			" left join item_discovery id on i.itemid=id.itemid"
 			" join item_rtdata ir on i.itemid=ir.itemid"
 			" where h.status in (%d,%d) and i.flags<>%d",
-			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED, ZBX_FLAG_DISCOVERY_PROTOTYPE)))
+			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED, ZBX_FLAG_DISCOVERY_PROTOTYPE);
 
+	if (SUCCEED == changelog)
 	{
-		return FAIL;
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and");
+		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "i.itemid", itemids->values,
+				itemids->values_num);
 	}
 
-	dbsync_prepare(sync, 50, dbsync_item_preproc_row);
+	result = DBselect("%s", sql);
+	zbx_free(sql);
+
+	if (NULL == result)
+		return FAIL;
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -1822,8 +2804,8 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 		return SUCCEED;
 	}
 
-	zbx_hashset_create(&ids, dbsync_env.cache->items.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&ids, SUCCEED == changelog ? itemids->values_num : dbsync_env.cache->items.num_data,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	while (NULL != (dbrow = DBfetch(result)))
 	{
@@ -1843,11 +2825,18 @@ int	zbx_dbsync_compare_items(zbx_dbsync_t *sync)
 			dbsync_add_row(sync, rowid, tag, row);
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->items, &iter);
-	while (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+	if (SUCCEED == changelog)
+	{
+		dbsync_remove_missing_rows(sync, &dbsync_env.cache->items, itemids, &ids);
+	}
+	else
 	{
-		if (NULL == zbx_hashset_search(&ids, &item->itemid))
-			dbsync_add_row(sync, item->itemid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		zbx_hashset_iter_reset(&dbsync_env.cache->items, &iter);
+		while (NULL != (item = (ZBX_DC_ITEM *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &item->itemid))
+				dbsync_add_row(sync, item->itemid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
 	}
 
 	zbx_hashset_destroy(&ids);
@@ -1885,16 +2874,38 @@ int	zbx_dbsync_compare_template_items(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	ZBX_DC_TEMPLATE_ITEM	*item;
-	char			**row;
+	char			**row, *sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			changelog;
+	zbx_vector_uint64_t	*itemids = &dbsync_changelog.sync_template_itemids;
 
-	if (NULL == (result = DBselect(
+	dbsync_prepare(sync, 3, NULL);
+
+	if (NULL != sync->snapshot)
+		return zbx_dbsnapshot_table_open(sync->snapshot, sync->columns_num);
+
+	if (SUCCEED == (changelog = dbsync_changelog_check(sync, itemids,
+			dbsync_env.cache->template_items.num_data)) && 0 == itemids->values_num)
+	{
+		return SUCCEED;
+	}
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select i.itemid,i.hostid,i.templateid from items i inner join hosts h on i.hostid=h.hostid"
-			" where h.status=%d", HOST_STATUS_TEMPLATE)))
+			" where h.status=%d", HOST_STATUS_TEMPLATE);
+
+	if (SUCCEED == changelog)
 	{
-		return FAIL;
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and");
+		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "i.itemid", itemids->values,
+				itemids->values_num);
 	}
 
-	dbsync_prepare(sync, 3, NULL);
+	result = DBselect("%s", sql);
+	zbx_free(sql);
+
+	if (NULL == result)
+		return FAIL;
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -1902,7 +2913,8 @@ int	zbx_dbsync_compare_template_items(zbx_dbsync_t *sync)
 		return SUCCEED;
 	}
 
-	zbx_hashset_create(&ids, dbsync_env.cache->template_items.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
+	zbx_hashset_create(&ids, SUCCEED == changelog ? itemids->values_num :
+			dbsync_env.cache->template_items.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
 			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	while (NULL != (dbrow = DBfetch(result)))
@@ -1926,11 +2938,18 @@ int	zbx_dbsync_compare_template_items(zbx_dbsync_t *sync)
 			dbsync_add_row(sync, rowid, tag, row);
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->template_items, &iter);
-	while (NULL != (item = (ZBX_DC_TEMPLATE_ITEM *)zbx_hashset_iter_next(&iter)))
+	if (SUCCEED == changelog)
+	{
+		dbsync_remove_missing_rows(sync, &dbsync_env.cache->template_items, itemids, &ids);
+	}
+	else
 	{
-		if (NULL == zbx_hashset_search(&ids, &item->itemid))
-			dbsync_add_row(sync, item->itemid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		zbx_hashset_iter_reset(&dbsync_env.cache->template_items, &iter);
+		while (NULL != (item = (ZBX_DC_TEMPLATE_ITEM *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &item->itemid))
+				dbsync_add_row(sync, item->itemid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
 	}
 
 	zbx_hashset_destroy(&ids);
@@ -1968,16 +2987,38 @@ int	zbx_dbsync_compare_prototype_items(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	ZBX_DC_PROTOTYPE_ITEM	*item;
-	char			**row;
+	char			**row, *sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			changelog;
+	zbx_vector_uint64_t	*itemids = &dbsync_changelog.sync_prototype_itemids;
 
-	if (NULL == (result = DBselect(
+	dbsync_prepare(sync, 3, NULL);
+
+	if (NULL != sync->snapshot)
+		return zbx_dbsnapshot_table_open(sync->snapshot, sync->columns_num);
+
+	if (SUCCEED == (changelog = dbsync_changelog_check(sync, itemids,
+			dbsync_env.cache->prototype_items.num_data)) && 0 == itemids->values_num)
+	{
+		return SUCCEED;
+	}
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select i.itemid,i.hostid,i.templateid from items i where i.flags=%d",
-				ZBX_FLAG_DISCOVERY_PROTOTYPE)))
+				ZBX_FLAG_DISCOVERY_PROTOTYPE);
+
+	if (SUCCEED == changelog)
 	{
-		return FAIL;
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and");
+		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "i.itemid", itemids->values,
+				itemids->values_num);
 	}
 
-	dbsync_prepare(sync, 3, NULL);
+	result = DBselect("%s", sql);
+	zbx_free(sql);
+
+	if (NULL == result)
+		return FAIL;
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -1985,7 +3026,8 @@ int	zbx_dbsync_compare_prototype_items(zbx_dbsync_t *sync)
 		return SUCCEED;
 	}
 
-	zbx_hashset_create(&ids, dbsync_env.cache->prototype_items.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
+	zbx_hashset_create(&ids, SUCCEED == changelog ? itemids->values_num :
+			dbsync_env.cache->prototype_items.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
 			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	while (NULL != (dbrow = DBfetch(result)))
@@ -2009,11 +3051,18 @@ int	zbx_dbsync_compare_prototype_items(zbx_dbsync_t *sync)
 			dbsync_add_row(sync, rowid, tag, row);
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->prototype_items, &iter);
-	while (NULL != (item = (ZBX_DC_PROTOTYPE_ITEM *)zbx_hashset_iter_next(&iter)))
+	if (SUCCEED == changelog)
+	{
+		dbsync_remove_missing_rows(sync, &dbsync_env.cache->prototype_items, itemids, &ids);
+	}
+	else
 	{
-		if (NULL == zbx_hashset_search(&ids, &item->itemid))
-			dbsync_add_row(sync, item->itemid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		zbx_hashset_iter_reset(&dbsync_env.cache->prototype_items, &iter);
+		while (NULL != (item = (ZBX_DC_PROTOTYPE_ITEM *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &item->itemid))
+				dbsync_add_row(sync, item->itemid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
 	}
 
 	zbx_hashset_destroy(&ids);
@@ -2147,9 +3196,25 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	ZBX_DC_TRIGGER		*trigger;
-	char			**row;
+	char			**row, *sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			changelog, conditions_num = 0;
+	zbx_vector_uint64_t	*triggerids = &dbsync_changelog.sync_triggerids,
+				*functionids = &dbsync_changelog.functionids;
 
-	if (NULL == (result = DBselect(
+	dbsync_prepare(sync, 15, dbsync_trigger_preproc_row);
+
+	if (NULL != sync->snapshot)
+		return zbx_dbsnapshot_table_open(sync->snapshot, sync->columns_num);
+
+	if (SUCCEED == (changelog = dbsync_changelog_check(sync, triggerids, dbsync_env.cache->triggers.num_data)) &&
+			0 == triggerids->values_num && 0 == functionids->values_num)
+	{
+		return SUCCEED;
+	}
+
+	/* the runtime column indexes are also used by configuration cache snapshot */
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select distinct t.triggerid,t.description,t.expression,t.error,t.priority,t.type,t.value,"
 				"t.state,t.lastchange,t.status,t.recovery_mode,t.recovery_expression,"
 				"t.correlation_mode,t.correlation_tag,opdata"
@@ -2160,12 +3225,24 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 				" and h.status in (%d,%d)"
 				" and t.flags<>%d",
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED,
-			ZBX_FLAG_DISCOVERY_PROTOTYPE)))
+			ZBX_FLAG_DISCOVERY_PROTOTYPE);
+
+	if (SUCCEED == changelog)
 	{
-		return FAIL;
+		/* new functions of cached triggers are selected by function identifiers */
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and (");
+		dbsync_changelog_add_condition(&sql, &sql_alloc, &sql_offset, "t.triggerid", triggerids,
+				&conditions_num);
+		dbsync_changelog_add_condition(&sql, &sql_alloc, &sql_offset, "f.functionid", functionids,
+				&conditions_num);
+		zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ')');
 	}
 
-	dbsync_prepare(sync, 15, dbsync_trigger_preproc_row);
+	result = DBselect("%s", sql);
+	zbx_free(sql);
+
+	if (NULL == result)
+		return FAIL;
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -2173,8 +3250,8 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 		return SUCCEED;
 	}
 
-	zbx_hashset_create(&ids, dbsync_env.cache->triggers.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
-			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_hashset_create(&ids, SUCCEED == changelog ? triggerids->values_num : dbsync_env.cache->triggers.num_data,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	while (NULL != (dbrow = DBfetch(result)))
 	{
@@ -2194,11 +3271,18 @@ int	zbx_dbsync_compare_triggers(zbx_dbsync_t *sync)
 		}
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->triggers, &iter);
-	while (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_iter_next(&iter)))
+	if (SUCCEED == changelog)
+	{
+		dbsync_remove_missing_rows(sync, &dbsync_env.cache->triggers, triggerids, &ids);
+	}
+	else
 	{
-		if (NULL == zbx_hashset_search(&ids, &trigger->triggerid))
-			dbsync_add_row(sync, trigger->triggerid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		zbx_hashset_iter_reset(&dbsync_env.cache->triggers, &iter);
+		while (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &trigger->triggerid))
+				dbsync_add_row(sync, trigger->triggerid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
 	}
 
 	zbx_hashset_destroy(&ids);
@@ -2346,8 +3430,23 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	ZBX_DC_FUNCTION		*function;
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			changelog;
+	zbx_vector_uint64_t	*functionids = &dbsync_changelog.sync_functionids;
 
-	if (NULL == (result = DBselect(
+	dbsync_prepare(sync, 5, NULL);
+
+	if (NULL != sync->snapshot)
+		return zbx_dbsnapshot_table_open(sync->snapshot, sync->columns_num);
+
+	if (SUCCEED == (changelog = dbsync_changelog_check(sync, functionids,
+			dbsync_env.cache->functions.num_data)) && 0 == functionids->values_num)
+	{
+		return SUCCEED;
+	}
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select i.itemid,f.functionid,f.name,f.parameter,t.triggerid"
 			" from hosts h,items i,functions f,triggers t"
 			" where h.hostid=i.hostid"
@@ -2356,12 +3455,20 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 				" and h.status in (%d,%d)"
 				" and t.flags<>%d",
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED,
-			ZBX_FLAG_DISCOVERY_PROTOTYPE)))
+			ZBX_FLAG_DISCOVERY_PROTOTYPE);
+
+	if (SUCCEED == changelog)
 	{
-		return FAIL;
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and");
+		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "f.functionid", functionids->values,
+				functionids->values_num);
 	}
 
-	dbsync_prepare(sync, 5, NULL);
+	result = DBselect("%s", sql);
+	zbx_free(sql);
+
+	if (NULL == result)
+		return FAIL;
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -2369,7 +3476,8 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 		return SUCCEED;
 	}
 
-	zbx_hashset_create(&ids, dbsync_env.cache->functions.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
+	zbx_hashset_create(&ids, SUCCEED == changelog ? functionids->values_num :
+			dbsync_env.cache->functions.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
 			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	while (NULL != (dbrow = DBfetch(result)))
@@ -2388,11 +3496,18 @@ int	zbx_dbsync_compare_functions(zbx_dbsync_t *sync)
 			dbsync_add_row(sync, rowid, tag, dbrow);
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->functions, &iter);
-	while (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_iter_next(&iter)))
+	if (SUCCEED == changelog)
+	{
+		dbsync_remove_missing_rows(sync, &dbsync_env.cache->functions, functionids, &ids);
+	}
+	else
 	{
-		if (NULL == zbx_hashset_search(&ids, &function->functionid))
-			dbsync_add_row(sync, function->functionid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		zbx_hashset_iter_reset(&dbsync_env.cache->functions, &iter);
+		while (NULL != (function = (ZBX_DC_FUNCTION *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &function->functionid))
+				dbsync_add_row(sync, function->functionid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
 	}
 
 	zbx_hashset_destroy(&ids);
@@ -3541,9 +4656,25 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 	zbx_hashset_iter_t	iter;
 	zbx_uint64_t		rowid;
 	zbx_dc_preproc_op_t	*preproc;
-	char			**row;
+	char			**row, *sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			changelog, conditions_num = 0;
+	zbx_vector_uint64_t	*item_preprocids = &dbsync_changelog.sync_item_preprocids,
+				*itemids = &dbsync_changelog.itemids, *hostids = &dbsync_changelog.hostids;
 
-	if (NULL == (result = DBselect(
+	dbsync_prepare(sync, 8, dbsync_item_pp_preproc_row);
+
+	if (NULL != sync->snapshot)
+		return zbx_dbsnapshot_table_open(sync->snapshot, sync->columns_num);
+
+	if (SUCCEED == (changelog = dbsync_changelog_check(sync, item_preprocids,
+			dbsync_env.cache->preprocops.num_data)) && 0 == item_preprocids->values_num &&
+			0 == itemids->values_num && 0 == hostids->values_num)
+	{
+		return SUCCEED;
+	}
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select pp.item_preprocid,pp.itemid,pp.type,pp.params,pp.step,i.hostid,pp.error_handler,"
 				"pp.error_handler_params,i.type,i.key_,h.proxy_hostid"
 			" from item_preproc pp,items i,hosts h"
@@ -3552,16 +4683,29 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 				" and (h.proxy_hostid is null"
 					" or i.type in (%d,%d,%d))"
 				" and h.status in (%d,%d)"
-				" and i.flags<>%d"
-			" order by pp.itemid",
+				" and i.flags<>%d",
 			ITEM_TYPE_INTERNAL, ITEM_TYPE_AGGREGATE, ITEM_TYPE_CALCULATED,
 			HOST_STATUS_MONITORED, HOST_STATUS_NOT_MONITORED,
-			ZBX_FLAG_DISCOVERY_PROTOTYPE)))
+			ZBX_FLAG_DISCOVERY_PROTOTYPE);
+
+	if (SUCCEED == changelog)
 	{
-		return FAIL;
+		/* item type, key and host proxy changes can make preprocessing steps processed by server */
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and (");
+		dbsync_changelog_add_condition(&sql, &sql_alloc, &sql_offset, "pp.item_preprocid", item_preprocids,
+				&conditions_num);
+		dbsync_changelog_add_condition(&sql, &sql_alloc, &sql_offset, "pp.itemid", itemids, &conditions_num);
+		dbsync_changelog_add_condition(&sql, &sql_alloc, &sql_offset, "i.hostid", hostids, &conditions_num);
+		zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ')');
 	}
 
-	dbsync_prepare(sync, 8, dbsync_item_pp_preproc_row);
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " order by pp.itemid");
+
+	result = DBselect("%s", sql);
+	zbx_free(sql);
+
+	if (NULL == result)
+		return FAIL;
 
 	if (ZBX_DBSYNC_INIT == sync->mode)
 	{
@@ -3569,7 +4713,8 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 		return SUCCEED;
 	}
 
-	zbx_hashset_create(&ids, dbsync_env.cache->hostgroups.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
+	zbx_hashset_create(&ids, SUCCEED == changelog ? item_preprocids->values_num :
+			dbsync_env.cache->hostgroups.num_data, ZBX_DEFAULT_UINT64_HASH_FUNC,
 			ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
 	while (NULL != (dbrow = DBfetch(result)))
@@ -3598,11 +4743,18 @@ int	zbx_dbsync_compare_item_preprocs(zbx_dbsync_t *sync)
 			dbsync_add_row(sync, rowid, tag, row);
 	}
 
-	zbx_hashset_iter_reset(&dbsync_env.cache->preprocops, &iter);
-	while (NULL != (preproc = (zbx_dc_preproc_op_t *)zbx_hashset_iter_next(&iter)))
+	if (SUCCEED == changelog)
+	{
+		dbsync_remove_missing_rows(sync, &dbsync_env.cache->preprocops, item_preprocids, &ids);
+	}
+	else
 	{
-		if (NULL == zbx_hashset_search(&ids, &preproc->item_preprocid))
-			dbsync_add_row(sync, preproc->item_preprocid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		zbx_hashset_iter_reset(&dbsync_env.cache->preprocops, &iter);
+		while (NULL != (preproc = (zbx_dc_preproc_op_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == zbx_hashset_search(&ids, &preproc->item_preprocid))
+				dbsync_add_row(sync, preproc->item_preprocid, ZBX_DBSYNC_ROW_REMOVE, NULL);
+		}
 	}
 
 	zbx_hashset_destroy(&ids);
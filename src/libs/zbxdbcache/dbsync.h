@@ -21,6 +21,7 @@
 #define ZABBIX_DBSYNC_H
 
 #include "common.h"
+#include "dbsnapshot.h"
 
 /* no changes */
 #define ZBX_DBSYNC_ROW_NONE	0
@@ -31,6 +32,26 @@
 /* a cached object must be removed from configuration cache */
 #define ZBX_DBSYNC_ROW_REMOVE	3
 
+/* the changelog object types, must be synced with CHANGELOG entries in schema.tmpl, */
+/* the changelog operations match ZBX_DBSYNC_ROW_ADD/UPDATE/REMOVE tags               */
+#define ZBX_DBSYNC_OBJ_HOST		1
+#define ZBX_DBSYNC_OBJ_ITEM		2
+#define ZBX_DBSYNC_OBJ_TRIGGER		3
+#define ZBX_DBSYNC_OBJ_FUNCTION		4
+#define ZBX_DBSYNC_OBJ_ITEM_PREPROC	5
+
+typedef struct
+{
+	zbx_uint64_t	changelogid;
+	zbx_uint64_t	objectid;
+	int		object;
+	int		operation;
+	int		clock;
+	/* the synchronization revision the record was last read in */
+	int		revision;
+}
+zbx_dbsync_changelog_t;
+
 #define ZBX_DBSYNC_UPDATE_HOSTS			__UINT64_C(0x0001)
 #define ZBX_DBSYNC_UPDATE_ITEMS			__UINT64_C(0x0002)
 #define ZBX_DBSYNC_UPDATE_FUNCTIONS		__UINT64_C(0x0004)
@@ -93,6 +114,9 @@ struct zbx_dbsync
 	/* the database result set for ZBX_DBSYNC_ALL mode */
 	DB_RESULT			dbresult;
 
+	/* the snapshot table used instead of database result set, can be NULL */
+	zbx_dbsnapshot_table_t		*snapshot;
+
 	/* the row preprocessing function */
 	zbx_dbsync_preproc_row_func_t	preproc_row_func;
 
@@ -108,13 +132,59 @@ struct zbx_dbsync
 	zbx_uint64_t	remove_num;
 };
 
+/* the maximum number of table comparisons in a batch */
+#define ZBX_DBSYNC_BATCH_MAX	16
+
+typedef int (*zbx_dbsync_compare_func_t)(zbx_dbsync_t *sync);
+
+typedef struct
+{
+	zbx_dbsync_compare_func_t	compare;
+	zbx_dbsync_t			*sync;
+
+	/* the comparison time is added to the referenced value after batch is finished */
+	double				*sec;
+	double				time;
+
+	int				ret;
+}
+zbx_dbsync_task_t;
+
+/* the independent table comparisons that can be performed in parallel */
+typedef struct
+{
+	zbx_dbsync_task_t	tasks[ZBX_DBSYNC_BATCH_MAX];
+	int			tasks_num;
+
+	/* the index of the next task to start */
+	int			next;
+
+	/* the number of finished tasks */
+	int			done;
+
+	/* FAIL - a comparison has failed, the tasks not yet started are skipped */
+	int			ret;
+}
+zbx_dbsync_batch_t;
+
 void	zbx_dbsync_init_env(ZBX_DC_CONFIG *cache);
 void	zbx_dbsync_free_env(void);
+void	zbx_dbsync_env_prepare(unsigned char mode);
+void	zbx_dbsync_env_ignore_changelog(void);
+void	zbx_dbsync_env_flush_changelog(void);
+void	zbx_dbsync_env_restore_changelog(const zbx_vector_ptr_t *records, int clock);
+void	zbx_dbsync_env_set_snapshot_clock(int clock);
 
 void	zbx_dbsync_init(zbx_dbsync_t *sync, unsigned char mode);
 void	zbx_dbsync_clear(zbx_dbsync_t *sync);
 int	zbx_dbsync_next(zbx_dbsync_t *sync, zbx_uint64_t *rowid, char ***rows, unsigned char *tag);
 
+void	zbx_dbsync_workers_init(int workers_num);
+void	zbx_dbsync_batch_init(zbx_dbsync_batch_t *batch);
+void	zbx_dbsync_batch_add(zbx_dbsync_batch_t *batch, zbx_dbsync_compare_func_t compare, zbx_dbsync_t *sync,
+		double *sec);
+int	zbx_dbsync_batch_run(zbx_dbsync_batch_t *batch);
+
 int	zbx_dbsync_compare_config(zbx_dbsync_t *sync);
 int	zbx_dbsync_compare_autoreg_psk(zbx_dbsync_t *sync);
 int	zbx_dbsync_compare_hosts(zbx_dbsync_t *sync);
@@ -44,6 +44,9 @@
  * If an item is already being cached the new values are automatically added to the cache
  * after being written into database.
  *
+ * To reduce memory usage the history data of numeric (float, unsigned) items is packed
+ * once it's not expected to change anymore - see vch_item_pack_chunk().
+ *
  * When cache runs out of memory to store new items it enters in low memory mode.
  * In low memory mode cache continues to function as before with few restrictions:
  *   1) items that weren't accessed during the last day are removed from cache.
@@ -52,6 +55,12 @@
  *
  * The low memory mode can't be turned off - it will persist until server is rebooted.
  * In low memory mode a warning message is written into log every 5 minutes.
+ *
+ * To reduce lock contention between processes the cache is split into shards
+ * (zbx_vc_shard_t) by itemid. Each shard has its own lock, shared memory segment,
+ * items hashset and string pool, so requests for items in different shards can be
+ * processed in parallel. The shard being accessed is selected with vc_select_shard()
+ * before locking it and all cache functions work with the selected shard data.
  */
 
 /* the period of low memory warning messages */
@@ -62,10 +71,9 @@
 
 #define ZBX_VC_LOW_MEMORY_ITEM_PRINT_LIMIT	25
 
+/* the memory of the selected value cache shard */
 static zbx_mem_info_t	*vc_mem = NULL;
 
-static zbx_mutex_t	vc_lock = ZBX_MUTEX_NULL;
-
 /* flag indicating that the cache was explicitly locked by this process */
 static int	vc_locked = 0;
 
@@ -79,6 +87,16 @@ static int	vc_state = ZBX_VC_DISABLED;
 /* the value cache size */
 extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
 
+/* the value cache snapshot file */
+extern char	*CONFIG_VALUE_CACHE_FILE;
+
+/* the time when the loaded value cache snapshot was saved and loaded */
+static int	vc_snapshot_time = 0;
+static int	vc_snapshot_load_time = 0;
+
+/* the minimum value cache shard size */
+#define ZBX_VC_SHARD_MIN_SIZE	(32 * ZBX_MEBIBYTE)
+
 ZBX_MEM_FUNC_IMPL(__vc, vc_mem)
 
 #define VC_STRPOOL_INIT_SIZE	(1000)
@@ -93,6 +111,21 @@ ZBX_MEM_FUNC_IMPL(__vc, vc_mem)
 
 #define ZBX_VC_ITEM_EXPIRE_PERIOD	SEC_PER_DAY
 
+/* the item eviction queues, see vc_release_space() */
+#define ZBX_VC_QUEUE_RECENT	0
+#define ZBX_VC_QUEUE_FREQUENT	1
+#define ZBX_VC_QUEUE_COUNT	2
+
+/* the recent items queue is evicted first while it holds more than 1/4 of cached items */
+#define ZBX_VC_RECENT_QUEUE_RATIO	4
+
+/* item references during this period after the item was cached are considered to be */
+/* correlated with the first reference and do not move it to the frequent items queue */
+#define ZBX_VC_CORRELATED_PERIOD	10
+
+/* the minimum number of evicted items remembered, see vc_ghost_limit() */
+#define ZBX_VC_GHOSTS_MIN	1000
+
 /* the data chunk used to store data fragment */
 typedef struct zbx_vc_chunk
 {
@@ -111,6 +144,11 @@ typedef struct zbx_vc_chunk
 	/* the number of item value slots in chunk */
 	int			slots_num;
 
+	/* The size of packed value data in bytes. Packed chunks store  */
+	/* slots_num values encoded as a byte stream in place of slots, */
+	/* plain chunks (packed_size is 0) store history records.       */
+	int			packed_size;
+
 	/* the item value data */
 	zbx_history_record_t	slots[1];
 }
@@ -124,12 +162,59 @@ zbx_vc_chunk_t;
 #define ZBX_VC_MAX_CHUNK_RECORDS	((64 * ZBX_KIBIBYTE - sizeof(zbx_vc_chunk_t)) / \
 		sizeof(zbx_history_record_t) + 1)
 
+/* the maximum size of one packed value - timestamp seconds and nanoseconds as 32 bit varints */
+/* followed by value type specific data, which does not exceed the size of 64 bit varint      */
+#define ZBX_VC_MAX_PACKED_RECORD_SIZE	(5 + 5 + 10)
+
 /* the item operational state flags */
 #define ZBX_ITEM_STATE_CLEAN_PENDING	1
 #define ZBX_ITEM_STATE_REMOVE_PENDING	2
 
-/* the value cache item data */
+/* the maximum number of aggregates kept for an item */
+#define ZBX_VC_ITEM_AGGREGATES_MAX	4
+
+/* the ratio of removed value and the remaining double sum when the sum must be recalculated */
+#define ZBX_VC_AGGREGATE_CANCEL_RATIO	1e6
+
+/* the incrementally updated aggregate of item values in a sliding period */
 typedef struct
+{
+	/* the aggregate function (ZBX_VC_AGGREGATE_*) */
+	int		func;
+
+	/* the period length in seconds or in number of values, only one of them is set */
+	int		seconds;
+	int		count;
+
+	/* the number of aggregated values */
+	int		values_num;
+
+	/* The number of values removed since the aggregate was calculated from cached values. */
+	/* Used to limit accumulated floating point errors of sums.                            */
+	int		values_removed;
+
+	/* set when the minimum/maximum value was removed and aggregate must be recalculated */
+	int		rescan;
+
+	/* the last time when aggregate was accessed, used to replace the least used aggregate */
+	int		last_accessed;
+
+	/* Time based aggregates cover values with timestamps in (from, to] range. Count based */
+	/* aggregates cover values in [from, to] range, where from is the timestamp of the     */
+	/* oldest aggregated value.                                                            */
+	zbx_timespec_t	from;
+	zbx_timespec_t	to;
+
+	/* the aggregated value - sum (double sum for averages), minimum or maximum */
+	history_value_t	value;
+
+	/* the rounding error compensation of double sums, see vc_aggregate_add_dbl() */
+	double		compensation;
+}
+zbx_vc_aggregate_t;
+
+/* the value cache item data */
+typedef struct zbx_vc_item
 {
 	/* the item id */
 	zbx_uint64_t	itemid;
@@ -186,9 +271,55 @@ typedef struct
 
 	/* the first (oldest) chunk of item history data              */
 	zbx_vc_chunk_t	*tail;
+
+	/* the aggregates of item values, allocated on the first      */
+	/* aggregate request, see zbx_vc_get_aggregate()              */
+	zbx_vc_aggregate_t	*aggregates;
+	int			aggregates_num;
+
+	/* 1 if the item was loaded from snapshot and was not checked */
+	/* for values added after the snapshot was saved              */
+	unsigned char	snapshot;
+
+	/* the eviction queue the item belongs to (ZBX_VC_QUEUE_*)    */
+	unsigned char	queue;
+
+	/* the time when item was added to the recent items queue     */
+	int		queue_time;
+
+	/* the neighbour items in eviction queue, the previous item   */
+	/* is closer to the queue head (more recently used)           */
+	struct zbx_vc_item	*queue_prev;
+	struct zbx_vc_item	*queue_next;
 }
 zbx_vc_item_t;
 
+/* the item eviction queue */
+typedef struct
+{
+	/* the most recently used (added) item */
+	zbx_vc_item_t	*head;
+
+	/* the least recently used (added) item - the eviction candidate */
+	zbx_vc_item_t	*tail;
+
+	int		items_num;
+
+	/* the number of cache hits of the queue items */
+	zbx_uint64_t	hits;
+}
+zbx_vc_queue_t;
+
+/* the item recently evicted from the recent items queue */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+
+	/* the eviction number when item was evicted */
+	zbx_uint64_t	eviction;
+}
+zbx_vc_ghost_t;
+
 /* the value cache data  */
 typedef struct
 {
@@ -215,34 +346,77 @@ typedef struct
 
 	/* the string pool for str, text and log item values */
 	zbx_hashset_t	strpool;
+
+	/* The item eviction queues, implementing 2Q replacement policy. Items are    */
+	/* added to the recent items queue and moved to the frequent items queue when */
+	/* referenced again. The frequent items queue is kept in LRU order.           */
+	zbx_vc_queue_t	queues[ZBX_VC_QUEUE_COUNT];
+
+	/* the items recently evicted from the recent items queue, which are moved */
+	/* directly to the frequent items queue when cached again                  */
+	zbx_hashset_t	ghosts;
+
+	/* the number of evicted items */
+	zbx_uint64_t	evictions;
 }
 zbx_vc_cache_t;
 
-/* the item weight data, used to determine if item can be removed from cache */
+ZBX_VECTOR_IMPL(vc_prefetch, zbx_vc_prefetch_t)
+
+/* the prefetched item, see zbx_vc_prefetch_values() */
 typedef struct
 {
-	/* a pointer to the value cache item */
-	zbx_vc_item_t	*item;
+	/* the history request, must be the first member as the prefetched items */
+	/* are passed to history backend as history requests                      */
+	zbx_history_request_t	request;
+
+	zbx_vc_item_t		*item;
+	int			range_start;
+}
+zbx_vc_prefetch_item_t;
+
+/* the value cache shard */
+typedef struct
+{
+	/* the shard memory */
+	zbx_mem_info_t	*mem;
 
-	/* the item 'weight' - <number of hits> / <number of cache records> */
-	double		weight;
+	/* the shard lock */
+	zbx_mutex_t	lock;
+
+	/* the shard data, allocated in the shard memory */
+	zbx_vc_cache_t	*cache;
 }
-zbx_vc_item_weight_t;
+zbx_vc_shard_t;
 
-ZBX_VECTOR_DECL(vc_itemweight, zbx_vc_item_weight_t)
-ZBX_VECTOR_IMPL(vc_itemweight, zbx_vc_item_weight_t)
+static zbx_vc_shard_t	vc_shards[ZBX_MUTEX_VALUECACHE_NUM];
+static int		vc_shards_num = 0;
 
-/* the value cache */
+/* the selected value cache shard and its data */
+static zbx_vc_shard_t	*vc_shard = NULL;
 static zbx_vc_cache_t	*vc_cache = NULL;
 
+/* The last accessed packed chunk and its unpacked values. The unpacked values are */
+/* valid only while the cache is locked and are reset whenever the cache is locked */
+/* or the chunk is freed.                                                          */
+static const zbx_vc_chunk_t	*vc_unpacked_chunk = NULL;
+static zbx_history_record_t	*vc_unpacked_values = NULL;
+
+/* the buffer used to pack chunk values before copying them to cache */
+static unsigned char	*vc_pack_buffer = NULL;
+
 /* function prototypes */
 static void	vc_history_record_copy(zbx_history_record_t *dst, const zbx_history_record_t *src, int value_type);
 static void	vc_history_record_vector_clean(zbx_vector_history_record_t *vector, int value_type);
 
+static size_t	vc_remove_item(zbx_vc_item_t *item);
 static size_t	vch_item_free_cache(zbx_vc_item_t *item);
 static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk);
 static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num);
 static void	vch_item_clean_cache(zbx_vc_item_t *item);
+static void	vch_item_remove_aggregate(zbx_vc_item_t *item, int index);
+static void	vch_item_invalidate_aggregates(zbx_vc_item_t *item, const zbx_timespec_t *ts);
+static void	vch_item_invalidate_partial_aggregates(zbx_vc_item_t *item);
 
 /******************************************************************************
  *                                                                            *
@@ -255,7 +429,10 @@ static void	vch_item_clean_cache(zbx_vc_item_t *item);
 static void	vc_try_lock(void)
 {
 	if (ZBX_VC_ENABLED == vc_state && 0 == vc_locked)
-		zbx_mutex_lock(vc_lock);
+	{
+		zbx_mutex_lock(vc_shard->lock);
+		vc_unpacked_chunk = NULL;
+	}
 }
 
 /******************************************************************************
@@ -269,7 +446,52 @@ static void	vc_try_lock(void)
 static void	vc_try_unlock(void)
 {
 	if (ZBX_VC_ENABLED == vc_state && 0 == vc_locked)
-		zbx_mutex_unlock(vc_lock);
+		zbx_mutex_unlock(vc_shard->lock);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_select_shard                                                  *
+ *                                                                            *
+ * Purpose: selects the value cache shard to work with                        *
+ *                                                                            *
+ * Parameters: index - [IN] the shard index                                   *
+ *                                                                            *
+ * Comments: The shard must be selected before locking it with vc_try_lock()  *
+ *           and must not be changed until it is unlocked, unless the whole   *
+ *           cache was explicitly locked with zbx_vc_lock() call.             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_select_shard(int index)
+{
+	vc_shard = &vc_shards[index];
+	vc_cache = vc_shard->cache;
+	vc_mem = vc_shard->mem;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_get_item_shard                                                *
+ *                                                                            *
+ * Purpose: returns index of the value cache shard storing the specified item *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_get_item_shard(zbx_uint64_t itemid)
+{
+	return ZBX_DEFAULT_UINT64_HASH_FUNC(&itemid) % vc_shards_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_select_item_shard                                             *
+ *                                                                            *
+ * Purpose: selects the value cache shard storing the specified item          *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_select_item_shard(zbx_uint64_t itemid)
+{
+	if (0 != vc_shards_num)
+		vc_select_shard(vc_get_item_shard(itemid));
 }
 
 /*********************************************************************************
@@ -540,23 +762,6 @@ static int	vc_strpool_compare_func(const void *d1, const void *d2)
 	return strcmp((char *)d1 + REFCOUNT_FIELD_SIZE, (char *)d2 + REFCOUNT_FIELD_SIZE);
 }
 
-/******************************************************************************
- *                                                                            *
- * Function: vc_item_weight_compare_func                                      *
- *                                                                            *
- * Purpose: compares two item weight data structures by their 'weight'        *
- *                                                                            *
- * Parameters: d1   - [IN] the first item weight data structure               *
- *             d2   - [IN] the second item weight data structure              *
- *                                                                            *
- ******************************************************************************/
-static int	vc_item_weight_compare_func(const zbx_vc_item_weight_t *d1, const zbx_vc_item_weight_t *d2)
-{
-	ZBX_RETURN_IF_NOT_EQUAL(d1->weight, d2->weight);
-
-	return 0;
-}
-
 /******************************************************************************
  *                                                                            *
  * Function: vc_history_logfree                                               *
@@ -630,6 +835,139 @@ static void	vc_history_record_vector_clean(zbx_vector_history_record_t *vector,
 	zbx_vector_history_record_clear(vector);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_queue_remove                                                  *
+ *                                                                            *
+ * Purpose: removes item from its eviction queue                              *
+ *                                                                            *
+ * Parameters: item - [IN] the item                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_queue_remove(zbx_vc_item_t *item)
+{
+	zbx_vc_queue_t	*queue = &vc_cache->queues[item->queue];
+
+	if (NULL != item->queue_prev)
+		item->queue_prev->queue_next = item->queue_next;
+	else
+		queue->head = item->queue_next;
+
+	if (NULL != item->queue_next)
+		item->queue_next->queue_prev = item->queue_prev;
+	else
+		queue->tail = item->queue_prev;
+
+	item->queue_prev = NULL;
+	item->queue_next = NULL;
+	queue->items_num--;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_queue_push                                                    *
+ *                                                                            *
+ * Purpose: adds item at the head of the specified eviction queue             *
+ *                                                                            *
+ * Parameters: item  - [IN] the item                                          *
+ *             index - [IN] the eviction queue (ZBX_VC_QUEUE_*)               *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_queue_push(zbx_vc_item_t *item, int index)
+{
+	zbx_vc_queue_t	*queue = &vc_cache->queues[index];
+
+	item->queue = (unsigned char)index;
+	item->queue_prev = NULL;
+	item->queue_next = queue->head;
+
+	if (NULL != queue->head)
+		queue->head->queue_prev = item;
+	else
+		queue->tail = item;
+
+	queue->head = item;
+	queue->items_num++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_item_touch                                                    *
+ *                                                                            *
+ * Purpose: updates item position in eviction queues after it was accessed   *
+ *                                                                            *
+ * Parameters: item - [IN] the item                                           *
+ *             now  - [IN] the current time                                   *
+ *                                                                            *
+ * Comments: Items in recent items queue are moved to the frequent items      *
+ *           queue when referenced after the correlated reference period, so  *
+ *           the items requested only once (or by a burst of requests) are    *
+ *           evicted first and do not push out the frequently used items.     *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_item_touch(zbx_vc_item_t *item, int now)
+{
+	if (ZBX_VC_QUEUE_RECENT == item->queue && now - item->queue_time < ZBX_VC_CORRELATED_PERIOD)
+		return;
+
+	if (ZBX_VC_QUEUE_FREQUENT == item->queue && vc_cache->queues[ZBX_VC_QUEUE_FREQUENT].head == item)
+		return;
+
+	vc_queue_remove(item);
+	vc_queue_push(item, ZBX_VC_QUEUE_FREQUENT);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_ghost_limit                                                   *
+ *                                                                            *
+ * Purpose: returns the number of the last evictions the evicted items are    *
+ *          remembered for                                                    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	vc_ghost_limit(void)
+{
+	return MAX((zbx_uint64_t)vc_cache->items.num_data / 2, ZBX_VC_GHOSTS_MIN);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_add_item                                                      *
+ *                                                                            *
+ * Purpose: adds new item to the selected cache shard                         *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *                                                                            *
+ * Return value: the added item or NULL if there is not enough memory         *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_vc_item_t	*vc_add_item(zbx_uint64_t itemid, int value_type)
+{
+	zbx_vc_item_t	new_item = {.itemid = itemid, .value_type = value_type}, *item;
+	zbx_vc_ghost_t	*ghost;
+	int		queue = ZBX_VC_QUEUE_RECENT;
+
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(zbx_vc_item_t))))
+		return NULL;
+
+	item->queue_time = time(NULL);
+	item->last_accessed = item->queue_time;
+
+	/* the item was evicted from the recent items queue not long ago, so it's being referenced repeatedly */
+	if (NULL != (ghost = (zbx_vc_ghost_t *)zbx_hashset_search(&vc_cache->ghosts, &itemid)))
+	{
+		if (vc_cache->evictions - ghost->eviction <= vc_ghost_limit())
+			queue = ZBX_VC_QUEUE_FREQUENT;
+
+		zbx_hashset_remove_direct(&vc_cache->ghosts, ghost);
+	}
+
+	vc_queue_push(item, queue);
+
+	return item;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: vc_update_statistics                                             *
@@ -641,21 +979,26 @@ static void	vc_history_record_vector_clean(zbx_vector_history_record_t *vector,
  *             misses  - [IN] the number of misses to add                     *
  *                                                                            *
  * Comments: The misses are added only to cache statistics, while hits are    *
- *           added to both - item and cache statistics.                       *
+ *           added to both - item and cache statistics. The item is also      *
+ *           moved in eviction queues as it was accessed.                     *
  *                                                                            *
  ******************************************************************************/
 static void	vc_update_statistics(zbx_vc_item_t *item, int hits, int misses)
 {
-	if (NULL != item)
-	{
-		item->hits += hits;
-		item->last_accessed = time(NULL);
-	}
-
 	if (ZBX_VC_ENABLED == vc_state)
 	{
 		vc_cache->hits += hits;
 		vc_cache->misses += misses;
+
+		if (NULL != item)
+			vc_cache->queues[item->queue].hits += hits;
+	}
+
+	if (NULL != item)
+	{
+		item->hits += hits;
+		item->last_accessed = time(NULL);
+		vc_item_touch(item, item->last_accessed);
 	}
 }
 
@@ -767,22 +1110,32 @@ static void	vc_warn_low_memory(void)
  ******************************************************************************/
 static size_t	vc_release_unused_items(const zbx_vc_item_t *source_item)
 {
-	int			timestamp;
-	zbx_hashset_iter_t	iter;
-	zbx_vc_item_t		*item;
-	size_t			freed = 0;
+	int		timestamp;
+	zbx_vc_item_t	*item, *prev;
+	size_t		freed = 0;
 
 	timestamp = time(NULL) - ZBX_VC_ITEM_EXPIRE_PERIOD;
 
-	zbx_hashset_iter_reset(&vc_cache->items, &iter);
-
-	while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+	/* The recent items queue is ordered by the time items were cached. Items accessed */
+	/* after correlated reference period are moved to the frequent items queue, so     */
+	/* items cached later than the expiration time cannot be expired.                  */
+	for (item = vc_cache->queues[ZBX_VC_QUEUE_RECENT].tail; NULL != item && item->queue_time < timestamp;
+			item = prev)
 	{
+		prev = item->queue_prev;
+
 		if (item->last_accessed < timestamp && 0 == item->refcount && source_item != item)
-		{
-			freed += vch_item_free_cache(item) + sizeof(zbx_vc_item_t);
-			zbx_hashset_iter_remove(&iter);
-		}
+			freed += vc_remove_item(item);
+	}
+
+	/* the frequent items queue is ordered by the last access time */
+	for (item = vc_cache->queues[ZBX_VC_QUEUE_FREQUENT].tail; NULL != item && item->last_accessed < timestamp;
+			item = prev)
+	{
+		prev = item->queue_prev;
+
+		if (0 == item->refcount && source_item != item)
+			freed += vc_remove_item(item);
 	}
 
 	return freed;
@@ -801,102 +1154,171 @@ static size_t	vc_release_unused_items(const zbx_vc_item_t *source_item)
  ******************************************************************************/
 void	zbx_vc_housekeeping_value_cache(void)
 {
-	vc_try_lock();
-	vc_release_unused_items(NULL);
-	vc_try_unlock();
+	int	i;
+
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		vc_select_shard(i);
+
+		vc_try_lock();
+		vc_release_unused_items(NULL);
+		vc_try_unlock();
+	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vc_release_space                                                 *
+ * Function: vc_evict_item                                                    *
  *                                                                            *
- * Purpose: frees space in cache to store the specified number of bytes by    *
- *          dropping the least accessed items                                 *
+ * Purpose: removes item from cache to free space                             *
  *                                                                            *
- * Parameters: item  - [IN] the item requesting more space to store its data  *
- *             space - [IN] the number of bytes to free                       *
+ * Parameters: item - [IN] the item                                           *
  *                                                                            *
- * Comments: The caller item must not be removed from cache to avoid          *
- *           complications (ie - checking if item still is in cache every     *
- *           time after calling vc_free_space() function).                    *
- *           vc_free_space() attempts to free at least min_free_request       *
- *           bytes of space to reduce number of space release requests.       *
+ * Return value: number of bytes freed                                        *
+ *                                                                            *
+ * Comments: Items evicted from the recent items queue are remembered, so     *
+ *           they can be moved directly to the frequent items queue if cached *
+ *           again soon.                                                      *
  *                                                                            *
  ******************************************************************************/
-static void	vc_release_space(zbx_vc_item_t *source_item, size_t space)
+static size_t	vc_evict_item(zbx_vc_item_t *item)
 {
-	zbx_hashset_iter_t		iter;
-	zbx_vc_item_t			*item;
-	int				i;
-	size_t				freed;
-	zbx_vector_vc_itemweight_t	items;
-
-	/* reserve at least min_free_request bytes to avoid spamming with free space requests */
-	if (space < vc_cache->min_free_request)
-		space = vc_cache->min_free_request;
+	zbx_vc_ghost_t		*ghost, ghost_local;
+	zbx_hashset_iter_t	iter;
+	size_t			freed;
+	int			queue = item->queue;
 
-	/* first remove items with the last accessed time older than a day */
-	if ((freed = vc_release_unused_items(source_item)) >= space)
-		return;
+	ghost_local.itemid = item->itemid;
+	ghost_local.eviction = ++vc_cache->evictions;
 
-	/* failed to free enough space by removing old items, entering low memory mode */
-	vc_cache->mode = ZBX_VC_MODE_LOWMEM;
-	vc_cache->mode_time = time(NULL);
+	freed = vc_remove_item(item);
 
-	vc_warn_low_memory();
+	if (ZBX_VC_QUEUE_RECENT != queue)
+		return freed;
 
-	/* remove items with least hits/size ratio */
-	zbx_vector_vc_itemweight_create(&items);
+	/* the ghost entry is not important, ignore it if there is not enough memory */
+	if (NULL == (ghost = (zbx_vc_ghost_t *)zbx_hashset_search(&vc_cache->ghosts, &ghost_local.itemid)))
+		ghost = (zbx_vc_ghost_t *)zbx_hashset_insert(&vc_cache->ghosts, &ghost_local, sizeof(ghost_local));
 
-	zbx_hashset_iter_reset(&vc_cache->items, &iter);
+	if (NULL != ghost)
+		ghost->eviction = ghost_local.eviction;
 
-	while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+	/* drop the forgotten items when the number of remembered items doubles */
+	if ((zbx_uint64_t)vc_cache->ghosts.num_data > vc_ghost_limit() * 2)
 	{
-		/* don't remove the item that requested the space and also keep */
-		/* items currently being accessed                               */
-		if (0 == item->refcount)
-		{
-			zbx_vc_item_weight_t	weight = {.item = item};
-
-			if (0 < item->values_total)
-				weight.weight = (double)item->hits / item->values_total;
+		zbx_hashset_iter_reset(&vc_cache->ghosts, &iter);
 
-			zbx_vector_vc_itemweight_append_ptr(&items, &weight);
+		while (NULL != (ghost = (zbx_vc_ghost_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (vc_cache->evictions - ghost->eviction > vc_ghost_limit())
+				zbx_hashset_iter_remove(&iter);
 		}
 	}
 
-	zbx_vector_vc_itemweight_sort(&items, (zbx_compare_func_t)vc_item_weight_compare_func);
-
-	for (i = 0; i < items.values_num && freed < space; i++)
-	{
-		item = items.values[i].item;
-
-		freed += vch_item_free_cache(item) + sizeof(zbx_vc_item_t);
-		zbx_hashset_remove_direct(&vc_cache->items, item);
-	}
-	zbx_vector_vc_itemweight_destroy(&items);
+	return freed;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vc_history_record_copy                                           *
+ * Function: vc_get_eviction_candidate                                        *
  *                                                                            *
- * Purpose: copies history value                                              *
+ * Purpose: finds the item to be evicted from cache                           *
  *                                                                            *
- * Parameters: dst        - [OUT] a pointer to the destination value          *
- *             src        - [IN] a pointer to the source value                *
- *             value_type - [IN] the value type (see ITEM_VALUE_TYPE_* defs)  *
+ * Return value: the item to evict or NULL if all items are being accessed    *
  *                                                                            *
- * Comments: Additional memory is allocated to store string, text and log     *
- *           value contents. This memory must be freed by the caller.         *
+ * Comments: The least recently added item of the recent items queue is       *
+ *           evicted while the queue holds more than 1/4 of cached items,     *
+ *           otherwise the least recently used item of the frequent items     *
+ *           queue is evicted.                                                *
  *                                                                            *
  ******************************************************************************/
-static void	vc_history_record_copy(zbx_history_record_t *dst, const zbx_history_record_t *src, int value_type)
+static zbx_vc_item_t	*vc_get_eviction_candidate(void)
 {
-	dst->timestamp = src->timestamp;
+	zbx_vc_item_t	*item;
+	int		i, first;
 
-	switch (value_type)
-	{
+	if (vc_cache->queues[ZBX_VC_QUEUE_RECENT].items_num * ZBX_VC_RECENT_QUEUE_RATIO > vc_cache->items.num_data)
+		first = ZBX_VC_QUEUE_RECENT;
+	else
+		first = ZBX_VC_QUEUE_FREQUENT;
+
+	for (i = 0; i < ZBX_VC_QUEUE_COUNT; i++)
+	{
+		zbx_vc_queue_t	*queue = &vc_cache->queues[(first + i) % ZBX_VC_QUEUE_COUNT];
+
+		/* keep items currently being accessed */
+		for (item = queue->tail; NULL != item; item = item->queue_prev)
+		{
+			if (0 == item->refcount)
+				return item;
+		}
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_release_space                                                 *
+ *                                                                            *
+ * Purpose: frees space in cache to store the specified number of bytes by    *
+ *          dropping the least accessed items                                 *
+ *                                                                            *
+ * Parameters: item  - [IN] the item requesting more space to store its data  *
+ *             space - [IN] the number of bytes to free                       *
+ *                                                                            *
+ * Comments: The caller item must not be removed from cache to avoid          *
+ *           complications (ie - checking if item still is in cache every     *
+ *           time after calling vc_free_space() function).                    *
+ *           vc_free_space() attempts to free at least min_free_request       *
+ *           bytes of space to reduce number of space release requests.       *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_release_space(zbx_vc_item_t *source_item, size_t space)
+{
+	zbx_vc_item_t	*item;
+	size_t		freed;
+
+	/* reserve at least min_free_request bytes to avoid spamming with free space requests */
+	if (space < vc_cache->min_free_request)
+		space = vc_cache->min_free_request;
+
+	/* first remove items with the last accessed time older than a day */
+	if ((freed = vc_release_unused_items(source_item)) >= space)
+		return;
+
+	/* failed to free enough space by removing old items, entering low memory mode */
+	vc_cache->mode = ZBX_VC_MODE_LOWMEM;
+	vc_cache->mode_time = time(NULL);
+
+	vc_warn_low_memory();
+
+	/* evict items by the eviction queues, the item that requested the space */
+	/* is being accessed and will not be evicted                               */
+	while (freed < space && NULL != (item = vc_get_eviction_candidate()))
+		freed += vc_evict_item(item);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_history_record_copy                                           *
+ *                                                                            *
+ * Purpose: copies history value                                              *
+ *                                                                            *
+ * Parameters: dst        - [OUT] a pointer to the destination value          *
+ *             src        - [IN] a pointer to the source value                *
+ *             value_type - [IN] the value type (see ITEM_VALUE_TYPE_* defs)  *
+ *                                                                            *
+ * Comments: Additional memory is allocated to store string, text and log     *
+ *           value contents. This memory must be freed by the caller.         *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_history_record_copy(zbx_history_record_t *dst, const zbx_history_record_t *src, int value_type)
+{
+	dst->timestamp = src->timestamp;
+
+	switch (value_type)
+	{
 		case ITEM_VALUE_TYPE_STR:
 		case ITEM_VALUE_TYPE_TEXT:
 			dst->value.str = zbx_strdup(NULL, src->value.str);
@@ -924,7 +1346,7 @@ static void	vc_history_record_copy(zbx_history_record_t *dst, const zbx_history_
  *                                                                            *
  ******************************************************************************/
 static void	vc_history_record_vector_append(zbx_vector_history_record_t *vector, int value_type,
-		zbx_history_record_t *value)
+		const zbx_history_record_t *value)
 {
 	zbx_history_record_t	record;
 
@@ -932,6 +1354,23 @@ static void	vc_history_record_vector_append(zbx_vector_history_record_t *vector,
 	zbx_vector_history_record_append_ptr(vector, &record);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_history_record_vector_append_func                             *
+ *                                                                            *
+ * Purpose: value cache iterator callback, appending values to the value      *
+ *          vector                                                            *
+ *                                                                            *
+ * Parameters: value      - [IN] the value to append                          *
+ *             value_type - [IN] the value type                               *
+ *             data       - [IN] the value vector                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_history_record_vector_append_func(const zbx_history_record_t *value, int value_type, void *data)
+{
+	vc_history_record_vector_append((zbx_vector_history_record_t *)data, value_type, value);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: vc_item_malloc                                                   *
@@ -1177,11 +1616,18 @@ static size_t	vc_item_free_values(zbx_vc_item_t *item, zbx_history_record_t *val
  *                                                                            *
  * Parameters: item    - [IN] the item                                        *
  *                                                                            *
+ * Return value: number of bytes freed                                        *
+ *                                                                            *
  ******************************************************************************/
-static void	vc_remove_item(zbx_vc_item_t *item)
+static size_t	vc_remove_item(zbx_vc_item_t *item)
 {
-	vch_item_free_cache(item);
+	size_t	freed;
+
+	freed = vch_item_free_cache(item) + sizeof(zbx_vc_item_t);
+	vc_queue_remove(item);
 	zbx_hashset_remove_direct(&vc_cache->items, item);
+
+	return freed;
 }
 
 /******************************************************************************
@@ -1283,1404 +1729,3757 @@ static void	vc_item_update_db_cached_from(zbx_vc_item_t *item, int timestamp)
  *
  * After adding a new chunk, the older chunks (outside the largest request
  * range) are automatically removed from cache.
+ *
+ * Chunks of float and unsigned items are packed when they are not expected to
+ * change anymore - the previous head chunk after a new head chunk was added and
+ * chunks filled with values read from database. The head chunk is never packed.
+ * Packed chunks store values as a byte stream:
+ *   <value type><value 1><value 2>...<value N>
+ * where each value is encoded as:
+ *   <seconds delta-of-delta><nanoseconds><value delta>
+ * Timestamp seconds are encoded as zigzag varint of difference between current and
+ * previous value timestamp deltas, nanoseconds as varint, unsigned values as zigzag
+ * varint of difference from the previous value and float values as bytes of XOR with
+ * the previous value, prefixed with leading/trailing zero byte counts.
+ * Packed chunks are accessed by unpacking them into a process local buffer, see
+ * vch_chunk_slots() function.
  */
 
+#define VC_ZIGZAG_ENCODE(v)	(((zbx_uint64_t)(v) << 1) ^ (zbx_uint64_t)((v) >> 63))
+#define VC_ZIGZAG_DECODE(u)	((zbx_int64_t)(((u) >> 1) ^ (~((u) & 1) + 1)))
+
+#define VC_PACKED_CHUNK_SIZE(size)	(sizeof(zbx_vc_chunk_t) - sizeof(zbx_history_record_t) + (size))
+
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_update_range                                            *
+ * Function: vc_pack_uint                                                     *
  *                                                                            *
- * Purpose: updates item range with current request range                     *
+ * Purpose: writes unsigned integer as variable length quantity               *
  *                                                                            *
- * Parameters: item   - [IN] the item                                         *
- *             range  - [IN] the request range                                *
- *             now    - [IN] the current timestamp                            *
+ * Parameters: ptr   - [OUT] the output buffer                                *
+ *             value - [IN] the value to write                                *
+ *                                                                            *
+ * Return value: the number of bytes written                                  *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_update_range(zbx_vc_item_t *item, int range, int now)
+static int	vc_pack_uint(unsigned char *ptr, zbx_uint64_t value)
 {
-	int	hour, diff;
+	int	len = 0;
 
-	if (VC_MIN_RANGE > range)
-		range = VC_MIN_RANGE;
+	while (0x80 <= value)
+	{
+		ptr[len++] = (unsigned char)(value | 0x80);
+		value >>= 7;
+	}
 
-	if (item->daily_range < range)
-		item->daily_range = range;
+	ptr[len++] = (unsigned char)value;
 
-	hour = (now / SEC_PER_HOUR) & 0xff;
+	return len;
+}
 
-	if (0 > (diff = hour - item->range_sync_hour))
-		diff += 0xff;
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_unpack_uint                                                   *
+ *                                                                            *
+ * Purpose: reads unsigned integer written by vc_pack_uint() function         *
+ *                                                                            *
+ * Parameters: ptr   - [IN] the input buffer                                  *
+ *             value - [OUT] the value read                                   *
+ *                                                                            *
+ * Return value: the number of bytes read                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_unpack_uint(const unsigned char *ptr, zbx_uint64_t *value)
+{
+	int		len = 0, shift = 0;
+	zbx_uint64_t	v = 0;
 
-	if (item->active_range < item->daily_range || ZBX_VC_RANGE_SYNC_PERIOD < diff)
+	do
 	{
-		item->active_range = item->daily_range;
-		item->daily_range = range;
-		item->range_sync_hour = hour;
+		v |= (zbx_uint64_t)(ptr[len] & 0x7f) << shift;
+		shift += 7;
 	}
+	while (0 != (ptr[len++] & 0x80));
+
+	*value = v;
+
+	return len;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_chunk_slot_count                                        *
+ * Function: vc_pack_xor                                                      *
  *                                                                            *
- * Purpose: calculates optimal number of slots for an item data chunk         *
+ * Purpose: writes meaningful bytes of XOR between two consecutive values     *
  *                                                                            *
- * Parameters:  item        - [IN] the item                                   *
- *              values_new  - [IN] the number of values to be added           *
+ * Parameters: ptr   - [OUT] the output buffer                                *
+ *             value - [IN] the value to write                                *
  *                                                                            *
- * Return value: the number of slots for a new item data chunk                *
+ * Return value: the number of bytes written                                  *
  *                                                                            *
- * Comments: From size perspective the optimal slot count per chunk is        *
- *           approximately square root of the number of cached values.        *
- *           Still creating too many chunks might affect timeshift request    *
- *           performance, so don't try creating more than 32 chunks unless    *
- *           the calculated slot count exceeds the maximum limit.             *
+ * Comments: The value is written as header byte containing number of leading *
+ *           (high 4 bits) and trailing (low 4 bits) zero bytes, followed by  *
+ *           the remaining bytes starting with the most significant one.      *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_chunk_slot_count(zbx_vc_item_t *item, int values_new)
+static int	vc_pack_xor(unsigned char *ptr, zbx_uint64_t value)
 {
-	int	nslots, values;
+	int	lead = 0, trail = 0, len = 1, i;
 
-	values = item->values_total + values_new;
+	if (0 == value)
+	{
+		*ptr = 8 << 4;
+		return 1;
+	}
 
-	nslots = zbx_isqrt32(values);
+	while (0 == ((value >> ((7 - lead) * 8)) & 0xff))
+		lead++;
 
-	if ((values + nslots - 1) / nslots + 1 > 32)
-		nslots = values / 32;
+	while (0 == ((value >> (trail * 8)) & 0xff))
+		trail++;
 
-	if (nslots > (int)ZBX_VC_MAX_CHUNK_RECORDS)
-		nslots = ZBX_VC_MAX_CHUNK_RECORDS;
-	if (nslots < (int)ZBX_VC_MIN_CHUNK_RECORDS)
-		nslots = ZBX_VC_MIN_CHUNK_RECORDS;
+	ptr[0] = (unsigned char)((lead << 4) | trail);
 
-	return nslots;
+	for (i = 7 - lead; i >= trail; i--)
+		ptr[len++] = (unsigned char)(value >> (i * 8));
+
+	return len;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_add_chunk                                               *
+ * Function: vc_unpack_xor                                                    *
  *                                                                            *
- * Purpose: adds a new data chunk at the end of item's history data list      *
+ * Purpose: reads value written by vc_pack_xor() function                     *
  *                                                                            *
- * Parameters: item          - [IN/OUT] the item to add chunk to              *
- *             nslots        - [IN] the number of slots in the new chunk      *
- *             insert_before - [IN] the target chunk before which the new     *
- *                             chunk must be inserted. If this value is NULL  *
- *                             then the new chunk is appended at the end of   *
- *                             chunk list (making it the newest chunk).       *
+ * Parameters: ptr   - [IN] the input buffer                                  *
+ *             value - [OUT] the value read                                   *
  *                                                                            *
- * Return value:  SUCCEED - the chunk was added successfully                  *
- *                FAIL - failed to create a new chunk (not enough memory)     *
+ * Return value: the number of bytes read                                     *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_add_chunk(zbx_vc_item_t *item, int nslots, zbx_vc_chunk_t *insert_before)
+static int	vc_unpack_xor(const unsigned char *ptr, zbx_uint64_t *value)
 {
-	zbx_vc_chunk_t	*chunk;
-	int		chunk_size;
+	int		lead, trail, len = 1, i;
+	zbx_uint64_t	v = 0;
 
-	chunk_size = sizeof(zbx_vc_chunk_t) + sizeof(zbx_history_record_t) * (nslots - 1);
+	lead = ptr[0] >> 4;
+	trail = ptr[0] & 0x0f;
 
-	if (NULL == (chunk = (zbx_vc_chunk_t *)vc_item_malloc(item, chunk_size)))
-		return FAIL;
+	for (i = 7 - lead; i >= trail; i--)
+		v |= (zbx_uint64_t)ptr[len++] << (i * 8);
 
-	memset(chunk, 0, sizeof(zbx_vc_chunk_t));
-	chunk->slots_num = nslots;
+	*value = v;
 
-	chunk->next = insert_before;
+	return len;
+}
 
-	if (NULL == insert_before)
-	{
-		chunk->prev = item->head;
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_pack_values                                                   *
+ *                                                                            *
+ * Purpose: packs float or unsigned history values                            *
+ *                                                                            *
+ * Parameters: buffer     - [OUT] the output buffer, must be large enough to  *
+ *                                store the packed values (see                *
+ *                                ZBX_VC_MAX_PACKED_RECORD_SIZE define)       *
+ *             value_type - [IN] the value type (ITEM_VALUE_TYPE_FLOAT or     *
+ *                               ITEM_VALUE_TYPE_UINT64)                      *
+ *             values     - [IN] the values to pack, sorted by timestamp in   *
+ *                               ascending order                              *
+ *             values_num - [IN] the number of values to pack                 *
+ *                                                                            *
+ * Return value: the size of packed data                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_pack_values(unsigned char *buffer, int value_type, const zbx_history_record_t *values,
+		int values_num)
+{
+	unsigned char	*ptr = buffer;
+	zbx_int64_t	delta, prev_delta = 0, prev_sec = 0;
+	zbx_uint64_t	prev = 0, value;
+	int		i;
 
-		if (NULL != item->head)
-			item->head->next = chunk;
-		else
-			item->tail = chunk;
+	*ptr++ = (unsigned char)value_type;
 
-		item->head = chunk;
-	}
-	else
+	for (i = 0; i < values_num; i++)
 	{
-		chunk->prev = insert_before->prev;
-		insert_before->prev = chunk;
+		delta = values[i].timestamp.sec - prev_sec;
+		ptr += vc_pack_uint(ptr, VC_ZIGZAG_ENCODE(delta - prev_delta));
+		prev_delta = delta;
+		prev_sec = values[i].timestamp.sec;
 
-		if (item->tail == insert_before)
-			item->tail = chunk;
+		ptr += vc_pack_uint(ptr, (zbx_uint64_t)values[i].timestamp.ns);
+
+		if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		{
+			memcpy(&value, &values[i].value.dbl, sizeof(value));
+			ptr += vc_pack_xor(ptr, value ^ prev);
+		}
 		else
-			chunk->prev->next = chunk;
+		{
+			value = values[i].value.ui64;
+			ptr += vc_pack_uint(ptr, VC_ZIGZAG_ENCODE((zbx_int64_t)(value - prev)));
+		}
+
+		prev = value;
 	}
 
-	return SUCCEED;
+	return (int)(ptr - buffer);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_chunk_find_last_value_before                                 *
- *                                                                            *
- * Purpose: find the index of the last value in chunk with timestamp less or  *
- *          equal to the specified timestamp.                                 *
+ * Function: vc_unpack_values                                                 *
  *                                                                            *
- * Parameters:  chunk - [IN] the chunk                                        *
- *              ts    - [IN] the target timestamp                             *
+ * Purpose: unpacks history values packed with vc_pack_values() function      *
  *                                                                            *
- * Return value: The index of the last value in chunk with timestamp less or  *
- *               equal to the specified timestamp.                            *
- *               -1 is returned in the case of failure (meaning that all      *
- *               values have timestamps greater than the target timestamp).   *
+ * Parameters: buffer     - [IN] the packed data                              *
+ *             values     - [OUT] the unpacked values                         *
+ *             values_num - [IN] the number of packed values                  *
  *                                                                            *
  ******************************************************************************/
-static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const zbx_timespec_t *ts)
+static void	vc_unpack_values(const unsigned char *buffer, zbx_history_record_t *values, int values_num)
 {
-	int	start = chunk->first_value, end = chunk->last_value, middle;
-
-	/* check if the last value timestamp is already greater or equal to the specified timestamp */
-	if (0 >= zbx_timespec_compare(&chunk->slots[end].timestamp, ts))
-		return end;
+	const unsigned char	*ptr = buffer;
+	zbx_int64_t		delta = 0, sec = 0;
+	zbx_uint64_t		prev = 0, value;
+	int			i, value_type;
 
-	/* chunk contains only one value, which did not pass the above check, return failure */
-	if (start == end)
-		return -1;
+	value_type = *ptr++;
 
-	/* perform value lookup using binary search */
-	while (start != end)
+	for (i = 0; i < values_num; i++)
 	{
-		middle = start + (end - start) / 2;
+		ptr += vc_unpack_uint(ptr, &value);
+		delta += VC_ZIGZAG_DECODE(value);
+		sec += delta;
+		values[i].timestamp.sec = (int)sec;
+
+		ptr += vc_unpack_uint(ptr, &value);
+		values[i].timestamp.ns = (int)value;
 
-		if (0 < zbx_timespec_compare(&chunk->slots[middle].timestamp, ts))
+		if (ITEM_VALUE_TYPE_FLOAT == value_type)
 		{
-			end = middle;
-			continue;
+			ptr += vc_unpack_xor(ptr, &value);
+			value ^= prev;
+			memcpy(&values[i].value.dbl, &value, sizeof(value));
 		}
-
-		if (0 >= zbx_timespec_compare(&chunk->slots[middle + 1].timestamp, ts))
+		else
 		{
-			start = middle;
-			continue;
+			ptr += vc_unpack_uint(ptr, &value);
+			value = prev + (zbx_uint64_t)VC_ZIGZAG_DECODE(value);
+			values[i].value.ui64 = value;
 		}
 
-		return middle;
+		prev = value;
 	}
-
-	return -1;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_get_last_value                                          *
+ * Function: vch_chunk_slots                                                  *
  *                                                                            *
- * Purpose: gets the chunk and index of the last value with a timestamp less  *
- *          or equal to the specified timestamp                               *
+ * Purpose: gets chunk value slots                                            *
  *                                                                            *
- * Parameters:  item          - [IN] the item                                 *
- *              ts            - [IN] the target timestamp                     *
- *                                   (NULL - current time)                    *
- *              pchunk        - [OUT] the chunk containing the target value   *
- *              pindex        - [OUT] the index of the target value           *
+ * Parameters: chunk - [IN] the chunk                                         *
  *                                                                            *
- * Return value: SUCCEED - the last value was found successfully              *
- *               FAIL - all values in cache have timestamps greater than the  *
- *                      target (timeshift) timestamp.                         *
+ * Return value: the chunk value slots                                        *
  *                                                                            *
- * Comments: If end_timestamp value is 0, then simply the last item value in  *
- *           cache is returned.                                               *
+ * Comments: Packed chunk values are unpacked into process local buffer,      *
+ *           which is reused by the next packed chunk. So the returned slots  *
+ *           must not be used after accessing slots of another chunk.         *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_get_last_value(const zbx_vc_item_t *item, const zbx_timespec_t *ts, zbx_vc_chunk_t **pchunk,
-		int *pindex)
+static const zbx_history_record_t	*vch_chunk_slots(const zbx_vc_chunk_t *chunk)
 {
-	zbx_vc_chunk_t	*chunk = item->head;
-	int		index;
-
-	if (NULL == chunk)
-		return FAIL;
-
-	index = chunk->last_value;
+	if (0 == chunk->packed_size)
+		return chunk->slots;
 
-	if (0 < zbx_timespec_compare(&chunk->slots[index].timestamp, ts))
+	if (vc_unpacked_chunk != chunk)
 	{
-		while (0 < zbx_timespec_compare(&chunk->slots[chunk->first_value].timestamp, ts))
+		if (NULL == vc_unpacked_values)
 		{
-			chunk = chunk->prev;
-			/* there are no values for requested range, return failure */
-			if (NULL == chunk)
-				return FAIL;
+			vc_unpacked_values = (zbx_history_record_t *)zbx_malloc(NULL,
+					ZBX_VC_MAX_CHUNK_RECORDS * sizeof(zbx_history_record_t));
 		}
-		index = vch_chunk_find_last_value_before(chunk, ts);
-	}
 
-	*pchunk = chunk;
-	*pindex = index;
+		vc_unpack_values((const unsigned char *)chunk->slots, vc_unpacked_values, chunk->slots_num);
+		vc_unpacked_chunk = chunk;
+	}
 
-	return SUCCEED;
+	return vc_unpacked_values;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_copy_value                                              *
+ * Function: vch_item_replace_chunk                                           *
  *                                                                            *
- * Purpose: copies value in the specified item's chunk slot                   *
+ * Purpose: replaces item data chunk with another chunk containing the same   *
+ *          values                                                            *
  *                                                                            *
- * Parameters: chunk        - [IN/OUT] the target chunk                       *
- *             index        - [IN] the target slot                            *
- *             source_value - [IN] the value to copy                          *
- *                                                                            *
- * Return value: SUCCEED - the value was copied successfully                  *
- *               FAIL    - the value copying failed (not enough space for     *
- *                         string, text or log type data)                     *
- *                                                                            *
- * Comments: This function is used to copy data to cache. The contents of     *
- *           str, text and log type values are stored in cache string pool.   *
+ * Parameters: item      - [IN/OUT] the chunk owner item                      *
+ *             chunk     - [IN] the chunk to replace, it's freed afterwards   *
+ *             new_chunk - [IN] the new chunk                                 *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_copy_value(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, int index,
-		const zbx_history_record_t *source_value)
+static void	vch_item_replace_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, zbx_vc_chunk_t *new_chunk)
 {
-	zbx_history_record_t	*value;
-	int			ret = FAIL;
+	new_chunk->prev = chunk->prev;
+	new_chunk->next = chunk->next;
 
-	value = &chunk->slots[index];
+	if (NULL != chunk->prev)
+		chunk->prev->next = new_chunk;
+	else
+		item->tail = new_chunk;
 
-	switch (item->value_type)
-	{
-		case ITEM_VALUE_TYPE_STR:
-		case ITEM_VALUE_TYPE_TEXT:
-			if (NULL == (value->value.str = vc_item_strdup(item, source_value->value.str)))
-				goto out;
-			break;
-		case ITEM_VALUE_TYPE_LOG:
-			if (NULL == (value->value.log = vc_item_logdup(item, source_value->value.log)))
-				goto out;
-			break;
-		default:
-			value->value = source_value->value;
-	}
-	value->timestamp = source_value->timestamp;
+	if (NULL != chunk->next)
+		chunk->next->prev = new_chunk;
+	else
+		item->head = new_chunk;
 
-	ret = SUCCEED;
-out:
-	return ret;
+	if (vc_unpacked_chunk == chunk)
+		vc_unpacked_chunk = NULL;
+
+	__vc_mem_free_func(chunk);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_copy_values_at_tail                                     *
- *                                                                            *
- * Purpose: copies values at the beginning of item tail chunk                 *
+ * Function: vch_item_pack_chunk                                              *
  *                                                                            *
- * Parameters: item       - [IN/OUT] the target item                          *
- *             values     - [IN] the values to copy                           *
- *             values_num - [IN] the number of values to copy                 *
+ * Purpose: replaces item data chunk with packed chunk                        *
  *                                                                            *
- * Return value: SUCCEED - the values were copied successfully                *
- *               FAIL    - the value copying failed (not enough space for     *
- *                         string, text or log type data)                     *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN] the chunk to pack                                 *
  *                                                                            *
- * Comments: This function is used to copy data to cache. The contents of     *
- *           str, text and log type values are stored in cache string pool.   *
+ * Comments: Only float and unsigned item chunks are packed. The chunk is     *
+ *           left as it is if packing does not reduce its size or there is    *
+ *           not enough memory to store the packed chunk.                     *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_copy_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+static void	vch_item_pack_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
 {
-	int	i, ret = FAIL, first_value = item->tail->first_value;
+	zbx_vc_chunk_t	*packed;
+	int		values_num, size;
 
-	switch (item->value_type)
-	{
-		case ITEM_VALUE_TYPE_STR:
-		case ITEM_VALUE_TYPE_TEXT:
-			for (i = values_num - 1; i >= 0; i--)
-			{
-				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+	if (0 != chunk->packed_size)
+		return;
 
-				if (NULL == (value->value.str = vc_item_strdup(item, values[i].value.str)))
-					goto out;
+	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
+		return;
 
-				value->timestamp = values[i].timestamp;
-				item->tail->first_value--;
-			}
-			ret = SUCCEED;
+	if (NULL == vc_pack_buffer)
+	{
+		vc_pack_buffer = (unsigned char *)zbx_malloc(NULL,
+				1 + ZBX_VC_MAX_CHUNK_RECORDS * ZBX_VC_MAX_PACKED_RECORD_SIZE);
+	}
 
-			break;
-		case ITEM_VALUE_TYPE_LOG:
-			for (i = values_num - 1; i >= 0; i--)
-			{
-				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+	values_num = chunk->last_value - chunk->first_value + 1;
+	size = vc_pack_values(vc_pack_buffer, item->value_type, chunk->slots + chunk->first_value, values_num);
 
-				if (NULL == (value->value.log = vc_item_logdup(item, values[i].value.log)))
-					goto out;
+	if ((size_t)size >= chunk->slots_num * sizeof(zbx_history_record_t))
+		return;
 
-				value->timestamp = values[i].timestamp;
-				item->tail->first_value--;
-			}
-			ret = SUCCEED;
+	/* packing is optional, so don't try freeing cache space if allocation fails */
+	if (NULL == (packed = (zbx_vc_chunk_t *)__vc_mem_malloc_func(NULL, VC_PACKED_CHUNK_SIZE(size))))
+		return;
 
-			break;
-		default:
-			memcpy(&item->tail->slots[item->tail->first_value - values_num], values,
-					values_num * sizeof(zbx_history_record_t));
-			item->tail->first_value -= values_num;
-			ret = SUCCEED;
-	}
-out:
-	item->values_total += first_value - item->tail->first_value;
+	packed->first_value = 0;
+	packed->last_value = values_num - 1;
+	packed->slots_num = values_num;
+	packed->packed_size = size;
+	memcpy(packed->slots, vc_pack_buffer, size);
 
-	return ret;
+	vch_item_replace_chunk(item, chunk, packed);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_free_chunk                                              *
+ * Function: vch_item_pack_chunks                                             *
  *                                                                            *
- * Purpose: frees chunk and all resources allocated to store its values       *
+ * Purpose: packs item data chunks in the specified range                     *
  *                                                                            *
- * Parameters: item    - [IN] the chunk owner item                            *
- *             chunk   - [IN] the chunk to free                               *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             first - [IN] the first (oldest) chunk to pack                  *
+ *             last  - [IN] the last (newest) chunk to pack, NULL to pack     *
+ *                          all chunks up to the head chunk                   *
  *                                                                            *
- * Return value: the number of bytes freed                                    *
+ * Comments: The head chunk is never packed.                                  *
  *                                                                            *
  ******************************************************************************/
-static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+static void	vch_item_pack_chunks(zbx_vc_item_t *item, zbx_vc_chunk_t *first, const zbx_vc_chunk_t *last)
 {
-	size_t	freed;
+	zbx_vc_chunk_t	*chunk, *next;
 
-	freed = sizeof(zbx_vc_chunk_t) + (chunk->slots_num - 1) * sizeof(zbx_history_record_t);
-	freed += vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->last_value);
+	for (chunk = first; NULL != chunk && chunk != item->head; chunk = next)
+	{
+		next = chunk->next;
 
-	__vc_mem_free_func(chunk);
+		if (chunk == last)
+			next = NULL;
 
-	return freed;
+		vch_item_pack_chunk(item, chunk);
+	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_remove_chunk                                            *
+ * Function: vch_item_unpack_chunk                                            *
  *                                                                            *
- * Purpose: removes item history data chunk                                   *
+ * Purpose: replaces packed item data chunk with plain chunk, so its values   *
+ *          can be modified                                                   *
  *                                                                            *
- * Parameters: item    - [IN ] the chunk owner item                           *
- *             chunk   - [IN] the chunk to remove                             *
+ * Parameters: item  - [IN/OUT] the chunk owner item                          *
+ *             chunk - [IN] the chunk to unpack                               *
+ *                                                                            *
+ * Return value: The unpacked chunk or NULL if there was not enough space in  *
+ *               cache.                                                       *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_remove_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+static zbx_vc_chunk_t	*vch_item_unpack_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
 {
-	if (NULL != chunk->next)
-		chunk->next->prev = chunk->prev;
+	zbx_vc_chunk_t	*unpacked;
 
-	if (NULL != chunk->prev)
-		chunk->prev->next = chunk->next;
+	if (0 == chunk->packed_size)
+		return chunk;
 
-	if (chunk == item->head)
-		item->head = chunk->prev;
+	if (NULL == (unpacked = (zbx_vc_chunk_t *)vc_item_malloc(item, sizeof(zbx_vc_chunk_t) +
+			sizeof(zbx_history_record_t) * (chunk->slots_num - 1))))
+	{
+		return NULL;
+	}
 
-	if (chunk == item->tail)
-		item->tail = chunk->next;
+	vc_unpack_values((const unsigned char *)chunk->slots, unpacked->slots, chunk->slots_num);
+	unpacked->first_value = chunk->first_value;
+	unpacked->last_value = chunk->last_value;
+	unpacked->slots_num = chunk->slots_num;
+	unpacked->packed_size = 0;
 
-	vch_item_free_chunk(item, chunk);
+	vch_item_replace_chunk(item, chunk, unpacked);
+
+	return unpacked;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_clean_cache                                             *
+ * Function: vch_item_update_range                                            *
  *                                                                            *
- * Purpose: removes item history data that are outside (older) the maximum    *
- *          request range                                                     *
+ * Purpose: updates item range with current request range                     *
  *                                                                            *
- * Parameters:  item   - [IN] the target item                                 *
+ * Parameters: item   - [IN] the item                                         *
+ *             range  - [IN] the request range                                *
+ *             now    - [IN] the current timestamp                            *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_clean_cache(zbx_vc_item_t *item)
+static void	vch_item_update_range(zbx_vc_item_t *item, int range, int now)
 {
-	zbx_vc_chunk_t	*next;
-
-	if (0 != item->active_range)
-	{
-		zbx_vc_chunk_t	*tail = item->tail;
-		zbx_vc_chunk_t	*chunk = tail;
-		int		timestamp;
-
-		timestamp = time(NULL) - item->active_range;
-
-		/* try to remove chunks with all history values older than maximum request range */
-		while (NULL != chunk && chunk->slots[chunk->last_value].timestamp.sec < timestamp &&
-				chunk->slots[chunk->last_value].timestamp.sec !=
-						item->head->slots[item->head->last_value].timestamp.sec)
-		{
-			/* don't remove the head chunk */
-			if (NULL == (next = chunk->next))
-				break;
-
-			/* Values with the same timestamps (seconds resolution) always should be either   */
-			/* kept in cache or removed together. There should not be a case when one of them */
-			/* is in cache and the second is dropped.                                         */
-			/* Here we are handling rare case, when the last value of first chunk has the     */
-			/* same timestamp (seconds resolution) as the first value in the second chunk.    */
-			/* In this case increase the first value index of the next chunk until the first  */
-			/* value timestamp is greater.                                                    */
+	int	hour, diff;
 
-			if (next->slots[next->first_value].timestamp.sec != next->slots[next->last_value].timestamp.sec)
-			{
-				while (next->slots[next->first_value].timestamp.sec ==
-						chunk->slots[chunk->last_value].timestamp.sec)
-				{
-					vc_item_free_values(item, next->slots, next->first_value, next->first_value);
-					next->first_value++;
-				}
-			}
+	if (VC_MIN_RANGE > range)
+		range = VC_MIN_RANGE;
 
-			/* set the database cached from timestamp to the last (oldest) removed value timestamp + 1 */
-			item->db_cached_from = chunk->slots[chunk->last_value].timestamp.sec + 1;
+	if (item->daily_range < range)
+		item->daily_range = range;
 
-			vch_item_remove_chunk(item, chunk);
+	hour = (now / SEC_PER_HOUR) & 0xff;
 
-			chunk = next;
-		}
+	if (0 > (diff = hour - item->range_sync_hour))
+		diff += 0xff;
 
-		/* reset the status flags if data was removed from cache */
-		if (tail != item->tail)
-			item->status = 0;
+	if (item->active_range < item->daily_range || ZBX_VC_RANGE_SYNC_PERIOD < diff)
+	{
+		item->active_range = item->daily_range;
+		item->daily_range = range;
+		item->range_sync_hour = hour;
 	}
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_remove_values                                           *
+ * Function: vch_item_chunk_slot_count                                        *
  *                                                                            *
- * Purpose: removes item history data that are older than the specified       *
- *          timestamp                                                         *
+ * Purpose: calculates optimal number of slots for an item data chunk         *
  *                                                                            *
- * Parameters:  item      - [IN] the target item                              *
- *              timestamp - [IN] the timestamp (number of seconds since the   *
- *                               Epoch)                                       *
+ * Parameters:  item        - [IN] the item                                   *
+ *              values_new  - [IN] the number of values to be added           *
+ *                                                                            *
+ * Return value: the number of slots for a new item data chunk                *
+ *                                                                            *
+ * Comments: From size perspective the optimal slot count per chunk is        *
+ *           approximately square root of the number of cached values.        *
+ *           Still creating too many chunks might affect timeshift request    *
+ *           performance, so don't try creating more than 32 chunks unless    *
+ *           the calculated slot count exceeds the maximum limit.             *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
+static int	vch_item_chunk_slot_count(zbx_vc_item_t *item, int values_new)
 {
-	zbx_vc_chunk_t	*chunk = item->tail;
-
-	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
-		item->status = 0;
-
-	/* try to remove chunks with all history values older than the timestamp */
-	while (chunk->slots[chunk->first_value].timestamp.sec < timestamp)
-	{
-		zbx_vc_chunk_t	*next;
+	int	nslots, values;
 
-		/* If chunk contains values with timestamp greater or equal - remove */
-		/* only the values with less timestamp. Otherwise remove the while   */
-		/* chunk and check next one.                                         */
-		if (chunk->slots[chunk->last_value].timestamp.sec >= timestamp)
-		{
-			while (chunk->slots[chunk->first_value].timestamp.sec < timestamp)
-			{
-				vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->first_value);
-				chunk->first_value++;
-			}
+	values = item->values_total + values_new;
 
-			break;
-		}
+	nslots = zbx_isqrt32(values);
 
-		next = chunk->next;
-		vch_item_remove_chunk(item, chunk);
+	if ((values + nslots - 1) / nslots + 1 > 32)
+		nslots = values / 32;
 
-		/* empty items must be removed to avoid situation when a new value is added to cache */
-		/* while other values with matching timestamp seconds are not cached                 */
-		if (NULL == next)
-		{
-			item->state |= ZBX_ITEM_STATE_REMOVE_PENDING;
-			break;
-		}
+	if (nslots > (int)ZBX_VC_MAX_CHUNK_RECORDS)
+		nslots = ZBX_VC_MAX_CHUNK_RECORDS;
+	if (nslots < (int)ZBX_VC_MIN_CHUNK_RECORDS)
+		nslots = ZBX_VC_MIN_CHUNK_RECORDS;
 
-		chunk = next;
-	}
+	return nslots;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_add_value_at_head                                       *
- *                                                                            *
- * Purpose: adds one item history value at the end of current item's history  *
- *          data                                                              *
+ * Function: vch_item_add_chunk                                               *
  *                                                                            *
- * Parameters:  item   - [IN] the item to add history data to                 *
- *              value  - [IN] the item history data value                     *
+ * Purpose: adds a new data chunk at the end of item's history data list      *
  *                                                                            *
- * Return value: SUCCEED - the history data value was added successfully      *
- *               FAIL - failed to add history data value (not enough memory)  *
+ * Parameters: item          - [IN/OUT] the item to add chunk to              *
+ *             nslots        - [IN] the number of slots in the new chunk      *
+ *             insert_before - [IN] the target chunk before which the new     *
+ *                             chunk must be inserted. If this value is NULL  *
+ *                             then the new chunk is appended at the end of   *
+ *                             chunk list (making it the newest chunk).       *
  *                                                                            *
- * Comments: In the case of failure the item will be removed from cache       *
- *           later.                                                           *
+ * Return value:  SUCCEED - the chunk was added successfully                  *
+ *                FAIL - failed to create a new chunk (not enough memory)     *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_record_t *value)
+static int	vch_item_add_chunk(zbx_vc_item_t *item, int nslots, zbx_vc_chunk_t *insert_before)
 {
-	int		ret = FAIL, index, sindex, nslots = 0;
-	zbx_vc_chunk_t	*head = item->head, *chunk, *schunk;
+	zbx_vc_chunk_t	*chunk;
+	int		chunk_size;
 
-	if (NULL != item->head &&
-			0 < zbx_history_record_compare_asc_func(&item->head->slots[item->head->last_value], value))
+	chunk_size = sizeof(zbx_vc_chunk_t) + sizeof(zbx_history_record_t) * (nslots - 1);
+
+	if (NULL == (chunk = (zbx_vc_chunk_t *)vc_item_malloc(item, chunk_size)))
+		return FAIL;
+
+	memset(chunk, 0, sizeof(zbx_vc_chunk_t));
+	chunk->slots_num = nslots;
+
+	chunk->next = insert_before;
+
+	if (NULL == insert_before)
 	{
-		if (0 < zbx_history_record_compare_asc_func(&item->tail->slots[item->tail->first_value], value))
-		{
-			/* If the added value has the same or older timestamp as the first value in cache */
-			/* we can't add it to keep cache consistency. Additionally we must make sure no   */
-			/* values with matching timestamp seconds are kept in cache.                      */
-			vch_item_remove_values(item, value->timestamp.sec + 1);
+		chunk->prev = item->head;
 
-			/* if the value is newer than the database cached from timestamp we must */
-			/* adjust the cached from timestamp to exclude this value                */
-			if (item->db_cached_from <= value->timestamp.sec)
-				item->db_cached_from = value->timestamp.sec + 1;
+		if (NULL != item->head)
+			item->head->next = chunk;
+		else
+			item->tail = chunk;
 
-			ret = SUCCEED;
-			goto out;
-		}
+		item->head = chunk;
+	}
+	else
+	{
+		chunk->prev = insert_before->prev;
+		insert_before->prev = chunk;
 
-		sindex = item->head->last_value;
-		schunk = item->head;
+		if (item->tail == insert_before)
+			item->tail = chunk;
+		else
+			chunk->prev->next = chunk;
+	}
 
-		if (0 == item->head->slots_num - item->head->last_value - 1)
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_chunk_find_last_value_before                                 *
+ *                                                                            *
+ * Purpose: find the index of the last value in chunk with timestamp less or  *
+ *          equal to the specified timestamp.                                 *
+ *                                                                            *
+ * Parameters:  chunk - [IN] the chunk                                        *
+ *              ts    - [IN] the target timestamp                             *
+ *                                                                            *
+ * Return value: The index of the last value in chunk with timestamp less or  *
+ *               equal to the specified timestamp.                            *
+ *               -1 is returned in the case of failure (meaning that all      *
+ *               values have timestamps greater than the target timestamp).   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_chunk_find_last_value_before(const zbx_vc_chunk_t *chunk, const zbx_timespec_t *ts)
+{
+	int				start = chunk->first_value, end = chunk->last_value, middle;
+	const zbx_history_record_t	*slots;
+
+	slots = vch_chunk_slots(chunk);
+
+	/* check if the last value timestamp is already greater or equal to the specified timestamp */
+	if (0 >= zbx_timespec_compare(&slots[end].timestamp, ts))
+		return end;
+
+	/* chunk contains only one value, which did not pass the above check, return failure */
+	if (start == end)
+		return -1;
+
+	/* perform value lookup using binary search */
+	while (start != end)
+	{
+		middle = start + (end - start) / 2;
+
+		if (0 < zbx_timespec_compare(&slots[middle].timestamp, ts))
 		{
-			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
-				goto out;
+			end = middle;
+			continue;
 		}
-		else
-			item->head->last_value++;
 
-		item->values_total++;
+		if (0 >= zbx_timespec_compare(&slots[middle + 1].timestamp, ts))
+		{
+			start = middle;
+			continue;
+		}
 
-		chunk = item->head;
-		index = item->head->last_value;
+		return middle;
+	}
 
-		do
+	return -1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_last_value                                          *
+ *                                                                            *
+ * Purpose: gets the chunk and index of the last value with a timestamp less  *
+ *          or equal to the specified timestamp                               *
+ *                                                                            *
+ * Parameters:  item          - [IN] the item                                 *
+ *              ts            - [IN] the target timestamp                     *
+ *                                   (NULL - current time)                    *
+ *              pchunk        - [OUT] the chunk containing the target value   *
+ *              pindex        - [OUT] the index of the target value           *
+ *                                                                            *
+ * Return value: SUCCEED - the last value was found successfully              *
+ *               FAIL - all values in cache have timestamps greater than the  *
+ *                      target (timeshift) timestamp.                         *
+ *                                                                            *
+ * Comments: If end_timestamp value is 0, then simply the last item value in  *
+ *           cache is returned.                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_last_value(const zbx_vc_item_t *item, const zbx_timespec_t *ts, zbx_vc_chunk_t **pchunk,
+		int *pindex)
+{
+	zbx_vc_chunk_t	*chunk = item->head;
+	int		index;
+
+	if (NULL == chunk)
+		return FAIL;
+
+	index = chunk->last_value;
+
+	if (0 < zbx_timespec_compare(&vch_chunk_slots(chunk)[index].timestamp, ts))
+	{
+		while (0 < zbx_timespec_compare(&vch_chunk_slots(chunk)[chunk->first_value].timestamp, ts))
 		{
-			chunk->slots[index] = schunk->slots[sindex];
+			chunk = chunk->prev;
+			/* there are no values for requested range, return failure */
+			if (NULL == chunk)
+				return FAIL;
+		}
+		index = vch_chunk_find_last_value_before(chunk, ts);
+	}
 
-			chunk = schunk;
-			index = sindex;
+	*pchunk = chunk;
+	*pindex = index;
 
-			if (--sindex < schunk->first_value)
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_copy_value                                              *
+ *                                                                            *
+ * Purpose: copies value in the specified item's chunk slot                   *
+ *                                                                            *
+ * Parameters: chunk        - [IN/OUT] the target chunk                       *
+ *             index        - [IN] the target slot                            *
+ *             source_value - [IN] the value to copy                          *
+ *                                                                            *
+ * Return value: SUCCEED - the value was copied successfully                  *
+ *               FAIL    - the value copying failed (not enough space for     *
+ *                         string, text or log type data)                     *
+ *                                                                            *
+ * Comments: This function is used to copy data to cache. The contents of     *
+ *           str, text and log type values are stored in cache string pool.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_copy_value(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk, int index,
+		const zbx_history_record_t *source_value)
+{
+	zbx_history_record_t	*value;
+	int			ret = FAIL;
+
+	value = &chunk->slots[index];
+
+	switch (item->value_type)
+	{
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			if (NULL == (value->value.str = vc_item_strdup(item, source_value->value.str)))
+				goto out;
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			if (NULL == (value->value.log = vc_item_logdup(item, source_value->value.log)))
+				goto out;
+			break;
+		default:
+			value->value = source_value->value;
+	}
+	value->timestamp = source_value->timestamp;
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_copy_values_at_tail                                     *
+ *                                                                            *
+ * Purpose: copies values at the beginning of item tail chunk                 *
+ *                                                                            *
+ * Parameters: item       - [IN/OUT] the target item                          *
+ *             values     - [IN] the values to copy                           *
+ *             values_num - [IN] the number of values to copy                 *
+ *                                                                            *
+ * Return value: SUCCEED - the values were copied successfully                *
+ *               FAIL    - the value copying failed (not enough space for     *
+ *                         string, text or log type data)                     *
+ *                                                                            *
+ * Comments: This function is used to copy data to cache. The contents of     *
+ *           str, text and log type values are stored in cache string pool.   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_copy_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+{
+	int	i, ret = FAIL, first_value = item->tail->first_value;
+
+	switch (item->value_type)
+	{
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			for (i = values_num - 1; i >= 0; i--)
 			{
-				if (NULL == (schunk = schunk->prev))
-				{
-					memset(&chunk->slots[index], 0, sizeof(zbx_vc_chunk_t));
-					THIS_SHOULD_NEVER_HAPPEN;
+				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
 
+				if (NULL == (value->value.str = vc_item_strdup(item, values[i].value.str)))
 					goto out;
-				}
 
-				sindex = schunk->last_value;
-			}
+				value->timestamp = values[i].timestamp;
+				item->tail->first_value--;
+			}
+			ret = SUCCEED;
+
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			for (i = values_num - 1; i >= 0; i--)
+			{
+				zbx_history_record_t	*value = &item->tail->slots[item->tail->first_value - 1];
+
+				if (NULL == (value->value.log = vc_item_logdup(item, values[i].value.log)))
+					goto out;
+
+				value->timestamp = values[i].timestamp;
+				item->tail->first_value--;
+			}
+			ret = SUCCEED;
+
+			break;
+		default:
+			memcpy(&item->tail->slots[item->tail->first_value - values_num], values,
+					values_num * sizeof(zbx_history_record_t));
+			item->tail->first_value -= values_num;
+			ret = SUCCEED;
+	}
+out:
+	item->values_total += first_value - item->tail->first_value;
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_free_chunk                                              *
+ *                                                                            *
+ * Purpose: frees chunk and all resources allocated to store its values       *
+ *                                                                            *
+ * Parameters: item    - [IN] the chunk owner item                            *
+ *             chunk   - [IN] the chunk to free                               *
+ *                                                                            *
+ * Return value: the number of bytes freed                                    *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_item_free_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	size_t	freed;
+
+	if (0 != chunk->packed_size)
+	{
+		freed = VC_PACKED_CHUNK_SIZE(chunk->packed_size);
+		item->values_total -= chunk->last_value - chunk->first_value + 1;
+	}
+	else
+	{
+		freed = sizeof(zbx_vc_chunk_t) + (chunk->slots_num - 1) * sizeof(zbx_history_record_t);
+		freed += vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->last_value);
+	}
+
+	if (vc_unpacked_chunk == chunk)
+		vc_unpacked_chunk = NULL;
+
+	__vc_mem_free_func(chunk);
+
+	return freed;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_remove_chunk                                            *
+ *                                                                            *
+ * Purpose: removes item history data chunk                                   *
+ *                                                                            *
+ * Parameters: item    - [IN ] the chunk owner item                           *
+ *             chunk   - [IN] the chunk to remove                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_remove_chunk(zbx_vc_item_t *item, zbx_vc_chunk_t *chunk)
+{
+	if (NULL != chunk->next)
+		chunk->next->prev = chunk->prev;
+
+	if (NULL != chunk->prev)
+		chunk->prev->next = chunk->next;
+
+	if (chunk == item->head)
+		item->head = chunk->prev;
+
+	if (chunk == item->tail)
+		item->tail = chunk->next;
+
+	vch_item_free_chunk(item, chunk);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_clean_cache                                             *
+ *                                                                            *
+ * Purpose: removes item history data that are outside (older) the maximum    *
+ *          request range                                                     *
+ *                                                                            *
+ * Parameters:  item   - [IN] the target item                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_clean_cache(zbx_vc_item_t *item)
+{
+	zbx_vc_chunk_t	*next;
+
+	if (0 != item->active_range)
+	{
+		zbx_vc_chunk_t	*tail = item->tail;
+		zbx_vc_chunk_t	*chunk = tail;
+		int		timestamp, head_sec, last_sec, i;
+
+		timestamp = time(NULL) - item->active_range;
+
+		/* keep values of aggregates requested within the maximum request range, so they */
+		/* can be removed from aggregates when the aggregated periods slide forward     */
+		for (i = 0; i < item->aggregates_num; i++)
+		{
+			if (item->aggregates[i].from.sec >= timestamp)
+				continue;
+
+			if (item->aggregates[i].last_accessed < timestamp)
+				vch_item_remove_aggregate(item, i--);
+			else
+				timestamp = item->aggregates[i].from.sec;
+		}
+
+		head_sec = vch_chunk_slots(item->head)[item->head->last_value].timestamp.sec;
+
+		/* try to remove chunks with all history values older than maximum request range */
+		while (NULL != chunk && (last_sec = vch_chunk_slots(chunk)[chunk->last_value].timestamp.sec) < timestamp &&
+				last_sec != head_sec)
+		{
+			/* don't remove the head chunk */
+			if (NULL == (next = chunk->next))
+				break;
+
+			/* Values with the same timestamps (seconds resolution) always should be either   */
+			/* kept in cache or removed together. There should not be a case when one of them */
+			/* is in cache and the second is dropped.                                         */
+			/* Here we are handling rare case, when the last value of first chunk has the     */
+			/* same timestamp (seconds resolution) as the first value in the second chunk.    */
+			/* In this case increase the first value index of the next chunk until the first  */
+			/* value timestamp is greater.                                                    */
+
+			if (vch_chunk_slots(next)[next->first_value].timestamp.sec !=
+					vch_chunk_slots(next)[next->last_value].timestamp.sec)
+			{
+				while (vch_chunk_slots(next)[next->first_value].timestamp.sec == last_sec)
+				{
+					vc_item_free_values(item, next->slots, next->first_value, next->first_value);
+					next->first_value++;
+				}
+			}
+
+			/* set the database cached from timestamp to the last (oldest) removed value timestamp + 1 */
+			item->db_cached_from = last_sec + 1;
+
+			vch_item_remove_chunk(item, chunk);
+
+			chunk = next;
+		}
+
+		/* reset the status flags if data was removed from cache */
+		if (tail != item->tail)
+			item->status = 0;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_remove_values                                           *
+ *                                                                            *
+ * Purpose: removes item history data that are older than the specified       *
+ *          timestamp                                                         *
+ *                                                                            *
+ * Parameters:  item      - [IN] the target item                              *
+ *              timestamp - [IN] the timestamp (number of seconds since the   *
+ *                               Epoch)                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_remove_values(zbx_vc_item_t *item, int timestamp)
+{
+	zbx_vc_chunk_t	*chunk = item->tail;
+
+	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
+		item->status = 0;
+
+	/* try to remove chunks with all history values older than the timestamp */
+	while (vch_chunk_slots(chunk)[chunk->first_value].timestamp.sec < timestamp)
+	{
+		zbx_vc_chunk_t	*next;
+
+		/* If chunk contains values with timestamp greater or equal - remove */
+		/* only the values with less timestamp. Otherwise remove the while   */
+		/* chunk and check next one.                                         */
+		if (vch_chunk_slots(chunk)[chunk->last_value].timestamp.sec >= timestamp)
+		{
+			while (vch_chunk_slots(chunk)[chunk->first_value].timestamp.sec < timestamp)
+			{
+				vc_item_free_values(item, chunk->slots, chunk->first_value, chunk->first_value);
+				chunk->first_value++;
+			}
+
+			break;
+		}
+
+		next = chunk->next;
+		vch_item_remove_chunk(item, chunk);
+
+		/* empty items must be removed to avoid situation when a new value is added to cache */
+		/* while other values with matching timestamp seconds are not cached                 */
+		if (NULL == next)
+		{
+			item->state |= ZBX_ITEM_STATE_REMOVE_PENDING;
+			break;
+		}
+
+		chunk = next;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_add_value_at_head                                       *
+ *                                                                            *
+ * Purpose: adds one item history value at the end of current item's history  *
+ *          data                                                              *
+ *                                                                            *
+ * Parameters:  item   - [IN] the item to add history data to                 *
+ *              value  - [IN] the item history data value                     *
+ *                                                                            *
+ * Return value: SUCCEED - the history data value was added successfully      *
+ *               FAIL - failed to add history data value (not enough memory)  *
+ *                                                                            *
+ * Comments: In the case of failure the item will be removed from cache       *
+ *           later. If the failure happens after values were moved to make    *
+ *           space for older value, the item data is dropped immediately.     *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_add_value_at_head(zbx_vc_item_t *item, const zbx_history_record_t *value)
+{
+	int		ret = FAIL, index, sindex, nslots = 0, shifted = 0;
+	zbx_vc_chunk_t	*head = item->head, *chunk, *schunk, *unpacked = NULL;
+
+	/* aggregates of periods including the value timestamp can't be updated incrementally anymore */
+	if (0 != item->aggregates_num)
+		vch_item_invalidate_aggregates(item, &value->timestamp);
+
+	if (NULL != item->head &&
+			0 < zbx_history_record_compare_asc_func(&item->head->slots[item->head->last_value], value))
+	{
+		if (0 < zbx_history_record_compare_asc_func(&vch_chunk_slots(item->tail)[item->tail->first_value],
+				value))
+		{
+			/* If the added value has the same or older timestamp as the first value in cache */
+			/* we can't add it to keep cache consistency. Additionally we must make sure no   */
+			/* values with matching timestamp seconds are kept in cache.                      */
+			vch_item_remove_values(item, value->timestamp.sec + 1);
+
+			/* if the value is newer than the database cached from timestamp we must */
+			/* adjust the cached from timestamp to exclude this value                */
+			if (item->db_cached_from <= value->timestamp.sec)
+				item->db_cached_from = value->timestamp.sec + 1;
+
+			ret = SUCCEED;
+			goto out;
+		}
+
+		/* Values are moved between chunks, so packed chunks must be unpacked. Unpack all chunks */
+		/* with newer values before changing the item, so unpacking failure leaves it unchanged. */
+		for (schunk = item->head; NULL != schunk; schunk = schunk->prev)
+		{
+			if (0 >= zbx_timespec_compare(&vch_chunk_slots(schunk)[schunk->last_value].timestamp,
+					&value->timestamp))
+			{
+				break;
+			}
+
+			if (0 != schunk->packed_size)
+			{
+				if (NULL == (schunk = vch_item_unpack_chunk(item, schunk)))
+					goto out;
+
+				unpacked = schunk;
+			}
+
+			if (0 >= zbx_timespec_compare(&schunk->slots[schunk->first_value].timestamp, &value->timestamp))
+				break;
+		}
+
+		sindex = item->head->last_value;
+		schunk = item->head;
+
+		if (0 == item->head->slots_num - item->head->last_value - 1)
+		{
+			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
+				goto out;
+		}
+		else
+			item->head->last_value++;
+
+		item->values_total++;
+		shifted = 1;
+
+		chunk = item->head;
+		index = item->head->last_value;
+
+		do
+		{
+			chunk->slots[index] = schunk->slots[sindex];
+
+			chunk = schunk;
+			index = sindex;
+
+			if (--sindex < schunk->first_value)
+			{
+				if (NULL == (schunk = schunk->prev))
+				{
+					memset(&chunk->slots[index], 0, sizeof(zbx_vc_chunk_t));
+					THIS_SHOULD_NEVER_HAPPEN;
+
+					goto out;
+				}
+
+				sindex = schunk->last_value;
+			}
+		}
+		while (0 < zbx_timespec_compare(&vch_chunk_slots(schunk)[sindex].timestamp, &value->timestamp));
+	}
+	else
+	{
+		/* find the number of free slots on the right side in last (head) chunk */
+		if (NULL != item->head)
+			nslots = item->head->slots_num - item->head->last_value - 1;
+
+		if (0 == nslots)
+		{
+			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
+				goto out;
+		}
+		else
+			item->head->last_value++;
+
+		item->values_total++;
+
+		chunk = item->head;
+		index = item->head->last_value;
+	}
+
+	if (SUCCEED != vch_item_copy_value(item, chunk, index, value))
+		goto out;
+
+	/* pack the previous head chunk and chunks unpacked to insert the value */
+	if (NULL != unpacked)
+		vch_item_pack_chunks(item, unpacked, NULL);
+	else if (NULL != head && head != item->head)
+		vch_item_pack_chunks(item, head, NULL);
+
+	/* try to remove old (unused) chunks if a new chunk was added */
+	if (head != item->head)
+		item->state |= ZBX_ITEM_STATE_CLEAN_PENDING;
+
+	ret = SUCCEED;
+out:
+	if (FAIL == ret)
+	{
+		if (0 != shifted)
+		{
+			/* values were already moved, drop the item data rather than keeping it inconsistent */
+			vch_item_free_cache(item);
+			item->status = 0;
+			item->db_cached_from = 0;
+		}
+		else if (NULL != unpacked)
+			vch_item_pack_chunks(item, unpacked, NULL);
+	}
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_add_values_at_tail                                      *
+ *                                                                            *
+ * Purpose: adds item history values at the beginning of current item's       *
+ *          history data                                                      *
+ *                                                                            *
+ * Parameters:  item   - [IN] the item to add history data to                 *
+ *              values - [IN] the item history data values                    *
+ *              num    - [IN] the number of history data values to add        *
+ *                                                                            *
+ * Return value: SUCCEED - the history data values were added successfully    *
+ *               FAIL - failed to add history data values (not enough memory) *
+ *                                                                            *
+ * Comments: In the case of failure the item is removed from cache.           *
+ *           Overlapping values (by timestamp seconds) are ignored.           *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+{
+	int 		count = values_num, ret = FAIL;
+	zbx_vc_chunk_t	*tail = item->tail;
+
+	/* skip values already added to the item cache by another process */
+	if (NULL != item->tail)
+	{
+		int	sec = vch_chunk_slots(item->tail)[item->tail->first_value].timestamp.sec;
+
+		while (--count >= 0 && values[count].timestamp.sec >= sec)
+			;
+		++count;
+	}
+
+	while (0 != count)
+	{
+		int	copy_slots, nslots = 0;
+
+		/* find the number of free slots on the left side in first (tail) chunk, */
+		/* packed chunks have no free slots                                      */
+		if (NULL != item->tail && 0 == item->tail->packed_size)
+			nslots = item->tail->first_value;
+
+		if (0 == nslots)
+		{
+			nslots = vch_item_chunk_slot_count(item, count);
+
+			if (FAIL == vch_item_add_chunk(item, nslots, item->tail))
+				goto out;
+
+			item->tail->last_value = nslots - 1;
+			item->tail->first_value = nslots;
+		}
+
+		/* copy values to chunk */
+		copy_slots = MIN(nslots, count);
+		count -= copy_slots;
+
+		if (FAIL == vch_item_copy_values_at_tail(item, values + count, copy_slots))
+			goto out;
+	}
+
+	/* pack the chunks filled with the added values */
+	vch_item_pack_chunks(item, item->tail, tail);
+
+	if (0 != item->aggregates_num)
+		vch_item_invalidate_partial_aggregates(item);
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_db_range                                            *
+ *                                                                            *
+ * Purpose: finds the item values period that must be read from database to  *
+ *          cache values starting with the specified time                     *
+ *                                                                            *
+ * Parameters: item        - [IN] the item                                    *
+ *             range_start - [IN] the interval start time                     *
+ *             range_end   - [OUT] the interval end time                      *
+ *                                                                            *
+ * Return value:  SUCCEED - values in [range_start, range_end] interval must  *
+ *                          be read from database                             *
+ *                FAIL    - the requested interval is already cached          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_db_range(const zbx_vc_item_t *item, int range_start, int *range_end)
+{
+	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
+		return FAIL;
+
+	/* check if the requested period is in the cached range */
+	if (0 != item->db_cached_from && range_start >= item->db_cached_from)
+		return FAIL;
+
+	/* find if the cache should be updated to cover the required range */
+	if (NULL != item->tail)
+	{
+		/* we need to get item values before the first cached value, but not including it */
+		*range_end = vch_chunk_slots(item->tail)[item->tail->first_value].timestamp.sec - 1;
+	}
+	else
+		*range_end = ZBX_JAN_2038;
+
+	return range_start < *range_end ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_add_db_values                                           *
+ *                                                                            *
+ * Purpose: adds values read from database to the item cache                  *
+ *                                                                            *
+ * Parameters: item        - [IN] the item                                    *
+ *             records     - [IN] the values read from database, sorted by    *
+ *                                timestamp in ascending order                *
+ *             range_start - [IN] the interval start time                     *
+ *                                                                            *
+ * Return value:  >=0    - the number of values read from database            *
+ *                FAIL   - not enough space in cache                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_add_db_values(zbx_vc_item_t *item, const zbx_vector_history_record_t *records,
+		int range_start)
+{
+	int	ret = SUCCEED;
+
+	if (0 < records->values_num)
+		ret = vch_item_add_values_at_tail(item, records->values, records->values_num);
+
+	/* when updating cache with time based request we can always reset status flags */
+	/* flag even if the requested period contains no data                           */
+	item->status = 0;
+
+	if (SUCCEED == ret)
+	{
+		ret = records->values_num;
+		vc_item_update_db_cached_from(item, range_start);
+	}
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_cache_values_by_time                                    *
+ *                                                                            *
+ * Purpose: cache item history data for the specified time period             *
+ *                                                                            *
+ * Parameters: item        - [IN] the item                                    *
+ *             range_start - [IN] the interval start time                     *
+ *                                                                            *
+ * Return value:  >=0    - the number of values read from database            *
+ *                FAIL   - an error occurred while trying to cache values     *
+ *                                                                            *
+ * Comments: This function checks if the requested value range is cached and  *
+ *           updates cache from database if necessary.                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_cache_values_by_time(zbx_vc_item_t *item, int range_start)
+{
+	int				ret, range_end;
+	zbx_vector_history_record_t	records;
+
+	/* update cache if necessary */
+	if (SUCCEED != vch_item_get_db_range(item, range_start, &range_end))
+		return SUCCEED;
+
+	zbx_vector_history_record_create(&records);
+
+	vc_try_unlock();
+
+	if (SUCCEED == (ret = vc_db_read_values_by_time(item->itemid, item->value_type, &records, range_start,
+			range_end)))
+	{
+		zbx_vector_history_record_sort(&records, (zbx_compare_func_t)zbx_history_record_compare_asc_func);
+	}
+
+	vc_try_lock();
+
+	if (SUCCEED == ret)
+		ret = vch_item_add_db_values(item, &records, range_start);
+
+	zbx_history_record_vector_destroy(&records, item->value_type);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_cache_values_by_time_and_count                          *
+ *                                                                            *
+ * Purpose: cache the specified number of history data values for time period *
+ *          since timestamp                                                   *
+ *                                                                            *
+ * Parameters: item        - [IN] the item                                    *
+ *             range_start - [IN] the interval start time                     *
+ *             count       - [IN] the number of history values to retrieve    *
+ *             ts          - [IN] the target timestamp                        *
+ *                                                                            *
+ * Return value:  >=0    - the number of values read from database            *
+ *                FAIL   - an error occurred while trying to cache values     *
+ *                                                                            *
+ * Comments: This function checks if the requested number of values is cached *
+ *           and updates cache from database if necessary.                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t *item, int range_start, int count,
+		const zbx_timespec_t *ts)
+{
+	int	ret = SUCCEED, cached_records = 0, range_end;
+
+	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
+		return SUCCEED;
+
+	/* check if the requested period is in the cached range */
+	if (0 != item->db_cached_from && range_start >= item->db_cached_from)
+		return SUCCEED;
+
+	/* find if the cache should be updated to cover the required count */
+	if (NULL != item->head)
+	{
+		zbx_vc_chunk_t	*chunk;
+		int		index;
+
+		if (SUCCEED == vch_item_get_last_value(item, ts, &chunk, &index))
+		{
+			cached_records = index - chunk->first_value + 1;
+
+			while (NULL != (chunk = chunk->prev) && cached_records < count)
+				cached_records += chunk->last_value - chunk->first_value + 1;
+		}
+	}
+
+	/* update cache if necessary */
+	if (cached_records < count)
+	{
+		zbx_vector_history_record_t	records;
+
+		/* get the end timestamp to which (including) the values should be cached */
+		if (NULL != item->head)
+			range_end = vch_chunk_slots(item->tail)[item->tail->first_value].timestamp.sec - 1;
+		else
+			range_end = ZBX_JAN_2038;
+
+		vc_try_unlock();
+
+		zbx_vector_history_record_create(&records);
+
+		if (range_end > ts->sec)
+		{
+			ret = vc_db_read_values_by_time(item->itemid, item->value_type, &records, ts->sec + 1,
+					range_end);
+
+			range_end = ts->sec;
+		}
+
+		if (SUCCEED == ret && SUCCEED == (ret = vc_db_read_values_by_time_and_count(item->itemid,
+				item->value_type, &records, range_start, count - cached_records, range_end, ts)))
+		{
+			zbx_vector_history_record_sort(&records,
+					(zbx_compare_func_t)zbx_history_record_compare_asc_func);
+		}
+
+		vc_try_lock();
+
+		if (SUCCEED == ret)
+		{
+			if (0 < records.values_num)
+				ret = vch_item_add_values_at_tail(item, records.values, records.values_num);
+
+			if (SUCCEED == ret)
+			{
+				ret = records.values_num;
+				if ((count <= records.values_num || 0 == range_start) && 0 != records.values_num)
+				{
+					vc_item_update_db_cached_from(item,
+							vch_chunk_slots(item->tail)[item->tail->first_value].timestamp.sec);
+				}
+				else if (0 != range_start)
+					vc_item_update_db_cached_from(item, range_start);
+			}
+		}
+
+		zbx_history_record_vector_destroy(&records, item->value_type);
+	}
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_iterate_range                                           *
+ *                                                                            *
+ * Purpose: iterates cached item values in the specified range                *
+ *                                                                            *
+ * Parameters: item  - [IN] the item                                          *
+ *             start - [IN] the range start timestamp (exclusive)             *
+ *             end   - [IN] the range end timestamp (inclusive)               *
+ *             func  - [IN] the function to call for each value in the range, *
+ *                          starting with the newest value                    *
+ *             data  - [IN] the data passed to the callback function          *
+ *                                                                            *
+ * Return value: The number of values passed to the callback function.        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_iterate_range(zbx_vc_item_t *item, const zbx_timespec_t *start, const zbx_timespec_t *end,
+		zbx_vc_value_func_t func, void *data)
+{
+	int				index, values_num = 0;
+	zbx_vc_chunk_t			*chunk;
+	const zbx_history_record_t	*slots;
+
+	if (FAIL == vch_item_get_last_value(item, end, &chunk, &index))
+		return 0;
+
+	slots = vch_chunk_slots(chunk);
+
+	while (0 < zbx_timespec_compare(&slots[chunk->last_value].timestamp, start))
+	{
+		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, start))
+		{
+			func(&slots[index--], item->value_type, data);
+			values_num++;
+		}
+
+		if (NULL == (chunk = chunk->prev))
+			break;
+
+		index = chunk->last_value;
+		slots = vch_chunk_slots(chunk);
+	}
+
+	return values_num;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_values_by_time                                      *
+ *                                                                            *
+ * Purpose: iterates item history data in cache                               *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             seconds   - [IN] the time period to retrieve data for          *
+ *             ts        - [IN] the requested period end timestamp            *
+ *             func      - [IN] the function to call for each value in the    *
+ *                              period, starting with the newest value        *
+ *             data      - [IN] the data passed to the callback function      *
+ *                                                                            *
+ * Return value: The number of values passed to the callback function.        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_values_by_time(zbx_vc_item_t *item, int seconds, const zbx_timespec_t *ts,
+		zbx_vc_value_func_t func, void *data)
+{
+	int		now;
+	zbx_timespec_t	start = {ts->sec - seconds, ts->ns};
+
+	/* Check if maximum request range is not set and all data are cached.  */
+	/* Because that indicates there was a count based request with unknown */
+	/* range which might be greater than the current request range.        */
+	if (0 != item->active_range || ZBX_ITEM_STATUS_CACHED_ALL != item->status)
+	{
+		now = time(NULL);
+		/* add another second to include nanosecond shifts */
+		vch_item_update_range(item, seconds + now - ts->sec + 1, now);
+	}
+
+	/* pass item history values to callback until the start timestamp is reached */
+	return vch_item_iterate_range(item, &start, ts, func, data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_values_by_time_and_count                            *
+ *                                                                            *
+ * Purpose: iterates item history data in cache                               *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             seconds   - [IN] the time period                               *
+ *             count     - [IN] the number of history values to retrieve      *
+ *             timestamp - [IN] the target timestamp                          *
+ *             func      - [IN] the function to call for each value in the    *
+ *                              range, starting with the newest value         *
+ *             data      - [IN] the data passed to the callback function      *
+ *                                                                            *
+ * Return value: The number of values passed to the callback function.        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, int seconds, int count,
+		const zbx_timespec_t *ts, zbx_vc_value_func_t func, void *data)
+{
+	int				index, now, range_timestamp = 0, values_num = 0;
+	zbx_vc_chunk_t			*chunk;
+	zbx_timespec_t			start;
+	const zbx_history_record_t	*slots;
+
+	/* set start timestamp of the requested time period */
+	if (0 != seconds)
+	{
+		start.sec = ts->sec - seconds;
+		start.ns = ts->ns;
+	}
+	else
+	{
+		start.sec = 0;
+		start.ns = 0;
+	}
+
+	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
+	{
+		/* return empty vector with success */
+		goto out;
+	}
+
+	/* pass item history values to callback until the <count> values are read */
+	/* or no more values within specified time period                        */
+	slots = vch_chunk_slots(chunk);
+
+	while (0 < zbx_timespec_compare(&slots[chunk->last_value].timestamp, &start))
+	{
+		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&slots[index].timestamp, &start))
+		{
+			/* remember the oldest value timestamp to update the item range */
+			range_timestamp = slots[index].timestamp.sec - 1;
+
+			func(&slots[index--], item->value_type, data);
+
+			if (++values_num == count)
+				goto out;
+		}
+
+		if (NULL == (chunk = chunk->prev))
+			break;
+
+		index = chunk->last_value;
+		slots = vch_chunk_slots(chunk);
+	}
+out:
+	if (count > values_num)
+	{
+		if (0 == seconds)
+		{
+			/* not enough data in db to fulfill a count based request request */
+			item->active_range = 0;
+			item->daily_range = 0;
+			item->status = ZBX_ITEM_STATUS_CACHED_ALL;
+			return values_num;
+		}
+		/* not enough data in the requested period, set the range equal to the period plus */
+		/* one second to include nanosecond shifts                                         */
+		range_timestamp = ts->sec - seconds;
+	}
+
+	/* otherwise the requested number of values was retrieved and the range */
+	/* is set to the oldest value timestamp                                 */
+
+	now = time(NULL);
+	vch_item_update_range(item, now - range_timestamp, now);
+
+	return values_num;
+}
+
+/* the item snapshot check data, see vch_item_check_snapshot() */
+typedef struct
+{
+	/* the item values read from database, sorted by timestamps in descending order */
+	const zbx_vector_history_record_t	*records;
+
+	/* the index of database value to compare with the next cached value */
+	int					index;
+
+	/* set when a cached value does not match database value */
+	int					mismatch;
+}
+zbx_vc_snapshot_check_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_value_check_func                                              *
+ *                                                                            *
+ * Purpose: value iterator callback, compares cached value timestamp with     *
+ *          the next database value timestamp                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_value_check_func(const zbx_history_record_t *value, int value_type, void *data)
+{
+	zbx_vc_snapshot_check_t	*check = (zbx_vc_snapshot_check_t *)data;
+
+	ZBX_UNUSED(value_type);
+
+	if (check->index >= check->records->values_num ||
+			0 != zbx_timespec_compare(&value->timestamp, &check->records->values[check->index].timestamp))
+	{
+		check->mismatch = 1;
+	}
+
+	check->index++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_snapshot_bounds                                     *
+ *                                                                            *
+ * Purpose: gets timestamps of the oldest cached item value and of the newest *
+ *          cached item value saved in snapshot                               *
+ *                                                                            *
+ * Parameters: item - [IN] the item                                           *
+ *             ts   - [IN] the snapshot timestamp                             *
+ *             head - [OUT] the newest value timestamp not newer than the     *
+ *                          snapshot timestamp, zero if there is none         *
+ *             tail - [OUT] the oldest value timestamp, zero if there are no  *
+ *                          cached values                                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_get_snapshot_bounds(const zbx_vc_item_t *item, const zbx_timespec_t *ts, zbx_timespec_t *head,
+		zbx_timespec_t *tail)
+{
+	zbx_vc_chunk_t	*chunk;
+	int		index;
+
+	head->sec = head->ns = 0;
+	tail->sec = tail->ns = 0;
+
+	if (NULL == item->tail)
+		return;
+
+	*tail = vch_chunk_slots(item->tail)[item->tail->first_value].timestamp;
+
+	if (SUCCEED == vch_item_get_last_value(item, ts, &chunk, &index))
+		*head = vch_chunk_slots(chunk)[index].timestamp;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_db_check_value                                                *
+ *                                                                            *
+ * Purpose: checks if database has item value with the specified timestamp    *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item identifier                          *
+ *             value_type - [IN] the item value type                          *
+ *             ts         - [IN] the value timestamp, zero timestamp is not   *
+ *                               checked                                      *
+ *             found      - [OUT] 1 - the value was found, 0 - otherwise      *
+ *                                                                            *
+ * Return value:  SUCCEED - the values were read from database                *
+ *                FAIL    - failed to read item values from database          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_db_check_value(zbx_uint64_t itemid, int value_type, const zbx_timespec_t *ts, int *found)
+{
+	zbx_vector_history_record_t	records;
+	int				ret, i;
+
+	*found = 1;
+
+	if (0 == ts->sec)
+		return SUCCEED;
+
+	*found = 0;
+
+	zbx_vector_history_record_create(&records);
+
+	if (SUCCEED == (ret = vc_db_read_values_by_time(itemid, value_type, &records, ts->sec, ts->sec)))
+	{
+		for (i = 0; i < records.values_num; i++)
+		{
+			if (0 == zbx_timespec_compare(&records.values[i].timestamp, ts))
+			{
+				*found = 1;
+				break;
+			}
+		}
+	}
+
+	zbx_history_record_vector_destroy(&records, value_type);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_check_snapshot                                          *
+ *                                                                            *
+ * Purpose: checks if item values loaded from snapshot are up to date         *
+ *                                                                            *
+ * Parameters: item - [IN] the item                                           *
+ *                                                                            *
+ * Return value:  SUCCEED - the item was checked                              *
+ *                FAIL    - failed to read item values from database          *
+ *                                                                            *
+ * Comments: Values can be written to database by another server instance     *
+ *           after the snapshot was saved and before it was loaded, and the   *
+ *           old values can be removed by housekeeper. The item values in     *
+ *           this interval are read from database and compared with the       *
+ *           cached values by timestamps. The oldest cached value and the     *
+ *           newest cached value saved in snapshot must also be still present *
+ *           in database. If any of the checks fails, then the item cache is  *
+ *           reset and will be filled from database with the next request.    *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_check_snapshot(zbx_vc_item_t *item)
+{
+	zbx_vector_history_record_t	records;
+	zbx_timespec_t			start = {vc_snapshot_time - 1, VC_MAX_NANOSECONDS},
+					end = {vc_snapshot_load_time, VC_MAX_NANOSECONDS}, head, tail, head_db, tail_db;
+	zbx_vc_snapshot_check_t		check = {&records, 0, 0};
+	int				ret, head_found = 0, tail_found = 0;
+
+	zbx_vector_history_record_create(&records);
+
+	vch_item_get_snapshot_bounds(item, &start, &head_db, &tail_db);
+
+	vc_try_unlock();
+
+	if (SUCCEED == (ret = vc_db_read_values_by_time(item->itemid, item->value_type, &records, vc_snapshot_time,
+			vc_snapshot_load_time)) &&
+			SUCCEED == (ret = vc_db_check_value(item->itemid, item->value_type, &head_db, &head_found)))
+	{
+		ret = vc_db_check_value(item->itemid, item->value_type, &tail_db, &tail_found);
+	}
+
+	vc_try_lock();
+
+	if (SUCCEED == ret && 0 != item->snapshot)
+	{
+		zbx_vector_history_record_sort(&records, (zbx_compare_func_t)zbx_history_record_compare_desc_func);
+		vch_item_iterate_range(item, &start, &end, vc_value_check_func, &check);
+
+		/* the cache could have been changed while it was unlocked */
+		vch_item_get_snapshot_bounds(item, &start, &head, &tail);
+
+		if (0 != check.mismatch || check.index != records.values_num || 0 == head_found || 0 == tail_found ||
+				0 != zbx_timespec_compare(&head, &head_db) || 0 != zbx_timespec_compare(&tail, &tail_db))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "item " ZBX_FS_UI64 " values loaded from value cache snapshot"
+					" are outdated", item->itemid);
+
+			vch_item_free_cache(item);
+			item->status = 0;
+			item->db_cached_from = 0;
+		}
+
+		item->snapshot = 0;
+	}
+
+	zbx_history_record_vector_destroy(&records, item->value_type);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_value_range                                         *
+ *                                                                            *
+ * Purpose: iterate item values for the specified range                       *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             seconds   - [IN] the time period to retrieve data for          *
+ *             count     - [IN] the number of history values to retrieve      *
+ *             ts        - [IN] the target timestamp                          *
+ *             func      - [IN] the function to call for each value in the    *
+ *                              range, starting with the newest value         *
+ *             data      - [IN] the data passed to the callback function      *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: This function passes data from cache to the callback function,   *
+ *           if necessary updating cache from DB. If cache update was         *
+ *           required and failed (not enough memory to cache DB values), then *
+ *           this function fails without calling the callback function.       *
+ *                                                                            *
+ *           If <count> is set then value range is defined as <count> values  *
+ *           before <timestamp>. Otherwise the range is defined as <seconds>  *
+ *           seconds before <timestamp>.                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_values(zbx_vc_item_t *item, int seconds, int count, const zbx_timespec_t *ts,
+		zbx_vc_value_func_t func, void *data)
+{
+	int	ret, records_read, hits, misses, range_start, values_num;
+
+	if (0 != item->snapshot && FAIL == (ret = vch_item_check_snapshot(item)))
+		goto out;
+
+	if (0 == count)
+	{
+		if (0 > (range_start = ts->sec - seconds))
+			range_start = 0;
+
+		if (FAIL == (ret = vch_item_cache_values_by_time(item, range_start)))
+			goto out;
+
+		records_read = ret;
+
+		values_num = vch_item_get_values_by_time(item, seconds, ts, func, data);
+	}
+	else
+	{
+		range_start = (0 == seconds ? 0 : ts->sec - seconds);
+
+		if (FAIL == (ret = vch_item_cache_values_by_time_and_count(item, range_start, count, ts)))
+			goto out;
+
+		records_read = ret;
+
+		values_num = vch_item_get_values_by_time_and_count(item, seconds, count, ts, func, data);
+	}
+
+	if (records_read > values_num)
+		records_read = values_num;
+
+	hits = values_num - records_read;
+	misses = records_read;
+
+	vc_update_statistics(item, hits, misses);
+
+	ret = SUCCEED;
+out:
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_numeric_value_compare                                         *
+ *                                                                            *
+ * Purpose: compares two numeric history values                               *
+ *                                                                            *
+ * Parameters: value1     - [IN] the first value                              *
+ *             value2     - [IN] the second value                             *
+ *             value_type - [IN] the value type (float or unsigned)           *
+ *                                                                            *
+ * Return value: <0 - the first value is less than the second value           *
+ *                0 - the values are equal                                    *
+ *               >0 - the first value is greater than the second value        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_numeric_value_compare(const history_value_t *value1, const history_value_t *value2, int value_type)
+{
+	if (ITEM_VALUE_TYPE_UINT64 == value_type)
+	{
+		ZBX_RETURN_IF_NOT_EQUAL(value1->ui64, value2->ui64);
+	}
+	else
+	{
+		ZBX_RETURN_IF_NOT_EQUAL(value1->dbl, value2->dbl);
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_aggregate_is_dbl_sum                                          *
+ *                                                                            *
+ * Purpose: checks if the aggregate value is a double sum                     *
+ *                                                                            *
+ * Return value: SUCCEED - the aggregate value is a double sum                *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_aggregate_is_dbl_sum(const zbx_vc_aggregate_t *aggregate, int value_type)
+{
+	if (ZBX_VC_AGGREGATE_AVG == aggregate->func ||
+			(ZBX_VC_AGGREGATE_SUM == aggregate->func && ITEM_VALUE_TYPE_FLOAT == value_type))
+	{
+		return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_aggregate_add_dbl                                             *
+ *                                                                            *
+ * Purpose: adds value to the double sum of aggregate                         *
+ *                                                                            *
+ * Comments: The lost low order bits are accumulated in the compensation      *
+ *           (Neumaier summation), so values leaving the period do not cancel *
+ *           out the smaller values added together with them.                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_aggregate_add_dbl(zbx_vc_aggregate_t *aggregate, double value)
+{
+	double	sum;
+
+	sum = aggregate->value.dbl + value;
+
+	/* infinite or not a number sum cannot be compensated */
+	if (ZBX_INFINITY > fabs(sum))
+	{
+		if (fabs(aggregate->value.dbl) >= fabs(value))
+			aggregate->compensation += (aggregate->value.dbl - sum) + value;
+		else
+			aggregate->compensation += (value - sum) + aggregate->value.dbl;
+	}
+
+	aggregate->value.dbl = sum;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_aggregate_get_value                                           *
+ *                                                                            *
+ * Purpose: gets the aggregated value with compensated double sum             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_aggregate_get_value(const zbx_vc_aggregate_t *aggregate, int value_type, history_value_t *value)
+{
+	*value = aggregate->value;
+
+	if (SUCCEED == vc_aggregate_is_dbl_sum(aggregate, value_type))
+		value->dbl += aggregate->compensation;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_aggregate_add                                                 *
+ *                                                                            *
+ * Purpose: value iterator callback, adds value to the aggregate              *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_aggregate_add(const zbx_history_record_t *value, int value_type, void *data)
+{
+	zbx_vc_aggregate_t	*aggregate = (zbx_vc_aggregate_t *)data;
+
+	switch (aggregate->func)
+	{
+		case ZBX_VC_AGGREGATE_SUM:
+			if (ITEM_VALUE_TYPE_FLOAT == value_type)
+				vc_aggregate_add_dbl(aggregate, value->value.dbl);
+			else
+				aggregate->value.ui64 += value->value.ui64;
+			break;
+		case ZBX_VC_AGGREGATE_AVG:
+			if (ITEM_VALUE_TYPE_FLOAT == value_type)
+				vc_aggregate_add_dbl(aggregate, value->value.dbl);
+			else
+				vc_aggregate_add_dbl(aggregate, (double)value->value.ui64);
+			break;
+		case ZBX_VC_AGGREGATE_MIN:
+			if (0 == aggregate->values_num ||
+					0 > vc_numeric_value_compare(&value->value, &aggregate->value, value_type))
+			{
+				aggregate->value = value->value;
+			}
+			break;
+		case ZBX_VC_AGGREGATE_MAX:
+			if (0 == aggregate->values_num ||
+					0 < vc_numeric_value_compare(&value->value, &aggregate->value, value_type))
+			{
+				aggregate->value = value->value;
+			}
+			break;
+	}
+
+	aggregate->values_num++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_aggregate_remove                                              *
+ *                                                                            *
+ * Purpose: value iterator callback, removes value from the aggregate         *
+ *                                                                            *
+ * Comments: Removing the minimum/maximum value sets the rescan flag as the   *
+ *           new minimum/maximum can be found only by checking all values.    *
+ *           Removing a value much larger than the remaining double sum also  *
+ *           sets the rescan flag, as most of the sum precision is lost.      *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_aggregate_remove(const zbx_history_record_t *value, int value_type, void *data)
+{
+	zbx_vc_aggregate_t	*aggregate = (zbx_vc_aggregate_t *)data;
+	double			value_dbl;
+
+	switch (aggregate->func)
+	{
+		case ZBX_VC_AGGREGATE_SUM:
+			if (ITEM_VALUE_TYPE_UINT64 == value_type)
+			{
+				aggregate->value.ui64 -= value->value.ui64;
+				break;
+			}
+			ZBX_FALLTHROUGH;
+		case ZBX_VC_AGGREGATE_AVG:
+			if (ITEM_VALUE_TYPE_FLOAT == value_type)
+				value_dbl = value->value.dbl;
+			else
+				value_dbl = (double)value->value.ui64;
+
+			vc_aggregate_add_dbl(aggregate, -value_dbl);
+
+			if (fabs(value_dbl) > ZBX_VC_AGGREGATE_CANCEL_RATIO *
+					fabs(aggregate->value.dbl + aggregate->compensation))
+			{
+				aggregate->rescan = 1;
+			}
+			break;
+		case ZBX_VC_AGGREGATE_MIN:
+		case ZBX_VC_AGGREGATE_MAX:
+			if (0 == vc_numeric_value_compare(&value->value, &aggregate->value, value_type))
+				aggregate->rescan = 1;
+			break;
+	}
+
+	aggregate->values_num--;
+	aggregate->values_removed++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_aggregate_init                                                *
+ *                                                                            *
+ * Purpose: value iterator callback, adds value to the aggregate being        *
+ *          calculated from scratch                                           *
+ *                                                                            *
+ * Comments: The values are iterated starting with the newest value, so the   *
+ *           aggregate start timestamp is set to the oldest value timestamp.  *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_aggregate_init(const zbx_history_record_t *value, int value_type, void *data)
+{
+	zbx_vc_aggregate_t	*aggregate = (zbx_vc_aggregate_t *)data;
+
+	vc_aggregate_add(value, value_type, data);
+	aggregate->from = value->timestamp;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_find_aggregate                                          *
+ *                                                                            *
+ * Purpose: finds item aggregate by function and period                       *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *             func    - [IN] the aggregate function (ZBX_VC_AGGREGATE_*)     *
+ *             seconds - [IN] the period length in seconds                    *
+ *             count   - [IN] the period length in number of values           *
+ *                                                                            *
+ * Return value: the aggregate or NULL if it was not found                    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_vc_aggregate_t	*vch_item_find_aggregate(zbx_vc_item_t *item, int func, int seconds, int count)
+{
+	int	i;
+
+	for (i = 0; i < item->aggregates_num; i++)
+	{
+		zbx_vc_aggregate_t	*aggregate = &item->aggregates[i];
+
+		if (aggregate->func == func && aggregate->seconds == seconds && aggregate->count == count)
+			return aggregate;
+	}
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_store_aggregate                                         *
+ *                                                                            *
+ * Purpose: stores aggregate in item, replacing the least recently used       *
+ *          aggregate if necessary                                            *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             aggregate - [IN] the aggregate to store                        *
+ *                                                                            *
+ * Comments: The aggregate is not stored if there is not enough space in      *
+ *           cache.                                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_store_aggregate(zbx_vc_item_t *item, const zbx_vc_aggregate_t *aggregate)
+{
+	zbx_vc_aggregate_t	*slot;
+	int			i;
+
+	if (NULL == (slot = vch_item_find_aggregate(item, aggregate->func, aggregate->seconds, aggregate->count)))
+	{
+		if (NULL == item->aggregates)
+		{
+			if (NULL == (item->aggregates = (zbx_vc_aggregate_t *)vc_item_malloc(item,
+					sizeof(zbx_vc_aggregate_t) * ZBX_VC_ITEM_AGGREGATES_MAX)))
+			{
+				return;
+			}
+
+			item->aggregates_num = 0;
+		}
+
+		if (ZBX_VC_ITEM_AGGREGATES_MAX == item->aggregates_num)
+		{
+			slot = &item->aggregates[0];
+
+			for (i = 1; i < item->aggregates_num; i++)
+			{
+				if (item->aggregates[i].last_accessed < slot->last_accessed)
+					slot = &item->aggregates[i];
+			}
+		}
+		else
+			slot = &item->aggregates[item->aggregates_num++];
+	}
+
+	*slot = *aggregate;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_remove_aggregate                                        *
+ *                                                                            *
+ * Purpose: removes item aggregate                                            *
+ *                                                                            *
+ * Parameters: item  - [IN] the item                                          *
+ *             index - [IN] the index of aggregate to remove                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_remove_aggregate(zbx_vc_item_t *item, int index)
+{
+	if (index != --item->aggregates_num)
+		item->aggregates[index] = item->aggregates[item->aggregates_num];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_invalidate_aggregates                                   *
+ *                                                                            *
+ * Purpose: removes item aggregates affected by a value added to cache        *
+ *                                                                            *
+ * Parameters: item - [IN] the item                                           *
+ *             ts   - [IN] the added value timestamp                          *
+ *                                                                            *
+ * Comments: A value added inside aggregated period can't be accounted in     *
+ *           aggregate when it slides further, so such aggregates are removed *
+ *           and calculated from scratch when requested next time.            *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_invalidate_aggregates(zbx_vc_item_t *item, const zbx_timespec_t *ts)
+{
+	int	i;
+
+	for (i = 0; i < item->aggregates_num; i++)
+	{
+		if (0 <= zbx_timespec_compare(&item->aggregates[i].to, ts))
+			vch_item_remove_aggregate(item, i--);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_invalidate_partial_aggregates                           *
+ *                                                                            *
+ * Purpose: removes count based item aggregates having less values than the   *
+ *          requested count                                                   *
+ *                                                                            *
+ * Parameters: item - [IN] the item                                           *
+ *                                                                            *
+ * Comments: Such aggregates are valid only while all item values are cached  *
+ *           and must be removed when older values are added to cache.        *
+ *                                                                            *
+ ******************************************************************************/
+static void	vch_item_invalidate_partial_aggregates(zbx_vc_item_t *item)
+{
+	int	i;
+
+	for (i = 0; i < item->aggregates_num; i++)
+	{
+		if (0 != item->aggregates[i].count && item->aggregates[i].values_num < item->aggregates[i].count)
+			vch_item_remove_aggregate(item, i--);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_remove_oldest_values                                    *
+ *                                                                            *
+ * Purpose: removes the oldest values from count based aggregate              *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             aggregate - [IN/OUT] the aggregate                             *
+ *             num       - [IN] the number of values to remove                *
+ *                                                                            *
+ * Return value: SUCCEED - the values were removed                            *
+ *               FAIL    - the oldest aggregated value cannot be located in   *
+ *                         cache                                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_remove_oldest_values(zbx_vc_item_t *item, zbx_vc_aggregate_t *aggregate, int num)
+{
+	zbx_vc_chunk_t			*chunk;
+	int				index;
+	const zbx_history_record_t	*slots;
+
+	if (FAIL == vch_item_get_last_value(item, &aggregate->from, &chunk, &index))
+		return FAIL;
+
+	/* the oldest value is identified by its timestamp, so it must be unique */
+	if (index > chunk->first_value)
+	{
+		if (0 == zbx_timespec_compare(&vch_chunk_slots(chunk)[index - 1].timestamp, &aggregate->from))
+			return FAIL;
+	}
+	else if (NULL != chunk->prev)
+	{
+		if (0 == zbx_timespec_compare(&vch_chunk_slots(chunk->prev)[chunk->prev->last_value].timestamp,
+				&aggregate->from))
+		{
+			return FAIL;
+		}
+	}
+
+	slots = vch_chunk_slots(chunk);
+
+	if (0 != zbx_timespec_compare(&slots[index].timestamp, &aggregate->from))
+		return FAIL;
+
+	while (0 != num--)
+	{
+		vc_aggregate_remove(&slots[index], item->value_type, aggregate);
+
+		if (++index > chunk->last_value)
+		{
+			if (NULL == (chunk = chunk->next))
+				return FAIL;
+
+			index = chunk->first_value;
+			slots = vch_chunk_slots(chunk);
+		}
+	}
+
+	aggregate->from = slots[index].timestamp;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_update_aggregate                                        *
+ *                                                                            *
+ * Purpose: slides aggregate period to the specified end timestamp            *
+ *                                                                            *
+ * Parameters: item      - [IN] the item                                      *
+ *             aggregate - [IN/OUT] the aggregate                             *
+ *             ts        - [IN] the new period end timestamp                  *
+ *             now       - [IN] the current timestamp                         *
+ *                                                                            *
+ * Return value: SUCCEED - the aggregate was updated                          *
+ *               FAIL    - the aggregate cannot be updated incrementally and  *
+ *                         must be calculated from scratch                    *
+ *                                                                            *
+ * Comments: Only the values leaving and entering the period are iterated.    *
+ *           The aggregate can be updated only if the period is moved         *
+ *           forward and all values leaving the period are still cached.      *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_update_aggregate(zbx_vc_item_t *item, zbx_vc_aggregate_t *aggregate, const zbx_timespec_t *ts,
+		int now)
+{
+	if (0 != aggregate->rescan || 0 > zbx_timespec_compare(ts, &aggregate->to))
+		return FAIL;
+
+	if (0 != aggregate->seconds)
+	{
+		zbx_timespec_t	from = {ts->sec - aggregate->seconds, ts->ns};
+
+		if (ZBX_ITEM_STATUS_CACHED_ALL != item->status &&
+				(0 == item->db_cached_from || aggregate->from.sec < item->db_cached_from))
+		{
+			return FAIL;
+		}
+
+		/* recalculating aggregate is cheaper if the periods do not overlap */
+		if (0 > zbx_timespec_compare(&from, &aggregate->from) || 0 <= zbx_timespec_compare(&from, &aggregate->to))
+			return FAIL;
+
+		vch_item_iterate_range(item, &aggregate->from, &from, vc_aggregate_remove, aggregate);
+		vch_item_iterate_range(item, &aggregate->to, ts, vc_aggregate_add, aggregate);
+		aggregate->from = from;
+
+		/* update item range in the same way as time based request would do */
+		if (0 != item->active_range || ZBX_ITEM_STATUS_CACHED_ALL != item->status)
+			vch_item_update_range(item, aggregate->seconds + now - ts->sec + 1, now);
+	}
+	else
+	{
+		/* less than requested values are aggregated only if all values are cached */
+		if (aggregate->values_num < aggregate->count && ZBX_ITEM_STATUS_CACHED_ALL != item->status)
+			return FAIL;
+
+		vch_item_iterate_range(item, &aggregate->to, ts, vc_aggregate_add, aggregate);
+
+		if (aggregate->values_num > aggregate->count && FAIL == vch_item_remove_oldest_values(item, aggregate,
+				aggregate->values_num - aggregate->count))
+		{
+			return FAIL;
+		}
+
+		/* update item range in the same way as count based request would do */
+		if (aggregate->values_num < aggregate->count)
+		{
+			item->active_range = 0;
+			item->daily_range = 0;
+		}
+		else if (0 != aggregate->values_num)
+			vch_item_update_range(item, now - aggregate->from.sec + 1, now);
+	}
+
+	if (0 != aggregate->rescan)
+		return FAIL;
+
+	/* recalculate sums from scratch after all values have been replaced to limit rounding errors */
+	if (SUCCEED == vc_aggregate_is_dbl_sum(aggregate, item->value_type) &&
+			aggregate->values_removed > aggregate->values_num)
+	{
+		return FAIL;
+	}
+
+	aggregate->to = *ts;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_get_aggregate                                           *
+ *                                                                            *
+ * Purpose: gets aggregate of item values in the specified period             *
+ *                                                                            *
+ * Parameters: item       - [IN] the item                                     *
+ *             func       - [IN] the aggregate function (ZBX_VC_AGGREGATE_*)  *
+ *             seconds    - [IN] the period length in seconds                 *
+ *             count      - [IN] the period length in number of values        *
+ *             ts         - [IN] the period end timestamp                     *
+ *             value      - [OUT] the aggregated value                        *
+ *             values_num - [OUT] the number of aggregated values             *
+ *                                                                            *
+ * Return value:  SUCCEED - the aggregate was calculated successfully         *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: The stored aggregate is updated incrementally if possible,       *
+ *           otherwise it's calculated from the item history data, updating   *
+ *           cache from DB if necessary.                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	vch_item_get_aggregate(zbx_vc_item_t *item, int func, int seconds, int count, const zbx_timespec_t *ts,
+		history_value_t *value, int *values_num)
+{
+	zbx_vc_aggregate_t	*aggregate, local;
+	int			now;
+
+	now = time(NULL);
+
+	if (NULL != (aggregate = vch_item_find_aggregate(item, func, seconds, count)))
+	{
+		aggregate->last_accessed = now;
+
+		if (SUCCEED == vch_item_update_aggregate(item, aggregate, ts, now))
+		{
+			vc_aggregate_get_value(aggregate, item->value_type, value);
+			*values_num = aggregate->values_num;
+
+			vc_update_statistics(item, aggregate->values_num, 0);
+
+			return SUCCEED;
+		}
+	}
+
+	memset(&local, 0, sizeof(local));
+	local.func = func;
+	local.seconds = seconds;
+	local.count = count;
+
+	if (FAIL == vch_item_get_values(item, seconds, count, ts, vc_aggregate_init, &local))
+		return FAIL;
+
+	if (0 != seconds)
+	{
+		local.from.sec = ts->sec - seconds;
+		local.from.ns = ts->ns;
+	}
+
+	local.to = *ts;
+	local.last_accessed = now;
+
+	/* cache might have been unlocked while reading values from database, so the */
+	/* item aggregates must be searched again when storing the new aggregate     */
+	if (0 != seconds || 0 != local.values_num)
+		vch_item_store_aggregate(item, &local);
+
+	vc_aggregate_get_value(&local, item->value_type, value);
+	*values_num = local.values_num;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vch_item_free_cache                                              *
+ *                                                                            *
+ * Purpose: frees resources allocated for item history data                   *
+ *                                                                            *
+ * Parameters: item    - [IN] the item                                        *
+ *                                                                            *
+ * Return value: the size of freed memory (bytes)                             *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	vch_item_free_cache(zbx_vc_item_t *item)
+{
+	size_t	freed = 0;
+
+	zbx_vc_chunk_t	*chunk = item->tail;
+
+	while (NULL != chunk)
+	{
+		zbx_vc_chunk_t	*next = chunk->next;
+
+		freed += vch_item_free_chunk(item, chunk);
+		chunk = next;
+	}
+	item->values_total = 0;
+	item->head = NULL;
+	item->tail = NULL;
+
+	if (NULL != item->aggregates)
+	{
+		__vc_mem_free_func(item->aggregates);
+		freed += sizeof(zbx_vc_aggregate_t) * ZBX_VC_ITEM_AGGREGATES_MAX;
+
+		item->aggregates = NULL;
+		item->aggregates_num = 0;
+	}
+
+	return freed;
+}
+
+/******************************************************************************************************************
+ *                                                                                                                *
+ * Public API                                                                                                     *
+ *                                                                                                                *
+ ******************************************************************************************************************/
+
+/******************************************************************************************************************
+ *                                                                                                                *
+ * Value cache snapshot                                                                                           *
+ *                                                                                                                *
+ ******************************************************************************************************************/
+/*
+ * The value cache snapshot is saved on server shutdown and loaded when value cache is
+ * initialized, so the item history data does not need to be read from database again
+ * after restart. The snapshot file has the following format:
+ *   <header><item 1><item 1 values>...<item N><item N values><terminator>
+ * where header (zbx_vc_snapshot_header_t) contains the file signature, format version
+ * and the snapshot creation time, item (zbx_vc_snapshot_item_t) contains item properties
+ * followed by the item values in ascending order and terminator is an item with zero
+ * itemid. Each value is stored as a timestamp followed by value type specific data,
+ * strings are stored as length followed by string contents.
+ * The snapshot is written and read by the same server binary, so the data is stored in
+ * the native byte order.
+ */
+
+#define ZBX_VC_SNAPSHOT_SIGNATURE	0x5a425643
+#define ZBX_VC_SNAPSHOT_VERSION		1
+
+/* the string length used to store NULL strings */
+#define ZBX_VC_SNAPSHOT_NULL_STR	0xffffffff
+
+/* the maximum string length accepted when loading snapshot */
+#define ZBX_VC_SNAPSHOT_MAX_STR_LEN	(16 * ZBX_MEBIBYTE)
+
+typedef struct
+{
+	zbx_uint32_t	signature;
+	zbx_uint32_t	version;
+	int		time;
+}
+zbx_vc_snapshot_header_t;
+
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	int		value_type;
+	int		status;
+	int		active_range;
+	int		daily_range;
+	int		db_cached_from;
+	int		values_num;
+}
+zbx_vc_snapshot_item_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_write                                                *
+ *                                                                            *
+ * Purpose: writes data to snapshot file                                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_write(FILE *file, const void *data, size_t size)
+{
+	return 1 == fwrite(data, size, 1, file) ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_write_str                                            *
+ *                                                                            *
+ * Purpose: writes string to snapshot file                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_write_str(FILE *file, const char *str)
+{
+	zbx_uint32_t	len;
+
+	len = (NULL == str ? ZBX_VC_SNAPSHOT_NULL_STR : (zbx_uint32_t)strlen(str));
+
+	if (SUCCEED != vc_snapshot_write(file, &len, sizeof(len)))
+		return FAIL;
+
+	if (NULL == str || 0 == len)
+		return SUCCEED;
+
+	return vc_snapshot_write(file, str, len);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_write_value                                          *
+ *                                                                            *
+ * Purpose: writes history value to snapshot file                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_write_value(FILE *file, const zbx_history_record_t *value, int value_type)
+{
+	const zbx_log_value_t	*log;
+
+	if (SUCCEED != vc_snapshot_write(file, &value->timestamp, sizeof(value->timestamp)))
+		return FAIL;
+
+	switch (value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			return vc_snapshot_write(file, &value->value.dbl, sizeof(value->value.dbl));
+		case ITEM_VALUE_TYPE_UINT64:
+			return vc_snapshot_write(file, &value->value.ui64, sizeof(value->value.ui64));
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			return vc_snapshot_write_str(file, value->value.str);
+		case ITEM_VALUE_TYPE_LOG:
+			log = value->value.log;
+
+			if (SUCCEED != vc_snapshot_write_str(file, log->value) ||
+					SUCCEED != vc_snapshot_write_str(file, log->source) ||
+					SUCCEED != vc_snapshot_write(file, &log->timestamp, sizeof(log->timestamp)) ||
+					SUCCEED != vc_snapshot_write(file, &log->logeventid, sizeof(log->logeventid)) ||
+					SUCCEED != vc_snapshot_write(file, &log->severity, sizeof(log->severity)))
+			{
+				return FAIL;
+			}
+
+			return SUCCEED;
+	}
+
+	THIS_SHOULD_NEVER_HAPPEN;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_write_item                                           *
+ *                                                                            *
+ * Purpose: writes item and its cached values to snapshot file                *
+ *                                                                            *
+ * Parameters: file   - [IN] the snapshot file                                *
+ *             item   - [IN] the item                                         *
+ *                                                                            *
+ * Return value: SUCCEED - the item was written successfully                  *
+ *               FAIL    - a write error occurred                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_write_item(FILE *file, const zbx_vc_item_t *item)
+{
+	zbx_vc_snapshot_item_t		sitem;
+	const zbx_vc_chunk_t		*chunk;
+	const zbx_history_record_t	*slots;
+	int				i;
+
+	sitem.itemid = item->itemid;
+	sitem.value_type = item->value_type;
+	sitem.status = item->status;
+	sitem.active_range = item->active_range;
+	sitem.daily_range = item->daily_range;
+	sitem.db_cached_from = item->db_cached_from;
+	sitem.values_num = 0;
+
+	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
+		sitem.values_num += chunk->last_value - chunk->first_value + 1;
+
+	if (SUCCEED != vc_snapshot_write(file, &sitem, sizeof(sitem)))
+		return FAIL;
+
+	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
+	{
+		slots = vch_chunk_slots(chunk);
+
+		for (i = chunk->first_value; i <= chunk->last_value; i++)
+		{
+			if (SUCCEED != vc_snapshot_write_value(file, &slots[i], item->value_type))
+				return FAIL;
+		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_read                                                 *
+ *                                                                            *
+ * Purpose: reads data from snapshot file                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_read(FILE *file, void *data, size_t size)
+{
+	return 1 == fread(data, size, 1, file) ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_read_str                                             *
+ *                                                                            *
+ * Purpose: reads string from snapshot file                                   *
+ *                                                                            *
+ * Comments: The returned string must be freed by the caller.                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_read_str(FILE *file, char **str)
+{
+	zbx_uint32_t	len;
+
+	*str = NULL;
+
+	if (SUCCEED != vc_snapshot_read(file, &len, sizeof(len)))
+		return FAIL;
+
+	if (ZBX_VC_SNAPSHOT_NULL_STR == len)
+		return SUCCEED;
+
+	if (ZBX_VC_SNAPSHOT_MAX_STR_LEN < len)
+		return FAIL;
+
+	*str = (char *)zbx_malloc(NULL, len + 1);
+	(*str)[len] = '\0';
+
+	if (0 != len && SUCCEED != vc_snapshot_read(file, *str, len))
+	{
+		zbx_free(*str);
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_read_value                                           *
+ *                                                                            *
+ * Purpose: reads history value from snapshot file                            *
+ *                                                                            *
+ * Comments: The value data is allocated and must be freed by the caller even *
+ *           if reading failed.                                               *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_read_value(FILE *file, zbx_history_record_t *value, int value_type)
+{
+	zbx_log_value_t	*log;
+
+	memset(value, 0, sizeof(zbx_history_record_t));
+
+	if (SUCCEED != vc_snapshot_read(file, &value->timestamp, sizeof(value->timestamp)))
+		return FAIL;
+
+	switch (value_type)
+	{
+		case ITEM_VALUE_TYPE_FLOAT:
+			return vc_snapshot_read(file, &value->value.dbl, sizeof(value->value.dbl));
+		case ITEM_VALUE_TYPE_UINT64:
+			return vc_snapshot_read(file, &value->value.ui64, sizeof(value->value.ui64));
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			if (SUCCEED != vc_snapshot_read_str(file, &value->value.str))
+				return FAIL;
+
+			if (NULL == value->value.str)
+				value->value.str = zbx_strdup(NULL, "");
+
+			return SUCCEED;
+		case ITEM_VALUE_TYPE_LOG:
+			log = value->value.log = (zbx_log_value_t *)zbx_malloc(NULL, sizeof(zbx_log_value_t));
+			memset(log, 0, sizeof(zbx_log_value_t));
+
+			if (SUCCEED != vc_snapshot_read_str(file, &log->value) ||
+					SUCCEED != vc_snapshot_read_str(file, &log->source) ||
+					SUCCEED != vc_snapshot_read(file, &log->timestamp, sizeof(log->timestamp)) ||
+					SUCCEED != vc_snapshot_read(file, &log->logeventid, sizeof(log->logeventid)) ||
+					SUCCEED != vc_snapshot_read(file, &log->severity, sizeof(log->severity)))
+			{
+				return FAIL;
+			}
+
+			if (NULL == log->value)
+				log->value = zbx_strdup(NULL, "");
+
+			return SUCCEED;
+	}
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_read_values                                          *
+ *                                                                            *
+ * Purpose: reads item values from snapshot file                              *
+ *                                                                            *
+ * Parameters: file   - [IN] the snapshot file                                *
+ *             sitem  - [IN] the snapshot item                                *
+ *             values - [OUT] the item values                                 *
+ *                                                                            *
+ * Return value: SUCCEED - the values were read successfully                  *
+ *               FAIL    - the snapshot file is truncated or corrupted        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_read_values(FILE *file, const zbx_vc_snapshot_item_t *sitem,
+		zbx_vector_history_record_t *values)
+{
+	zbx_history_record_t	value;
+	int			i, ret;
+
+	for (i = 0; i < sitem->values_num; i++)
+	{
+		ret = vc_snapshot_read_value(file, &value, sitem->value_type);
+		zbx_vector_history_record_append_ptr(values, &value);
+
+		if (SUCCEED != ret)
+			return FAIL;
+
+		/* the values are stored in ascending order */
+		if (0 != i && 0 < zbx_timespec_compare(&values->values[i - 1].timestamp, &value.timestamp))
+			return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_load_item                                            *
+ *                                                                            *
+ * Purpose: adds item loaded from snapshot to cache                           *
+ *                                                                            *
+ * Parameters: sitem  - [IN] the snapshot item                                *
+ *             values - [IN] the item values                                  *
+ *             now    - [IN] the current time                                 *
+ *                                                                            *
+ * Return value: SUCCEED - the item was added to cache                        *
+ *               FAIL    - not enough space in cache                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vc_snapshot_load_item(const zbx_vc_snapshot_item_t *sitem, const zbx_vector_history_record_t *values,
+		int now)
+{
+	zbx_vc_item_t	*item;
+	size_t		size;
+	int		i, ret;
+
+	vc_select_item_shard(sitem->itemid);
+
+	if (NULL != zbx_hashset_search(&vc_cache->items, &sitem->itemid))
+		return SUCCEED;
+
+	size = values->values_num * sizeof(zbx_history_record_t) + sizeof(zbx_vc_item_t);
+
+	switch (sitem->value_type)
+	{
+		case ITEM_VALUE_TYPE_STR:
+		case ITEM_VALUE_TYPE_TEXT:
+			for (i = 0; i < values->values_num; i++)
+				size += strlen(values->values[i].value.str) + 1;
+			break;
+		case ITEM_VALUE_TYPE_LOG:
+			for (i = 0; i < values->values_num; i++)
+				size += sizeof(zbx_log_value_t) + strlen(values->values[i].value.log->value) + 1;
+			break;
+	}
+
+	/* don't let loaded items push cache into low memory mode, leave space for new items */
+	if (vc_mem->free_size < size + vc_cache->min_free_request * 2)
+		return FAIL;
+
+	if (NULL == (item = vc_add_item(sitem->itemid, sitem->value_type)))
+		return FAIL;
+
+	/* protect the item from being removed if cache space must be released */
+	vc_item_addref(item);
+	ret = vch_item_add_values_at_tail(item, values->values, values->values_num);
+	item->refcount--;
+
+	if (SUCCEED != ret)
+	{
+		vc_remove_item(item);
+		return FAIL;
+	}
+
+	item->status = (unsigned char)sitem->status;
+	item->active_range = sitem->active_range;
+	item->daily_range = sitem->daily_range;
+	item->db_cached_from = sitem->db_cached_from;
+	item->range_sync_hour = (now / SEC_PER_HOUR) & 0xff;
+	item->last_accessed = now;
+	item->snapshot = 1;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vc_snapshot_load                                                 *
+ *                                                                            *
+ * Purpose: loads value cache snapshot                                        *
+ *                                                                            *
+ * Parameters: filename - [IN] the snapshot file name                         *
+ *                                                                            *
+ * Comments: The snapshot file is removed after loading, so an outdated       *
+ *           snapshot is not loaded after server crash.                       *
+ *           Loaded items are checked for values written to database after    *
+ *           the snapshot was created on the first access, see                *
+ *           vch_item_check_snapshot() function.                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	vc_snapshot_load(const char *filename)
+{
+	FILE				*file;
+	zbx_vc_snapshot_header_t	header;
+	zbx_vc_snapshot_item_t		sitem;
+	zbx_vector_history_record_t	values;
+	int				now, value_type = ITEM_VALUE_TYPE_FLOAT, items_num = 0, items_skipped = 0,
+					values_num = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() filename:'%s'", __func__, filename);
+
+	if (NULL == (file = fopen(filename, "rb")))
+	{
+		if (ENOENT != errno)
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot open value cache snapshot file \"%s\": %s", filename,
+					zbx_strerror(errno));
+		}
+
+		goto out;
+	}
+
+	now = time(NULL);
+
+	if (SUCCEED != vc_snapshot_read(file, &header, sizeof(header)) ||
+			ZBX_VC_SNAPSHOT_SIGNATURE != header.signature || ZBX_VC_SNAPSHOT_VERSION != header.version)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "value cache snapshot file \"%s\" has unsupported format", filename);
+		goto close;
+	}
+
+	if (header.time > now || header.time < now - ZBX_VC_ITEM_EXPIRE_PERIOD)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "value cache snapshot file \"%s\" is outdated", filename);
+		goto close;
+	}
+
+	vc_snapshot_time = header.time;
+	vc_snapshot_load_time = now;
+
+	zbx_history_record_vector_create(&values);
+
+	while (1)
+	{
+		if (SUCCEED != vc_snapshot_read(file, &sitem, sizeof(sitem)) || (0 != sitem.itemid &&
+				(0 > sitem.value_type || ITEM_VALUE_TYPE_MAX <= sitem.value_type ||
+				0 >= sitem.values_num)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "value cache snapshot file \"%s\" is corrupted", filename);
+			break;
+		}
+
+		if (0 == sitem.itemid)
+			break;
+
+		value_type = sitem.value_type;
+
+		if (SUCCEED != vc_snapshot_read_values(file, &sitem, &values))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "value cache snapshot file \"%s\" is corrupted", filename);
+			break;
 		}
-		while (0 < zbx_timespec_compare(&schunk->slots[sindex].timestamp, &value->timestamp));
-	}
-	else
-	{
-		/* find the number of free slots on the right side in last (head) chunk */
-		if (NULL != item->head)
-			nslots = item->head->slots_num - item->head->last_value - 1;
 
-		if (0 == nslots)
+		if (SUCCEED == vc_snapshot_load_item(&sitem, &values, now))
 		{
-			if (FAIL == vch_item_add_chunk(item, vch_item_chunk_slot_count(item, 1), NULL))
-				goto out;
+			items_num++;
+			values_num += values.values_num;
 		}
 		else
-			item->head->last_value++;
-
-		item->values_total++;
+			items_skipped++;
 
-		chunk = item->head;
-		index = item->head->last_value;
+		zbx_history_record_vector_clean(&values, value_type);
 	}
 
-	if (SUCCEED != vch_item_copy_value(item, chunk, index, value))
-		goto out;
+	zbx_history_record_vector_destroy(&values, value_type);
 
-	/* try to remove old (unused) chunks if a new chunk was added */
-	if (head != item->head)
-		item->state |= ZBX_ITEM_STATE_CLEAN_PENDING;
+	zabbix_log(LOG_LEVEL_INFORMATION, "loaded %d items with %d values from value cache snapshot, %d items"
+			" skipped because of insufficient cache size", items_num, values_num, items_skipped);
+close:
+	fclose(file);
 
-	ret = SUCCEED;
+	if (0 != unlink(filename))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot remove value cache snapshot file \"%s\": %s", filename,
+				zbx_strerror(errno));
+	}
 out:
-	return ret;
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_add_values_at_tail                                      *
- *                                                                            *
- * Purpose: adds item history values at the beginning of current item's       *
- *          history data                                                      *
+ * Function: vc_init_shard                                                    *
  *                                                                            *
- * Parameters:  item   - [IN] the item to add history data to                 *
- *              values - [IN] the item history data values                    *
- *              num    - [IN] the number of history data values to add        *
+ * Purpose: initializes value cache shard                                     *
  *                                                                            *
- * Return value: SUCCEED - the history data values were added successfully    *
- *               FAIL - failed to add history data values (not enough memory) *
+ * Parameters: shard - [OUT] the shard to initialize                          *
+ *             name  - [IN] the shard mutex name                              *
+ *             size  - [IN] the shard memory size                             *
+ *             error - [OUT] the error message                                *
  *                                                                            *
- * Comments: In the case of failure the item is removed from cache.           *
- *           Overlapping values (by timestamp seconds) are ignored.           *
+ * Return value: SUCCEED - the shard was initialized successfully             *
+ *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_add_values_at_tail(zbx_vc_item_t *item, const zbx_history_record_t *values, int values_num)
+static int	vc_init_shard(zbx_vc_shard_t *shard, zbx_mutex_name_t name, zbx_uint64_t size, char **error)
 {
-	int 	count = values_num, ret = FAIL;
+	zbx_vc_cache_t	*cache;
 
-	/* skip values already added to the item cache by another process */
-	if (NULL != item->tail)
-	{
-		int	sec = item->tail->slots[item->tail->first_value].timestamp.sec;
+	if (SUCCEED != zbx_mutex_create(&shard->lock, name, error))
+		return FAIL;
 
-		while (--count >= 0 && values[count].timestamp.sec >= sec)
-			;
-		++count;
-	}
+	if (SUCCEED != zbx_mem_create(&shard->mem, size, "value cache size", "ValueCacheSize", 1, error))
+		return FAIL;
 
-	while (0 != count)
+	/* the cache hashsets use memory of the selected shard */
+	vc_shard = shard;
+	vc_mem = shard->mem;
+
+	if (NULL == (cache = (zbx_vc_cache_t *)__vc_mem_malloc_func(NULL, sizeof(zbx_vc_cache_t))))
 	{
-		int	copy_slots, nslots = 0;
+		*error = zbx_strdup(*error, "cannot allocate value cache header");
+		return FAIL;
+	}
+	memset(cache, 0, sizeof(zbx_vc_cache_t));
 
-		/* find the number of free slots on the left side in first (tail) chunk */
-		if (NULL != item->tail)
-			nslots = item->tail->first_value;
+	zbx_hashset_create_ext(&cache->items, VC_ITEMS_INIT_SIZE,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+			__vc_mem_malloc_func, __vc_mem_realloc_func, __vc_mem_free_func);
 
-		if (0 == nslots)
-		{
-			nslots = vch_item_chunk_slot_count(item, count);
+	if (NULL == cache->items.slots)
+	{
+		*error = zbx_strdup(*error, "cannot allocate value cache data storage");
+		return FAIL;
+	}
 
-			if (FAIL == vch_item_add_chunk(item, nslots, item->tail))
-				goto out;
+	zbx_hashset_create_ext(&cache->strpool, VC_STRPOOL_INIT_SIZE,
+			vc_strpool_hash_func, vc_strpool_compare_func, NULL,
+			__vc_mem_malloc_func, __vc_mem_realloc_func, __vc_mem_free_func);
 
-			item->tail->last_value = nslots - 1;
-			item->tail->first_value = nslots;
-		}
+	if (NULL == cache->strpool.slots)
+	{
+		*error = zbx_strdup(*error, "cannot allocate string pool for value cache data storage");
+		return FAIL;
+	}
 
-		/* copy values to chunk */
-		copy_slots = MIN(nslots, count);
-		count -= copy_slots;
+	zbx_hashset_create_ext(&cache->ghosts, 0,
+			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
+			__vc_mem_malloc_func, __vc_mem_realloc_func, __vc_mem_free_func);
 
-		if (FAIL == vch_item_copy_values_at_tail(item, values + count, copy_slots))
-			goto out;
-	}
+	shard->cache = cache;
 
-	ret = SUCCEED;
-out:
-	return ret;
+	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_cache_values_by_time                                    *
- *                                                                            *
- * Purpose: cache item history data for the specified time period             *
- *                                                                            *
- * Parameters: item        - [IN] the item                                    *
- *             range_start - [IN] the interval start time                     *
+ * Function: zbx_vc_init                                                      *
  *                                                                            *
- * Return value:  >=0    - the number of values read from database            *
- *                FAIL   - an error occurred while trying to cache values     *
+ * Purpose: initializes value cache                                           *
  *                                                                            *
- * Comments: This function checks if the requested value range is cached and  *
- *           updates cache from database if necessary.                        *
+ * Comments: The cache is split into one shard per history syncer, limited by *
+ *           the number of value cache mutexes and the minimum shard size.    *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_cache_values_by_time(zbx_vc_item_t *item, int range_start)
+int	zbx_vc_init(char **error)
 {
-	int	ret = SUCCEED, range_end;
+	zbx_uint64_t	size_reserved, shard_size;
+	size_t		min_free_request;
+	int		i, shards_num, ret = FAIL;
 
-	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
+	if (0 == CONFIG_VALUE_CACHE_SIZE)
 		return SUCCEED;
 
-	/* check if the requested period is in the cached range */
-	if (0 != item->db_cached_from && range_start >= item->db_cached_from)
-		return SUCCEED;
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	/* find if the cache should be updated to cover the required range */
-	if (NULL != item->tail)
-	{
-		/* we need to get item values before the first cached value, but not including it */
-		range_end = item->tail->slots[item->tail->first_value].timestamp.sec - 1;
-	}
-	else
-		range_end = ZBX_JAN_2038;
+	shards_num = MIN(CONFIG_HISTSYNCER_FORKS, ZBX_MUTEX_VALUECACHE_NUM);
 
-	/* update cache if necessary */
-	if (range_start < range_end)
-	{
-		zbx_vector_history_record_t	records;
+	if ((zbx_uint64_t)shards_num > CONFIG_VALUE_CACHE_SIZE / ZBX_VC_SHARD_MIN_SIZE)
+		shards_num = (int)(CONFIG_VALUE_CACHE_SIZE / ZBX_VC_SHARD_MIN_SIZE);
 
-		zbx_vector_history_record_create(&records);
+	if (0 >= shards_num)
+		shards_num = 1;
 
-		vc_try_unlock();
+	shard_size = CONFIG_VALUE_CACHE_SIZE / shards_num;
+	size_reserved = zbx_mem_required_size(1, "value cache size", "ValueCacheSize");
+
+	/* the free space request should be 5% of shard size, but no more than 128KB */
+	min_free_request = ((shard_size - size_reserved) / 100) * 5;
+	if (min_free_request > 128 * ZBX_KIBIBYTE)
+		min_free_request = 128 * ZBX_KIBIBYTE;
 
-		if (SUCCEED == (ret = vc_db_read_values_by_time(item->itemid, item->value_type, &records,
-				range_start, range_end)))
+	for (i = 0; i < shards_num; i++)
+	{
+		if (SUCCEED != vc_init_shard(&vc_shards[i], (zbx_mutex_name_t)(ZBX_MUTEX_VALUECACHE + i), shard_size,
+				error))
 		{
-			zbx_vector_history_record_sort(&records,
-					(zbx_compare_func_t)zbx_history_record_compare_asc_func);
+			goto out;
 		}
 
-		vc_try_lock();
+		vc_shards[i].cache->min_free_request = min_free_request;
+	}
 
-		if (SUCCEED == ret)
-		{
-			if (0 < records.values_num)
-				ret = vch_item_add_values_at_tail(item, records.values, records.values_num);
+	CONFIG_VALUE_CACHE_SIZE -= size_reserved * shards_num;
 
-			/* when updating cache with time based request we can always reset status flags */
-			/* flag even if the requested period contains no data                           */
-			item->status = 0;
+	vc_shards_num = shards_num;
+	vc_select_shard(0);
 
-			if (SUCCEED == ret)
-			{
-				ret = records.values_num;
-				vc_item_update_db_cached_from(item, range_start);
-			}
+	zabbix_log(LOG_LEVEL_DEBUG, "value cache is split into %d shards of " ZBX_FS_UI64 " bytes", shards_num,
+			shard_size);
 
-		}
-		zbx_history_record_vector_destroy(&records, item->value_type);
-	}
+	if (NULL != CONFIG_VALUE_CACHE_FILE)
+		vc_snapshot_load(CONFIG_VALUE_CACHE_FILE);
+
+	ret = SUCCEED;
+out:
+	zbx_vc_disable();
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 
 	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_cache_values_by_time_and_count                          *
+ * Function: zbx_vc_destroy                                                   *
  *                                                                            *
- * Purpose: cache the specified number of history data values for time period *
- *          since timestamp                                                   *
+ * Purpose: destroys value cache                                              *
  *                                                                            *
- * Parameters: item        - [IN] the item                                    *
- *             range_start - [IN] the interval start time                     *
- *             count       - [IN] the number of history values to retrieve    *
- *             ts          - [IN] the target timestamp                        *
+ ******************************************************************************/
+void	zbx_vc_destroy(void)
+{
+	int	i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		vc_select_shard(i);
+
+		zbx_mutex_destroy(&vc_shard->lock);
+
+		zbx_hashset_destroy(&vc_cache->items);
+		zbx_hashset_destroy(&vc_cache->strpool);
+		zbx_hashset_destroy(&vc_cache->ghosts);
+
+		__vc_mem_free_func(vc_cache);
+		vc_shard->cache = NULL;
+	}
+
+	vc_shards_num = 0;
+	vc_shard = NULL;
+	vc_cache = NULL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
+/******************************************************************************
  *                                                                            *
- * Return value:  >=0    - the number of values read from database            *
- *                FAIL   - an error occurred while trying to cache values     *
+ * Function: zbx_vc_reset                                                     *
  *                                                                            *
- * Comments: This function checks if the requested number of values is cached *
- *           and updates cache from database if necessary.                    *
+ * Purpose: resets value cache                                                *
+ *                                                                            *
+ * Comments: All items and their historical data are removed,                 *
+ *           cache working mode, statistics reset.                            *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_cache_values_by_time_and_count(zbx_vc_item_t *item, int range_start, int count,
-		const zbx_timespec_t *ts)
+void	zbx_vc_reset(void)
 {
-	int	ret = SUCCEED, cached_records = 0, range_end;
-
-	if (ZBX_ITEM_STATUS_CACHED_ALL == item->status)
-		return SUCCEED;
+	int	i;
 
-	/* check if the requested period is in the cached range */
-	if (0 != item->db_cached_from && range_start >= item->db_cached_from)
-		return SUCCEED;
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	/* find if the cache should be updated to cover the required count */
-	if (NULL != item->head)
+	for (i = 0; i < vc_shards_num; i++)
 	{
-		zbx_vc_chunk_t	*chunk;
-		int		index;
+		zbx_vc_item_t		*item;
+		zbx_hashset_iter_t	iter;
 
-		if (SUCCEED == vch_item_get_last_value(item, ts, &chunk, &index))
-		{
-			cached_records = index - chunk->first_value + 1;
+		vc_select_shard(i);
+		vc_try_lock();
 
-			while (NULL != (chunk = chunk->prev) && cached_records < count)
-				cached_records += chunk->last_value - chunk->first_value + 1;
+		zbx_hashset_iter_reset(&vc_cache->items, &iter);
+		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			vch_item_free_cache(item);
+			zbx_hashset_iter_remove(&iter);
 		}
+
+		memset(vc_cache->queues, 0, sizeof(vc_cache->queues));
+		zbx_hashset_clear(&vc_cache->ghosts);
+
+		vc_cache->hits = 0;
+		vc_cache->misses = 0;
+		vc_cache->evictions = 0;
+		vc_cache->min_free_request = 0;
+		vc_cache->mode = ZBX_VC_MODE_NORMAL;
+		vc_cache->mode_time = 0;
+		vc_cache->last_warning_time = 0;
+
+		vc_try_unlock();
 	}
 
-	/* update cache if necessary */
-	if (cached_records < count)
-	{
-		zbx_vector_history_record_t	records;
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
 
-		/* get the end timestamp to which (including) the values should be cached */
-		if (NULL != item->head)
-			range_end = item->tail->slots[item->tail->first_value].timestamp.sec - 1;
-		else
-			range_end = ZBX_JAN_2038;
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_add_values                                                *
+ *                                                                            *
+ * Purpose: adds item values to the history and value cache                   *
+ *                                                                            *
+ * Parameters: history - [IN] item history values                             *
+ *                                                                            *
+ * Return value: SUCCEED - the values were added successfully                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vc_add_values(zbx_vector_ptr_t *history)
+{
+	zbx_vc_item_t		*item;
+	int 			i, shard, *shards;
+	ZBX_DC_HISTORY		*h;
+	time_t			expire_timestamp;
+
+	if (FAIL == zbx_history_add_values(history))
+		return FAIL;
 
-		vc_try_unlock();
+	if (ZBX_VC_DISABLED == vc_state)
+		return SUCCEED;
 
-		zbx_vector_history_record_create(&records);
+	expire_timestamp = time(NULL) - ZBX_VC_ITEM_EXPIRE_PERIOD;
 
-		if (range_end > ts->sec)
-		{
-			ret = vc_db_read_values_by_time(item->itemid, item->value_type, &records, ts->sec + 1,
-					range_end);
+	/* values are added shard by shard, locking each shard only once */
+	shards = (int *)zbx_malloc(NULL, sizeof(int) * MAX(history->values_num, 1));
 
-			range_end = ts->sec;
-		}
+	for (i = 0; i < history->values_num; i++)
+		shards[i] = vc_get_item_shard(((ZBX_DC_HISTORY *)history->values[i])->itemid);
 
-		if (SUCCEED == ret && SUCCEED == (ret = vc_db_read_values_by_time_and_count(item->itemid,
-				item->value_type, &records, range_start, count - cached_records, range_end, ts)))
+	for (shard = 0; shard < vc_shards_num; shard++)
+	{
+		int	locked = 0;
+
+		for (i = 0; i < history->values_num; i++)
 		{
-			zbx_vector_history_record_sort(&records,
-					(zbx_compare_func_t)zbx_history_record_compare_asc_func);
-		}
+			if (shard != shards[i])
+				continue;
 
-		vc_try_lock();
+			if (0 == locked)
+			{
+				vc_select_shard(shard);
+				vc_try_lock();
+				locked = 1;
+			}
 
-		if (SUCCEED == ret)
-		{
-			if (0 < records.values_num)
-				ret = vch_item_add_values_at_tail(item, records.values, records.values_num);
+			h = (ZBX_DC_HISTORY *)history->values[i];
 
-			if (SUCCEED == ret)
+			if (NULL != (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &h->itemid)))
 			{
-				ret = records.values_num;
-				if ((count <= records.values_num || 0 == range_start) && 0 != records.values_num)
+				zbx_history_record_t	record = {h->ts, h->value};
+
+				if (0 == (item->state & ZBX_ITEM_STATE_REMOVE_PENDING))
 				{
-					vc_item_update_db_cached_from(item,
-							item->tail->slots[item->tail->first_value].timestamp.sec);
+					vc_item_addref(item);
+
+					/* If the new value type does not match the item's type in cache we can't  */
+					/* change the cache because other processes might still be accessing it    */
+					/* at the same time. The only thing that can be done - mark it for removal */
+					/* so it could be added later with new type.                               */
+					/* Also mark it for removal if the value adding failed. In this case we    */
+					/* won't have the latest data in cache - so the requests must go directly  */
+					/* to the database.                                                        */
+					if (item->value_type != h->value_type ||
+							item->last_accessed < expire_timestamp ||
+							FAIL == vch_item_add_value_at_head(item, &record))
+					{
+						item->state |= ZBX_ITEM_STATE_REMOVE_PENDING;
+					}
+
+					vc_item_release(item);
 				}
-				else if (0 != range_start)
-					vc_item_update_db_cached_from(item, range_start);
 			}
 		}
 
-		zbx_history_record_vector_destroy(&records, item->value_type);
+		if (0 != locked)
+			vc_try_unlock();
 	}
 
-	return ret;
+	zbx_free(shards);
+
+	return SUCCEED;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_get_values_by_time                                      *
+ * Function: vc_get_item                                                      *
  *                                                                            *
- * Purpose: retrieves item history data from cache                            *
+ * Purpose: finds item in the selected cache shard, adding it if necessary    *
  *                                                                            *
- * Parameters: item      - [IN] the item                                      *
- *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order                           *
- *             seconds   - [IN] the time period to retrieve data for          *
- *             ts        - [IN] the requested period end timestamp            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *                                                                            *
+ * Return value: the item or NULL if the item was not found and new items     *
+ *               cannot be added to cache                                     *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_get_values_by_time(zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
-		const zbx_timespec_t *ts)
+static zbx_vc_item_t	*vc_get_item(zbx_uint64_t itemid, int value_type)
 {
-	int		index, now;
-	zbx_timespec_t	start = {ts->sec - seconds, ts->ns};
-	zbx_vc_chunk_t	*chunk;
-
-	/* Check if maximum request range is not set and all data are cached.  */
-	/* Because that indicates there was a count based request with unknown */
-	/* range which might be greater than the current request range.        */
-	if (0 != item->active_range || ZBX_ITEM_STATUS_CACHED_ALL != item->status)
-	{
-		now = time(NULL);
-		/* add another second to include nanosecond shifts */
-		vch_item_update_range(item, seconds + now - ts->sec + 1, now);
-	}
+	zbx_vc_item_t	*item;
 
-	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
+	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
 	{
-		/* Cache does not contain records for the specified timeshift & seconds range. */
-		/* Return empty vector with success.                                           */
-		return;
+		if (ZBX_VC_MODE_NORMAL == vc_cache->mode)
+			item = vc_add_item(itemid, value_type);
 	}
 
-	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
-	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
-
-		if (NULL == (chunk = chunk->prev))
-			break;
-
-		index = chunk->last_value;
-	}
+	return item;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_get_values_by_time_and_count                            *
+ * Function: vc_get_values                                                    *
  *                                                                            *
- * Purpose: retrieves item history data from cache                            *
+ * Purpose: get item history data for the specified time period               *
  *                                                                            *
- * Parameters: item      - [IN] the item                                      *
- *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order, optional                 *
- *                         If null then cache is updated if necessary, but no *
- *                         values are returned. Used to ensure that cache     *
- *                         contains a value of the specified timestamp.       *
- *             seconds   - [IN] the time period                               *
- *             count     - [IN] the number of history values to retrieve      *
- *             timestamp - [IN] the target timestamp                          *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             seconds    - [IN] the time period to retrieve data for         *
+ *             count      - [IN] the number of history values to retrieve     *
+ *             ts         - [IN] the period end timestamp                     *
+ *             func       - [IN] the function to call for each cached value   *
+ *             data       - [IN] the data passed to the callback function     *
+ *             values     - [OUT] the item history data read from database if *
+ *                          it could not be retrieved from cache              *
+ *                                                                            *
+ * Return value:  SUCCEED - the item history data was retrieved successfully  *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: The values are either passed to the callback function while     *
+ *           cache is locked or are read from database into values vector.    *
  *                                                                            *
  ******************************************************************************/
-static void	vch_item_get_values_by_time_and_count(zbx_vc_item_t *item, zbx_vector_history_record_t *values,
-		int seconds, int count, const zbx_timespec_t *ts)
+static int	vc_get_values(zbx_uint64_t itemid, int value_type, int seconds, int count, const zbx_timespec_t *ts,
+		zbx_vc_value_func_t func, void *data, zbx_vector_history_record_t *values)
 {
-	int		index, now, range_timestamp;
-	zbx_vc_chunk_t	*chunk;
-	zbx_timespec_t	start;
+	zbx_vc_item_t	*item = NULL;
+	int 		ret = FAIL;
 
-	/* set start timestamp of the requested time period */
-	if (0 != seconds)
-	{
-		start.sec = ts->sec - seconds;
-		start.ns = ts->ns;
-	}
-	else
-	{
-		start.sec = 0;
-		start.ns = 0;
-	}
+	vc_select_item_shard(itemid);
+	vc_try_lock();
 
-	if (FAIL == vch_item_get_last_value(item, ts, &chunk, &index))
-	{
-		/* return empty vector with success */
+	if (ZBX_VC_DISABLED == vc_state)
 		goto out;
-	}
 
-	/* fill the values vector with item history values until the <count> values are read    */
-	/* or no more values within specified time period                                       */
-	/* fill the values vector with item history values until the start timestamp is reached */
-	while (0 < zbx_timespec_compare(&chunk->slots[chunk->last_value].timestamp, &start))
-	{
-		while (index >= chunk->first_value && 0 < zbx_timespec_compare(&chunk->slots[index].timestamp, &start))
-		{
-			vc_history_record_vector_append(values, item->value_type, &chunk->slots[index--]);
+	if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
+		vc_warn_low_memory();
 
-			if (values->values_num == count)
-				goto out;
-		}
+	if (NULL == (item = vc_get_item(itemid, value_type)))
+		goto out;
 
-		if (NULL == (chunk = chunk->prev))
-			break;
+	vc_item_addref(item);
 
-		index = chunk->last_value;
-	}
+	if (0 != (item->state & ZBX_ITEM_STATE_REMOVE_PENDING) || item->value_type != value_type)
+		goto out;
+
+	ret = vch_item_get_values(item, seconds, count, ts, func, data);
 out:
-	if (count > values->values_num)
-	{
-		if (0 == seconds)
-		{
-			/* not enough data in db to fulfill a count based request request */
-			item->active_range = 0;
-			item->daily_range = 0;
-			item->status = ZBX_ITEM_STATUS_CACHED_ALL;
-			return;
-		}
-		/* not enough data in the requested period, set the range equal to the period plus */
-		/* one second to include nanosecond shifts                                         */
-		range_timestamp = ts->sec - seconds;
-	}
-	else
+	if (FAIL == ret)
 	{
-		/* the requested number of values was retrieved, set the range to the oldest value timestamp */
-		range_timestamp = values->values[values->values_num - 1].timestamp.sec - 1;
+		if (NULL != item)
+			item->state |= ZBX_ITEM_STATE_REMOVE_PENDING;
+
+		vc_try_unlock();
+
+		ret = vc_db_get_values(itemid, value_type, values, seconds, count, ts);
+
+		vc_try_lock();
+
+		if (SUCCEED == ret)
+			vc_update_statistics(NULL, 0, values->values_num);
 	}
 
-	now = time(NULL);
-	vch_item_update_range(item, now - range_timestamp, now);
+	if (NULL != item)
+		vc_item_release(item);
+
+	vc_try_unlock();
+
+	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_get_value_range                                         *
+ * Function: zbx_vc_get_values                                                *
  *                                                                            *
- * Purpose: get item values for the specified range                           *
+ * Purpose: get item history data for the specified time period               *
  *                                                                            *
- * Parameters: item      - [IN] the item                                      *
- *             values    - [OUT] the item history data stored time/value      *
- *                         pairs in undefined order, optional                 *
- *                         If null then cache is updated if necessary, but no *
- *                         values are returned. Used to ensure that cache     *
- *                         contains a value of the specified timestamp.       *
- *             seconds   - [IN] the time period to retrieve data for          *
- *             count     - [IN] the number of history values to retrieve      *
- *             ts        - [IN] the target timestamp                          *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             values     - [OUT] the item history data stored time/value     *
+ *                          pairs in descending order                         *
+ *             seconds    - [IN] the time period to retrieve data for         *
+ *             count      - [IN] the number of history values to retrieve     *
+ *             ts         - [IN] the period end timestamp                     *
  *                                                                            *
  * Return value:  SUCCEED - the item history data was retrieved successfully  *
  *                FAIL    - the item history data was not retrieved           *
  *                                                                            *
- * Comments: This function returns data from cache if necessary updating it   *
- *           from DB. If cache update was required and failed (not enough     *
- *           memory to cache DB values), then this function also fails.       *
+ * Comments: If the data is not in cache, it's read from DB, so this function *
+ *           will always return the requested data, unless some error occurs. *
  *                                                                            *
  *           If <count> is set then value range is defined as <count> values  *
  *           before <timestamp>. Otherwise the range is defined as <seconds>  *
  *           seconds before <timestamp>.                                      *
  *                                                                            *
  ******************************************************************************/
-static int	vch_item_get_values(zbx_vc_item_t *item, zbx_vector_history_record_t *values, int seconds,
+int	zbx_vc_get_values(zbx_uint64_t itemid, int value_type, zbx_vector_history_record_t *values, int seconds,
 		int count, const zbx_timespec_t *ts)
 {
-	int	ret, records_read, hits, misses, range_start;
-
-	zbx_vector_history_record_clear(values);
-
-	if (0 == count)
-	{
-		if (0 > (range_start = ts->sec - seconds))
-			range_start = 0;
-
-		if (FAIL == (ret = vch_item_cache_values_by_time(item, range_start)))
-			goto out;
-
-		records_read = ret;
-
-		vch_item_get_values_by_time(item, values, seconds, ts);
-
-		if (records_read > values->values_num)
-			records_read = values->values_num;
-	}
-	else
-	{
-		range_start = (0 == seconds ? 0 : ts->sec - seconds);
-
-		if (FAIL == (ret = vch_item_cache_values_by_time_and_count(item, range_start, count, ts)))
-			goto out;
-
-		records_read = ret;
+	int	ret;
 
-		vch_item_get_values_by_time_and_count(item, values, seconds, count, ts);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d seconds:%d count:%d sec:%d ns:%d",
+			__func__, itemid, value_type, seconds, count, ts->sec, ts->ns);
 
-		if (records_read > values->values_num)
-			records_read = values->values_num;
-	}
+	zbx_vector_history_record_clear(values);
 
-	hits = values->values_num - records_read;
-	misses = records_read;
+	ret = vc_get_values(itemid, value_type, seconds, count, ts, vc_history_record_vector_append_func, values,
+			values);
 
-	vc_update_statistics(item, hits, misses);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d", __func__, zbx_result_string(ret), values->values_num);
 
-	ret = SUCCEED;
-out:
 	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vch_item_free_cache                                              *
+ * Function: zbx_vc_iterate_values                                            *
  *                                                                            *
- * Purpose: frees resources allocated for item history data                   *
+ * Purpose: iterates item history data for the specified time period without  *
+ *          copying it                                                        *
  *                                                                            *
- * Parameters: item    - [IN] the item                                        *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             seconds    - [IN] the time period to retrieve data for         *
+ *             count      - [IN] the number of history values to retrieve     *
+ *             ts         - [IN] the period end timestamp                     *
+ *             func       - [IN] the function to call for each value,         *
+ *                               starting with the newest value               *
+ *             data       - [IN] the data passed to the callback function     *
  *                                                                            *
- * Return value: the size of freed memory (bytes)                             *
+ * Return value:  SUCCEED - the item history data was iterated successfully   *
+ *                FAIL    - the item history data was not retrieved           *
+ *                                                                            *
+ * Comments: The callback function is called with value cache locked, so it   *
+ *           must be fast, must not call value cache functions and must not   *
+ *           keep references to the passed value after returning.             *
+ *                                                                            *
+ *           The value range is defined in the same way as for                *
+ *           zbx_vc_get_values() function. If the data is not in cache, it's  *
+ *           read from DB and passed to the callback function afterwards.     *
  *                                                                            *
  ******************************************************************************/
-static size_t	vch_item_free_cache(zbx_vc_item_t *item)
+int	zbx_vc_iterate_values(zbx_uint64_t itemid, int value_type, int seconds, int count, const zbx_timespec_t *ts,
+		zbx_vc_value_func_t func, void *data)
 {
-	size_t	freed = 0;
+	zbx_vector_history_record_t	values;
+	int				ret, i;
 
-	zbx_vc_chunk_t	*chunk = item->tail;
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d seconds:%d count:%d sec:%d ns:%d",
+			__func__, itemid, value_type, seconds, count, ts->sec, ts->ns);
 
-	while (NULL != chunk)
-	{
-		zbx_vc_chunk_t	*next = chunk->next;
+	zbx_history_record_vector_create(&values);
 
-		freed += vch_item_free_chunk(item, chunk);
-		chunk = next;
+	if (SUCCEED == (ret = vc_get_values(itemid, value_type, seconds, count, ts, func, data, &values)))
+	{
+		/* pass values read from database, if any */
+		for (i = 0; i < values.values_num; i++)
+			func(&values.values[i], value_type, data);
 	}
-	item->values_total = 0;
-	item->head = NULL;
-	item->tail = NULL;
 
-	return freed;
-}
+	zbx_history_record_vector_destroy(&values, value_type);
 
-/******************************************************************************************************************
- *                                                                                                                *
- * Public API                                                                                                     *
- *                                                                                                                *
- ******************************************************************************************************************/
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_init                                                      *
+ * Function: zbx_vc_get_aggregate                                             *
  *                                                                            *
- * Purpose: initializes value cache                                           *
+ * Purpose: get aggregate of item values for the specified time period        *
+ *                                                                            *
+ * Parameters: itemid     - [IN] the item id                                  *
+ *             value_type - [IN] the item value type                          *
+ *             func       - [IN] the aggregate function (ZBX_VC_AGGREGATE_*)  *
+ *             seconds    - [IN] the time period to aggregate values for      *
+ *             count      - [IN] the number of history values to aggregate    *
+ *             ts         - [IN] the period end timestamp                     *
+ *             value      - [OUT] the sum (ui64 or dbl depending on value     *
+ *                          type), the average (dbl), the minimum or the      *
+ *                          maximum value (optional for count function)       *
+ *             values_num - [OUT] the number of values in the period          *
+ *                                                                            *
+ * Return value:  SUCCEED - the aggregate was calculated successfully         *
+ *                FAIL    - the aggregate cannot be calculated by value       *
+ *                          cache, zbx_vc_iterate_values() must be used       *
+ *                          instead. The output parameters are not changed.   *
+ *                                                                            *
+ * Comments: The value range is defined in the same way as for                *
+ *           zbx_vc_get_values() function, but only one of <seconds> and      *
+ *           <count> can be set.                                              *
+ *                                                                            *
+ *           Sum, average, minimum and maximum functions are supported for    *
+ *           float and unsigned items only. The returned minimum and maximum  *
+ *           values are valid only when values_num is greater than 0.         *
+ *                                                                            *
+ *           The aggregates are kept in cache and, while the following        *
+ *           requests move the period forward, updated by adding values       *
+ *           entering the period and removing values leaving it.              *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_init(char **error)
+int	zbx_vc_get_aggregate(zbx_uint64_t itemid, int value_type, int func, int seconds, int count,
+		const zbx_timespec_t *ts, history_value_t *value, int *values_num)
 {
-	zbx_uint64_t	size_reserved;
-	int		ret = FAIL;
+	zbx_vc_item_t	*item = NULL;
+	int		ret = FAIL, aggregate_num;
+	history_value_t	aggregate;
 
-	if (0 == CONFIG_VALUE_CACHE_SIZE)
-		return SUCCEED;
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d func:%d seconds:%d count:%d"
+			" sec:%d ns:%d", __func__, itemid, value_type, func, seconds, count, ts->sec, ts->ns);
+
+	if ((0 == seconds) == (0 == count))
+		goto finish;
+
+	if (ZBX_VC_AGGREGATE_COUNT != func && ITEM_VALUE_TYPE_FLOAT != value_type &&
+			ITEM_VALUE_TYPE_UINT64 != value_type)
+	{
+		goto finish;
+	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	vc_select_item_shard(itemid);
+	vc_try_lock();
 
-	if (SUCCEED != zbx_mutex_create(&vc_lock, ZBX_MUTEX_VALUECACHE, error))
+	if (ZBX_VC_DISABLED == vc_state)
 		goto out;
 
-	size_reserved = zbx_mem_required_size(1, "value cache size", "ValueCacheSize");
+	if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
+		vc_warn_low_memory();
 
-	if (SUCCEED != zbx_mem_create(&vc_mem, CONFIG_VALUE_CACHE_SIZE, "value cache size", "ValueCacheSize", 1, error))
+	if (NULL == (item = vc_get_item(itemid, value_type)))
 		goto out;
 
-	CONFIG_VALUE_CACHE_SIZE -= size_reserved;
-
-	vc_cache = (zbx_vc_cache_t *)__vc_mem_malloc_func(vc_cache, sizeof(zbx_vc_cache_t));
+	vc_item_addref(item);
 
-	if (NULL == vc_cache)
-	{
-		*error = zbx_strdup(*error, "cannot allocate value cache header");
+	if (0 != (item->state & ZBX_ITEM_STATE_REMOVE_PENDING) || item->value_type != value_type)
 		goto out;
-	}
-	memset(vc_cache, 0, sizeof(zbx_vc_cache_t));
 
-	zbx_hashset_create_ext(&vc_cache->items, VC_ITEMS_INIT_SIZE,
-			ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC, NULL,
-			__vc_mem_malloc_func, __vc_mem_realloc_func, __vc_mem_free_func);
+	if (FAIL == (ret = vch_item_get_aggregate(item, func, seconds, count, ts, &aggregate, &aggregate_num)))
+		item->state |= ZBX_ITEM_STATE_REMOVE_PENDING;
+out:
+	if (NULL != item)
+		vc_item_release(item);
 
-	if (NULL == vc_cache->items.slots)
-	{
-		*error = zbx_strdup(*error, "cannot allocate value cache data storage");
-		goto out;
-	}
+	vc_try_unlock();
 
-	zbx_hashset_create_ext(&vc_cache->strpool, VC_STRPOOL_INIT_SIZE,
-			vc_strpool_hash_func, vc_strpool_compare_func, NULL,
-			__vc_mem_malloc_func, __vc_mem_realloc_func, __vc_mem_free_func);
+	if (SUCCEED != ret)
+		goto finish;
 
-	if (NULL == vc_cache->strpool.slots)
+	if (ZBX_VC_AGGREGATE_AVG == func && 0 != aggregate_num)
 	{
-		*error = zbx_strdup(*error, "cannot allocate string pool for value cache data storage");
-		goto out;
-	}
+		/* the sum of float values can overflow (become infinite or not a number), */
+		/* in that case fall back to the incremental average calculation           */
+		if (ZBX_INFINITY == aggregate.dbl || -ZBX_INFINITY == aggregate.dbl || aggregate.dbl != aggregate.dbl)
+		{
+			ret = FAIL;
+			goto finish;
+		}
 
-	/* the free space request should be 5% of cache size, but no more than 128KB */
-	vc_cache->min_free_request = (CONFIG_VALUE_CACHE_SIZE / 100) * 5;
-	if (vc_cache->min_free_request > 128 * ZBX_KIBIBYTE)
-		vc_cache->min_free_request = 128 * ZBX_KIBIBYTE;
+		aggregate.dbl /= aggregate_num;
+	}
 
-	ret = SUCCEED;
-out:
-	zbx_vc_disable();
+	if (NULL != value)
+		*value = aggregate;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	*values_num = aggregate_num;
+finish:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_destroy                                                   *
+ * Function: vc_prefetch_compare                                              *
  *                                                                            *
- * Purpose: destroys value cache                                              *
+ * Purpose: sorts prefetch requests by itemid and period start time           *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_destroy(void)
+static int	vc_prefetch_compare(const void *d1, const void *d2)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+	const zbx_vc_prefetch_t	*p1 = (const zbx_vc_prefetch_t *)d1;
+	const zbx_vc_prefetch_t	*p2 = (const zbx_vc_prefetch_t *)d2;
 
-	if (NULL != vc_cache)
-	{
-		zbx_mutex_destroy(&vc_lock);
-
-		zbx_hashset_destroy(&vc_cache->items);
-		zbx_hashset_destroy(&vc_cache->strpool);
+	ZBX_RETURN_IF_NOT_EQUAL(p1->itemid, p2->itemid);
+	ZBX_RETURN_IF_NOT_EQUAL(p1->ts.sec - p1->seconds, p2->ts.sec - p2->seconds);
 
-		__vc_mem_free_func(vc_cache);
-		vc_cache = NULL;
-	}
-
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	return 0;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_reset                                                     *
+ * Function: vc_prefetch_item                                                 *
  *                                                                            *
- * Purpose: resets value cache                                                *
+ * Purpose: checks if the item period must be read from history backend and   *
+ *          prepares the history request if necessary                         *
  *                                                                            *
- * Comments: All items and their historical data are removed,                 *
- *           cache working mode, statistics reset.                            *
+ * Parameters: itemid      - [IN] the item id                                 *
+ *             value_type  - [IN] the item value type                         *
+ *             range_start - [IN] the period start time                       *
+ *                                                                            *
+ * Return value: the prefetched item or NULL if the period is already cached  *
+ *               or cannot be cached                                          *
+ *                                                                            *
+ * Comments: The returned prefetched item keeps a reference to the value      *
+ *           cache item.                                                      *
  *                                                                            *
  ******************************************************************************/
-void	zbx_vc_reset(void)
+static zbx_vc_prefetch_item_t	*vc_prefetch_item(zbx_uint64_t itemid, int value_type, int range_start)
 {
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
-	if (NULL != vc_cache)
-	{
-		zbx_vc_item_t		*item;
-		zbx_hashset_iter_t	iter;
+	zbx_vc_item_t		*item;
+	zbx_vc_prefetch_item_t	*prefetch = NULL;
+	int			range_end;
 
-		vc_try_lock();
+	vc_select_item_shard(itemid);
+	vc_try_lock();
 
-		zbx_hashset_iter_reset(&vc_cache->items, &iter);
-		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
-		{
-			vch_item_free_cache(item);
-			zbx_hashset_iter_remove(&iter);
-		}
+	if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
+		goto out;
 
-		vc_cache->hits = 0;
-		vc_cache->misses = 0;
-		vc_cache->min_free_request = 0;
-		vc_cache->mode = ZBX_VC_MODE_NORMAL;
-		vc_cache->mode_time = 0;
-		vc_cache->last_warning_time = 0;
+	if (NULL == (item = vc_get_item(itemid, value_type)))
+		goto out;
 
-		vc_try_unlock();
+	/* items with pending snapshot check are validated by the following value requests */
+	if (0 != (item->state & ZBX_ITEM_STATE_REMOVE_PENDING) || item->value_type != value_type ||
+			0 != item->snapshot)
+	{
+		goto out;
 	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+	if (SUCCEED != vch_item_get_db_range(item, range_start, &range_end))
+		goto out;
+
+	vc_item_addref(item);
+
+	prefetch = (zbx_vc_prefetch_item_t *)zbx_malloc(NULL, sizeof(zbx_vc_prefetch_item_t));
+	prefetch->item = item;
+	prefetch->range_start = range_start;
+	prefetch->request.itemid = itemid;
+	/* decrement interval start point because interval starting point is excluded by history backend */
+	prefetch->request.start = (0 != range_start ? range_start - 1 : 0);
+	prefetch->request.end = range_end;
+	zbx_history_record_vector_create(&prefetch->request.values);
+out:
+	vc_try_unlock();
+
+	return prefetch;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_add_values                                                *
- *                                                                            *
- * Purpose: adds item values to the history and value cache                   *
+ * Function: vc_prefetch_add_values                                           *
  *                                                                            *
- * Parameters: history - [IN] item history values                             *
+ * Purpose: adds prefetched item values to cache and frees the prefetched     *
+ *          item                                                              *
  *                                                                            *
- * Return value: SUCCEED - the values were added successfully                 *
- *               FAIL    - otherwise                                          *
+ * Parameters: prefetch   - [IN] the prefetched item                          *
+ *             value_type - [IN] the item value type                          *
+ *             ret        - [IN] the history request result                   *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_add_values(zbx_vector_ptr_t *history)
+static void	vc_prefetch_add_values(zbx_vc_prefetch_item_t *prefetch, int value_type, int ret)
 {
-	zbx_vc_item_t		*item;
-	int 			i;
-	ZBX_DC_HISTORY		*h;
-	time_t			expire_timestamp;
-
-	if (FAIL == zbx_history_add_values(history))
-		return FAIL;
+	zbx_vc_item_t	*item = prefetch->item;
+	int		records_num;
 
-	if (ZBX_VC_DISABLED == vc_state)
-		return SUCCEED;
-
-	expire_timestamp = time(NULL) - ZBX_VC_ITEM_EXPIRE_PERIOD;
+	if (SUCCEED == ret)
+	{
+		zbx_vector_history_record_sort(&prefetch->request.values,
+				(zbx_compare_func_t)zbx_history_record_compare_asc_func);
+	}
 
+	vc_select_item_shard(prefetch->request.itemid);
 	vc_try_lock();
 
-	for (i = 0; i < history->values_num; i++)
+	if (SUCCEED == ret && 0 == (item->state & ZBX_ITEM_STATE_REMOVE_PENDING))
 	{
-		h = (ZBX_DC_HISTORY *)history->values[i];
-
-		if (NULL != (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &h->itemid)))
+		if (FAIL == (records_num = vch_item_add_db_values(item, &prefetch->request.values,
+				prefetch->range_start)))
 		{
-			zbx_history_record_t	record = {h->ts, h->value};
-
-			if (0 == (item->state & ZBX_ITEM_STATE_REMOVE_PENDING))
-			{
-				vc_item_addref(item);
-
-				/* If the new value type does not match the item's type in cache we can't  */
-				/* change the cache because other processes might still be accessing it    */
-				/* at the same time. The only thing that can be done - mark it for removal */
-				/* so it could be added later with new type.                               */
-				/* Also mark it for removal if the value adding failed. In this case we    */
-				/* won't have the latest data in cache - so the requests must go directly  */
-				/* to the database.                                                        */
-				if (item->value_type != h->value_type || item->last_accessed < expire_timestamp ||
-						FAIL == vch_item_add_value_at_head(item, &record))
-				{
-					item->state |= ZBX_ITEM_STATE_REMOVE_PENDING;
-				}
-
-				vc_item_release(item);
-			}
+			item->state |= ZBX_ITEM_STATE_REMOVE_PENDING;
 		}
+		else
+			vc_update_statistics(NULL, 0, records_num);
 	}
 
+	vc_item_release(item);
+
 	vc_try_unlock();
 
-	return SUCCEED;
+	zbx_history_record_vector_destroy(&prefetch->request.values, value_type);
+	zbx_free(prefetch);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: zbx_vc_get_values                                                *
- *                                                                            *
- * Purpose: get item history data for the specified time period               *
+ * Function: zbx_vc_prefetch_values                                           *
  *                                                                            *
- * Parameters: itemid     - [IN] the item id                                  *
- *             value_type - [IN] the item value type                          *
- *             values     - [OUT] the item history data stored time/value     *
- *                          pairs in descending order                         *
- *             seconds    - [IN] the time period to retrieve data for         *
- *             count      - [IN] the number of history values to retrieve     *
- *             ts         - [IN] the period end timestamp                     *
+ * Purpose: caches time based periods of multiple items                       *
  *                                                                            *
- * Return value:  SUCCEED - the item history data was retrieved successfully  *
- *                FAIL    - the item history data was not retrieved           *
+ * Parameters: requests - [IN/OUT] the prefetch requests, the vector is       *
+ *                                 sorted by itemid                           *
  *                                                                            *
- * Comments: If the data is not in cache, it's read from DB, so this function *
- *           will always return the requested data, unless some error occurs. *
+ * Comments: The item periods missing in cache are read from history backend  *
+ *           with one batched request per value type instead of a separate    *
+ *           request for each item. Prefetching is an optimization - the      *
+ *           following zbx_vc_get_values() or similar requests will read any  *
+ *           data that could not be prefetched.                               *
  *                                                                            *
- *           If <count> is set then value range is defined as <count> values  *
- *           before <timestamp>. Otherwise the range is defined as <seconds>  *
- *           seconds before <timestamp>.                                      *
+ *           Multiple requests of the same item are merged into the longest   *
+ *           period.                                                          *
  *                                                                            *
  ******************************************************************************/
-int	zbx_vc_get_values(zbx_uint64_t itemid, int value_type, zbx_vector_history_record_t *values, int seconds,
-		int count, const zbx_timespec_t *ts)
+void	zbx_vc_prefetch_values(zbx_vector_vc_prefetch_t *requests)
 {
-	zbx_vc_item_t	*item = NULL;
-	int 		ret = FAIL, cache_used = 1;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " value_type:%d seconds:%d count:%d sec:%d ns:%d",
-			__func__, itemid, value_type, seconds, count, ts->sec, ts->ns);
+	zbx_vector_ptr_t	prefetch[ITEM_VALUE_TYPE_MAX];
+	zbx_vc_prefetch_item_t	*item;
+	int			i, j, range_start, ret, prefetched = 0;
 
-	vc_try_lock();
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() requests:%d", __func__, requests->values_num);
 
 	if (ZBX_VC_DISABLED == vc_state)
 		goto out;
 
-	if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
-		vc_warn_low_memory();
-
-	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
-	{
-		if (ZBX_VC_MODE_NORMAL == vc_cache->mode)
-		{
-			zbx_vc_item_t   new_item = {.itemid = itemid, .value_type = value_type};
-
-			if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(zbx_vc_item_t))))
-				goto out;
-		}
-		else
-			goto out;
-	}
-
-	vc_item_addref(item);
+	for (i = 0; i < ITEM_VALUE_TYPE_MAX; i++)
+		zbx_vector_ptr_create(&prefetch[i]);
 
-	if (0 != (item->state & ZBX_ITEM_STATE_REMOVE_PENDING) || item->value_type != value_type)
-		goto out;
+	zbx_vector_vc_prefetch_sort(requests, vc_prefetch_compare);
 
-	ret = vch_item_get_values(item, values, seconds, count, ts);
-out:
-	if (FAIL == ret)
+	for (i = 0; i < requests->values_num; i++)
 	{
-		if (NULL != item)
-			item->state |= ZBX_ITEM_STATE_REMOVE_PENDING;
-
-		cache_used = 0;
+		zbx_vc_prefetch_t	*request = &requests->values[i];
 
-		vc_try_unlock();
+		/* the requests are sorted by period start, so the first request of an item is the longest one */
+		if (0 != i && request->itemid == requests->values[i - 1].itemid)
+			continue;
 
-		ret = vc_db_get_values(itemid, value_type, values, seconds, count, ts);
+		if (0 > request->value_type || ITEM_VALUE_TYPE_MAX <= request->value_type)
+			continue;
 
-		vc_try_lock();
+		if (0 > (range_start = request->ts.sec - request->seconds))
+			range_start = 0;
 
-		if (SUCCEED == ret)
-			vc_update_statistics(NULL, 0, values->values_num);
+		if (NULL != (item = vc_prefetch_item(request->itemid, request->value_type, range_start)))
+			zbx_vector_ptr_append(&prefetch[request->value_type], item);
 	}
 
-	if (NULL != item)
-		vc_item_release(item);
+	for (i = 0; i < ITEM_VALUE_TYPE_MAX; i++)
+	{
+		if (0 == prefetch[i].values_num)
+			continue;
 
-	vc_try_unlock();
+		ret = zbx_history_get_values_multi(i, &prefetch[i]);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s count:%d cached:%d",
-			__func__, zbx_result_string(ret), values->values_num, cache_used);
+		for (j = 0; j < prefetch[i].values_num; j++)
+			vc_prefetch_add_values((zbx_vc_prefetch_item_t *)prefetch[i].values[j], i, ret);
 
-	return ret;
+		prefetched += prefetch[i].values_num;
+	}
+
+	for (i = 0; i < ITEM_VALUE_TYPE_MAX; i++)
+		zbx_vector_ptr_destroy(&prefetch[i]);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() prefetched:%d", __func__, prefetched);
 }
 
 /******************************************************************************
@@ -2737,26 +5536,140 @@ out:
  *                FAIL    - failed to retrieve cache statistics               *
  *                          (cache was not initialized)                       *
  *                                                                            *
+ * Comments: The statistics are summed over all cache shards.                *
+ *                                                                            *
  ******************************************************************************/
 int	zbx_vc_get_statistics(zbx_vc_stats_t *stats)
 {
+	int	i;
+
 	if (ZBX_VC_DISABLED == vc_state)
 		return FAIL;
 
-	vc_try_lock();
+	memset(stats, 0, sizeof(zbx_vc_stats_t));
+	stats->mode = ZBX_VC_MODE_NORMAL;
 
-	stats->hits = vc_cache->hits;
-	stats->misses = vc_cache->misses;
-	stats->mode = vc_cache->mode;
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		vc_select_shard(i);
+		vc_try_lock();
 
-	stats->total_size = vc_mem->total_size;
-	stats->free_size = vc_mem->free_size;
+		stats->hits += vc_cache->hits;
+		stats->misses += vc_cache->misses;
+		stats->evictions += vc_cache->evictions;
 
-	vc_try_unlock();
+		stats->recent_items += vc_cache->queues[ZBX_VC_QUEUE_RECENT].items_num;
+		stats->recent_hits += vc_cache->queues[ZBX_VC_QUEUE_RECENT].hits;
+		stats->frequent_items += vc_cache->queues[ZBX_VC_QUEUE_FREQUENT].items_num;
+		stats->frequent_hits += vc_cache->queues[ZBX_VC_QUEUE_FREQUENT].hits;
+
+		/* report low memory mode if any of the shards is running out of memory */
+		if (ZBX_VC_MODE_LOWMEM == vc_cache->mode)
+			stats->mode = ZBX_VC_MODE_LOWMEM;
+
+		stats->total_size += vc_mem->total_size;
+		stats->free_size += vc_mem->free_size;
+
+		vc_try_unlock();
+	}
 
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vc_save                                                      *
+ *                                                                            *
+ * Purpose: saves value cache snapshot to the file specified by ValueCacheFile*
+ *          configuration parameter                                           *
+ *                                                                            *
+ * Comments: The snapshot is written to a temporary file which is renamed     *
+ *           after all data is written, so a partially written snapshot is    *
+ *           never loaded.                                                    *
+ *           This function must be called after history cache has been        *
+ *           flushed to database, otherwise the values left in history cache  *
+ *           will be missing from the loaded snapshot.                        *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_vc_save(void)
+{
+	FILE				*file;
+	char				*filename_tmp;
+	zbx_vc_snapshot_header_t	header = {ZBX_VC_SNAPSHOT_SIGNATURE, ZBX_VC_SNAPSHOT_VERSION};
+	zbx_vc_snapshot_item_t		terminator = {0};
+	zbx_vc_item_t			*item;
+	zbx_hashset_iter_t		iter;
+	int				i, items_num = 0, ret = SUCCEED;
+
+	if (NULL == CONFIG_VALUE_CACHE_FILE || ZBX_VC_DISABLED == vc_state)
+		return;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	filename_tmp = zbx_dsprintf(NULL, "%s.tmp", CONFIG_VALUE_CACHE_FILE);
+
+	if (NULL == (file = fopen(filename_tmp, "wb")))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot create value cache snapshot file \"%s\": %s", filename_tmp,
+				zbx_strerror(errno));
+		goto out;
+	}
+
+	header.time = time(NULL);
+
+	if (SUCCEED != vc_snapshot_write(file, &header, sizeof(header)))
+		ret = FAIL;
+
+	for (i = 0; i < vc_shards_num && SUCCEED == ret; i++)
+	{
+		vc_select_shard(i);
+		vc_try_lock();
+
+		zbx_hashset_iter_reset(&vc_cache->items, &iter);
+
+		while (NULL != (item = (zbx_vc_item_t *)zbx_hashset_iter_next(&iter)))
+		{
+			if (NULL == item->tail || 0 != (item->state & ZBX_ITEM_STATE_REMOVE_PENDING))
+				continue;
+
+			if (SUCCEED != (ret = vc_snapshot_write_item(file, item)))
+				break;
+
+			items_num++;
+		}
+
+		vc_try_unlock();
+	}
+
+	if (SUCCEED == ret)
+		ret = vc_snapshot_write(file, &terminator, sizeof(terminator));
+
+	if (0 != fclose(file))
+		ret = FAIL;
+
+	if (SUCCEED != ret)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot write value cache snapshot file \"%s\": %s", filename_tmp,
+				zbx_strerror(errno));
+		unlink(filename_tmp);
+		goto out;
+	}
+
+	if (0 != rename(filename_tmp, CONFIG_VALUE_CACHE_FILE))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot rename value cache snapshot file \"%s\" to \"%s\": %s",
+				filename_tmp, CONFIG_VALUE_CACHE_FILE, zbx_strerror(errno));
+		unlink(filename_tmp);
+		goto out;
+	}
+
+	zabbix_log(LOG_LEVEL_INFORMATION, "saved %d items to value cache snapshot", items_num);
+out:
+	zbx_free(filename_tmp);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_vc_lock                                                      *
@@ -2768,11 +5681,19 @@ int	zbx_vc_get_statistics(zbx_vc_stats_t *stats)
  *           API call using the cache unless it was explicitly locked with    *
  *           zbx_vc_lock() function by the same process.                      *
  *                                                                            *
+ *           All cache shards are locked, so this function should be used     *
+ *           only when the whole cache must be accessed exclusively.          *
+ *                                                                            *
  ******************************************************************************/
 void	zbx_vc_lock(void)
 {
-	zbx_mutex_lock(vc_lock);
+	int	i;
+
+	for (i = 0; i < vc_shards_num; i++)
+		zbx_mutex_lock(vc_shards[i].lock);
+
 	vc_locked = 1;
+	vc_unpacked_chunk = NULL;
 }
 
 /******************************************************************************
@@ -2786,8 +5707,12 @@ void	zbx_vc_lock(void)
  ******************************************************************************/
 void	zbx_vc_unlock(void)
 {
+	int	i;
+
 	vc_locked = 0;
-	zbx_mutex_unlock(vc_lock);
+
+	for (i = vc_shards_num - 1; i >= 0; i--)
+		zbx_mutex_unlock(vc_shards[i].lock);
 }
 
 /******************************************************************************
@@ -2799,7 +5724,7 @@ void	zbx_vc_unlock(void)
  ******************************************************************************/
 void	zbx_vc_enable(void)
 {
-	if (NULL != vc_cache)
+	if (0 != vc_shards_num)
 		vc_state = ZBX_VC_ENABLED;
 }
 
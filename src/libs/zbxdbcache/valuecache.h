@@ -49,12 +49,34 @@
  *   either zbx_history_record_vector_destroy() function (free the zbx_vc_get_values()
  *   call output) or zbx_history_record_clear() function (free the zbx_vc_get_value() call output).
  *
+ *   The zbx_vc_iterate_values() function passes the cached history data directly to a
+ *   callback function without copying it and is intended for calculating aggregates over
+ *   long periods.
+ *
+ *   The zbx_vc_get_aggregate() function returns sum, average, minimum, maximum or count of
+ *   item values in the requested period. The aggregates are kept in cache and updated
+ *   incrementally with values entering and leaving the period, so repeated requests of
+ *   sliding periods do not need to iterate all period values.
+ *
+ *   The zbx_vc_prefetch_values() function caches time based periods of multiple items
+ *   with batched history requests, so the following requests of those periods do not
+ *   need to query history backend for each item separately.
+ *
  * Locking
  *
  *   The cache ensures synchronization between processes by using automatic locks whenever
  *   a cache function (zbx_vc_*) is called and by providing manual cache locking functionality
  *   with zbx_vc_lock()/zbx_vc_unlock() functions.
  *
+ *   The cache is split into independently locked shards by itemid, so the automatic locks
+ *   lock only the shard of the requested item, while zbx_vc_lock() locks all shards.
+ *
+ * Eviction
+ *
+ *   When cache runs out of memory the items are evicted using 2Q replacement policy - the
+ *   items requested once are evicted before the items requested repeatedly, so one-off
+ *   requests of many items do not push out the frequently used items.
+ *
  */
 
 #define ZBX_VC_MODE_NORMAL	0
@@ -74,6 +96,17 @@ typedef struct
 	zbx_uint64_t	hits;
 	zbx_uint64_t	misses;
 
+	/* The cache items are split into recent (referenced once) and frequent (referenced   */
+	/* repeatedly) items. Comparing hits of both groups shows how much the frequent items */
+	/* are protected from eviction by the one-off requests.                               */
+	zbx_uint64_t	recent_items;
+	zbx_uint64_t	recent_hits;
+	zbx_uint64_t	frequent_items;
+	zbx_uint64_t	frequent_hits;
+
+	/* the number of items evicted from cache to free space */
+	zbx_uint64_t	evictions;
+
 	zbx_uint64_t	total_size;
 	zbx_uint64_t	free_size;
 
@@ -82,10 +115,35 @@ typedef struct
 }
 zbx_vc_stats_t;
 
+/* the value cache aggregate functions, see zbx_vc_get_aggregate() */
+#define ZBX_VC_AGGREGATE_SUM	0
+#define ZBX_VC_AGGREGATE_AVG	1
+#define ZBX_VC_AGGREGATE_MIN	2
+#define ZBX_VC_AGGREGATE_MAX	3
+#define ZBX_VC_AGGREGATE_COUNT	4
+
+/* the value cache iterator callback, see zbx_vc_iterate_values() */
+typedef void (*zbx_vc_value_func_t)(const zbx_history_record_t *value, int value_type, void *data);
+
+/* the value cache prefetch request, see zbx_vc_prefetch_values() */
+typedef struct
+{
+	zbx_uint64_t	itemid;
+	int		value_type;
+	/* the requested period - <seconds> seconds before <ts> */
+	int		seconds;
+	zbx_timespec_t	ts;
+}
+zbx_vc_prefetch_t;
+
+ZBX_VECTOR_DECL(vc_prefetch, zbx_vc_prefetch_t)
+
 int	zbx_vc_init(char **error);
 
 void	zbx_vc_destroy(void);
 
+void	zbx_vc_save(void);
+
 void	zbx_vc_reset(void);
 
 void	zbx_vc_lock(void);
@@ -99,6 +157,14 @@ void	zbx_vc_disable(void);
 int	zbx_vc_get_values(zbx_uint64_t itemid, int value_type, zbx_vector_history_record_t *values, int seconds,
 		int count, const zbx_timespec_t *ts);
 
+int	zbx_vc_iterate_values(zbx_uint64_t itemid, int value_type, int seconds, int count, const zbx_timespec_t *ts,
+		zbx_vc_value_func_t func, void *data);
+
+int	zbx_vc_get_aggregate(zbx_uint64_t itemid, int value_type, int func, int seconds, int count,
+		const zbx_timespec_t *ts, history_value_t *value, int *values_num);
+
+void	zbx_vc_prefetch_values(zbx_vector_vc_prefetch_t *requests);
+
 int	zbx_vc_get_value(zbx_uint64_t itemid, int value_type, const zbx_timespec_t *ts, zbx_history_record_t *value);
 
 int	zbx_vc_add_values(zbx_vector_ptr_t *history);
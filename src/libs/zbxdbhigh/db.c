@@ -53,7 +53,7 @@ zbx_autoreg_host_t;
 extern char	ZBX_PG_ESCAPE_BACKSLASH;
 #endif
 
-static int	connection_failure;
+static ZBX_THREAD_LOCAL int	connection_failure;
 extern unsigned char	program_type;
 
 void	DBclose(void)
@@ -511,6 +511,43 @@ DB_RESULT	DBselectN(const char *query, int n)
 	return rc;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DBselect_prepared                                                *
+ *                                                                            *
+ * Purpose: execute a select statement with parameters                        *
+ *                                                                            *
+ * Parameters: sql        - [IN] the statement with $1..$N placeholders       *
+ *             params_num - [IN] the number of parameters                     *
+ *             params     - [IN] the numeric parameter values                 *
+ *                                                                            *
+ * Comments: retry until DB is up                                             *
+ *           The statement is prepared once per database connection where     *
+ *           supported, see zbx_db_select_prepared() for restrictions.        *
+ *                                                                            *
+ ******************************************************************************/
+DB_RESULT	DBselect_prepared(const char *sql, int params_num, const char **params)
+{
+	DB_RESULT	rc;
+
+	rc = zbx_db_select_prepared(sql, params_num, params);
+
+	while ((DB_RESULT)ZBX_DB_DOWN == rc)
+	{
+		DBclose();
+		DBconnect(ZBX_DB_CONNECT_NORMAL);
+
+		if ((DB_RESULT)ZBX_DB_DOWN == (rc = zbx_db_select_prepared(sql, params_num, params)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", ZBX_DB_WAIT_DOWN);
+			connection_failure = 1;
+			sleep(ZBX_DB_WAIT_DOWN);
+		}
+	}
+
+	return rc;
+}
+
 int	DBget_row_count(const char *table_name)
 {
 	int		count = 0;
@@ -2699,7 +2736,9 @@ void	zbx_db_insert_add_values_dyn(zbx_db_insert_t *self, const zbx_db_value_t **
 			case ZBX_TYPE_CHAR:
 			case ZBX_TYPE_TEXT:
 			case ZBX_TYPE_SHORTTEXT:
-#ifdef HAVE_ORACLE
+#if defined(HAVE_ORACLE) || defined(HAVE_POSTGRESQL)
+				/* PostgreSQL values are escaped when rendering insert statement, */
+				/* because copy command requires different escaping              */
 				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_OFF);
 #else
 				row[i].str = DBdyn_escape_field_len(field, value->str, ESCAPE_SEQUENCE_ON);
@@ -2781,6 +2820,189 @@ void	zbx_db_insert_add_values(zbx_db_insert_t *self, ...)
 	zbx_vector_ptr_destroy(&values);
 }
 
+#ifdef HAVE_POSTGRESQL
+/* minimum number of rows for bulk insert to use copy instead of multi-row insert statements */
+#define ZBX_DB_INSERT_COPY_ROWS_MIN	100
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DBcopy                                                           *
+ *                                                                            *
+ * Purpose: execute copy from stdin statement                                 *
+ *                                                                            *
+ * Comments: retry until DB is up                                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	DBcopy(const char *sql, const char *data, size_t data_len)
+{
+	int	rc;
+
+	rc = zbx_db_copy(sql, data, data_len);
+
+	while (ZBX_DB_DOWN == rc)
+	{
+		DBclose();
+		DBconnect(ZBX_DB_CONNECT_NORMAL);
+
+		if (ZBX_DB_DOWN == (rc = zbx_db_copy(sql, data, data_len)))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "database is down: retrying in %d seconds", ZBX_DB_WAIT_DOWN);
+			connection_failure = 1;
+			sleep(ZBX_DB_WAIT_DOWN);
+		}
+	}
+
+	return rc;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: db_copy_strcpy_alloc                                             *
+ *                                                                            *
+ * Purpose: append string value escaped for copy command text format          *
+ *                                                                            *
+ ******************************************************************************/
+static void	db_copy_strcpy_alloc(char **data, size_t *data_alloc, size_t *data_offset, const char *src)
+{
+	const char	*ptr, *esc;
+
+	for (ptr = src; '\0' != *ptr; ptr++)
+	{
+		switch (*ptr)
+		{
+			case '\\':
+				esc = "\\\\";
+				break;
+			case '\t':
+				esc = "\\t";
+				break;
+			case '\n':
+				esc = "\\n";
+				break;
+			case '\r':
+				esc = "\\r";
+				break;
+			default:
+				continue;
+		}
+
+		zbx_strncpy_alloc(data, data_alloc, data_offset, src, (size_t)(ptr - src));
+		zbx_strcpy_alloc(data, data_alloc, data_offset, esc);
+		src = ptr + 1;
+	}
+
+	zbx_strncpy_alloc(data, data_alloc, data_offset, src, (size_t)(ptr - src));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: db_insert_execute_copy                                           *
+ *                                                                            *
+ * Purpose: executes the prepared database bulk insert operation with copy    *
+ *          from stdin statements                                             *
+ *                                                                            *
+ * Parameters: self - [IN] the bulk insert data                               *
+ *                                                                            *
+ * Return value: Returns SUCCEED if the operation completed successfully or   *
+ *               FAIL otherwise.                                              *
+ *                                                                            *
+ * Comments: Text format is used because binary format requires values to     *
+ *           match column types exactly, while unsigned fields are stored in  *
+ *           numeric columns and float fields can be stored either as numeric *
+ *           or double precision depending on database upgrade state.         *
+ *                                                                            *
+ ******************************************************************************/
+static int	db_insert_execute_copy(zbx_db_insert_t *self)
+{
+	int		ret = SUCCEED, i, j;
+	const ZBX_FIELD	*field;
+	char		*sql = NULL, *data, delim[2] = {',', '('};
+	size_t		sql_alloc = 0, sql_offset = 0, data_alloc = 16 * ZBX_KIBIBYTE, data_offset = 0;
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, "copy %s ", self->table->table);
+
+	for (i = 0; i < self->fields.values_num; i++)
+	{
+		field = (ZBX_FIELD *)self->fields.values[i];
+
+		zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, delim[0 == i]);
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, field->name);
+	}
+
+	zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, ") from stdin");
+
+	data = (char *)zbx_malloc(NULL, data_alloc);
+	*data = '\0';
+
+	for (i = 0; i < self->rows.values_num; i++)
+	{
+		zbx_db_value_t	*values = (zbx_db_value_t *)self->rows.values[i];
+
+		for (j = 0; j < self->fields.values_num; j++)
+		{
+			const zbx_db_value_t	*value = &values[j];
+
+			field = (const ZBX_FIELD *)self->fields.values[j];
+
+			if (0 != j)
+				zbx_chrcpy_alloc(&data, &data_alloc, &data_offset, '\t');
+
+			switch (field->type)
+			{
+				case ZBX_TYPE_CHAR:
+				case ZBX_TYPE_TEXT:
+				case ZBX_TYPE_SHORTTEXT:
+				case ZBX_TYPE_LONGTEXT:
+					db_copy_strcpy_alloc(&data, &data_alloc, &data_offset, value->str);
+					break;
+				case ZBX_TYPE_INT:
+					zbx_snprintf_alloc(&data, &data_alloc, &data_offset, "%d", value->i32);
+					break;
+				case ZBX_TYPE_FLOAT:
+					zbx_snprintf_alloc(&data, &data_alloc, &data_offset, ZBX_FS_DBL64, value->dbl);
+					break;
+				case ZBX_TYPE_UINT:
+					zbx_snprintf_alloc(&data, &data_alloc, &data_offset, ZBX_FS_UI64, value->ui64);
+					break;
+				case ZBX_TYPE_ID:
+					if (0 == value->ui64)
+					{
+						zbx_strcpy_alloc(&data, &data_alloc, &data_offset, "\\N");
+						break;
+					}
+
+					zbx_snprintf_alloc(&data, &data_alloc, &data_offset, ZBX_FS_UI64, value->ui64);
+					break;
+				default:
+					THIS_SHOULD_NEVER_HAPPEN;
+					exit(EXIT_FAILURE);
+			}
+		}
+
+		zbx_chrcpy_alloc(&data, &data_alloc, &data_offset, '\n');
+
+		if (ZBX_MAX_SQL_SIZE < data_offset)
+		{
+			if (ZBX_DB_OK > DBcopy(sql, data, data_offset))
+			{
+				ret = FAIL;
+				goto out;
+			}
+
+			data_offset = 0;
+		}
+	}
+
+	if (0 != data_offset && ZBX_DB_OK > DBcopy(sql, data, data_offset))
+		ret = FAIL;
+out:
+	zbx_free(data);
+	zbx_free(sql);
+
+	return ret;
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_db_insert_execute                                            *
@@ -2808,6 +3030,9 @@ int	zbx_db_insert_execute(zbx_db_insert_t *self)
 	char		*sql_values = NULL;
 	size_t		sql_values_alloc = 0, sql_values_offset = 0;
 #	endif
+#	ifdef HAVE_POSTGRESQL
+	char		*str_esc;
+#	endif
 #else
 	zbx_db_bind_context_t	*contexts;
 	int			rc, tries = 0;
@@ -2831,6 +3056,11 @@ int	zbx_db_insert_execute(zbx_db_insert_t *self)
 		}
 	}
 
+#ifdef HAVE_POSTGRESQL
+	if (ZBX_DB_INSERT_COPY_ROWS_MIN <= self->rows.values_num)
+		return db_insert_execute_copy(self);
+#endif
+
 #ifndef HAVE_ORACLE
 	sql = (char *)zbx_malloc(NULL, sql_alloc);
 #endif
@@ -2966,7 +3196,14 @@ retry_oracle:
 				case ZBX_TYPE_SHORTTEXT:
 				case ZBX_TYPE_LONGTEXT:
 					zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, '\'');
+#	ifdef HAVE_POSTGRESQL
+					str_esc = zbx_db_dyn_escape_string(value->str, ZBX_SIZE_T_MAX, ZBX_SIZE_T_MAX,
+							ESCAPE_SEQUENCE_ON);
+					zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, str_esc);
+					zbx_free(str_esc);
+#	else
 					zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, value->str);
+#	endif
 					zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, '\'');
 					break;
 				case ZBX_TYPE_INT:
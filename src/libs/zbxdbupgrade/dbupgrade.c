@@ -718,6 +718,123 @@ int	DBdrop_foreign_key(const char *table_name, int id)
 	return ret;
 }
 
+static void	DBcreate_changelog_trigger_sql(char **sql, size_t *sql_alloc, size_t *sql_offset,
+		const char *table_name, const char *field_name, int object, const char *event, int operation,
+		const char *row, const char *update_fields)
+{
+#if defined(HAVE_MYSQL)
+	zbx_snprintf_alloc(sql, sql_alloc, sql_offset,
+			"create trigger `%s_%s` after %s on " ZBX_FS_SQL_NAME
+			" for each row"
+			" insert into changelog (object,objectid,operation,clock)",
+			table_name, event, event, table_name);
+
+	if (NULL != update_fields)
+	{
+		const char	*field, *next;
+
+		/* MySQL triggers cannot be limited to columns, the values are compared instead */
+		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, " select %d,%s.%s,%d,unix_timestamp() from dual"
+				" where not (", object, row, field_name, operation);
+
+		for (field = update_fields; NULL != field; field = next)
+		{
+			int	len;
+
+			if (NULL != (next = strchr(field, ',')))
+				len = (int)(next++ - field);
+			else
+				len = (int)strlen(field);
+
+			zbx_snprintf_alloc(sql, sql_alloc, sql_offset, "%sold.%.*s<=>new.%.*s",
+					field == update_fields ? "" : " and ", len, field, len, field);
+		}
+
+		zbx_chrcpy_alloc(sql, sql_alloc, sql_offset, ')');
+	}
+	else
+	{
+		zbx_snprintf_alloc(sql, sql_alloc, sql_offset, " values (%d,%s.%s,%d,unix_timestamp())", object, row,
+				field_name, operation);
+	}
+#elif defined(HAVE_POSTGRESQL)
+	zbx_snprintf_alloc(sql, sql_alloc, sql_offset,
+			"create function changelog_%s_%s() returns trigger language plpgsql as $$"
+			" begin"
+				" insert into changelog (object,objectid,operation,clock)"
+					" values (%d,%s.%s,%d,cast(extract(epoch from now()) as int));"
+				" return null;"
+			" end $$;"
+			"create trigger %s_%s after %s%s%s on %s"
+			" for each row execute procedure changelog_%s_%s()",
+			table_name, event, object, row, field_name, operation, table_name, event, event,
+			NULL != update_fields ? " of " : "", ZBX_NULL2EMPTY_STR(update_fields), table_name,
+			table_name, event);
+#elif defined(HAVE_ORACLE)
+	zbx_snprintf_alloc(sql, sql_alloc, sql_offset,
+			"create trigger %s_%s after %s%s%s on %s"
+			" for each row"
+			" begin"
+				" insert into changelog (object,objectid,operation,clock)"
+					" values (%d,:%s.%s,%d,trunc((cast(sys_extract_utc(systimestamp) as date)"
+						"-date'1970-01-01')*86400));"
+			" end;",
+			table_name, event, event, NULL != update_fields ? " of " : "",
+			ZBX_NULL2EMPTY_STR(update_fields), table_name, object, row, field_name, operation);
+#endif
+}
+
+static int	DBcreate_changelog_trigger(const char *table_name, const char *field_name, int object,
+		const char *event, int operation, const char *row, const char *update_fields)
+{
+	char	*sql = NULL;
+	size_t	sql_alloc = 0, sql_offset = 0;
+	int	ret = FAIL;
+
+	DBcreate_changelog_trigger_sql(&sql, &sql_alloc, &sql_offset, table_name, field_name, object, event,
+			operation, row, update_fields);
+
+	if (ZBX_DB_OK <= DBexecute("%s", sql))
+		ret = SUCCEED;
+
+	zbx_free(sql);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DBcreate_changelog_triggers                                      *
+ *                                                                            *
+ * Purpose: creates triggers recording insert, update and delete operations   *
+ *          on the specified table in the changelog table                     *
+ *                                                                            *
+ * Parameters: table_name    - [IN] the table name                            *
+ *             field_name    - [IN] the table primary key field name          *
+ *             object        - [IN] the changelog object type                 *
+ *             update_fields - [IN] the comma separated configuration fields  *
+ *                                  to record updates of, NULL for all fields *
+ *                                                                            *
+ * Comments: The object types, operations and fields must be kept in sync     *
+ *           with CHANGELOG entries in schema.tmpl and the changelog reader   *
+ *           in configuration cache synchronization (dbsync.c).               *
+ *                                                                            *
+ ******************************************************************************/
+int	DBcreate_changelog_triggers(const char *table_name, const char *field_name, int object,
+		const char *update_fields)
+{
+	if (SUCCEED != DBcreate_changelog_trigger(table_name, field_name, object, "insert", 1, "new", NULL))
+		return FAIL;
+
+	if (SUCCEED != DBcreate_changelog_trigger(table_name, field_name, object, "update", 2, "new",
+			update_fields))
+	{
+		return FAIL;
+	}
+
+	return DBcreate_changelog_trigger(table_name, field_name, object, "delete", 3, "old", NULL);
+}
+
 static int	DBcreate_dbversion_table(void)
 {
 	const ZBX_TABLE	table =
@@ -780,7 +897,7 @@ extern zbx_dbpatch_t	DBPATCH_VERSION(4030)[];
 extern zbx_dbpatch_t	DBPATCH_VERSION(4040)[];
 extern zbx_dbpatch_t	DBPATCH_VERSION(4050)[];
 extern zbx_dbpatch_t	DBPATCH_VERSION(5000)[];
-/*extern zbx_dbpatch_t	DBPATCH_VERSION(5010)[];*/
+extern zbx_dbpatch_t	DBPATCH_VERSION(5010)[];
 
 static zbx_db_version_t dbversions[] = {
 	{DBPATCH_VERSION(2010), "2.2 development"},
@@ -801,7 +918,7 @@ static zbx_db_version_t dbversions[] = {
 	{DBPATCH_VERSION(4040), "4.4 maintenance"},
 	{DBPATCH_VERSION(4050), "5.0 development"},
 	{DBPATCH_VERSION(5000), "5.0 maintenance"},
-/*	{DBPATCH_VERSION(5010), "5.2 development"},*/
+	{DBPATCH_VERSION(5010), "5.2 development"},
 	{NULL}
 };
 
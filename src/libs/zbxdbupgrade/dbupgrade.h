@@ -65,6 +65,8 @@ int	DBrename_index(const char *table_name, const char *old_name, const char *new
 		int unique);
 int	DBadd_foreign_key(const char *table_name, int id, const ZBX_FIELD *field);
 int	DBdrop_foreign_key(const char *table_name, int id);
+int	DBcreate_changelog_triggers(const char *table_name, const char *field_name, int object,
+		const char *update_fields);
 
 #endif
 
@@ -29,10 +29,99 @@
 
 extern unsigned char	program_type;
 
-/*static int	DBpatch_5010000(void)
+static int	DBpatch_5010000(void)
 {
-	*** put the first upgrade patch here ***
-}*/
+#if defined(HAVE_MYSQL)
+	if (ZBX_DB_OK > DBexecute(
+			"create table changelog ("
+				"changelogid bigint unsigned not null auto_increment,"
+				"object integer default '0' not null,"
+				"objectid bigint unsigned not null,"
+				"operation integer default '0' not null,"
+				"clock integer default '0' not null,"
+				"primary key (changelogid)"
+			") engine=innodb"))
+	{
+		return FAIL;
+	}
+#elif defined(HAVE_POSTGRESQL)
+	if (ZBX_DB_OK > DBexecute(
+			"create table changelog ("
+				"changelogid bigserial not null,"
+				"object integer default '0' not null,"
+				"objectid bigint not null,"
+				"operation integer default '0' not null,"
+				"clock integer default '0' not null,"
+				"primary key (changelogid)"
+			")"))
+	{
+		return FAIL;
+	}
+#elif defined(HAVE_ORACLE)
+	if (ZBX_DB_OK > DBexecute(
+			"create table changelog ("
+				"changelogid number(20) not null,"
+				"object number(10) default '0' not null,"
+				"objectid number(20) not null,"
+				"operation number(10) default '0' not null,"
+				"clock number(10) default '0' not null,"
+				"primary key (changelogid)"
+			")"))
+	{
+		return FAIL;
+	}
+
+	if (ZBX_DB_OK > DBexecute("create sequence changelog_seq start with 1 increment by 1 nomaxvalue"))
+		return FAIL;
+
+	if (ZBX_DB_OK > DBexecute(
+			"create trigger changelog_tr"
+			" before insert on changelog"
+			" for each row"
+			" begin"
+				" select changelog_seq.nextval into :new.changelogid from dual;"
+			" end;"))
+	{
+		return FAIL;
+	}
+#endif
+	return SUCCEED;
+}
+
+static int	DBpatch_5010001(void)
+{
+	return DBcreate_index("changelog", "changelog_1", "clock", 0);
+}
+
+static int	DBpatch_5010002(void)
+{
+	/* host availability and maintenance are updated by server without changing configuration */
+	return DBcreate_changelog_triggers("hosts", "hostid", 1, "proxy_hostid,host,status,ipmi_authtype,"
+			"ipmi_privilege,ipmi_username,ipmi_password,name,flags,tls_connect,tls_accept,tls_issuer,"
+			"tls_subject,tls_psk_identity,tls_psk,proxy_address,auto_compress");
+}
+
+static int	DBpatch_5010003(void)
+{
+	return DBcreate_changelog_triggers("items", "itemid", 2, NULL);
+}
+
+static int	DBpatch_5010004(void)
+{
+	/* trigger value, state and error are updated by server without changing configuration */
+	return DBcreate_changelog_triggers("triggers", "triggerid", 3, "description,expression,priority,type,"
+			"status,flags,recovery_mode,recovery_expression,correlation_mode,correlation_tag,opdata");
+}
+
+static int	DBpatch_5010005(void)
+{
+	return DBcreate_changelog_triggers("functions", "functionid", 4, NULL);
+}
+
+static int	DBpatch_5010006(void)
+{
+	return DBcreate_changelog_triggers("item_preproc", "item_preprocid", 5, NULL);
+}
 
 #endif
 
@@ -40,6 +129,12 @@ DBPATCH_START(5010)
 
 /* version, duplicates flag, mandatory flag */
 
-/*DBPATCH_ADD(5010000, 0, 1)*/
+DBPATCH_ADD(5010000, 0, 1)
+DBPATCH_ADD(5010001, 0, 1)
+DBPATCH_ADD(5010002, 0, 1)
+DBPATCH_ADD(5010003, 0, 1)
+DBPATCH_ADD(5010004, 0, 1)
+DBPATCH_ADD(5010005, 0, 1)
+DBPATCH_ADD(5010006, 0, 1)
 
 DBPATCH_END()
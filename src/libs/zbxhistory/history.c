@@ -32,6 +32,9 @@ extern char	*CONFIG_HISTORY_STORAGE_OPTS;
 
 zbx_history_iface_t	history_ifaces[ITEM_VALUE_TYPE_MAX];
 
+/* the maximum number of items read from history storage with a single request */
+#define ZBX_HISTORY_MULTI_BATCH_SIZE	1000
+
 /************************************************************************************
  *                                                                                  *
  * Function: zbx_history_init                                                       *
@@ -177,6 +180,73 @@ int	zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int c
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: history_request_compare_range                                          *
+ *                                                                                  *
+ * Purpose: sorts history requests by period and itemid                             *
+ *                                                                                  *
+ ************************************************************************************/
+int	history_request_compare_range(const void *d1, const void *d2)
+{
+	const zbx_history_request_t	*r1 = *(const zbx_history_request_t * const *)d1;
+	const zbx_history_request_t	*r2 = *(const zbx_history_request_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(r1->start, r2->start);
+	ZBX_RETURN_IF_NOT_EQUAL(r1->end, r2->end);
+	ZBX_RETURN_IF_NOT_EQUAL(r1->itemid, r2->itemid);
+
+	return 0;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: zbx_history_get_values_multi                                           *
+ *                                                                                  *
+ * Purpose: gets values of multiple items from history storage                      *
+ *                                                                                  *
+ * Parameters:  value_type - [IN] the items value type                              *
+ *              requests   - [IN/OUT] the item history requests                     *
+ *                                       (zbx_history_request_t), sorted by itemid  *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: This function reads all values from ]<start>,<end>] interval of each   *
+ *           request into the request values vector. The requests are read in     *
+ *           batches, with one history storage query per batch instead of one     *
+ *           query per item.                                                        *
+ *           The itemids must be unique and the requests vector is not reordered.  *
+ *                                                                                  *
+ ************************************************************************************/
+int	zbx_history_get_values_multi(int value_type, zbx_vector_ptr_t *requests)
+{
+	int			i, ret = SUCCEED;
+	zbx_history_iface_t	*writer = &history_ifaces[value_type];
+	zbx_vector_ptr_t	batch;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() value_type:%d requests:%d", __func__, value_type,
+			requests->values_num);
+
+	zbx_vector_ptr_create(&batch);
+
+	for (i = 0; i < requests->values_num && SUCCEED == ret; i += ZBX_HISTORY_MULTI_BATCH_SIZE)
+	{
+		int	num = MIN(requests->values_num - i, ZBX_HISTORY_MULTI_BATCH_SIZE);
+
+		zbx_vector_ptr_clear(&batch);
+		zbx_vector_ptr_append_array(&batch, requests->values + i, num);
+
+		ret = writer->get_values_multi(writer, &batch);
+	}
+
+	zbx_vector_ptr_destroy(&batch);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: zbx_history_requires_trends                                            *
@@ -29,6 +29,7 @@ typedef void (*zbx_history_destroy_func_t)(struct zbx_history_iface *hist);
 typedef int (*zbx_history_add_values_func_t)(struct zbx_history_iface *hist, const zbx_vector_ptr_t *history);
 typedef int (*zbx_history_get_values_func_t)(struct zbx_history_iface *hist, zbx_uint64_t itemid, int start,
 		int count, int end, zbx_vector_history_record_t *values);
+typedef int (*zbx_history_get_values_multi_func_t)(struct zbx_history_iface *hist, zbx_vector_ptr_t *requests);
 typedef int (*zbx_history_flush_func_t)(struct zbx_history_iface *hist);
 
 struct zbx_history_iface
@@ -40,9 +41,12 @@ struct zbx_history_iface
 	zbx_history_destroy_func_t	destroy;
 	zbx_history_add_values_func_t	add_values;
 	zbx_history_get_values_func_t	get_values;
+	zbx_history_get_values_multi_func_t	get_values_multi;
 	zbx_history_flush_func_t	flush;
 };
 
+int	history_request_compare_range(const void *d1, const void *d2);
+
 /* SQL hist */
 int	zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
 
@@ -79,6 +79,9 @@ zbx_curlpage_t;
 
 static zbx_curlpage_t	page_w[ITEM_VALUE_TYPE_MAX];
 
+/* the callback function to process value found by elastic_search() */
+typedef int (*zbx_elastic_value_func_t)(zbx_history_iface_t *hist, struct zbx_json_parse *jp_source, void *data);
+
 static size_t	curl_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
 	size_t	r_size = size * nmemb;
@@ -621,122 +624,72 @@ static void	elastic_destroy(zbx_history_iface_t *hist)
 
 /************************************************************************************
  *                                                                                  *
- * Function: elastic_get_values                                                     *
+ * Function: elastic_search                                                         *
  *                                                                                  *
- * Purpose: gets item history data from history storage                             *
+ * Purpose: performs scrolling search of item history data                          *
  *                                                                                  *
- * Parameters:  hist    - [IN] the history storage interface                        *
- *              itemid  - [IN] the itemid                                           *
- *              start   - [IN] the period start timestamp                           *
- *              count   - [IN] the number of values to read                         *
- *              end     - [IN] the period end timestamp                             *
- *              values  - [OUT] the item history data values                        *
+ * Parameters:  hist  - [IN] the history storage interface                          *
+ *              query - [IN] the search query                                       *
+ *              count - [IN] the number of values to read, 0 - read all values      *
+ *              func  - [IN] the function to call for each found value              *
+ *              data  - [IN] the data passed to the callback function               *
  *                                                                                  *
  * Return value: SUCCEED - the history data were read successfully                  *
  *               FAIL - otherwise                                                   *
  *                                                                                  *
- * Comments: This function reads <count> values from ]<start>,<end>] interval or    *
- *           all values from the specified interval if count is zero.               *
- *                                                                                  *
  ************************************************************************************/
-static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, int start, int count, int end,
-		zbx_vector_history_record_t *values)
+static int	elastic_search(zbx_history_iface_t *hist, const char *query, int count, zbx_elastic_value_func_t func,
+		void *data)
 {
-	zbx_elastic_data_t	*data = (zbx_elastic_data_t *)hist->data;
+	zbx_elastic_data_t	*edata = (zbx_elastic_data_t *)hist->data;
 	size_t			url_alloc = 0, url_offset = 0, id_alloc = 0, scroll_alloc = 0, scroll_offset = 0;
 	int			total, empty, ret;
 	CURLcode		err;
-	struct zbx_json		query;
 	struct curl_slist	*curl_headers = NULL;
 	char			*scroll_id = NULL, *scroll_query = NULL, errbuf[CURL_ERROR_SIZE];
 	CURLoption		opt;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
-
 	ret = FAIL;
 
-	if (NULL == (data->handle = curl_easy_init()))
+	if (NULL == (edata->handle = curl_easy_init()))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot initialize cURL session");
 
 		return FAIL;
 	}
 
-	zbx_snprintf_alloc(&data->post_url, &url_alloc, &url_offset, "%s/%s*/_search?scroll=10s", data->base_url,
+	zbx_snprintf_alloc(&edata->post_url, &url_alloc, &url_offset, "%s/%s*/_search?scroll=10s", edata->base_url,
 			value_type_str[hist->value_type]);
 
-	/* prepare the json query for elasticsearch, apply ranges if needed */
-	zbx_json_init(&query, ZBX_JSON_ALLOCATE);
-
-	if (0 < count)
-	{
-		zbx_json_adduint64(&query, "size", count);
-		zbx_json_addarray(&query, "sort");
-		zbx_json_addobject(&query, NULL);
-		zbx_json_addobject(&query, "clock");
-		zbx_json_addstring(&query, "order", "desc", ZBX_JSON_TYPE_STRING);
-		zbx_json_close(&query);
-		zbx_json_close(&query);
-		zbx_json_close(&query);
-	}
-
-	zbx_json_addobject(&query, "query");
-	zbx_json_addobject(&query, "bool");
-	zbx_json_addarray(&query, "must");
-	zbx_json_addobject(&query, NULL);
-	zbx_json_addobject(&query, "match");
-	zbx_json_adduint64(&query, "itemid", itemid);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_addarray(&query, "filter");
-	zbx_json_addobject(&query, NULL);
-	zbx_json_addobject(&query, "range");
-	zbx_json_addobject(&query, "clock");
-
-	if (0 < start)
-		zbx_json_adduint64(&query, "gt", start);
-
-	if (0 < end)
-		zbx_json_adduint64(&query, "lte", end);
-
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-	zbx_json_close(&query);
-
 	curl_headers = curl_slist_append(curl_headers, "Content-Type: application/json");
 
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, data->post_url)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, query.buffer)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEFUNCTION,
+	if (CURLE_OK != (err = curl_easy_setopt(edata->handle, opt = CURLOPT_URL, edata->post_url)) ||
+			CURLE_OK != (err = curl_easy_setopt(edata->handle, opt = CURLOPT_POSTFIELDS, query)) ||
+			CURLE_OK != (err = curl_easy_setopt(edata->handle, opt = CURLOPT_WRITEFUNCTION,
 					curl_write_cb)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_WRITEDATA, &page_r)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_HTTPHEADER, curl_headers)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_FAILONERROR, 1L)) ||
-			CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_ERRORBUFFER, errbuf)))
+			CURLE_OK != (err = curl_easy_setopt(edata->handle, opt = CURLOPT_WRITEDATA, &page_r)) ||
+			CURLE_OK != (err = curl_easy_setopt(edata->handle, opt = CURLOPT_HTTPHEADER, curl_headers)) ||
+			CURLE_OK != (err = curl_easy_setopt(edata->handle, opt = CURLOPT_FAILONERROR, 1L)) ||
+			CURLE_OK != (err = curl_easy_setopt(edata->handle, opt = CURLOPT_ERRORBUFFER, errbuf)))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt, curl_easy_strerror(err));
 		goto out;
 	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "sending query to %s; post data: %s", data->post_url, query.buffer);
+	zabbix_log(LOG_LEVEL_DEBUG, "sending query to %s; post data: %s", edata->post_url, query);
 
 	page_r.offset = 0;
 	*errbuf = '\0';
-	if (CURLE_OK != (err = curl_easy_perform(data->handle)))
+	if (CURLE_OK != (err = curl_easy_perform(edata->handle)))
 	{
-		elastic_log_error(data->handle, err, errbuf);
+		elastic_log_error(edata->handle, err, errbuf);
 		goto out;
 	}
 
 	url_offset = 0;
-	zbx_snprintf_alloc(&data->post_url, &url_alloc, &url_offset, "%s/_search/scroll", data->base_url);
+	zbx_snprintf_alloc(&edata->post_url, &url_alloc, &url_offset, "%s/_search/scroll", edata->base_url);
 
-	if (CURLE_OK != (err = curl_easy_setopt(data->handle, CURLOPT_URL, data->post_url)))
+	if (CURLE_OK != (err = curl_easy_setopt(edata->handle, CURLOPT_URL, edata->post_url)))
 	{
 		zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)CURLOPT_URL,
 				curl_easy_strerror(err));
@@ -751,7 +704,6 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 	do
 	{
 		struct zbx_json_parse	jp, jp_values, jp_item, jp_sub, jp_hits, jp_source;
-		zbx_history_record_t	hr;
 		const char		*p = NULL;
 
 		empty = 1;
@@ -781,11 +733,9 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 			if (SUCCEED != zbx_json_brackets_by_name(&jp_item, "_source", &jp_source))
 				continue;
 
-			if (SUCCEED != history_parse_value(&jp_source, hist->value_type, &hr))
+			if (SUCCEED != func(hist, &jp_source, data))
 				continue;
 
-			zbx_vector_history_record_append_ptr(values, &hr);
-
 			if (-1 != total)
 				--total;
 
@@ -807,7 +757,7 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 		zbx_snprintf_alloc(&scroll_query, &scroll_alloc, &scroll_offset,
 				"{\"scroll\":\"10s\",\"scroll_id\":\"%s\"}\n", ZBX_NULL2EMPTY_STR(scroll_id));
 
-		if (CURLE_OK != (err = curl_easy_setopt(data->handle, CURLOPT_POSTFIELDS, scroll_query)))
+		if (CURLE_OK != (err = curl_easy_setopt(edata->handle, CURLOPT_POSTFIELDS, scroll_query)))
 		{
 			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)CURLOPT_POSTFIELDS,
 					curl_easy_strerror(err));
@@ -816,9 +766,9 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 
 		page_r.offset = 0;
 		*errbuf = '\0';
-		if (CURLE_OK != (err = curl_easy_perform(data->handle)))
+		if (CURLE_OK != (err = curl_easy_perform(edata->handle)))
 		{
-			elastic_log_error(data->handle, err, errbuf);
+			elastic_log_error(edata->handle, err, errbuf);
 			break;
 		}
 	}
@@ -828,12 +778,13 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 	if (NULL != scroll_id)
 	{
 		url_offset = 0;
-		zbx_snprintf_alloc(&data->post_url, &url_alloc, &url_offset, "%s/_search/scroll/%s", data->base_url,
+		zbx_snprintf_alloc(&edata->post_url, &url_alloc, &url_offset, "%s/_search/scroll/%s", edata->base_url,
 				scroll_id);
 
-		if (CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_URL, data->post_url)) ||
-				CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_POSTFIELDS, NULL)) ||
-				CURLE_OK != (err = curl_easy_setopt(data->handle, opt = CURLOPT_CUSTOMREQUEST, "DELETE")))
+		if (CURLE_OK != (err = curl_easy_setopt(edata->handle, opt = CURLOPT_URL, edata->post_url)) ||
+				CURLE_OK != (err = curl_easy_setopt(edata->handle, opt = CURLOPT_POSTFIELDS, NULL)) ||
+				CURLE_OK != (err = curl_easy_setopt(edata->handle, opt = CURLOPT_CUSTOMREQUEST,
+						"DELETE")))
 		{
 			zabbix_log(LOG_LEVEL_ERR, "cannot set cURL option %d: [%s]", (int)opt,
 					curl_easy_strerror(err));
@@ -842,12 +793,12 @@ static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, in
 		}
 
 
-		zabbix_log(LOG_LEVEL_DEBUG, "elasticsearch closing scroll %s", data->post_url);
+		zabbix_log(LOG_LEVEL_DEBUG, "elasticsearch closing scroll %s", edata->post_url);
 
 		page_r.offset = 0;
 		*errbuf = '\0';
-		if (CURLE_OK != (err = curl_easy_perform(data->handle)))
-			elastic_log_error(data->handle, err, errbuf);
+		if (CURLE_OK != (err = curl_easy_perform(edata->handle)))
+			elastic_log_error(edata->handle, err, errbuf);
 	}
 
 out:
@@ -855,11 +806,161 @@ out:
 
 	curl_slist_free_all(curl_headers);
 
-	zbx_json_free(&query);
-
 	zbx_free(scroll_id);
 	zbx_free(scroll_query);
 
+	return ret;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_add_value                                                      *
+ *                                                                                  *
+ * Purpose: adds found value to the values vector                                   *
+ *                                                                                  *
+ * Parameters:  hist      - [IN] the history storage interface                      *
+ *              jp_source - [IN] the found document source                          *
+ *              data      - [IN] the values vector                                  *
+ *                                                                                  *
+ * Return value: SUCCEED - the value was added                                      *
+ *               FAIL - failed to parse value                                       *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_add_value(zbx_history_iface_t *hist, struct zbx_json_parse *jp_source, void *data)
+{
+	zbx_vector_history_record_t	*values = (zbx_vector_history_record_t *)data;
+	zbx_history_record_t		hr;
+
+	if (SUCCEED != history_parse_value(jp_source, hist->value_type, &hr))
+		return FAIL;
+
+	zbx_vector_history_record_append_ptr(values, &hr);
+
+	return SUCCEED;
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_add_request_value                                              *
+ *                                                                                  *
+ * Purpose: adds found value to the values vector of the item history request      *
+ *                                                                                  *
+ * Parameters:  hist      - [IN] the history storage interface                      *
+ *              jp_source - [IN] the found document source                          *
+ *              data      - [IN] the item history requests, sorted by itemid        *
+ *                                                                                  *
+ * Return value: SUCCEED - the value was added                                      *
+ *               FAIL - failed to parse value or the item was not requested         *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_add_request_value(zbx_history_iface_t *hist, struct zbx_json_parse *jp_source, void *data)
+{
+	zbx_vector_ptr_t	*requests = (zbx_vector_ptr_t *)data;
+	zbx_history_request_t	*request;
+	char			buffer[MAX_ID_LEN + 1];
+	zbx_uint64_t		itemid;
+	int			index;
+
+	if (SUCCEED != zbx_json_value_by_name(jp_source, "itemid", buffer, sizeof(buffer), NULL) ||
+			SUCCEED != is_uint64(buffer, &itemid))
+	{
+		return FAIL;
+	}
+
+	if (FAIL == (index = zbx_vector_ptr_bsearch(requests, &itemid, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
+		return FAIL;
+
+	request = (zbx_history_request_t *)requests->values[index];
+
+	return elastic_add_value(hist, jp_source, &request->values);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_json_add_range                                                 *
+ *                                                                                  *
+ * Purpose: adds clock range filter to elasticsearch query                          *
+ *                                                                                  *
+ ************************************************************************************/
+static void	elastic_json_add_range(struct zbx_json *query, int start, int end)
+{
+	zbx_json_addobject(query, NULL);
+	zbx_json_addobject(query, "range");
+	zbx_json_addobject(query, "clock");
+
+	if (0 < start)
+		zbx_json_adduint64(query, "gt", start);
+
+	if (0 < end)
+		zbx_json_adduint64(query, "lte", end);
+
+	zbx_json_close(query);
+	zbx_json_close(query);
+	zbx_json_close(query);
+}
+
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_get_values                                                     *
+ *                                                                                  *
+ * Purpose: gets item history data from history storage                             *
+ *                                                                                  *
+ * Parameters:  hist    - [IN] the history storage interface                        *
+ *              itemid  - [IN] the itemid                                           *
+ *              start   - [IN] the period start timestamp                           *
+ *              count   - [IN] the number of values to read                         *
+ *              end     - [IN] the period end timestamp                             *
+ *              values  - [OUT] the item history data values                        *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: This function reads <count> values from ]<start>,<end>] interval or    *
+ *           all values from the specified interval if count is zero.               *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, int start, int count, int end,
+		zbx_vector_history_record_t *values)
+{
+	int		ret;
+	struct zbx_json	query;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
+
+	/* prepare the json query for elasticsearch, apply ranges if needed */
+	zbx_json_init(&query, ZBX_JSON_ALLOCATE);
+
+	if (0 < count)
+	{
+		zbx_json_adduint64(&query, "size", count);
+		zbx_json_addarray(&query, "sort");
+		zbx_json_addobject(&query, NULL);
+		zbx_json_addobject(&query, "clock");
+		zbx_json_addstring(&query, "order", "desc", ZBX_JSON_TYPE_STRING);
+		zbx_json_close(&query);
+		zbx_json_close(&query);
+		zbx_json_close(&query);
+	}
+
+	zbx_json_addobject(&query, "query");
+	zbx_json_addobject(&query, "bool");
+	zbx_json_addarray(&query, "must");
+	zbx_json_addobject(&query, NULL);
+	zbx_json_addobject(&query, "match");
+	zbx_json_adduint64(&query, "itemid", itemid);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_addarray(&query, "filter");
+	elastic_json_add_range(&query, start, end);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+
+	ret = elastic_search(hist, query.buffer, count, elastic_add_value, values);
+
+	zbx_json_free(&query);
+
 	zbx_vector_history_record_sort(values, (zbx_compare_func_t)zbx_history_record_compare_desc_func);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
@@ -867,6 +968,92 @@ out:
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: elastic_get_values_multi                                               *
+ *                                                                                  *
+ * Purpose: gets history data of multiple items from history storage                *
+ *                                                                                  *
+ * Parameters:  hist     - [IN] the history storage interface                       *
+ *              requests - [IN/OUT] the item history requests, sorted by itemid     *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: The requests are grouped by their periods and combined into a single   *
+ *           query as alternative (should) clauses, each matching the group        *
+ *           itemids with terms query and the group period with range filter.      *
+ *                                                                                  *
+ ************************************************************************************/
+static int	elastic_get_values_multi(zbx_history_iface_t *hist, zbx_vector_ptr_t *requests)
+{
+	int			i, j, ret;
+	struct zbx_json		query;
+	zbx_vector_ptr_t	ranges;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() requests:%d", __func__, requests->values_num);
+
+	if (0 == requests->values_num)
+	{
+		ret = SUCCEED;
+		goto out;
+	}
+
+	zbx_vector_ptr_create(&ranges);
+	zbx_vector_ptr_append_array(&ranges, requests->values, requests->values_num);
+	zbx_vector_ptr_sort(&ranges, history_request_compare_range);
+
+	zbx_json_init(&query, ZBX_JSON_ALLOCATE);
+
+	zbx_json_addobject(&query, "query");
+	zbx_json_addobject(&query, "bool");
+	zbx_json_addarray(&query, "should");
+
+	for (i = 0; i < ranges.values_num; i = j)
+	{
+		const zbx_history_request_t	*request = (const zbx_history_request_t *)ranges.values[i];
+
+		zbx_json_addobject(&query, NULL);
+		zbx_json_addobject(&query, "bool");
+		zbx_json_addarray(&query, "filter");
+		zbx_json_addobject(&query, NULL);
+		zbx_json_addobject(&query, "terms");
+		zbx_json_addarray(&query, "itemid");
+
+		for (j = i; j < ranges.values_num; j++)
+		{
+			const zbx_history_request_t	*next = (const zbx_history_request_t *)ranges.values[j];
+
+			if (next->start != request->start || next->end != request->end)
+				break;
+
+			zbx_json_adduint64(&query, NULL, next->itemid);
+		}
+
+		zbx_json_close(&query);
+		zbx_json_close(&query);
+		zbx_json_close(&query);
+		elastic_json_add_range(&query, request->start, request->end);
+		zbx_json_close(&query);
+		zbx_json_close(&query);
+		zbx_json_close(&query);
+	}
+
+	zbx_json_close(&query);
+	zbx_json_adduint64(&query, "minimum_should_match", 1);
+	zbx_json_close(&query);
+	zbx_json_close(&query);
+
+	ret = elastic_search(hist, query.buffer, 0, elastic_add_request_value, requests);
+
+	zbx_json_free(&query);
+	zbx_vector_ptr_destroy(&ranges);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
+
+	return ret;
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: elastic_add_values                                                     *
@@ -1010,6 +1197,7 @@ int	zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type
 	hist->add_values = elastic_add_values;
 	hist->flush = elastic_flush;
 	hist->get_values = elastic_get_values;
+	hist->get_values_multi = elastic_get_values_multi;
 	hist->requires_trends = 0;
 
 	return SUCCEED;
@@ -355,33 +355,44 @@ static void	add_history_log(zbx_vector_ptr_t *history)
 static int	db_read_values_by_time(zbx_uint64_t itemid, int value_type, zbx_vector_history_record_t *values,
 		int seconds, int end_timestamp)
 {
-	char			*sql = NULL;
+	char			*sql = NULL, buffer[3][MAX_ID_LEN + 1];
+	const char		*params[3] = {buffer[0], buffer[1], buffer[2]};
 	size_t	 		sql_alloc = 0, sql_offset = 0;
+	int			params_num;
 	DB_RESULT		result;
 	DB_ROW			row;
 	zbx_vc_history_table_t	*table = &vc_history_tables[value_type];
 
+	/* the query is executed as prepared statement, so only placeholders can vary between calls */
 	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
 			"select clock,ns,%s"
 			" from %s"
-			" where itemid=" ZBX_FS_UI64,
-			table->fields, table->name, itemid);
+			" where itemid=$1",
+			table->fields, table->name);
+
+	zbx_snprintf(buffer[0], sizeof(buffer[0]), ZBX_FS_UI64, itemid);
 
 	if (ZBX_JAN_2038 == end_timestamp)
 	{
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock>%d", end_timestamp - seconds);
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and clock>$2");
+		zbx_snprintf(buffer[1], sizeof(buffer[1]), "%d", end_timestamp - seconds);
+		params_num = 2;
 	}
 	else if (1 == seconds)
 	{
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock=%d", end_timestamp);
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and clock=$2");
+		zbx_snprintf(buffer[1], sizeof(buffer[1]), "%d", end_timestamp);
+		params_num = 2;
 	}
 	else
 	{
-		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock>%d and clock<=%d",
-				end_timestamp - seconds, end_timestamp);
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and clock>$2 and clock<=$3");
+		zbx_snprintf(buffer[1], sizeof(buffer[1]), "%d", end_timestamp - seconds);
+		zbx_snprintf(buffer[2], sizeof(buffer[2]), "%d", end_timestamp);
+		params_num = 3;
 	}
 
-	result = DBselect("%s", sql);
+	result = DBselect_prepared(sql, params_num, params);
 
 	zbx_free(sql);
 
@@ -602,6 +613,109 @@ out:
 	return ret;
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: db_read_values_multi                                                   *
+ *                                                                                  *
+ * Purpose: reads history data of multiple items from database                      *
+ *                                                                                  *
+ * Parameters:  value_type - [IN] the value type (see ITEM_VALUE_TYPE_* defs)       *
+ *              requests   - [IN/OUT] the item history requests, sorted by itemid   *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ * Comments: The requests are grouped by their periods and each group is selected   *
+ *           with "itemid in (...)" condition, so all values are read with a       *
+ *           single query.                                                          *
+ *                                                                                  *
+ ************************************************************************************/
+static int	db_read_values_multi(int value_type, zbx_vector_ptr_t *requests)
+{
+	char			*sql = NULL;
+	size_t			sql_alloc = 0, sql_offset = 0;
+	int			i, j;
+	DB_RESULT		result;
+	DB_ROW			row;
+	zbx_vc_history_table_t	*table = &vc_history_tables[value_type];
+	zbx_vector_ptr_t	ranges;
+	zbx_vector_uint64_t	itemids;
+
+	zbx_vector_ptr_create(&ranges);
+	zbx_vector_ptr_append_array(&ranges, requests->values, requests->values_num);
+	zbx_vector_ptr_sort(&ranges, history_request_compare_range);
+
+	zbx_vector_uint64_create(&itemids);
+
+	zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset,
+			"select itemid,clock,ns,%s"
+			" from %s"
+			" where",
+			table->fields, table->name);
+
+	for (i = 0; i < ranges.values_num; i = j)
+	{
+		const zbx_history_request_t	*request = (const zbx_history_request_t *)ranges.values[i];
+
+		zbx_vector_uint64_clear(&itemids);
+
+		for (j = i; j < ranges.values_num; j++)
+		{
+			const zbx_history_request_t	*next = (const zbx_history_request_t *)ranges.values[j];
+
+			if (next->start != request->start || next->end != request->end)
+				break;
+
+			zbx_vector_uint64_append(&itemids, next->itemid);
+		}
+
+		if (0 != i)
+			zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " or");
+
+		zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " (clock>%d", request->start);
+
+		if (ZBX_JAN_2038 != request->end)
+			zbx_snprintf_alloc(&sql, &sql_alloc, &sql_offset, " and clock<=%d", request->end);
+
+		zbx_strcpy_alloc(&sql, &sql_alloc, &sql_offset, " and");
+		DBadd_condition_alloc(&sql, &sql_alloc, &sql_offset, "itemid", itemids.values, itemids.values_num);
+		zbx_chrcpy_alloc(&sql, &sql_alloc, &sql_offset, ')');
+	}
+
+	zbx_vector_uint64_destroy(&itemids);
+	zbx_vector_ptr_destroy(&ranges);
+
+	result = DBselect("%s", sql);
+
+	zbx_free(sql);
+
+	if (NULL == result)
+		goto out;
+
+	while (NULL != (row = DBfetch(result)))
+	{
+		zbx_history_request_t	*request;
+		zbx_history_record_t	value;
+		zbx_uint64_t		itemid;
+
+		ZBX_STR2UINT64(itemid, row[0]);
+
+		if (FAIL == (i = zbx_vector_ptr_bsearch(requests, &itemid, ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
+			continue;
+
+		request = (zbx_history_request_t *)requests->values[i];
+
+		value.timestamp.sec = atoi(row[1]);
+		value.timestamp.ns = atoi(row[2]);
+		table->rtov(&value.value, row + 3);
+
+		zbx_vector_history_record_append_ptr(&request->values, &value);
+	}
+	DBfree_result(result);
+out:
+	return SUCCEED;
+}
+
 /******************************************************************************************************************
  *                                                                                                                *
  * history interface support                                                                                      *
@@ -654,6 +768,27 @@ static int	sql_get_values(zbx_history_iface_t *hist, zbx_uint64_t itemid, int st
 	return db_read_values_by_time_and_count(itemid, hist->value_type, values, end - start, count, end);
 }
 
+/************************************************************************************
+ *                                                                                  *
+ * Function: sql_get_values_multi                                                   *
+ *                                                                                  *
+ * Purpose: gets history data of multiple items from history storage                *
+ *                                                                                  *
+ * Parameters:  hist     - [IN] the history storage interface                       *
+ *              requests - [IN/OUT] the item history requests, sorted by itemid     *
+ *                                                                                  *
+ * Return value: SUCCEED - the history data were read successfully                  *
+ *               FAIL - otherwise                                                   *
+ *                                                                                  *
+ ************************************************************************************/
+static int	sql_get_values_multi(zbx_history_iface_t *hist, zbx_vector_ptr_t *requests)
+{
+	if (0 == requests->values_num)
+		return SUCCEED;
+
+	return db_read_values_multi(hist->value_type, requests);
+}
+
 /************************************************************************************
  *                                                                                  *
  * Function: sql_add_values                                                         *
@@ -728,6 +863,7 @@ int	zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, ch
 	hist->add_values = sql_add_values;
 	hist->flush = sql_flush;
 	hist->get_values = sql_get_values;
+	hist->get_values_multi = sql_get_values_multi;
 
 	switch (value_type)
 	{
@@ -88,6 +88,46 @@
  *  lo_bound             `size' fields in chunk B                   hi_bound  *
  *  (aligned)            have MEM_FLG_USED bit set                 (aligned)  *
  *                                                                            *
+ *                                                                            *
+ * (*) small objects are allocated from slabs of fixed size classes           *
+ *                                                                            *
+ *     a slab page is a used chunk split into equal object slots, each slot   *
+ *     has a single size field with MEM_FLG_USED and MEM_FLG_SLAB bits set    *
+ *     and the slot offset from the page start in the other bits              *
+ *                                                                            *
+ *                                                                            *
+ *              +------------------ slab page chunk ------------------+       *
+ *              |                                                     |       *
+ *              v                                                     v       *
+ *     |--------|--header--|----|--object--|----|--object--|...|------|----|  *
+ *                              ^               ^                             *
+ *                              |               |                             *
+ *                          slot size field with offset from page start       *
+ *                                                                            *
+ *     free objects of a page are kept in singly-linked list, with the next   *
+ *     pointer in the first ZBX_PTR_SIZE bytes of object memory               *
+ *                                                                            *
+ *     the pages having free objects are stored in doubly-linked list of the  *
+ *     slab, full pages are unlinked and empty pages are returned to the      *
+ *     chunk allocator, except the last page of slab                          *
+ *                                                                            *
+ *     notes:                                                                 *
+ *                                                                            *
+ *         - allocating and freeing small objects does not split and merge    *
+ *           chunks and small objects do not fragment the free chunk space    *
+ *                                                                            *
+ *         - object slots have one size field instead of two                  *
+ *                                                                            *
+ *                                                                            *
+ * (*) allocations can be relocated to reduce fragmentation                   *
+ *                                                                            *
+ *     a used chunk preceded by a free chunk is moved to the start of the     *
+ *     free chunk, so the free space moves after it and is merged with the    *
+ *     following free chunk, if any                                           *
+ *                                                                            *
+ *     an object in a sparsely used slab page is moved to the first page of   *
+ *     the slab having free objects, so sparse pages are emptied and freed    *
+ *                                                                            *
  ******************************************************************************/
 
 static void	*ALIGN4(void *ptr);
@@ -114,6 +154,12 @@ static void	*__mem_malloc(zbx_mem_info_t *info, zbx_uint64_t size);
 static void	*__mem_realloc(zbx_mem_info_t *info, void *old, zbx_uint64_t size);
 static void	__mem_free(zbx_mem_info_t *info, void *ptr);
 
+static void	*mem_slab_malloc(zbx_mem_info_t *info, zbx_uint64_t size);
+static void	mem_slab_free(zbx_mem_info_t *info, void *ptr);
+
+static void	*mem_chunk_relocate(zbx_mem_info_t *info, void *ptr);
+static void	*mem_slab_relocate(zbx_mem_info_t *info, void *ptr);
+
 #define MEM_SIZE_FIELD		sizeof(zbx_uint64_t)
 
 #define MEM_FLG_USED		((__UINT64_C(1))<<63)
@@ -130,6 +176,32 @@ static void	__mem_free(zbx_mem_info_t *info, void *ptr);
 #define MEM_MAX_BUCKET_SIZE	256 /* starting from this size all free chunks are put into the same bucket */
 #define MEM_BUCKET_COUNT	((MEM_MAX_BUCKET_SIZE - MEM_MIN_BUCKET_SIZE) / 8 + 1)
 
+#define MEM_FLG_SLAB		((__UINT64_C(1))<<62)
+
+#define SLAB_OBJECT(ptr)	(0 != ((*(zbx_uint64_t *)((char *)(ptr) - MEM_SIZE_FIELD)) & MEM_FLG_SLAB))
+#define SLAB_OFFSET(ptr)	((*(zbx_uint64_t *)((char *)(ptr) - MEM_SIZE_FIELD)) & ~(MEM_FLG_USED | MEM_FLG_SLAB))
+
+#define MEM_SLAB_MAX_SIZE	256	/* objects up to this size are allocated from slabs */
+#define MEM_SLAB_COUNT		(MEM_SLAB_MAX_SIZE / 8)
+#define MEM_SLAB_PAGE_SIZE	(16 * ZBX_KIBIBYTE)
+/* slabs are used for memory segments large enough to keep few pages of each slab */
+#define MEM_SLAB_MIN_TOTAL_SIZE	(MEM_SLAB_COUNT * MEM_SLAB_PAGE_SIZE * 8)
+
+/* the slab page header, stored at the beginning of slab page chunk memory */
+typedef struct zbx_mem_slab_page
+{
+	struct zbx_mem_slab_page	*prev;
+	struct zbx_mem_slab_page	*next;
+	void				*free_objects;
+	zbx_uint32_t			slab;
+	zbx_uint32_t			objects_num;
+	zbx_uint32_t			objects_used;
+	zbx_uint32_t			objects_carved;	/* the number of slots taken from unused page space */
+}
+zbx_mem_slab_page_t;
+
+#define MEM_SLAB_PAGE_HEADER	((sizeof(zbx_mem_slab_page_t) + 7) & ~(size_t)7)
+
 /* helper functions */
 
 static void	*ALIGN4(void *ptr)
@@ -536,13 +608,508 @@ static void	__mem_free(zbx_mem_info_t *info, void *ptr)
 	}
 }
 
+/* slab functions */
+
+static zbx_uint64_t	mem_slab_object_size(int slab)
+{
+	return (zbx_uint64_t)(slab + 1) * 8;
+}
+
+static void	mem_slab_link_page(zbx_mem_slab_t *slab, zbx_mem_slab_page_t *page)
+{
+	page->prev = NULL;
+	page->next = (zbx_mem_slab_page_t *)slab->pages;
+
+	if (NULL != page->next)
+		page->next->prev = page;
+
+	slab->pages = page;
+}
+
+static void	mem_slab_unlink_page(zbx_mem_slab_t *slab, zbx_mem_slab_page_t *page)
+{
+	if (NULL != page->prev)
+		page->prev->next = page->next;
+	else
+		slab->pages = page->next;
+
+	if (NULL != page->next)
+		page->next->prev = page->prev;
+}
+
+static void	*mem_slab_malloc(zbx_mem_info_t *info, zbx_uint64_t size)
+{
+	int			index;
+	zbx_mem_slab_t		*slab;
+	zbx_mem_slab_page_t	*page;
+	char			*object;
+	zbx_uint64_t		slot_size;
+
+	index = (int)((size - 1) >> 3);
+	slab = &info->slabs[index];
+	slot_size = MEM_SIZE_FIELD + mem_slab_object_size(index);
+
+	if (NULL == (page = (zbx_mem_slab_page_t *)slab->pages))
+	{
+		void	*chunk;
+
+		if (NULL == (chunk = __mem_malloc(info, MEM_SLAB_PAGE_SIZE)))
+			return NULL;
+
+		page = (zbx_mem_slab_page_t *)((char *)chunk + MEM_SIZE_FIELD);
+		page->free_objects = NULL;
+		page->slab = (zbx_uint32_t)index;
+		page->objects_num = (zbx_uint32_t)((MEM_SLAB_PAGE_SIZE - MEM_SLAB_PAGE_HEADER) / slot_size);
+		page->objects_used = 0;
+		page->objects_carved = 0;
+
+		mem_slab_link_page(slab, page);
+		slab->pages_num++;
+		slab->objects_total += page->objects_num;
+	}
+
+	if (NULL != page->free_objects)
+	{
+		object = (char *)page->free_objects;
+		page->free_objects = *(void **)object;
+	}
+	else
+	{
+		object = (char *)page + MEM_SLAB_PAGE_HEADER + page->objects_carved++ * slot_size + MEM_SIZE_FIELD;
+		*(zbx_uint64_t *)(object - MEM_SIZE_FIELD) = MEM_FLG_USED | MEM_FLG_SLAB |
+				(zbx_uint64_t)(object - (char *)page);
+	}
+
+	if (++page->objects_used == page->objects_num)
+		mem_slab_unlink_page(slab, page);
+
+	slab->objects_used++;
+
+	return object;
+}
+
+static void	mem_slab_free(zbx_mem_info_t *info, void *ptr)
+{
+	zbx_mem_slab_page_t	*page;
+	zbx_mem_slab_t		*slab;
+
+	page = (zbx_mem_slab_page_t *)((char *)ptr - SLAB_OFFSET(ptr));
+	slab = &info->slabs[page->slab];
+
+	if (page->objects_used-- == page->objects_num)
+		mem_slab_link_page(slab, page);
+
+	slab->objects_used--;
+
+	/* keep the last page to avoid reallocating it when objects are freed and allocated in turns */
+	if (0 == page->objects_used && 1 < slab->pages_num)
+	{
+		mem_slab_unlink_page(slab, page);
+		slab->pages_num--;
+		slab->objects_total -= page->objects_num;
+
+		__mem_free(info, page);
+
+		return;
+	}
+
+	*(void **)ptr = page->free_objects;
+	page->free_objects = ptr;
+}
+
+static void	*mem_malloc(zbx_mem_info_t *info, zbx_uint64_t size)
+{
+	void	*chunk;
+
+	if (NULL != info->slabs && MEM_SLAB_MAX_SIZE >= size)
+	{
+		void	*object;
+
+		if (NULL != (object = mem_slab_malloc(info, size)))
+			return object;
+	}
+
+	if (NULL == (chunk = __mem_malloc(info, size)))
+		return NULL;
+
+	return (void *)((char *)chunk + MEM_SIZE_FIELD);
+}
+
+static void	*mem_slab_realloc(zbx_mem_info_t *info, void *old, zbx_uint64_t size)
+{
+	zbx_mem_slab_page_t	*page;
+	zbx_uint64_t		object_size;
+	void			*ptr;
+
+	page = (zbx_mem_slab_page_t *)((char *)old - SLAB_OFFSET(old));
+	object_size = mem_slab_object_size((int)page->slab);
+
+	if (size <= object_size && size > object_size / 2)
+		return old;
+
+	if (NULL == (ptr = mem_malloc(info, size)))
+		return NULL;
+
+	memcpy(ptr, old, MIN(size, object_size));
+	mem_slab_free(info, old);
+
+	return ptr;
+}
+
+/* relocation functions */
+
+static void	*mem_chunk_relocate(zbx_mem_info_t *info, void *ptr)
+{
+	void		*chunk, *prev_chunk, *free_chunk;
+	zbx_uint64_t	chunk_size, prev_size;
+
+	chunk = (void *)((char *)ptr - MEM_SIZE_FIELD);
+
+	if (info->lo_bound >= chunk || !FREE_CHUNK((char *)chunk - MEM_SIZE_FIELD))
+		return ptr;
+
+	chunk_size = CHUNK_SIZE(chunk);
+	prev_size = CHUNK_SIZE((char *)chunk - MEM_SIZE_FIELD);
+	prev_chunk = (void *)((char *)chunk - MEM_SIZE_FIELD - prev_size - MEM_SIZE_FIELD);
+
+	mem_unlink_chunk(info, prev_chunk);
+
+	memmove((char *)prev_chunk + MEM_SIZE_FIELD, ptr, chunk_size);
+	mem_set_used_chunk_size(prev_chunk, chunk_size);
+
+	/* the free chunk of the same size is placed after the relocated chunk and */
+	/* freed again to merge it with the next chunk                             */
+	free_chunk = (void *)((char *)prev_chunk + MEM_SIZE_FIELD + chunk_size + MEM_SIZE_FIELD);
+	mem_set_used_chunk_size(free_chunk, prev_size);
+
+	info->free_size -= prev_size;
+	info->used_size += prev_size;
+
+	__mem_free(info, (char *)free_chunk + MEM_SIZE_FIELD);
+
+	return (char *)prev_chunk + MEM_SIZE_FIELD;
+}
+
+static void	*mem_slab_relocate(zbx_mem_info_t *info, void *ptr)
+{
+	zbx_mem_slab_page_t	*page;
+	zbx_uint64_t		object_size;
+	void			*object;
+
+	page = (zbx_mem_slab_page_t *)((char *)ptr - SLAB_OFFSET(ptr));
+
+	/* objects are moved only from pages less than half used to the page objects are allocated from */
+	if (page->objects_used * 2 >= page->objects_num || page == info->slabs[page->slab].pages ||
+			NULL == info->slabs[page->slab].pages)
+	{
+		return ptr;
+	}
+
+	object_size = mem_slab_object_size((int)page->slab);
+
+	/* the first slab page has free objects, so allocation will not fail */
+	object = mem_slab_malloc(info, object_size);
+	memcpy(object, ptr, object_size);
+	mem_slab_free(info, ptr);
+
+	return object;
+}
+
+/* shared memory backing */
+
+extern int	CONFIG_SHM_HUGE_PAGES;
+extern char	*CONFIG_SHM_NUMA_POLICY;
+
+#define MEM_NUMA_MAX_NODES	1024
+#define MEM_NUMA_MASK_BITS	(8 * sizeof(unsigned long))
+#define MEM_NUMA_MASK_SIZE	(MEM_NUMA_MAX_NODES / MEM_NUMA_MASK_BITS)
+
+/* memory policy modes, see mbind(2) */
+#define MEM_MPOL_BIND		2
+#define MEM_MPOL_INTERLEAVE	3
+
+#define MEM_NUMA_ONLINE_NODES	"/sys/devices/system/node/online"
+
+#ifdef SHM_HUGETLB
+/******************************************************************************
+ *                                                                            *
+ * Function: mem_get_huge_page_size                                           *
+ *                                                                            *
+ * Purpose: gets the default huge page size of the system                     *
+ *                                                                            *
+ * Return value: the huge page size in bytes or 0 if huge pages are not       *
+ *               supported                                                    *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	mem_get_huge_page_size(void)
+{
+	zbx_uint64_t	size = 0;
+	FILE		*f;
+	char		line[MAX_STRING_LEN];
+
+	if (NULL == (f = fopen("/proc/meminfo", "r")))
+		return 0;
+
+	while (NULL != fgets(line, sizeof(line), f))
+	{
+		if (1 == sscanf(line, "Hugepagesize: " ZBX_FS_UI64 " kB", &size))
+		{
+			size *= ZBX_KIBIBYTE;
+			break;
+		}
+	}
+
+	zbx_fclose(f);
+
+	return size;
+}
+#endif
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mem_shm_get                                                      *
+ *                                                                            *
+ * Purpose: gets private shared memory segment, backed by huge pages if       *
+ *          configured and available                                          *
+ *                                                                            *
+ * Parameters: size      - [IN/OUT] the requested size, rounded up to huge    *
+ *                                  page size if huge pages are used          *
+ *             descr     - [IN] the segment description                       *
+ *             page_size - [OUT] the huge page size or 0 if the segment is    *
+ *                               backed by regular pages                      *
+ *                                                                            *
+ * Return value: the shared memory identifier or -1 on failure                *
+ *                                                                            *
+ * Comments: Failure to get huge pages is not fatal - the segment is          *
+ *           allocated with regular pages instead.                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	mem_shm_get(zbx_uint64_t *size, const char *descr, zbx_uint64_t *page_size)
+{
+	*page_size = 0;
+
+	if (0 == CONFIG_SHM_HUGE_PAGES)
+		return shmget(IPC_PRIVATE, *size, 0600);
+#ifdef SHM_HUGETLB
+	if (0 != (*page_size = mem_get_huge_page_size()))
+	{
+		int		shm_id;
+		zbx_uint64_t	huge_size;
+
+		huge_size = (*size + *page_size - 1) / *page_size * *page_size;
+
+		if (-1 != (shm_id = shmget(IPC_PRIVATE, huge_size, 0600 | SHM_HUGETLB)))
+		{
+			*size = huge_size;
+			return shm_id;
+		}
+
+		zabbix_log(LOG_LEVEL_WARNING, "cannot get " ZBX_FS_UI64 " bytes of huge pages for %s: %s,"
+				" using regular pages", huge_size, descr, zbx_strerror(errno));
+		*page_size = 0;
+	}
+	else
+		zabbix_log(LOG_LEVEL_WARNING, "huge pages are not available for %s, using regular pages", descr);
+#else
+	zabbix_log(LOG_LEVEL_WARNING, "huge pages are not supported on this platform, using regular pages for %s",
+			descr);
+#endif
+	return shmget(IPC_PRIVATE, *size, 0600);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mem_numa_parse_nodes                                             *
+ *                                                                            *
+ * Purpose: parses NUMA node list in format <node>[-<node>][,...]             *
+ *                                                                            *
+ * Parameters: list     - [IN] the node list                                  *
+ *             nodemask - [OUT] the node mask (optional)                      *
+ *             max_node - [OUT] the highest node in list (optional)           *
+ *                                                                            *
+ * Return value: SUCCEED - the node list was parsed successfully              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	mem_numa_parse_nodes(const char *list, unsigned long *nodemask, int *max_node)
+{
+	const char	*ptr = list;
+	char		*end;
+	long		from, to;
+
+	if (NULL != nodemask)
+		memset(nodemask, 0, MEM_NUMA_MASK_SIZE * sizeof(unsigned long));
+
+	if (NULL != max_node)
+		*max_node = -1;
+
+	do
+	{
+		if (0 == isdigit((unsigned char)*ptr))
+			return FAIL;
+
+		to = from = strtol(ptr, &end, 10);
+
+		if ('-' == *end)
+		{
+			if (0 == isdigit((unsigned char)*(ptr = end + 1)))
+				return FAIL;
+
+			to = strtol(ptr, &end, 10);
+		}
+
+		if (from > to || MEM_NUMA_MAX_NODES <= to)
+			return FAIL;
+
+		for (; from <= to; from++)
+		{
+			if (NULL != nodemask)
+				nodemask[from / MEM_NUMA_MASK_BITS] |= 1UL << (from % MEM_NUMA_MASK_BITS);
+		}
+
+		if (NULL != max_node && *max_node < to)
+			*max_node = (int)to;
+
+		ptr = end + 1;
+	}
+	while (',' == *end);
+
+	return '\0' == *end ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mem_numa_parse_policy                                            *
+ *                                                                            *
+ * Purpose: parses NUMA memory policy in format interleave[:<nodes>] or       *
+ *          bind:<nodes>                                                      *
+ *                                                                            *
+ * Parameters: policy - [IN] the memory policy                                *
+ *             mode   - [OUT] the memory policy mode, MEM_MPOL_*              *
+ *             nodes  - [OUT] the node list, NULL for all online nodes        *
+ *                                                                            *
+ * Return value: SUCCEED - the memory policy was parsed successfully          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	mem_numa_parse_policy(const char *policy, int *mode, const char **nodes)
+{
+	if (0 == strcmp(policy, "interleave"))
+	{
+		*mode = MEM_MPOL_INTERLEAVE;
+		*nodes = NULL;
+		return SUCCEED;
+	}
+
+	if (0 == strncmp(policy, "interleave:", ZBX_CONST_STRLEN("interleave:")))
+	{
+		*mode = MEM_MPOL_INTERLEAVE;
+		*nodes = policy + ZBX_CONST_STRLEN("interleave:");
+	}
+	else if (0 == strncmp(policy, "bind:", ZBX_CONST_STRLEN("bind:")))
+	{
+		*mode = MEM_MPOL_BIND;
+		*nodes = policy + ZBX_CONST_STRLEN("bind:");
+	}
+	else
+		return FAIL;
+
+	return mem_numa_parse_nodes(*nodes, NULL, NULL);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: mem_numa_set_policy                                              *
+ *                                                                            *
+ * Purpose: sets NUMA memory policy for shared memory segment                 *
+ *                                                                            *
+ * Parameters: base  - [IN] the segment address                               *
+ *             size  - [IN] the segment size                                  *
+ *             descr - [IN] the segment description                           *
+ *                                                                            *
+ * Return value: SUCCEED - the memory policy was set                          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The policy must be set before the segment memory is accessed,    *
+ *           as it affects only pages allocated afterwards.                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	mem_numa_set_policy(void *base, zbx_uint64_t size, const char *descr)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+	unsigned long	nodemask[MEM_NUMA_MASK_SIZE];
+	const char	*nodes;
+	char		*online = NULL;
+	int		mode, max_node, ret = FAIL;
+
+	if (SUCCEED != mem_numa_parse_policy(CONFIG_SHM_NUMA_POLICY, &mode, &nodes))
+		goto out;
+
+	if (NULL == nodes)
+	{
+		FILE	*f;
+		char	line[MAX_STRING_LEN];
+
+		if (NULL == (f = fopen(MEM_NUMA_ONLINE_NODES, "r")))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot set NUMA memory policy for %s: cannot open \"%s\": %s",
+					descr, MEM_NUMA_ONLINE_NODES, zbx_strerror(errno));
+			goto out;
+		}
+
+		if (NULL != fgets(line, sizeof(line), f))
+		{
+			zbx_rtrim(line, "\n");
+			online = zbx_strdup(NULL, line);
+		}
+
+		zbx_fclose(f);
+
+		if (NULL == (nodes = online))
+			goto out;
+	}
+
+	if (SUCCEED != mem_numa_parse_nodes(nodes, nodemask, &max_node))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot set NUMA memory policy for %s: invalid node list \"%s\"",
+				descr, nodes);
+		goto out;
+	}
+
+	/* the maximum node number passed to mbind() must be one greater than the last node in mask */
+	if (0 != syscall(SYS_mbind, base, (unsigned long)size, mode, nodemask, (unsigned long)max_node + 2, 0))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot set NUMA memory policy \"%s\" for %s: %s",
+				CONFIG_SHM_NUMA_POLICY, descr, zbx_strerror(errno));
+		goto out;
+	}
+
+	ret = SUCCEED;
+out:
+	zbx_free(online);
+
+	return ret;
+#else
+	ZBX_UNUSED(base);
+	ZBX_UNUSED(size);
+
+	zabbix_log(LOG_LEVEL_WARNING, "NUMA memory policies are not supported on this platform, cannot set policy"
+			" for %s", descr);
+
+	return FAIL;
+#endif
+}
+
 /* public memory interface */
 
 int	zbx_mem_create(zbx_mem_info_t **info, zbx_uint64_t size, const char *descr, const char *param, int allow_oom,
 		char **error)
 {
-	int	shm_id, index, ret = FAIL;
-	void	*base;
+	int		shm_id, index, ret = FAIL;
+	void		*base;
+	zbx_uint64_t	shm_size, page_size;
+	const char	*numa_policy = "default";
+	char		pages[MAX_ID_LEN];
 
 	descr = ZBX_NULL2STR(descr);
 	param = ZBX_NULL2STR(param);
@@ -565,7 +1132,9 @@ int	zbx_mem_create(zbx_mem_info_t **info, zbx_uint64_t size, const char *descr,
 		goto out;
 	}
 
-	if (-1 == (shm_id = shmget(IPC_PRIVATE, size, 0600)))
+	shm_size = size;
+
+	if (-1 == (shm_id = mem_shm_get(&shm_size, descr, &page_size)))
 	{
 		*error = zbx_dsprintf(*error, "cannot get private shared memory of size " ZBX_FS_SIZE_T " for %s: %s",
 				(zbx_fs_size_t)size, descr, zbx_strerror(errno));
@@ -581,6 +1150,18 @@ int	zbx_mem_create(zbx_mem_info_t **info, zbx_uint64_t size, const char *descr,
 	if (-1 == shmctl(shm_id, IPC_RMID, NULL))
 		zbx_error("cannot mark shared memory %d for destruction: %s", shm_id, zbx_strerror(errno));
 
+	if (NULL != CONFIG_SHM_NUMA_POLICY && SUCCEED == mem_numa_set_policy(base, shm_size, descr))
+		numa_policy = CONFIG_SHM_NUMA_POLICY;
+
+	if (0 != page_size)
+		zbx_snprintf(pages, sizeof(pages), ZBX_FS_UI64 "KB huge", page_size / ZBX_KIBIBYTE);
+	else
+		zbx_strlcpy(pages, "regular", sizeof(pages));
+
+	zabbix_log(0 != CONFIG_SHM_HUGE_PAGES || NULL != CONFIG_SHM_NUMA_POLICY ? LOG_LEVEL_INFORMATION :
+			LOG_LEVEL_DEBUG, "%s: allocated " ZBX_FS_UI64 " bytes of shared memory with %s pages,"
+			" NUMA memory policy: %s", descr, shm_size, pages, numa_policy);
+
 	ret = SUCCEED;
 
 	/* allocate zbx_mem_info_t structure, its buckets, and description inside shared memory */
@@ -624,6 +1205,7 @@ int	zbx_mem_create(zbx_mem_info_t **info, zbx_uint64_t size, const char *descr,
 
 	(*info)->used_size = 0;
 	(*info)->free_size = (*info)->total_size;
+	(*info)->slabs = NULL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "valid user addresses: [%p, %p] total size: " ZBX_FS_SIZE_T,
 			(void *)((char *)(*info)->lo_bound + MEM_SIZE_FIELD),
@@ -637,7 +1219,7 @@ out:
 
 void	*__zbx_mem_malloc(const char *file, int line, zbx_mem_info_t *info, const void *old, size_t size)
 {
-	void	*chunk;
+	void	*ptr;
 
 	if (NULL != old)
 	{
@@ -653,9 +1235,9 @@ void	*__zbx_mem_malloc(const char *file, int line, zbx_mem_info_t *info, const v
 		exit(EXIT_FAILURE);
 	}
 
-	chunk = __mem_malloc(info, size);
+	ptr = mem_malloc(info, size);
 
-	if (NULL == chunk)
+	if (NULL == ptr)
 	{
 		if (1 == info->allow_oom)
 			return NULL;
@@ -669,12 +1251,12 @@ void	*__zbx_mem_malloc(const char *file, int line, zbx_mem_info_t *info, const v
 		exit(EXIT_FAILURE);
 	}
 
-	return (void *)((char *)chunk + MEM_SIZE_FIELD);
+	return ptr;
 }
 
 void	*__zbx_mem_realloc(const char *file, int line, zbx_mem_info_t *info, void *old, size_t size)
 {
-	void	*chunk;
+	void	*ptr, *chunk;
 
 	if (0 == size || size > MEM_MAX_SIZE)
 	{
@@ -684,11 +1266,15 @@ void	*__zbx_mem_realloc(const char *file, int line, zbx_mem_info_t *info, void *
 	}
 
 	if (NULL == old)
-		chunk = __mem_malloc(info, size);
+		ptr = mem_malloc(info, size);
+	else if (SLAB_OBJECT(old))
+		ptr = mem_slab_realloc(info, old, size);
+	else if (NULL != (chunk = __mem_realloc(info, old, size)))
+		ptr = (void *)((char *)chunk + MEM_SIZE_FIELD);
 	else
-		chunk = __mem_realloc(info, old, size);
+		ptr = NULL;
 
-	if (NULL == chunk)
+	if (NULL == ptr)
 	{
 		if (1 == info->allow_oom)
 			return NULL;
@@ -702,7 +1288,7 @@ void	*__zbx_mem_realloc(const char *file, int line, zbx_mem_info_t *info, void *
 		exit(EXIT_FAILURE);
 	}
 
-	return (void *)((char *)chunk + MEM_SIZE_FIELD);
+	return ptr;
 }
 
 void	__zbx_mem_free(const char *file, int line, zbx_mem_info_t *info, void *ptr)
@@ -713,7 +1299,10 @@ void	__zbx_mem_free(const char *file, int line, zbx_mem_info_t *info, void *ptr)
 		exit(EXIT_FAILURE);
 	}
 
-	__mem_free(info, ptr);
+	if (SLAB_OBJECT(ptr))
+		mem_slab_free(info, ptr);
+	else
+		__mem_free(info, ptr);
 }
 
 void	zbx_mem_clear(zbx_mem_info_t *info)
@@ -731,9 +1320,137 @@ void	zbx_mem_clear(zbx_mem_info_t *info)
 	info->used_size = 0;
 	info->free_size = info->total_size;
 
+	/* slabs were allocated in the cleared memory */
+	if (NULL != info->slabs)
+	{
+		info->slabs = NULL;
+		zbx_mem_enable_slabs(info);
+	}
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __func__);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mem_relocate                                                 *
+ *                                                                            *
+ * Purpose: moves allocated memory to reduce memory fragmentation             *
+ *                                                                            *
+ * Parameters: info - [IN] the memory segment                                 *
+ *             ptr  - [IN] the allocated memory, can be NULL                  *
+ *                                                                            *
+ * Return value: the new location of the memory contents, or ptr if the       *
+ *               memory was not moved                                         *
+ *                                                                            *
+ * Comments: The caller must replace the only reference to the memory with    *
+ *           the returned pointer - relocation is not possible for memory     *
+ *           referenced from multiple places.                                 *
+ *                                                                            *
+ ******************************************************************************/
+void	*zbx_mem_relocate(zbx_mem_info_t *info, void *ptr)
+{
+	if (NULL == ptr)
+		return NULL;
+
+	if (SLAB_OBJECT(ptr))
+		return mem_slab_relocate(info, ptr);
+
+	return mem_chunk_relocate(info, ptr);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mem_get_fragmentation                                        *
+ *                                                                            *
+ * Purpose: gets free memory fragmentation                                    *
+ *                                                                            *
+ * Parameters: info - [IN] the memory segment                                 *
+ *                                                                            *
+ * Return value: the percentage of free memory, including unused slab         *
+ *               objects, not available for the largest possible allocation   *
+ *                                                                            *
+ ******************************************************************************/
+double	zbx_mem_get_fragmentation(zbx_mem_info_t *info)
+{
+	void		*chunk;
+	int		index;
+	zbx_uint64_t	max_size = 0, free_size = info->free_size;
+
+	for (index = MEM_BUCKET_COUNT - 1; 0 <= index; index--)
+	{
+		if (NULL == (chunk = info->buckets[index]))
+			continue;
+
+		for (; NULL != chunk; chunk = mem_get_next_chunk(chunk))
+			max_size = MAX(max_size, CHUNK_SIZE(chunk));
+
+		break;
+	}
+
+	if (NULL != info->slabs)
+	{
+		for (index = 0; index < MEM_SLAB_COUNT; index++)
+		{
+			free_size += (info->slabs[index].objects_total - info->slabs[index].objects_used) *
+					mem_slab_object_size(index);
+		}
+	}
+
+	if (0 == free_size)
+		return 0;
+
+	return (double)(free_size - max_size) / free_size * 100;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mem_validate_numa_policy                                     *
+ *                                                                            *
+ * Purpose: validates shared memory NUMA policy configuration parameter       *
+ *                                                                            *
+ * Parameters: policy - [IN] the memory policy                                *
+ *                                                                            *
+ * Return value: SUCCEED - the memory policy is valid                         *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_mem_validate_numa_policy(const char *policy)
+{
+	int		mode;
+	const char	*nodes;
+
+	return mem_numa_parse_policy(policy, &mode, &nodes);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mem_enable_slabs                                             *
+ *                                                                            *
+ * Purpose: enables allocation of small objects from fixed size class slabs   *
+ *                                                                            *
+ * Parameters: info - [IN] the memory segment                                 *
+ *                                                                            *
+ * Comments: Slabs reduce chunk splitting and merging and free space          *
+ *           fragmentation for segments storing many small objects. They are  *
+ *           not enabled for small segments, where partially used slab pages  *
+ *           would take significant part of memory, and should not be enabled *
+ *           for segments sized with zbx_mem_required_size().                 *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mem_enable_slabs(zbx_mem_info_t *info)
+{
+	void	*chunk;
+
+	if (NULL != info->slabs || MEM_SLAB_MIN_TOTAL_SIZE > info->total_size)
+		return;
+
+	if (NULL == (chunk = __mem_malloc(info, MEM_SLAB_COUNT * sizeof(zbx_mem_slab_t))))
+		return;
+
+	info->slabs = (zbx_mem_slab_t *)((char *)chunk + MEM_SIZE_FIELD);
+	memset(info->slabs, 0, MEM_SLAB_COUNT * sizeof(zbx_mem_slab_t));
+}
+
 void	zbx_mem_dump_stats(int level, zbx_mem_info_t *info)
 {
 	void		*chunk;
@@ -776,6 +1493,40 @@ void	zbx_mem_dump_stats(int level, zbx_mem_info_t *info)
 	zabbix_log(level, "of those, %10llu bytes are in %8llu used chunks",
 			(unsigned long long)info->used_size, (unsigned long long)(total - total_free));
 
+	/* the part of free memory not usable for the largest allocation */
+	if (0 != total_free)
+	{
+		zabbix_log(level, "free memory fragmentation: %.2f%%",
+				(double)(info->free_size - max_size) / info->free_size * 100);
+	}
+
+	if (NULL != info->slabs)
+	{
+		zbx_uint64_t	pages_num = 0, objects_used = 0, objects_size = 0;
+
+		for (index = 0; index < MEM_SLAB_COUNT; index++)
+		{
+			zbx_mem_slab_t	*slab = &info->slabs[index];
+
+			if (0 == slab->pages_num)
+				continue;
+
+			zabbix_log(level, "slab objects of size %3d bytes: %8llu used of %8llu in %6llu pages (%.2f%%)",
+					(int)mem_slab_object_size(index), (unsigned long long)slab->objects_used,
+					(unsigned long long)slab->objects_total, (unsigned long long)slab->pages_num,
+					(double)slab->objects_used / slab->objects_total * 100);
+
+			pages_num += slab->pages_num;
+			objects_used += slab->objects_used;
+			objects_size += slab->objects_used * mem_slab_object_size(index);
+		}
+
+		zabbix_log(level, "of used memory, %10llu bytes are in %6llu slab pages with %8llu objects of %llu"
+				" bytes", (unsigned long long)(pages_num * MEM_SLAB_PAGE_SIZE),
+				(unsigned long long)pages_num, (unsigned long long)objects_used,
+				(unsigned long long)objects_size);
+	}
+
 	zabbix_log(level, "================================");
 }
 
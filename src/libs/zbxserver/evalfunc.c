@@ -39,6 +39,15 @@ typedef enum
 }
 zbx_value_type_t;
 
+/* the numeric history value aggregate, calculated by value cache iterator callbacks */
+typedef struct
+{
+	history_value_t	value;
+	double		avg;
+	int		values_num;
+}
+zbx_value_aggregate_t;
+
 static const char	*zbx_type_string(zbx_value_type_t type)
 {
 	switch (type)
@@ -550,6 +559,35 @@ static void	count_one_str(int *count, int op, const char *value, const char *pat
 	}
 }
 
+/* the count function data, used by value cache iterator callbacks */
+typedef struct
+{
+	int		op;
+	zbx_uint64_t	pattern_ui64;
+	zbx_uint64_t	mask_ui64;
+	double		pattern_dbl;
+	int		count;
+}
+zbx_count_data_t;
+
+static void	count_one_numeric(const zbx_history_record_t *value, int value_type, void *data)
+{
+	zbx_count_data_t	*cd = (zbx_count_data_t *)data;
+
+	if (ITEM_VALUE_TYPE_UINT64 == value_type)
+		count_one_ui64(&cd->count, cd->op, value->value.ui64, cd->pattern_ui64, cd->mask_ui64);
+	else
+		count_one_dbl(&cd->count, cd->op, value->value.dbl, cd->pattern_dbl);
+}
+
+static void	count_all(const zbx_history_record_t *value, int value_type, void *data)
+{
+	ZBX_UNUSED(value);
+	ZBX_UNUSED(value_type);
+
+	((zbx_count_data_t *)data)->count++;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: evaluate_COUNT                                                   *
@@ -579,9 +617,10 @@ static int	evaluate_COUNT(char **value, DC_ITEM *item, const char *parameters, c
 	int				arg1, op = OP_UNKNOWN, numeric_search, nparams, count = 0, i, ret = FAIL;
 	int				seconds = 0, nvalues = 0;
 	char				*arg2 = NULL, *arg2_2 = NULL, *arg3 = NULL, buf[ZBX_MAX_UINT64_LEN];
-	double				arg2_dbl;
-	zbx_uint64_t			arg2_ui64, arg2_2_ui64;
+	double				arg2_dbl = 0;
+	zbx_uint64_t			arg2_ui64 = 0, arg2_2_ui64 = 0;
 	zbx_value_type_t		arg1_type;
+	zbx_count_data_t		cd = {0};
 	zbx_vector_ptr_t		regexps;
 	zbx_vector_history_record_t	values;
 	zbx_timespec_t			ts_end = *ts;
@@ -771,70 +810,86 @@ static int	evaluate_COUNT(char **value, DC_ITEM *item, const char *parameters, c
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
-	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto out;
-	}
-
 	/* skip counting values one by one if both pattern and operator are empty or "" is searched in text values */
 	if ((NULL != arg2 && '\0' != *arg2) || (NULL != arg3 && '\0' != *arg3 &&
 			OP_LIKE != op && OP_REGEXP != op && OP_IREGEXP != op))
 	{
-		switch (item->value_type)
+		if (0 != numeric_search)
 		{
-			case ITEM_VALUE_TYPE_UINT64:
-				if (0 != numeric_search)
-				{
-					for (i = 0; i < values.values_num; i++)
-					{
-						count_one_ui64(&count, op, values.values[i].value.ui64, arg2_ui64,
-								arg2_2_ui64);
-					}
-				}
-				else
-				{
+			/* numeric values are compared directly in value cache without copying them */
+			cd.op = op;
+			cd.pattern_ui64 = arg2_ui64;
+			cd.mask_ui64 = arg2_2_ui64;
+			cd.pattern_dbl = arg2_dbl;
+
+			if (FAIL == zbx_vc_iterate_values(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+					count_one_numeric, &cd))
+			{
+				*error = zbx_strdup(*error, "cannot get values from value cache");
+				goto out;
+			}
+
+			count = cd.count;
+		}
+		else
+		{
+			if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues,
+					&ts_end))
+			{
+				*error = zbx_strdup(*error, "cannot get values from value cache");
+				goto out;
+			}
+
+			switch (item->value_type)
+			{
+				case ITEM_VALUE_TYPE_UINT64:
 					for (i = 0; i < values.values_num && FAIL != count; i++)
 					{
 						zbx_snprintf(buf, sizeof(buf), ZBX_FS_UI64,
 								values.values[i].value.ui64);
 						count_one_str(&count, op, buf, arg2, &regexps);
 					}
-				}
-				break;
-			case ITEM_VALUE_TYPE_FLOAT:
-				if (0 != numeric_search)
-				{
-					for (i = 0; i < values.values_num; i++)
-						count_one_dbl(&count, op, values.values[i].value.dbl, arg2_dbl);
-				}
-				else
-				{
+					break;
+				case ITEM_VALUE_TYPE_FLOAT:
 					for (i = 0; i < values.values_num && FAIL != count; i++)
 					{
 						zbx_snprintf(buf, sizeof(buf), ZBX_FS_DBL_EXT(4),
 								values.values[i].value.dbl);
 						count_one_str(&count, op, buf, arg2, &regexps);
 					}
-				}
-				break;
-			case ITEM_VALUE_TYPE_LOG:
-				for (i = 0; i < values.values_num && FAIL != count; i++)
-					count_one_str(&count, op, values.values[i].value.log->value, arg2, &regexps);
-				break;
-			default:
-				for (i = 0; i < values.values_num && FAIL != count; i++)
-					count_one_str(&count, op, values.values[i].value.str, arg2, &regexps);
-		}
+					break;
+				case ITEM_VALUE_TYPE_LOG:
+					for (i = 0; i < values.values_num && FAIL != count; i++)
+					{
+						count_one_str(&count, op, values.values[i].value.log->value, arg2,
+								&regexps);
+					}
+					break;
+				default:
+					for (i = 0; i < values.values_num && FAIL != count; i++)
+						count_one_str(&count, op, values.values[i].value.str, arg2, &regexps);
+			}
 
-		if (FAIL == count)
+			if (FAIL == count)
+			{
+				*error = zbx_strdup(*error, "invalid regular expression");
+				goto out;
+			}
+		}
+	}
+	else
+	{
+		if (SUCCEED != zbx_vc_get_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_COUNT, seconds,
+				nvalues, &ts_end, NULL, &cd.count) &&
+				FAIL == zbx_vc_iterate_values(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+				count_all, &cd))
 		{
-			*error = zbx_strdup(*error, "invalid regular expression");
+			*error = zbx_strdup(*error, "cannot get values from value cache");
 			goto out;
 		}
+
+		count = cd.count;
 	}
-	else
-		count = values.values_num;
 
 	zbx_snprintf_alloc(value, &value_alloc, &value_offset, "%d", count);
 
@@ -866,6 +921,99 @@ out:
 #undef OP_BAND
 #undef OP_MAX
 
+/******************************************************************************
+ *                                                                            *
+ * Function: aggregate_sum                                                    *
+ *                                                                            *
+ * Purpose: value cache iterator callback, summing numeric values             *
+ *                                                                            *
+ ******************************************************************************/
+static void	aggregate_sum(const zbx_history_record_t *value, int value_type, void *data)
+{
+	zbx_value_aggregate_t	*aggr = (zbx_value_aggregate_t *)data;
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		aggr->value.dbl += value->value.dbl;
+	else
+		aggr->value.ui64 += value->value.ui64;
+
+	aggr->values_num++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: aggregate_avg                                                    *
+ *                                                                            *
+ * Purpose: value cache iterator callback, calculating average of numeric     *
+ *          values                                                            *
+ *                                                                            *
+ * Comments: The average of float values is calculated incrementally to avoid *
+ *           overflow, while unsigned values are summed and the sum must be   *
+ *           divided by the number of values afterwards.                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	aggregate_avg(const zbx_history_record_t *value, int value_type, void *data)
+{
+	zbx_value_aggregate_t	*aggr = (zbx_value_aggregate_t *)data;
+
+	aggr->values_num++;
+
+	if (ITEM_VALUE_TYPE_FLOAT == value_type)
+		aggr->avg += value->value.dbl / aggr->values_num - aggr->avg / aggr->values_num;
+	else
+		aggr->avg += value->value.ui64;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: aggregate_min                                                    *
+ *                                                                            *
+ * Purpose: value cache iterator callback, finding the minimum numeric value  *
+ *                                                                            *
+ ******************************************************************************/
+static void	aggregate_min(const zbx_history_record_t *value, int value_type, void *data)
+{
+	zbx_value_aggregate_t	*aggr = (zbx_value_aggregate_t *)data;
+
+	if (0 == aggr->values_num++)
+		aggr->value = value->value;
+	else if (ITEM_VALUE_TYPE_UINT64 == value_type)
+	{
+		if (value->value.ui64 < aggr->value.ui64)
+			aggr->value.ui64 = value->value.ui64;
+	}
+	else
+	{
+		if (value->value.dbl < aggr->value.dbl)
+			aggr->value.dbl = value->value.dbl;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: aggregate_max                                                    *
+ *                                                                            *
+ * Purpose: value cache iterator callback, finding the maximum numeric value  *
+ *                                                                            *
+ ******************************************************************************/
+static void	aggregate_max(const zbx_history_record_t *value, int value_type, void *data)
+{
+	zbx_value_aggregate_t	*aggr = (zbx_value_aggregate_t *)data;
+
+	if (0 == aggr->values_num++)
+		aggr->value = value->value;
+	else if (ITEM_VALUE_TYPE_UINT64 == value_type)
+	{
+		if (value->value.ui64 > aggr->value.ui64)
+			aggr->value.ui64 = value->value.ui64;
+	}
+	else
+	{
+		if (value->value.dbl > aggr->value.dbl)
+			aggr->value.dbl = value->value.dbl;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: evaluate_SUM                                                     *
@@ -881,16 +1029,13 @@ out:
  ******************************************************************************/
 static int	evaluate_SUM(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, i, ret = FAIL, seconds = 0, nvalues = 0;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	history_value_t			result;
-	zbx_timespec_t			ts_end = *ts;
+	int			nparams, arg1, ret = FAIL, seconds = 0, nvalues = 0;
+	zbx_value_type_t	arg1_type;
+	zbx_value_aggregate_t	aggr = {0};
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -938,32 +1083,23 @@ static int	evaluate_SUM(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
-	{
-		*error = zbx_strdup(*error, "cannot get values from value cache");
-		goto out;
-	}
-
 	if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-	{
-		result.dbl = 0;
-
-		for (i = 0; i < values.values_num; i++)
-			result.dbl += values.values[i].value.dbl;
-	}
+		aggr.value.dbl = 0;
 	else
-	{
-		result.ui64 = 0;
+		aggr.value.ui64 = 0;
 
-		for (i = 0; i < values.values_num; i++)
-			result.ui64 += values.values[i].value.ui64;
+	if (SUCCEED != zbx_vc_get_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_SUM, seconds, nvalues,
+			&ts_end, &aggr.value, &aggr.values_num) &&
+			FAIL == zbx_vc_iterate_values(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+			aggregate_sum, &aggr))
+	{
+		*error = zbx_strdup(*error, "cannot get values from value cache");
+		goto out;
 	}
 
-	*value = zbx_history_value2str_dyn(&result, item->value_type);
+	*value = zbx_history_value2str_dyn(&aggr.value, item->value_type);
 	ret = SUCCEED;
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -984,15 +1120,14 @@ out:
  ******************************************************************************/
 static int	evaluate_AVG(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, ret = FAIL, i, seconds = 0, nvalues = 0;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			nparams, arg1, ret = FAIL, seconds = 0, nvalues = 0;
+	zbx_value_type_t	arg1_type;
+	zbx_value_aggregate_t	aggr = {0};
+	history_value_t		avg;
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1040,30 +1175,25 @@ static int	evaluate_AVG(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (SUCCEED == zbx_vc_get_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_AVG, seconds, nvalues,
+			&ts_end, &avg, &aggr.values_num))
+	{
+		aggr.avg = avg.dbl;
+	}
+	else if (FAIL == zbx_vc_iterate_values(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+			aggregate_avg, &aggr))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
+	else if (ITEM_VALUE_TYPE_UINT64 == item->value_type && 0 < aggr.values_num)
+		aggr.avg = aggr.avg / aggr.values_num;
 
-	if (0 < values.values_num)
+	if (0 < aggr.values_num)
 	{
-		double	avg = 0;
 		size_t	value_alloc = 0, value_offset = 0;
 
-		if (ITEM_VALUE_TYPE_FLOAT == item->value_type)
-		{
-			for (i = 0; i < values.values_num; i++)
-				avg += values.values[i].value.dbl / (i + 1) - avg / (i + 1);
-		}
-		else
-		{
-			for (i = 0; i < values.values_num; i++)
-				avg += values.values[i].value.ui64;
-
-			avg = avg / values.values_num;
-		}
-		zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_DBL64, avg);
+		zbx_snprintf_alloc(value, &value_alloc, &value_offset, ZBX_FS_DBL64, aggr.avg);
 
 		ret = SUCCEED;
 	}
@@ -1073,8 +1203,6 @@ static int	evaluate_AVG(char **value, DC_ITEM *item, const char *parameters, con
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1194,15 +1322,13 @@ out:
  ******************************************************************************/
 static int	evaluate_MIN(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, i, ret = FAIL, seconds = 0, nvalues = 0;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			nparams, arg1, ret = FAIL, seconds = 0, nvalues = 0;
+	zbx_value_type_t	arg1_type;
+	zbx_value_aggregate_t	aggr = {0};
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1250,34 +1376,18 @@ static int	evaluate_MIN(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (SUCCEED != zbx_vc_get_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_MIN, seconds, nvalues,
+			&ts_end, &aggr.value, &aggr.values_num) &&
+			FAIL == zbx_vc_iterate_values(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+			aggregate_min, &aggr))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < aggr.values_num)
 	{
-		int	index = 0;
-
-		if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
-		{
-			for (i = 1; i < values.values_num; i++)
-			{
-				if (values.values[i].value.ui64 < values.values[index].value.ui64)
-					index = i;
-			}
-		}
-		else
-		{
-			for (i = 1; i < values.values_num; i++)
-			{
-				if (values.values[i].value.dbl < values.values[index].value.dbl)
-					index = i;
-			}
-		}
-
-		*value = zbx_history_value2str_dyn(&values.values[index].value, item->value_type);
+		*value = zbx_history_value2str_dyn(&aggr.value, item->value_type);
 		ret = SUCCEED;
 	}
 	else
@@ -1286,8 +1396,6 @@ static int	evaluate_MIN(char **value, DC_ITEM *item, const char *parameters, con
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -1308,15 +1416,13 @@ out:
  ******************************************************************************/
 static int	evaluate_MAX(char **value, DC_ITEM *item, const char *parameters, const zbx_timespec_t *ts, char **error)
 {
-	int				nparams, arg1, ret = FAIL, i, seconds = 0, nvalues = 0;
-	zbx_value_type_t		arg1_type;
-	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts_end = *ts;
+	int			nparams, arg1, ret = FAIL, seconds = 0, nvalues = 0;
+	zbx_value_type_t	arg1_type;
+	zbx_value_aggregate_t	aggr = {0};
+	zbx_timespec_t		ts_end = *ts;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __func__);
 
-	zbx_history_record_vector_create(&values);
-
 	if (ITEM_VALUE_TYPE_FLOAT != item->value_type && ITEM_VALUE_TYPE_UINT64 != item->value_type)
 	{
 		*error = zbx_strdup(*error, "invalid value type");
@@ -1364,35 +1470,18 @@ static int	evaluate_MAX(char **value, DC_ITEM *item, const char *parameters, con
 			THIS_SHOULD_NEVER_HAPPEN;
 	}
 
-	if (FAIL == zbx_vc_get_values(item->itemid, item->value_type, &values, seconds, nvalues, &ts_end))
+	if (SUCCEED != zbx_vc_get_aggregate(item->itemid, item->value_type, ZBX_VC_AGGREGATE_MAX, seconds, nvalues,
+			&ts_end, &aggr.value, &aggr.values_num) &&
+			FAIL == zbx_vc_iterate_values(item->itemid, item->value_type, seconds, nvalues, &ts_end,
+			aggregate_max, &aggr))
 	{
 		*error = zbx_strdup(*error, "cannot get values from value cache");
 		goto out;
 	}
 
-	if (0 < values.values_num)
+	if (0 < aggr.values_num)
 	{
-		int	index = 0;
-
-		if (ITEM_VALUE_TYPE_UINT64 == item->value_type)
-		{
-			for (i = 1; i < values.values_num; i++)
-			{
-				if (values.values[i].value.ui64 > values.values[index].value.ui64)
-					index = i;
-			}
-		}
-		else
-		{
-			for (i = 1; i < values.values_num; i++)
-			{
-				if (values.values[i].value.dbl > values.values[index].value.dbl)
-					index = i;
-			}
-		}
-
-		*value = zbx_history_value2str_dyn(&values.values[index].value, item->value_type);
-
+		*value = zbx_history_value2str_dyn(&aggr.value, item->value_type);
 		ret = SUCCEED;
 	}
 	else
@@ -1401,8 +1490,6 @@ static int	evaluate_MAX(char **value, DC_ITEM *item, const char *parameters, con
 		*error = zbx_strdup(*error, "not enough data");
 	}
 out:
-	zbx_history_record_vector_destroy(&values, item->value_type);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __func__, zbx_result_string(ret));
 
 	return ret;
@@ -3440,3 +3527,78 @@ int	evaluatable_for_notsupported(const char *fn)
 
 	return FAIL;
 }
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_function_period                                              *
+ *                                                                            *
+ * Purpose: gets time based history period requested by function             *
+ *                                                                            *
+ * Parameters: item       - [IN] item (performance metric)                    *
+ *             function   - [IN] function name                                *
+ *             parameters - [IN] function parameters                          *
+ *             ts         - [IN] the function evaluation time                 *
+ *             seconds    - [OUT] the period length                           *
+ *             end        - [OUT] the period end timestamp                    *
+ *                                                                            *
+ * Return value: SUCCEED - the function requests item values for the returned *
+ *                         period                                             *
+ *               FAIL    - the function does not request a time based period  *
+ *                         or the parameters are invalid                      *
+ *                                                                            *
+ * Comments: Is used to prefetch history of the evaluated functions, so only  *
+ *           the functions aggregating time based periods are recognized.     *
+ *                                                                            *
+ ******************************************************************************/
+int	get_function_period(const DC_ITEM *item, const char *function, const char *parameters,
+		const zbx_timespec_t *ts, int *seconds, zbx_timespec_t *end)
+{
+	static const struct
+	{
+		const char	*name;
+		/* the time shift parameter index */
+		int		time_shift;
+	}
+	functions[] = {
+		{"avg", 2}, {"min", 2}, {"max", 2}, {"sum", 2}, {"delta", 2}, {"percentile", 2},
+		{"forecast", 2}, {"timeleft", 2}, {"count", 4}, {NULL, 0}
+	};
+
+	int			i, arg1, time_shift = 0;
+	zbx_value_type_t	arg1_type, time_shift_type = ZBX_VALUE_SECONDS;
+
+	for (i = 0; NULL != functions[i].name; i++)
+	{
+		if (0 == strcmp(functions[i].name, function))
+			break;
+	}
+
+	if (NULL == functions[i].name)
+		return FAIL;
+
+	/* only count() function supports non-numeric items */
+	if (0 != strcmp(function, "count") && ITEM_VALUE_TYPE_FLOAT != item->value_type &&
+			ITEM_VALUE_TYPE_UINT64 != item->value_type)
+	{
+		return FAIL;
+	}
+
+	if (SUCCEED != get_function_parameter_int(item->host.hostid, parameters, 1, ZBX_PARAM_MANDATORY, &arg1,
+			&arg1_type) || ZBX_VALUE_SECONDS != arg1_type || 0 >= arg1)
+	{
+		return FAIL;
+	}
+
+	if (functions[i].time_shift <= num_param(parameters) && (SUCCEED != get_function_parameter_int(
+			item->host.hostid, parameters, functions[i].time_shift, ZBX_PARAM_OPTIONAL, &time_shift,
+			&time_shift_type) || ZBX_VALUE_SECONDS != time_shift_type || 0 > time_shift))
+	{
+		return FAIL;
+	}
+
+	*seconds = arg1;
+	*end = *ts;
+	end->sec -= time_shift;
+
+	return SUCCEED;
+}
@@ -23,5 +23,7 @@
 int	evaluate_macro_function(char **result, const char *host, const char *key, const char *function,
 		const char *parameter);
 int	evaluatable_for_notsupported(const char *fn);
+int	get_function_period(const DC_ITEM *item, const char *function, const char *parameters,
+		const zbx_timespec_t *ts, int *seconds, zbx_timespec_t *end);
 
 #endif
@@ -4958,6 +4958,59 @@ static void	zbx_populate_function_items(const zbx_vector_uint64_t *functionids,
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() ifuncs_num:%d", __func__, ifuncs->num_data);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_prefetch_item_values                                         *
+ *                                                                            *
+ * Purpose: caches history periods requested by the functions to be evaluated *
+ *          with batched history requests                                     *
+ *                                                                            *
+ * Parameters: funcs    - [IN] the functions to evaluate                      *
+ *             itemids  - [IN] the sorted function itemids                    *
+ *             items    - [IN] the function items                             *
+ *             errcodes - [IN] the function item error codes                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_prefetch_item_values(zbx_hashset_t *funcs, const zbx_vector_uint64_t *itemids,
+		const DC_ITEM *items, const int *errcodes)
+{
+	zbx_func_t			*func;
+	zbx_hashset_iter_t		iter;
+	zbx_vector_vc_prefetch_t	requests;
+	zbx_vc_prefetch_t		request;
+	int				i;
+
+	zbx_vector_vc_prefetch_create(&requests);
+
+	zbx_hashset_iter_reset(funcs, &iter);
+	while (NULL != (func = (zbx_func_t *)zbx_hashset_iter_next(&iter)))
+	{
+		i = zbx_vector_uint64_bsearch(itemids, func->itemid, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+		if (SUCCEED != errcodes[i] || ITEM_STATUS_ACTIVE != items[i].status ||
+				HOST_STATUS_MONITORED != items[i].host.status ||
+				ITEM_STATE_NOTSUPPORTED == items[i].state)
+		{
+			continue;
+		}
+
+		if (SUCCEED != get_function_period(&items[i], func->function, func->parameter, &func->timespec,
+				&request.seconds, &request.ts))
+		{
+			continue;
+		}
+
+		request.itemid = items[i].itemid;
+		request.value_type = items[i].value_type;
+		zbx_vector_vc_prefetch_append(&requests, request);
+	}
+
+	if (1 < requests.values_num)
+		zbx_vc_prefetch_values(&requests);
+
+	zbx_vector_vc_prefetch_destroy(&requests);
+}
+
 static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *unknown_msgs)
 {
 	DC_ITEM			*items = NULL;
@@ -4985,6 +5038,8 @@ static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *
 
 	DCconfig_get_items_by_itemids(items, itemids.values, errcodes, itemids.values_num);
 
+	zbx_prefetch_item_values(funcs, &itemids, items, errcodes);
+
 	zbx_hashset_iter_reset(funcs, &iter);
 	while (NULL != (func = (zbx_func_t *)zbx_hashset_iter_next(&iter)))
 	{
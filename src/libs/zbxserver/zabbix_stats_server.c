@@ -77,7 +77,14 @@ void	zbx_get_zabbix_stats_ext(struct zbx_json *json)
 		zbx_json_adduint64(json, "requests", vc_stats.hits + vc_stats.misses);
 		zbx_json_adduint64(json, "hits", vc_stats.hits);
 		zbx_json_adduint64(json, "misses", vc_stats.misses);
+		zbx_json_addfloat(json, "phits", 0 == vc_stats.hits + vc_stats.misses ? 0 :
+				(double)vc_stats.hits / (vc_stats.hits + vc_stats.misses) * 100);
 		zbx_json_adduint64(json, "mode", vc_stats.mode);
+		zbx_json_adduint64(json, "recent_items", vc_stats.recent_items);
+		zbx_json_adduint64(json, "recent_hits", vc_stats.recent_hits);
+		zbx_json_adduint64(json, "frequent_items", vc_stats.frequent_items);
+		zbx_json_adduint64(json, "frequent_hits", vc_stats.frequent_hits);
+		zbx_json_adduint64(json, "evictions", vc_stats.evictions);
 		zbx_json_close(json);
 
 		zbx_json_close(json);
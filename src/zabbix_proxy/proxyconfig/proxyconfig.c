@@ -31,6 +31,9 @@
 #define CONFIG_PROXYCONFIG_RETRY	120	/* seconds */
 
 extern unsigned char	process_type, program_type;
+extern int		CONFIG_CONFSYNCER_THREADS;
+extern char		*CONFIG_CONF_CACHE_SNAPSHOT_FILE;
+extern int		CONFIG_CONF_CACHE_SNAPSHOT_FREQUENCY;
 extern int		server_num, process_num;
 
 static void	zbx_proxyconfig_sigusr_handler(int flags)
@@ -42,6 +45,8 @@ static void	zbx_proxyconfig_sigusr_handler(int flags)
 			zabbix_log(LOG_LEVEL_WARNING, "forced reloading of the configuration cache");
 			zbx_wakeup();
 		}
+		else if (SUCCEED == DCconfig_compact_interrupt())
+			zabbix_log(LOG_LEVEL_WARNING, "forced reloading of the configuration cache");
 		else
 			zabbix_log(LOG_LEVEL_WARNING, "configuration cache reloading is already in progress");
 	}
@@ -137,6 +142,7 @@ ZBX_THREAD_ENTRY(proxyconfig_thread, args)
 {
 	size_t	data_size;
 	double	sec;
+	time_t	snapshot_time = 0;
 
 	process_type = ((zbx_thread_args_t *)args)->process_type;
 	server_num = ((zbx_thread_args_t *)args)->server_num;
@@ -152,9 +158,18 @@ ZBX_THREAD_ENTRY(proxyconfig_thread, args)
 	zbx_setproctitle("%s [connecting to the database]", get_process_type_string(process_type));
 
 	DBconnect(ZBX_DB_CONNECT_NORMAL);
+	DCsync_configuration_start_workers(CONFIG_CONFSYNCER_THREADS);
 
 	zbx_setproctitle("%s [syncing configuration]", get_process_type_string(process_type));
-	DCsync_configuration(ZBX_DBSYNC_INIT);
+
+	/* the snapshot just loaded is written again only after the configured period */
+	if (NULL != CONFIG_CONF_CACHE_SNAPSHOT_FILE &&
+			SUCCEED == DCconfig_snapshot_load(CONFIG_CONF_CACHE_SNAPSHOT_FILE))
+	{
+		snapshot_time = time(NULL) + CONFIG_CONF_CACHE_SNAPSHOT_FREQUENCY;
+	}
+	else
+		DCsync_configuration(ZBX_DBSYNC_INIT);
 
 	while (ZBX_IS_RUNNING())
 	{
@@ -170,7 +185,25 @@ ZBX_THREAD_ENTRY(proxyconfig_thread, args)
 				get_process_type_string(process_type), (zbx_fs_size_t)data_size, sec,
 				CONFIG_PROXYCONFIG_FREQUENCY);
 
-		zbx_sleep_loop(CONFIG_PROXYCONFIG_FREQUENCY);
+		sec = zbx_time();
+
+		if (NULL != CONFIG_CONF_CACHE_SNAPSHOT_FILE && snapshot_time <= (time_t)sec)
+		{
+			zbx_setproctitle("%s [writing configuration cache snapshot]",
+					get_process_type_string(process_type));
+
+			DCconfig_snapshot_write(CONFIG_CONF_CACHE_SNAPSHOT_FILE);
+			snapshot_time = (time_t)sec + CONFIG_CONF_CACHE_SNAPSHOT_FREQUENCY;
+
+			zbx_setproctitle("%s [synced config " ZBX_FS_SIZE_T " bytes, idle %d sec]",
+					get_process_type_string(process_type), (zbx_fs_size_t)data_size,
+					CONFIG_PROXYCONFIG_FREQUENCY);
+		}
+
+		/* use idle time to reduce configuration cache fragmentation, skipping the rest of */
+		/* idle time if compaction was interrupted by shutdown or forced reload            */
+		if (SUCCEED == DCconfig_compact(CONFIG_PROXYCONFIG_FREQUENCY / 2))
+			zbx_sleep_loop(CONFIG_PROXYCONFIG_FREQUENCY - (int)(zbx_time() - sec));
 	}
 
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
@@ -27,6 +27,9 @@
 #include "dbcache.h"
 
 extern int		CONFIG_CONFSYNCER_FREQUENCY;
+extern int		CONFIG_CONFSYNCER_THREADS;
+extern char		*CONFIG_CONF_CACHE_SNAPSHOT_FILE;
+extern int		CONFIG_CONF_CACHE_SNAPSHOT_FREQUENCY;
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 
@@ -39,6 +42,8 @@ static void	zbx_dbconfig_sigusr_handler(int flags)
 			zabbix_log(LOG_LEVEL_WARNING, "forced reloading of the configuration cache");
 			zbx_wakeup();
 		}
+		else if (SUCCEED == DCconfig_compact_interrupt())
+			zabbix_log(LOG_LEVEL_WARNING, "forced reloading of the configuration cache");
 		else
 			zabbix_log(LOG_LEVEL_WARNING, "configuration cache reloading is already in progress");
 	}
@@ -62,6 +67,7 @@ static void	zbx_dbconfig_sigusr_handler(int flags)
 ZBX_THREAD_ENTRY(dbconfig_thread, args)
 {
 	double	sec = 0.0;
+	time_t	snapshot_time = 0;
 
 	process_type = ((zbx_thread_args_t *)args)->process_type;
 	server_num = ((zbx_thread_args_t *)args)->server_num;
@@ -71,16 +77,27 @@ ZBX_THREAD_ENTRY(dbconfig_thread, args)
 			server_num, get_process_type_string(process_type), process_num);
 
 	update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+	dc_attach_history_cache(process_type, process_num);
 
 	zbx_set_sigusr_handler(zbx_dbconfig_sigusr_handler);
 
 	zbx_setproctitle("%s [connecting to the database]", get_process_type_string(process_type));
 
 	DBconnect(ZBX_DB_CONNECT_NORMAL);
+	DCsync_configuration_start_workers(CONFIG_CONFSYNCER_THREADS);
 
 	sec = zbx_time();
 	zbx_setproctitle("%s [syncing configuration]", get_process_type_string(process_type));
-	DCsync_configuration(ZBX_DBSYNC_INIT);
+
+	/* the snapshot just loaded is written again only after the configured period */
+	if (NULL != CONFIG_CONF_CACHE_SNAPSHOT_FILE &&
+			SUCCEED == DCconfig_snapshot_load(CONFIG_CONF_CACHE_SNAPSHOT_FILE))
+	{
+		snapshot_time = time(NULL) + CONFIG_CONF_CACHE_SNAPSHOT_FREQUENCY;
+	}
+	else
+		DCsync_configuration(ZBX_DBSYNC_INIT);
+
 	zbx_setproctitle("%s [synced configuration in " ZBX_FS_DBL " sec, idle %d sec]",
 			get_process_type_string(process_type), (sec = zbx_time() - sec), CONFIG_CONFSYNCER_FREQUENCY);
 	zbx_sleep_loop(CONFIG_CONFSYNCER_FREQUENCY);
@@ -100,7 +117,24 @@ ZBX_THREAD_ENTRY(dbconfig_thread, args)
 		zbx_setproctitle("%s [synced configuration in " ZBX_FS_DBL " sec, idle %d sec]",
 				get_process_type_string(process_type), sec, CONFIG_CONFSYNCER_FREQUENCY);
 
-		zbx_sleep_loop(CONFIG_CONFSYNCER_FREQUENCY);
+		sec = zbx_time();
+
+		if (NULL != CONFIG_CONF_CACHE_SNAPSHOT_FILE && snapshot_time <= (time_t)sec)
+		{
+			zbx_setproctitle("%s [writing configuration cache snapshot]",
+					get_process_type_string(process_type));
+
+			DCconfig_snapshot_write(CONFIG_CONF_CACHE_SNAPSHOT_FILE);
+			snapshot_time = (time_t)sec + CONFIG_CONF_CACHE_SNAPSHOT_FREQUENCY;
+
+			zbx_setproctitle("%s [synced configuration, idle %d sec]", get_process_type_string(process_type),
+					CONFIG_CONFSYNCER_FREQUENCY);
+		}
+
+		/* use idle time to reduce configuration cache fragmentation, skipping the rest of */
+		/* idle time if compaction was interrupted by shutdown or forced reload            */
+		if (SUCCEED == DCconfig_compact(CONFIG_CONFSYNCER_FREQUENCY / 2))
+			zbx_sleep_loop(CONFIG_CONFSYNCER_FREQUENCY - (int)(zbx_time() - sec));
 	}
 
 	zbx_setproctitle("%s #%d [terminated]", get_process_type_string(process_type), process_num);
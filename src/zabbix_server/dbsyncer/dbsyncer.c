@@ -81,8 +81,9 @@ static	void	unblock_signals(void)
  ******************************************************************************/
 ZBX_THREAD_ENTRY(dbsyncer_thread, args)
 {
-	int		sleeptime = -1, total_values_num = 0, values_num, more, total_triggers_num = 0, triggers_num;
-	double		sec, total_sec = 0.0;
+	int		sleeptime = -1, total_values_num = 0, values_num, more, total_triggers_num = 0, triggers_num,
+			total_hosts_num = 0, hosts_num, total_coalesced_num = 0, coalesced_num;
+	double		sec, total_sec = 0.0, last_availability_sec = 0.0;
 	time_t		last_stat_time;
 	char		*stats = NULL;
 	const char	*process_name;
@@ -96,9 +97,12 @@ ZBX_THREAD_ENTRY(dbsyncer_thread, args)
 			(process_name = get_process_type_string(process_type)), process_num);
 
 	update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+	dc_attach_history_cache(process_type, process_num);
 
 #define STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not faster than */
 				/* once in STAT_INTERVAL seconds */
+#define AVAILABILITY_FLUSH_INTERVAL	1	/* queued host availability changes are written not faster */
+						/* than once in AVAILABILITY_FLUSH_INTERVAL seconds        */
 
 	zbx_setproctitle("%s #%d [connecting to the database]", process_name, process_num);
 	last_stat_time = time(NULL);
@@ -134,10 +138,22 @@ ZBX_THREAD_ENTRY(dbsyncer_thread, args)
 		/* database APIs might not handle signals correctly and hang, block signals to avoid hanging */
 		block_signals();
 		zbx_sync_history_cache(&values_num, &triggers_num, &more);
+
+		/* host availability changes are flushed by single process to keep database updates in order */
+		if (1 == process_num && (AVAILABILITY_FLUSH_INTERVAL <= sec - last_availability_sec ||
+				!ZBX_IS_RUNNING()))
+		{
+			DCflush_hosts_availability(&hosts_num, &coalesced_num);
+			last_availability_sec = sec;
+		}
+		else
+			hosts_num = coalesced_num = 0;
 		unblock_signals();
 
 		total_values_num += values_num;
 		total_triggers_num += triggers_num;
+		total_hosts_num += hosts_num;
+		total_coalesced_num += coalesced_num;
 		total_sec += zbx_time() - sec;
 
 		sleeptime = (ZBX_SYNC_MORE == more ? 0 : CONFIG_HISTSYNCER_FREQUENCY);
@@ -153,6 +169,13 @@ ZBX_THREAD_ENTRY(dbsyncer_thread, args)
 						total_triggers_num);
 			}
 
+			if (0 != total_hosts_num)
+			{
+				zbx_snprintf_alloc(&stats, &stats_alloc, &stats_offset,
+						", %d host availability updates (%d coalesced)", total_hosts_num,
+						total_coalesced_num);
+			}
+
 			zbx_snprintf_alloc(&stats, &stats_alloc, &stats_offset, " in " ZBX_FS_DBL " sec", total_sec);
 
 			if (0 == sleeptime)
@@ -162,6 +185,8 @@ ZBX_THREAD_ENTRY(dbsyncer_thread, args)
 
 			total_values_num = 0;
 			total_triggers_num = 0;
+			total_hosts_num = 0;
+			total_coalesced_num = 0;
 			total_sec = 0.0;
 			last_stat_time = time(NULL);
 		}
@@ -181,4 +206,5 @@ ZBX_THREAD_ENTRY(dbsyncer_thread, args)
 	DBclose();
 	exit(EXIT_SUCCESS);
 #undef STAT_INTERVAL
+#undef AVAILABILITY_FLUSH_INTERVAL
 }
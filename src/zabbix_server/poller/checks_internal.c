@@ -655,6 +655,24 @@ int	get_value_internal(const DC_ITEM *item, AGENT_RESULT *result)
 				goto out;
 			}
 		}
+		else if (0 == strcmp(tmp, "availability"))
+		{
+			if (NULL == tmp1 || '\0' == *tmp1 || 0 == strcmp(tmp1, "written"))
+			{
+				SET_UI64_RESULT(result,
+						*(zbx_uint64_t *)DCconfig_get_stats(ZBX_CONFSTATS_AVAILABILITY_WRITTEN));
+			}
+			else if (0 == strcmp(tmp1, "coalesced"))
+			{
+				SET_UI64_RESULT(result,
+						*(zbx_uint64_t *)DCconfig_get_stats(ZBX_CONFSTATS_AVAILABILITY_COALESCED));
+			}
+			else
+			{
+				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
+				goto out;
+			}
+		}
 		else
 		{
 			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
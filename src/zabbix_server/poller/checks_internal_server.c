@@ -174,8 +174,23 @@ int	zbx_get_value_internal_ext(const char *param1, const AGENT_REQUEST *request,
 				SET_UI64_RESULT(result, stats.hits + stats.misses);
 			else if (0 == strcmp(param3, "misses"))
 				SET_UI64_RESULT(result, stats.misses);
+			else if (0 == strcmp(param3, "phits"))
+			{
+				SET_DBL_RESULT(result, 0 == stats.hits + stats.misses ? 0 :
+						(double)stats.hits / (stats.hits + stats.misses) * 100);
+			}
 			else if (0 == strcmp(param3, "mode"))
 				SET_UI64_RESULT(result, stats.mode);
+			else if (0 == strcmp(param3, "recent_items"))
+				SET_UI64_RESULT(result, stats.recent_items);
+			else if (0 == strcmp(param3, "recent_hits"))
+				SET_UI64_RESULT(result, stats.recent_hits);
+			else if (0 == strcmp(param3, "frequent_items"))
+				SET_UI64_RESULT(result, stats.frequent_items);
+			else if (0 == strcmp(param3, "frequent_hits"))
+				SET_UI64_RESULT(result, stats.frequent_hits);
+			else if (0 == strcmp(param3, "evictions"))
+				SET_UI64_RESULT(result, stats.evictions);
 			else
 			{
 				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
@@ -52,37 +52,6 @@ extern int		server_num, process_num;
 static volatile sig_atomic_t	snmp_cache_reload_requested;
 #endif
 
-/******************************************************************************
- *                                                                            *
- * Function: db_host_update_availability                                      *
- *                                                                            *
- * Purpose: write host availability changes into database                     *
- *                                                                            *
- * Parameters: ha    - [IN] the host availability data                        *
- *                                                                            *
- * Return value: SUCCEED - the availability changes were written into db      *
- *               FAIL    - no changes in availability data were detected      *
- *                                                                            *
- ******************************************************************************/
-static int	db_host_update_availability(const zbx_host_availability_t *ha)
-{
-	char	*sql = NULL;
-	size_t	sql_alloc = 0, sql_offset = 0;
-
-	if (SUCCEED == zbx_sql_add_host_availability(&sql, &sql_alloc, &sql_offset, ha))
-	{
-		DBbegin();
-		DBexecute("%s", sql);
-		DBcommit();
-
-		zbx_free(sql);
-
-		return SUCCEED;
-	}
-
-	return FAIL;
-}
-
 /******************************************************************************
  *                                                                            *
  * Function: host_get_availability                                            *
@@ -248,9 +217,6 @@ void	zbx_activate_item_host(DC_ITEM *item, zbx_timespec_t *ts)
 	if (FAIL == DChost_activate(item->host.hostid, agent_type, ts, &in.agents[agent_type], &out.agents[agent_type]))
 		goto out;
 
-	if (FAIL == db_host_update_availability(&out))
-		goto out;
-
 	host_set_availability(&item->host, agent_type, &out);
 
 	if (HOST_AVAILABLE_TRUE == in.agents[agent_type].available)
@@ -293,9 +259,6 @@ void	zbx_deactivate_item_host(DC_ITEM *item, zbx_timespec_t *ts, const char *err
 		goto out;
 	}
 
-	if (FAIL == db_host_update_availability(&out))
-		goto out;
-
 	host_set_availability(&item->host, agent_type, &out);
 
 	if (0 == in.agents[agent_type].errors_from)
@@ -1214,6 +1214,7 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 			server_num, get_process_type_string(process_type), process_num);
 
 	update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+	dc_attach_history_cache(process_type, process_num);
 
 	if (FAIL == zbx_ipc_service_start(&service, ZBX_IPC_SERVICE_PREPROCESSING, &error))
 	{
@@ -31,6 +31,7 @@
 #include "log.h"
 #include "zbxgetopt.h"
 #include "mutexs.h"
+#include "memalloc.h"
 
 #include "sysinfo.h"
 #include "zbxmodules.h"
@@ -202,6 +203,9 @@ int	CONFIG_HISTSYNCER_FORKS		= 4;
 int	CONFIG_HISTSYNCER_FREQUENCY	= 1;
 int	CONFIG_CONFSYNCER_FORKS		= 1;
 int	CONFIG_CONFSYNCER_FREQUENCY	= 60;
+int	CONFIG_CONFSYNCER_THREADS	= 0;
+char	*CONFIG_CONF_CACHE_SNAPSHOT_FILE	= NULL;
+int	CONFIG_CONF_CACHE_SNAPSHOT_FREQUENCY	= SEC_PER_HOUR;
 
 int	CONFIG_VMWARE_FORKS		= 0;
 int	CONFIG_VMWARE_FREQUENCY		= 60;
@@ -209,13 +213,16 @@ int	CONFIG_VMWARE_PERF_FREQUENCY	= 60;
 int	CONFIG_VMWARE_TIMEOUT		= 10;
 
 zbx_uint64_t	CONFIG_CONF_CACHE_SIZE		= 8 * ZBX_MEBIBYTE;
+int		CONFIG_ITEM_QUEUE_TIMER_WHEEL	= 0;
 zbx_uint64_t	CONFIG_HISTORY_CACHE_SIZE	= 16 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
+zbx_uint64_t	CONFIG_HISTORY_CACHE_OVERFLOW_SIZE	= ZBX_GIBIBYTE;
 zbx_uint64_t	CONFIG_TRENDS_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 8 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_EXPORT_FILE_SIZE		= ZBX_GIBIBYTE;
 
+int	CONFIG_SHM_HUGE_PAGES		= 0;
 int	CONFIG_UNREACHABLE_PERIOD	= 45;
 int	CONFIG_UNREACHABLE_DELAY	= 15;
 int	CONFIG_UNAVAILABLE_DELAY	= 60;
@@ -238,6 +245,9 @@ char	*CONFIG_DB_TLS_CA_FILE		= NULL;
 char	*CONFIG_DB_TLS_CIPHER		= NULL;
 char	*CONFIG_DB_TLS_CIPHER_13	= NULL;
 char	*CONFIG_EXPORT_DIR		= NULL;
+char	*CONFIG_HISTORY_CACHE_OVERFLOW_DIR	= NULL;
+char	*CONFIG_SHM_NUMA_POLICY		= NULL;
+char	*CONFIG_VALUE_CACHE_FILE	= NULL;
 int	CONFIG_DBPORT			= 0;
 int	CONFIG_ENABLE_REMOTE_COMMANDS	= 0;
 int	CONFIG_LOG_REMOTE_COMMANDS	= 0;
@@ -252,6 +262,8 @@ char	*CONFIG_SSH_KEY_LOCATION	= NULL;
 
 int	CONFIG_LOG_SLOW_QUERIES		= 0;	/* ms; 0 - disable */
 
+int	CONFIG_DB_PREPARED_STATEMENTS	= 1;	/* 0 - disable prepared statement caching */
+
 int	CONFIG_SERVER_STARTUP_TIME	= 0;	/* zabbix server startup time */
 
 int	CONFIG_PROXYPOLLER_FORKS	= 1;	/* parameters for passive proxies */
@@ -553,6 +565,13 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
+	if (NULL != CONFIG_SHM_NUMA_POLICY && SUCCEED != zbx_mem_validate_numa_policy(CONFIG_SHM_NUMA_POLICY))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "invalid \"SharedMemoryNUMAPolicy\" configuration parameter: '%s'",
+				CONFIG_SHM_NUMA_POLICY);
+		err = 1;
+	}
+
 	if (NULL != CONFIG_SOURCE_IP && SUCCEED != is_supported_ip(CONFIG_SOURCE_IP))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "invalid \"SourceIP\" configuration parameter: '%s'", CONFIG_SOURCE_IP);
@@ -667,16 +686,34 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			1},
 		{"CacheSize",			&CONFIG_CONF_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"ItemQueueTimerWheel",	&CONFIG_ITEM_QUEUE_TIMER_WHEEL,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"HistoryCacheSize",		&CONFIG_HISTORY_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&CONFIG_HISTORY_INDEX_CACHE_SIZE,	TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"HistoryCacheOverflowDir",	&CONFIG_HISTORY_CACHE_OVERFLOW_DIR,	TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"HistoryCacheOverflowSize",	&CONFIG_HISTORY_CACHE_OVERFLOW_SIZE,	TYPE_UINT64,
+			PARM_OPT,	16 * ZBX_MEBIBYTE,	__UINT64_C(1024) * ZBX_GIBIBYTE},
+		{"SharedMemoryHugePages",	&CONFIG_SHM_HUGE_PAGES,			TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"SharedMemoryNUMAPolicy",	&CONFIG_SHM_NUMA_POLICY,		TYPE_STRING,
+			PARM_OPT,	0,			0},
 		{"TrendCacheSize",		&CONFIG_TRENDS_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"ValueCacheSize",		&CONFIG_VALUE_CACHE_SIZE,		TYPE_UINT64,
 			PARM_OPT,	0,			__UINT64_C(64) * ZBX_GIBIBYTE},
+		{"ValueCacheFile",		&CONFIG_VALUE_CACHE_FILE,		TYPE_STRING,
+			PARM_OPT,	0,			0},
 		{"CacheUpdateFrequency",	&CONFIG_CONFSYNCER_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	1,			SEC_PER_HOUR},
+		{"CacheUpdateThreads",		&CONFIG_CONFSYNCER_THREADS,		TYPE_INT,
+			PARM_OPT,	0,			16},
+		{"CacheSnapshotFile",		&CONFIG_CONF_CACHE_SNAPSHOT_FILE,	TYPE_STRING,
+			PARM_OPT,	0,			0},
+		{"CacheSnapshotFrequency",	&CONFIG_CONF_CACHE_SNAPSHOT_FREQUENCY,	TYPE_INT,
+			PARM_OPT,	SEC_PER_MIN,		SEC_PER_DAY},
 		{"HousekeepingFrequency",	&CONFIG_HOUSEKEEPING_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	0,			24},
 		{"MaxHousekeeperDelete",	&CONFIG_MAX_HOUSEKEEPER_DELETE,		TYPE_INT,
@@ -747,6 +784,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"LogSlowQueries",		&CONFIG_LOG_SLOW_QUERIES,		TYPE_INT,
 			PARM_OPT,	0,			3600000},
+		{"DBPreparedStatements",	&CONFIG_DB_PREPARED_STATEMENTS,		TYPE_INT,
+			PARM_OPT,	0,			1},
 		{"StartProxyPollers",		&CONFIG_PROXYPOLLER_FORKS,		TYPE_INT,
 			PARM_OPT,	0,			250},
 		{"ProxyConfigFrequency",	&CONFIG_PROXYCONFIG_FREQUENCY,		TYPE_INT,
@@ -1195,7 +1234,7 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 				}
 
 				/* update maintenance states */
-				zbx_dc_update_maintenances();
+				zbx_dc_update_maintenances(NULL);
 
 				DBclose();
 
@@ -1339,6 +1378,10 @@ void	zbx_on_exit(int ret)
 
 	free_configuration_cache();
 
+	/* save history value cache after history cache is flushed, unless server is stopped because of failure */
+	if (SUCCEED == ret)
+		zbx_vc_save();
+
 	/* free history value cache */
 	zbx_vc_destroy();
 
@@ -508,8 +508,11 @@ cleanup:
  *                                                                            *
  * Purpose: update host maintenance parameters in cache and database          *
  *                                                                            *
+ * Parameters: modified_maintenanceids - [IN] the maintenances with changed   *
+ *                                       state, empty to check all hosts      *
+ *                                                                            *
  ******************************************************************************/
-static int	update_host_maintenances(void)
+static int	update_host_maintenances(const zbx_vector_uint64_t *modified_maintenanceids)
 {
 	zbx_vector_uint64_t	maintenanceids;
 	zbx_vector_ptr_t	updates;
@@ -529,7 +532,7 @@ static int	update_host_maintenances(void)
 
 		/* host maintenance update must be called even with no maintenances running */
 		/* to reset host maintenance status if necessary                            */
-		zbx_dc_get_host_maintenance_updates(&maintenanceids, &updates);
+		zbx_dc_get_host_maintenance_updates(&maintenanceids, modified_maintenanceids, &updates);
 
 		if (0 != updates.values_num)
 			db_update_host_maintenances(&updates);
@@ -557,10 +560,11 @@ static int	update_host_maintenances(void)
  ******************************************************************************/
 ZBX_THREAD_ENTRY(timer_thread, args)
 {
-	double		sec = 0.0;
-	int		maintenance_time = 0, update_time = 0, idle = 1, events_num, hosts_num, update;
-	char		*info = NULL;
-	size_t		info_alloc = 0, info_offset = 0;
+	double			sec = 0.0;
+	int			maintenance_time = 0, update_time = 0, idle = 1, events_num, hosts_num, update;
+	char			*info = NULL;
+	size_t			info_alloc = 0, info_offset = 0;
+	zbx_vector_uint64_t	modified_maintenanceids;
 
 	process_type = ((zbx_thread_args_t *)args)->process_type;
 	server_num = ((zbx_thread_args_t *)args)->server_num;
@@ -576,6 +580,8 @@ ZBX_THREAD_ENTRY(timer_thread, args)
 
 	DBconnect(ZBX_DB_CONNECT_NORMAL);
 
+	zbx_vector_uint64_create(&modified_maintenanceids);
+
 	while (ZBX_IS_RUNNING())
 	{
 		sec = zbx_time();
@@ -589,18 +595,23 @@ ZBX_THREAD_ENTRY(timer_thread, args)
 				zbx_setproctitle("%s #%d [%s, processing maintenances]",
 						get_process_type_string(process_type), process_num, info);
 
-				update = zbx_dc_update_maintenances();
+				update = zbx_dc_update_maintenances(&modified_maintenanceids);
 
 				/* force maintenance updates at server startup */
 				if (0 == maintenance_time)
+				{
 					update = SUCCEED;
+					zbx_vector_uint64_clear(&modified_maintenanceids);
+				}
 
 				/* update hosts if there are modified (stopped, started, changed) maintenances */
 				if (SUCCEED == update)
-					hosts_num = update_host_maintenances();
+					hosts_num = update_host_maintenances(&modified_maintenanceids);
 				else
 					hosts_num = 0;
 
+				zbx_vector_uint64_clear(&modified_maintenanceids);
+
 				db_remove_expired_event_suppress_data((int)sec);
 
 				if (SUCCEED == update)
@@ -1332,6 +1332,7 @@ ZBX_THREAD_ENTRY(trapper_thread, args)
 			server_num, get_process_type_string(process_type), process_num);
 
 	update_selfmon_counter(ZBX_PROCESS_STATE_BUSY);
+	dc_attach_history_cache(process_type, process_num);
 
 	memcpy(&s, (zbx_socket_t *)((zbx_thread_args_t *)args)->args, sizeof(zbx_socket_t));
 #ifdef HAVE_NETSNMP
@@ -0,0 +1,240 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "zbxalgo.h"
+
+typedef struct
+{
+	zbx_uint64_t	key;
+	int		time;
+	int		scheduled;
+}
+zbx_tw_test_elem_t;
+
+static void	read_keys(zbx_mock_handle_t hkeys, zbx_vector_uint64_t *keys)
+{
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	hkey;
+	zbx_uint64_t		key;
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hkeys, &hkey))))
+	{
+		if (ZBX_MOCK_SUCCESS != err || ZBX_MOCK_SUCCESS != (err = zbx_mock_uint64(hkey, &key)))
+			fail_msg("Cannot read key: %s", zbx_mock_error_string(err));
+
+		zbx_vector_uint64_append(keys, key);
+	}
+}
+
+static void	test_pop(zbx_timer_wheel_t *wheel, int now, zbx_mock_handle_t hkeys)
+{
+	zbx_vector_uint64_t	keys_expected, keys_returned;
+	const void		*data;
+	int			i;
+
+	zbx_vector_uint64_create(&keys_expected);
+	zbx_vector_uint64_create(&keys_returned);
+
+	read_keys(hkeys, &keys_expected);
+
+	/* the element data is set to its key */
+	while (NULL != (data = zbx_timer_wheel_pop(wheel, now)))
+		zbx_vector_uint64_append(&keys_returned, (zbx_uint64_t)(uintptr_t)data);
+
+	zbx_vector_uint64_sort(&keys_expected, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_uint64_sort(&keys_returned, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+
+	zbx_mock_assert_int_eq("number of due elements", keys_expected.values_num, keys_returned.values_num);
+
+	for (i = 0; i < keys_expected.values_num; i++)
+		zbx_mock_assert_uint64_eq("due element key", keys_expected.values[i], keys_returned.values[i]);
+
+	zbx_vector_uint64_destroy(&keys_returned);
+	zbx_vector_uint64_destroy(&keys_expected);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: test_random                                                      *
+ *                                                                            *
+ * Purpose: schedules, reschedules and removes random elements while          *
+ *          advancing timer wheel and checks the due elements against the     *
+ *          element schedule                                                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	test_random(zbx_timer_wheel_t *wheel, int elems_num, int range, int step, int iterations)
+{
+	zbx_tw_test_elem_t	*elems;
+	const void		*data;
+	int			i, j, now, next_time, min_time, scheduled_num = 0;
+
+	elems = (zbx_tw_test_elem_t *)zbx_malloc(NULL, sizeof(zbx_tw_test_elem_t) * elems_num);
+	now = wheel->time;
+
+	for (i = 0; i < elems_num; i++)
+	{
+		elems[i].key = i;
+		elems[i].scheduled = 0;
+	}
+
+	for (j = 0; j < iterations; j++)
+	{
+		/* schedule, reschedule or remove a part of elements */
+		for (i = 0; i < elems_num / 4; i++)
+		{
+			zbx_tw_test_elem_t	*elem = &elems[rand() % elems_num];
+
+			if (0 == rand() % 5)
+			{
+				zbx_mock_assert_int_eq("remove", 0 != elem->scheduled ? SUCCEED : FAIL,
+						zbx_timer_wheel_remove(wheel, elem->key));
+
+				if (0 != elem->scheduled)
+					scheduled_num--;
+
+				elem->scheduled = 0;
+				continue;
+			}
+
+			/* include times already passed by the wheel */
+			elem->time = now - 10 + rand() % range;
+			zbx_timer_wheel_insert(wheel, elem->key, (const void *)(uintptr_t)(elem->key + 1), elem->time);
+
+			if (0 == elem->scheduled)
+				scheduled_num++;
+
+			elem->scheduled = 1;
+		}
+
+		zbx_mock_assert_int_eq("number of elements", scheduled_num, zbx_timer_wheel_elems_num(wheel));
+
+		for (min_time = INT_MAX, i = 0; i < elems_num; i++)
+		{
+			if (0 != elems[i].scheduled && elems[i].time < min_time)
+				min_time = elems[i].time;
+		}
+
+		if (0 != scheduled_num)
+		{
+			next_time = zbx_timer_wheel_next_time(wheel);
+
+			if (next_time > min_time)
+				fail_msg("next time %d is later than the first element schedule %d", next_time, min_time);
+		}
+		else
+			zbx_mock_assert_int_eq("next time of empty wheel", FAIL, zbx_timer_wheel_next_time(wheel));
+
+		now += 1 + rand() % step;
+
+		while (NULL != (data = zbx_timer_wheel_pop(wheel, now)))
+		{
+			zbx_tw_test_elem_t	*elem = &elems[(uintptr_t)data - 1];
+
+			if (0 == elem->scheduled)
+				fail_msg("element " ZBX_FS_UI64 " was not scheduled", elem->key);
+
+			if (elem->time > now)
+				fail_msg("element " ZBX_FS_UI64 " scheduled at %d is due at %d", elem->key, elem->time, now);
+
+			elem->scheduled = 0;
+			scheduled_num--;
+		}
+
+		for (i = 0; i < elems_num; i++)
+		{
+			if (0 != elems[i].scheduled && elems[i].time <= now)
+			{
+				fail_msg("element " ZBX_FS_UI64 " scheduled at %d is not due at %d", elems[i].key,
+						elems[i].time, now);
+			}
+		}
+	}
+
+	zbx_free(elems);
+}
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_timer_wheel_t	wheel;
+	zbx_mock_error_t	err;
+	zbx_mock_handle_t	hops, hop;
+
+	ZBX_UNUSED(state);
+
+	zbx_timer_wheel_create(&wheel, (int)zbx_mock_get_parameter_uint64("in.time"));
+
+	hops = zbx_mock_get_parameter_handle("in.operations");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hops, &hop))))
+	{
+		const char	*op;
+
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read operation: %s", zbx_mock_error_string(err));
+
+		op = zbx_mock_get_object_member_string(hop, "op");
+
+		if (0 == strcmp(op, "insert"))
+		{
+			zbx_uint64_t	key;
+
+			key = zbx_mock_get_object_member_uint64(hop, "key");
+			zbx_timer_wheel_insert(&wheel, key, (const void *)(uintptr_t)key,
+					(int)zbx_mock_get_object_member_uint64(hop, "time"));
+		}
+		else if (0 == strcmp(op, "remove"))
+		{
+			zbx_mock_assert_result_eq("remove", zbx_mock_str_to_return_code(
+					zbx_mock_get_object_member_string(hop, "return")),
+					zbx_timer_wheel_remove(&wheel, zbx_mock_get_object_member_uint64(hop, "key")));
+		}
+		else if (0 == strcmp(op, "pop"))
+		{
+			test_pop(&wheel, (int)zbx_mock_get_object_member_uint64(hop, "now"),
+					zbx_mock_get_object_member_handle(hop, "keys"));
+		}
+		else if (0 == strcmp(op, "next"))
+		{
+			const char	*time;
+
+			time = zbx_mock_get_object_member_string(hop, "time");
+
+			zbx_mock_assert_int_eq("next time", 0 == strcmp(time, "FAIL") ? FAIL : atoi(time),
+					zbx_timer_wheel_next_time(&wheel));
+		}
+		else if (0 == strcmp(op, "random"))
+		{
+			srand((unsigned int)zbx_mock_get_object_member_uint64(hop, "seed"));
+
+			test_random(&wheel, (int)zbx_mock_get_object_member_uint64(hop, "elements"),
+					(int)zbx_mock_get_object_member_uint64(hop, "range"),
+					(int)zbx_mock_get_object_member_uint64(hop, "step"),
+					(int)zbx_mock_get_object_member_uint64(hop, "iterations"));
+		}
+		else
+			fail_msg("unknown operation \"%s\"", op);
+	}
+
+	zbx_timer_wheel_destroy(&wheel);
+}
@@ -29,3 +29,8 @@ int	dc_check_maintenance_period_test(const zbx_dc_maintenance_t *maintenance,
 {
 	return dc_check_maintenance_period(maintenance, period, now, running_since, running_until);
 }
+
+int	dc_calculate_maintenance_nextcheck_test(const zbx_dc_maintenance_t *maintenance, time_t now)
+{
+	return dc_calculate_maintenance_nextcheck(maintenance, now);
+}
@@ -0,0 +1,131 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "mutexs.h"
+#include "zbxalgo.h"
+#include "dbcache.h"
+#include "log.h"
+
+#define ZBX_DBCONFIG_IMPL
+#include "dbconfig.h"
+#include "dbconfig_maintenance_test.h"
+
+static int	get_time(const char *str)
+{
+	zbx_timespec_t	ts;
+
+	if (ZBX_MOCK_SUCCESS != zbx_strtime_to_timespec(str, &ts))
+		fail_msg("Invalid time format '%s'", str);
+
+	return ts.sec;
+}
+
+static zbx_timeperiod_type_t	get_period_type(const char *type)
+{
+	if (0 == strcmp(type, "onetime"))
+		return TIMEPERIOD_TYPE_ONETIME;
+	if (0 == strcmp(type, "daily"))
+		return TIMEPERIOD_TYPE_DAILY;
+	if (0 == strcmp(type, "weekly"))
+		return TIMEPERIOD_TYPE_WEEKLY;
+	if (0 == strcmp(type, "monthly"))
+		return TIMEPERIOD_TYPE_MONTHLY;
+
+	fail_msg("Invalid period type '%s'", type);
+
+	return TIMEPERIOD_TYPE_ONETIME;
+}
+
+static void	get_periods(zbx_vector_ptr_t *periods)
+{
+	zbx_mock_handle_t		hperiods, hperiod;
+	zbx_mock_error_t		err;
+	zbx_dc_maintenance_period_t	*period;
+
+	hperiods = zbx_mock_get_parameter_handle("in.periods");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (err = (zbx_mock_vector_element(hperiods, &hperiod))))
+	{
+		if (ZBX_MOCK_SUCCESS != err)
+			fail_msg("Cannot read period: %s", zbx_mock_error_string(err));
+
+		period = (zbx_dc_maintenance_period_t *)zbx_malloc(NULL, sizeof(zbx_dc_maintenance_period_t));
+		memset(period, 0, sizeof(zbx_dc_maintenance_period_t));
+
+		period->type = get_period_type(zbx_mock_get_object_member_string(hperiod, "type"));
+
+		if (TIMEPERIOD_TYPE_ONETIME == period->type)
+			period->start_date = get_time(zbx_mock_get_object_member_string(hperiod, "start_date"));
+		else
+			period->start_time = zbx_mock_get_object_member_uint64(hperiod, "start_time");
+
+		period->period = zbx_mock_get_object_member_uint64(hperiod, "period");
+
+		zbx_vector_ptr_append(periods, period);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mock_test_entry                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_dc_maintenance_t	maintenance;
+	int			nextcheck;
+
+	ZBX_UNUSED(state);
+
+	if (0 != setenv("TZ", zbx_mock_get_parameter_string("in.timezone"), 1))
+		fail_msg("Cannot set 'TZ' environment variable: %s", zbx_strerror(errno));
+
+	tzset();
+
+	memset(&maintenance, 0, sizeof(maintenance));
+	maintenance.active_since = get_time(zbx_mock_get_parameter_string("in.maintenance.active_since"));
+	maintenance.active_until = get_time(zbx_mock_get_parameter_string("in.maintenance.active_until"));
+
+	if (0 == strcmp(zbx_mock_get_parameter_string("in.maintenance.state"), "running"))
+	{
+		maintenance.state = ZBX_MAINTENANCE_RUNNING;
+		maintenance.running_until = get_time(zbx_mock_get_parameter_string("in.maintenance.running_until"));
+	}
+	else
+		maintenance.state = ZBX_MAINTENANCE_IDLE;
+
+	zbx_vector_ptr_create(&maintenance.periods);
+	get_periods(&maintenance.periods);
+
+	nextcheck = dc_calculate_maintenance_nextcheck_test(&maintenance,
+			get_time(zbx_mock_get_parameter_string("in.now")));
+
+	zbx_mock_assert_time_eq("maintenance next check", get_time(zbx_mock_get_parameter_string("out.nextcheck")),
+			nextcheck);
+
+	zbx_vector_ptr_clear_ext(&maintenance.periods, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&maintenance.periods);
+}
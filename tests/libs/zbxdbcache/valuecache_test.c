@@ -21,8 +21,13 @@
 
 void	zbx_vc_set_mode(int mode)
 {
-	vc_cache->mode = mode;
-	vc_cache->mode_time = time(NULL);
+	int	i;
+
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		vc_shards[i].cache->mode = mode;
+		vc_shards[i].cache->mode_time = time(NULL);
+	}
 }
 
 int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_vector_history_record_t *values)
@@ -31,6 +36,7 @@ int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_
 	int		i;
 	zbx_vc_chunk_t	*chunk;
 
+	vc_select_item_shard(itemid);
 	vc_try_lock();
 
 	if (NULL == (item = zbx_hashset_search(&vc_cache->items, &itemid)))
@@ -42,7 +48,7 @@ int	zbx_vc_get_cached_values(zbx_uint64_t itemid, unsigned char value_type, zbx_
 	for (chunk = item->tail; NULL != chunk; chunk = chunk->next)
 	{
 		for (i = chunk->first_value; i <= chunk->last_value; i++)
-			vc_history_record_vector_append(values, value_type, &chunk->slots[i]);
+			vc_history_record_vector_append(values, value_type, &vch_chunk_slots(chunk)[i]);
 	}
 
 	vc_try_unlock();
@@ -56,19 +62,17 @@ int	zbx_vc_precache_values(zbx_uint64_t itemid, int value_type, int seconds, int
 	int				ret;
 	zbx_vector_history_record_t	values;
 
+	vc_select_item_shard(itemid);
 	vc_try_lock();
 
 	/* add item to cache if necessary */
 	if (NULL == (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
-	{
-		zbx_vc_item_t   new_item = {.itemid = itemid, .value_type = value_type};
-		item = zbx_hashset_insert(&vc_cache->items, &new_item, sizeof(zbx_vc_item_t));
-	}
+		item = vc_add_item(itemid, value_type);
 
 	/* perform request to cache values */
 	vc_item_addref(item);
 	zbx_history_record_vector_create(&values);
-	ret = vch_item_get_values(item, &values, seconds, count, ts);
+	ret = vch_item_get_values(item, seconds, count, ts, vc_history_record_vector_append_func, &values);
 	zbx_history_record_vector_destroy(&values, value_type);
 	vc_item_release(item);
 
@@ -87,6 +91,7 @@ int	zbx_vc_get_item_state(zbx_uint64_t itemid, int *status, int *active_range, i
 	zbx_vc_item_t	*item;
 	int		ret = FAIL;
 
+	vc_select_item_shard(itemid);
 	vc_try_lock();
 
 	if (NULL != (item = (zbx_vc_item_t *)zbx_hashset_search(&vc_cache->items, &itemid)))
@@ -106,16 +111,28 @@ int	zbx_vc_get_item_state(zbx_uint64_t itemid, int *status, int *active_range, i
 
 int	zbx_vc_get_cache_state(int *mode, zbx_uint64_t *hits, zbx_uint64_t *misses)
 {
-	if (NULL == vc_cache)
+	int	i;
+
+	if (0 == vc_shards_num)
 		return FAIL;
 
-	vc_try_lock();
+	*mode = ZBX_VC_MODE_NORMAL;
+	*hits = 0;
+	*misses = 0;
 
-	*mode = vc_cache->mode;
-	*hits = vc_cache->hits;
-	*misses = vc_cache->misses;
+	for (i = 0; i < vc_shards_num; i++)
+	{
+		vc_select_shard(i);
+		vc_try_lock();
 
-	vc_try_unlock();
+		if (ZBX_VC_MODE_NORMAL != vc_cache->mode)
+			*mode = vc_cache->mode;
+
+		*hits += vc_cache->hits;
+		*misses += vc_cache->misses;
+
+		vc_try_unlock();
+	}
 
 	return SUCCEED;
 }
@@ -32,13 +32,16 @@
 
 static zbx_vector_ptr_t	macros;
 
+void	*__real_zbx_hashset_search(zbx_hashset_t *hs, const void *data);
+
 void	*__wrap_zbx_hashset_search(zbx_hashset_t *hs, const void *data)
 {
 	int			i;
 	const ZBX_DC_GMACRO_M	*query = (const ZBX_DC_GMACRO_M *)data;
 
+	/* only the global macro index is mocked, other hashsets (user macro cache) are real */
 	if (hs != &config->gmacros_m)
-		return NULL;
+		return NULL != hs->slots ? __real_zbx_hashset_search(hs, data) : NULL;
 
 	for (i = 0; i < macros.values_num; i++)
 	{
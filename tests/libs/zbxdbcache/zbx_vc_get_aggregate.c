@@ -0,0 +1,144 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "valuecache.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
+
+static int	vcmock_str_to_aggregate_func(const char *str)
+{
+	if (0 == strcmp(str, "sum"))
+		return ZBX_VC_AGGREGATE_SUM;
+
+	if (0 == strcmp(str, "avg"))
+		return ZBX_VC_AGGREGATE_AVG;
+
+	if (0 == strcmp(str, "min"))
+		return ZBX_VC_AGGREGATE_MIN;
+
+	if (0 == strcmp(str, "max"))
+		return ZBX_VC_AGGREGATE_MAX;
+
+	if (0 == strcmp(str, "count"))
+		return ZBX_VC_AGGREGATE_COUNT;
+
+	fail_msg("Unknown aggregate function \"%s\"", str);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mock_test_entry                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	int			err, seconds, count, func, values_num, step = 0;
+	char			*error, prefix[MAX_STRING_LEN];
+	const char		*data;
+	zbx_mock_handle_t	hsteps, hstep, hvalues, hresult;
+	zbx_mock_error_t	mock_err;
+	zbx_uint64_t		itemid, expected_ui64;
+	unsigned char		value_type;
+	zbx_timespec_t		ts;
+	history_value_t		value;
+
+	ZBX_UNUSED(state);
+
+	/* set small cache size to force smaller cache free request size (5% of cache size) */
+	CONFIG_VALUE_CACHE_SIZE = ZBX_KIBIBYTE;
+
+	err = zbx_vc_init(&error);
+	zbx_mock_assert_result_eq("Value cache initialization failed", SUCCEED, err);
+
+	zbx_vc_enable();
+
+	zbx_vcmock_ds_init();
+
+	hsteps = zbx_mock_get_parameter_handle("in.steps");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(hsteps, &hstep))))
+	{
+		if (ZBX_MOCK_SUCCESS != mock_err)
+			fail_msg("Cannot read step #%d: %s", step, zbx_mock_error_string(mock_err));
+
+		zbx_vcmock_set_time(hstep, "time");
+
+		/* add new values to cache */
+		if (ZBX_MOCK_SUCCESS == zbx_mock_object_member(hstep, "values", &hvalues))
+		{
+			zbx_vector_ptr_t	history;
+
+			zbx_vector_ptr_create(&history);
+			zbx_vcmock_get_dc_history(hvalues, &history);
+
+			err = zbx_vc_add_values(&history);
+			zbx_mock_assert_result_eq("zbx_vc_add_values()", SUCCEED, err);
+
+			zbx_vector_ptr_clear_ext(&history, zbx_vcmock_free_dc_history);
+			zbx_vector_ptr_destroy(&history);
+		}
+
+		zbx_vcmock_get_request_params(hstep, &itemid, &value_type, &seconds, &count, &ts);
+		func = vcmock_str_to_aggregate_func(zbx_mock_get_object_member_string(hstep, "function"));
+
+		zbx_snprintf(prefix, sizeof(prefix), "step #%d", step);
+
+		err = zbx_vc_get_aggregate(itemid, value_type, func, seconds, count, &ts, &value, &values_num);
+		zbx_mock_assert_result_eq(prefix, SUCCEED, err);
+
+		hresult = zbx_mock_get_object_member_handle(hstep, "result");
+
+		zbx_snprintf(prefix, sizeof(prefix), "step #%d values_num", step);
+		data = zbx_mock_get_object_member_string(hresult, "values_num");
+		zbx_mock_assert_int_eq(prefix, atoi(data), values_num);
+
+		if (ZBX_VC_AGGREGATE_COUNT != func && 0 != values_num)
+		{
+			zbx_snprintf(prefix, sizeof(prefix), "step #%d value", step);
+			data = zbx_mock_get_object_member_string(hresult, "value");
+
+			if (ITEM_VALUE_TYPE_FLOAT == value_type || ZBX_VC_AGGREGATE_AVG == func)
+			{
+				zbx_mock_assert_double_eq(prefix, atof(data), value.dbl);
+			}
+			else
+			{
+				ZBX_STR2UINT64(expected_ui64, data);
+				zbx_mock_assert_uint64_eq(prefix, expected_ui64, value.ui64);
+			}
+		}
+
+		step++;
+	}
+
+	zbx_vcmock_ds_destroy();
+
+	zbx_vc_reset();
+	zbx_vc_destroy();
+}
@@ -0,0 +1,148 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2020 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "valuecache.h"
+#include "valuecache_test.h"
+#include "mocks/valuecache/valuecache_mock.h"
+
+extern zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_mock_test_entry                                              *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_mock_test_entry(void **state)
+{
+	char				*error = NULL;
+	const char			*data;
+	int				err, seconds, count, item_status, item_active_range, item_db_cached_from,
+					item_values_total, cache_mode;
+	zbx_vector_history_record_t	expected, returned;
+	zbx_vector_vc_prefetch_t	requests;
+	zbx_vc_prefetch_t		request;
+	zbx_timespec_t			ts;
+	zbx_uint64_t			itemid, cache_hits, cache_misses, expected_misses;
+	unsigned char			value_type;
+	zbx_mock_handle_t		handle, hitems, hitem;
+	zbx_mock_error_t		mock_err;
+
+	ZBX_UNUSED(state);
+
+	/* set small cache size to force smaller cache free request size (5% of cache size) */
+	CONFIG_VALUE_CACHE_SIZE = ZBX_KIBIBYTE;
+
+	err = zbx_vc_init(&error);
+	zbx_mock_assert_result_eq("Value cache initialization failed", SUCCEED, err);
+
+	zbx_vc_enable();
+
+	zbx_vcmock_ds_init();
+	zbx_history_record_vector_create(&expected);
+	zbx_history_record_vector_create(&returned);
+	zbx_vector_vc_prefetch_create(&requests);
+
+	/* precache values */
+	if (ZBX_MOCK_SUCCESS == zbx_mock_parameter("in.precache", &handle))
+	{
+		while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(handle, &hitem))))
+		{
+			zbx_vcmock_set_time(hitem, "time");
+			zbx_vcmock_get_request_params(hitem, &itemid, &value_type, &seconds, &count, &ts);
+			zbx_vc_precache_values(itemid, value_type, seconds, count, &ts);
+		}
+	}
+
+	/* prefetch values */
+
+	zbx_vcmock_set_time(zbx_mock_get_parameter_handle("in"), "time");
+
+	handle = zbx_mock_get_parameter_handle("in.requests");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(handle, &hitem))))
+	{
+		zbx_vcmock_get_request_params(hitem, &request.itemid, &value_type, &request.seconds, &count,
+				&request.ts);
+		request.value_type = value_type;
+		zbx_vector_vc_prefetch_append(&requests, request);
+	}
+
+	zbx_vc_prefetch_values(&requests);
+
+	/* validate cache contents */
+
+	hitems = zbx_mock_get_parameter_handle("out.cache.items");
+
+	while (ZBX_MOCK_END_OF_VECTOR != (mock_err = (zbx_mock_vector_element(hitems, &hitem))))
+	{
+		data = zbx_mock_get_object_member_string(hitem, "itemid");
+		if (SUCCEED != is_uint64(data, &itemid))
+			fail_msg("Invalid itemid \"%s\"", data);
+
+		err = zbx_vc_get_item_state(itemid, &item_status, &item_active_range, &item_values_total,
+				&item_db_cached_from);
+		zbx_mock_assert_result_eq("zbx_vc_get_item_state() return value", SUCCEED, err);
+
+		data = zbx_mock_get_object_member_string(hitem, "values_total");
+		zbx_mock_assert_int_eq("item.values_total", atoi(data), item_values_total);
+
+		if (ZBX_MOCK_SUCCESS != (mock_err = zbx_strtime_to_timespec(
+				zbx_mock_get_object_member_string(hitem, "db_cached_from"), &ts)))
+		{
+			fail_msg("Cannot read out.item.db_cached_from timestamp: %s", zbx_mock_error_string(mock_err));
+		}
+
+		zbx_mock_assert_time_eq("item.db_cached_from", ts.sec, item_db_cached_from);
+
+		value_type = zbx_mock_str_to_value_type(zbx_mock_get_object_member_string(hitem, "value type"));
+
+		zbx_vcmock_read_values(zbx_mock_get_object_member_handle(hitem, "data"), value_type, &expected);
+		zbx_vc_get_cached_values(itemid, value_type, &returned);
+
+		zbx_vcmock_check_records("Cached values", value_type, &expected, &returned);
+
+		zbx_history_record_vector_clean(&expected, value_type);
+		zbx_history_record_vector_clean(&returned, value_type);
+	}
+
+	/* validate cache state */
+
+	zbx_vc_get_cache_state(&cache_mode, &cache_hits, &cache_misses);
+
+	if (FAIL == is_uint64(zbx_mock_get_parameter_string("out.cache.misses"), &expected_misses))
+		fail_msg("Invalid out.cache.misses value");
+	zbx_mock_assert_uint64_eq("cache.misses", expected_misses, cache_misses);
+
+	/* cleanup */
+
+	zbx_vector_vc_prefetch_destroy(&requests);
+	zbx_vector_history_record_destroy(&returned);
+	zbx_vector_history_record_destroy(&expected);
+
+	zbx_vcmock_ds_destroy();
+
+	zbx_vc_reset();
+	zbx_vc_destroy();
+}
@@ -51,6 +51,7 @@ void	__wrap___zbx_mem_free(const char *file, int line, zbx_mem_info_t *info, voi
 void	__wrap_zbx_mem_dump_stats(int level, zbx_mem_info_t *info);
 int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start, int count, int end,
 		zbx_vector_history_record_t *values);
+int	__wrap_zbx_history_get_values_multi(int value_type, zbx_vector_ptr_t *requests);
 int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history);
 int	__wrap_zbx_history_sql_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
 int	__wrap_zbx_history_elastic_init(zbx_history_iface_t *hist, unsigned char value_type, char **error);
@@ -502,23 +503,39 @@ void	zbx_vcmock_free_dc_history(void *ptr)
  * mock functions
  */
 
-static zbx_mutex_t	*vc_mutex = NULL;
+static zbx_mutex_t	*vc_mutexes[ZBX_MUTEX_COUNT];
+static int		vc_mutexes_num = 0;
 zbx_mem_info_t		*vc_meminfo = NULL;
 
 static size_t		vcmock_mem = ZBX_MEBIBYTE * 1024;
 
 int	__wrap_zbx_mutex_create(zbx_mutex_t *mutex, zbx_mutex_name_t name, char **error)
 {
-	vc_mutex = mutex;
 	ZBX_UNUSED(name);
 	ZBX_UNUSED(error);
 
+	if (ZBX_MUTEX_COUNT == vc_mutexes_num)
+		fail_msg("Too many mutexes created");
+
+	vc_mutexes[vc_mutexes_num++] = mutex;
+
 	return SUCCEED;
 }
 
 void	__wrap_zbx_mutex_destroy(zbx_mutex_t *mutex)
 {
-	zbx_mock_assert_ptr_eq("Attempting to destroy unknown mutex", vc_mutex, mutex);
+	int	i;
+
+	for (i = 0; i < vc_mutexes_num; i++)
+	{
+		if (vc_mutexes[i] == mutex)
+		{
+			vc_mutexes[i] = vc_mutexes[--vc_mutexes_num];
+			return;
+		}
+	}
+
+	fail_msg("Attempting to destroy unknown mutex");
 }
 
 int	__wrap_zbx_mem_create(zbx_mem_info_t **info, zbx_uint64_t size, const char *descr, const char *param,
@@ -635,6 +652,24 @@ int	__wrap_zbx_history_get_values(zbx_uint64_t itemid, int value_type, int start
 	return SUCCEED;
 }
 
+int	__wrap_zbx_history_get_values_multi(int value_type, zbx_vector_ptr_t *requests)
+{
+	int	i;
+
+	for (i = 0; i < requests->values_num; i++)
+	{
+		zbx_history_request_t	*request = (zbx_history_request_t *)requests->values[i];
+
+		if (0 != i && ((zbx_history_request_t *)requests->values[i - 1])->itemid >= request->itemid)
+			fail_msg("requests passed to zbx_history_get_values_multi function are not sorted by itemid");
+
+		__wrap_zbx_history_get_values(request->itemid, value_type, request->start, 0, request->end,
+				&request->values);
+	}
+
+	return SUCCEED;
+}
+
 int	__wrap_zbx_history_add_values(const zbx_vector_ptr_t *history)
 {
 	int			i;
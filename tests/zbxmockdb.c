@@ -69,6 +69,7 @@ struct zbx_db_result
 
 DB_RESULT	__fwd_zbx_db_select(const char *fmt, ...);
 DB_RESULT	__wrap_zbx_db_select_n(const char *query, int n);
+DB_RESULT	__wrap_zbx_db_select_prepared(const char *sql, int params_num, const char **params);
 int	__wrap___zbx_DBexecute(const char *fmt, ...);
 
 /* zbx_mockdb_t:queries hashset support */
@@ -198,6 +199,36 @@ DB_RESULT	__wrap_zbx_db_select_n(const char *query, int n)
 	return __fwd_zbx_db_select("%s limit %d", query, n);
 }
 
+DB_RESULT	__wrap_zbx_db_select_prepared(const char *sql, int params_num, const char **params)
+{
+	char		*text = NULL, *end;
+	size_t		text_alloc = 0, text_offset = 0;
+	const char	*ptr;
+	long		index;
+	DB_RESULT	result;
+
+	for (ptr = sql; '\0' != *ptr; ptr++)
+	{
+		if ('$' != *ptr || 0 == isdigit((unsigned char)ptr[1]))
+			continue;
+
+		if (1 > (index = strtol(ptr + 1, &end, 10)) || params_num < index)
+			fail_msg("Invalid parameter $%ld in SQL query: %s", index, sql);
+
+		zbx_strncpy_alloc(&text, &text_alloc, &text_offset, sql, (size_t)(ptr - sql));
+		zbx_strcpy_alloc(&text, &text_alloc, &text_offset, params[index - 1]);
+		sql = end;
+		ptr = end - 1;
+	}
+
+	zbx_strcpy_alloc(&text, &text_alloc, &text_offset, sql);
+
+	result = __fwd_zbx_db_select("%s", text);
+	zbx_free(text);
+
+	return result;
+}
+
 DB_ROW	__wrap_zbx_db_fetch(DB_RESULT result)
 {
 	zbx_mock_error_t	error;
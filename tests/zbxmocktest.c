@@ -73,13 +73,16 @@ int	CONFIG_VMWARE_PERF_FREQUENCY	= 60;
 int	CONFIG_VMWARE_TIMEOUT		= 10;
 
 zbx_uint64_t	CONFIG_CONF_CACHE_SIZE		= 8 * 0;
+int		CONFIG_ITEM_QUEUE_TIMER_WHEEL	= 0;
 zbx_uint64_t	CONFIG_HISTORY_CACHE_SIZE	= 16 * 0;
 zbx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE	= 4 * 0;
+zbx_uint64_t	CONFIG_HISTORY_CACHE_OVERFLOW_SIZE	= 0;
 zbx_uint64_t	CONFIG_TRENDS_CACHE_SIZE	= 4 * 0;
 zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 8 * 0;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * 0;
 zbx_uint64_t	CONFIG_EXPORT_FILE_SIZE;
 
+int	CONFIG_SHM_HUGE_PAGES		= 0;
 int	CONFIG_UNREACHABLE_PERIOD	= 45;
 int	CONFIG_UNREACHABLE_DELAY	= 15;
 int	CONFIG_UNAVAILABLE_DELAY	= 60;
@@ -102,6 +105,9 @@ char	*CONFIG_DB_TLS_CA_FILE		= NULL;
 char	*CONFIG_DB_TLS_CIPHER		= NULL;
 char	*CONFIG_DB_TLS_CIPHER_13	= NULL;
 char	*CONFIG_EXPORT_DIR		= NULL;
+char	*CONFIG_HISTORY_CACHE_OVERFLOW_DIR	= NULL;
+char	*CONFIG_SHM_NUMA_POLICY		= NULL;
+char	*CONFIG_VALUE_CACHE_FILE	= NULL;
 int	CONFIG_DBPORT			= 0;
 int	CONFIG_ENABLE_REMOTE_COMMANDS	= 0;
 int	CONFIG_LOG_REMOTE_COMMANDS	= 0;
@@ -115,6 +121,7 @@ int	CONFIG_JAVA_GATEWAY_PORT	= 0;
 char	*CONFIG_SSH_KEY_LOCATION	= NULL;
 
 int	CONFIG_LOG_SLOW_QUERIES		= 0;	/* ms; 0 - disable */
+int	CONFIG_DB_PREPARED_STATEMENTS	= 1;	/* 0 - disable prepared statement caching */
 
 int	CONFIG_SERVER_STARTUP_TIME	= 0;	/* zabbix server startup time */
 